@@ -6,11 +6,27 @@
 #include "json_parser/json_value.h"
 #include "json_parser/json_object.h"
 #include "json_parser/json_array.h"
+#include "json_parser/json_padded_buffer.h"
 #include "json_parser/json_parser.h"
+#include "json_parser/json_array_stream.h"
 #include "json_parser/json_writer.h"
 #include "json_parser/json_visitor.h"
 #include "json_parser/json_builder.h"
 #include "json_parser/json_utils.h"
+#include "json_parser/json_path.h"
+#include "json_parser/json_projection.h"
+#include "json_parser/json_reader.h"
+#include "json_parser/json_bind.h"
+#include "json_parser/json_schema.h"
+#include "json_parser/json_output_buffer.h"
+#include "json_parser/json_msgpack.h"
+#include "json_parser/json_cbor.h"
+#include "json_parser/json_snapshot.h"
+#include "json_parser/json_stream_writer.h"
+#include "json_parser/json_gzip.h"
+#include "json_parser/json_persistent.h"
+#include "json_parser/json_patch.h"
+#include "json_parser/json_diff.h"
 
 #endif  // JSON_PARSER_H_
 
@@ -16,9 +16,14 @@ class JsonArray {
   using ConstIterator = std::vector<JsonValue>::const_iterator;
 
   JsonArray() = default;
-  JsonArray(const JsonArray& other) = default;
+  // Copies are never frozen
+  JsonArray(const JsonArray& other) : values_(other.values_) {}
   JsonArray(JsonArray&& other) noexcept = default;
-  JsonArray& operator=(const JsonArray& other) = default;
+  JsonArray& operator=(const JsonArray& other) {
+    values_ = other.values_;
+    hash_cache_ = other.hash_cache_;
+    return *this;
+  }
   JsonArray& operator=(JsonArray&& other) noexcept = default;
   ~JsonArray() = default;
 
@@ -42,13 +47,23 @@ class JsonArray {
   void PushBack(JsonValue&& value);
   void PopBack();
   void Insert(size_t index, const JsonValue& value);
+  void Insert(size_t index, JsonValue&& value);
   void Erase(size_t index);
-  void Clear() { values_.clear(); }
+  void Clear() {
+    hash_cache_.Invalidate();
+    values_.clear();
+  }
 
   // Iterators
-  Iterator Begin() { return values_.begin(); }
+  Iterator Begin() {
+    hash_cache_.Invalidate();
+    return values_.begin();
+  }
   ConstIterator Begin() const { return values_.cbegin(); }
-  Iterator End() { return values_.end(); }
+  Iterator End() {
+    hash_cache_.Invalidate();
+    return values_.end();
+  }
   ConstIterator End() const { return values_.cend(); }
 
   // String representation
@@ -60,7 +75,16 @@ class JsonArray {
   bool operator!=(const JsonArray& other) const;
 
  private:
+  friend class JsonValue;
+  friend class internal::JsonInterner;
+
   std::vector<JsonValue> values_;
+  // Structural hash; cleared by modifiers and by accessors that return
+  // mutable references or iterators, never by const access
+  internal::HashCache hash_cache_;
+  // Set on interned containers, which JsonValue copies before handing out
+  // a mutable reference unless it holds the only one
+  bool frozen_ = false;
 };
 
 }  // namespace json_parser
@@ -0,0 +1,75 @@
+#ifndef JSON_PARSER_JSON_ARRAY_STREAM_H_
+#define JSON_PARSER_JSON_ARRAY_STREAM_H_
+
+#include "json_exception.h"
+#include "json_parser.h"
+#include "json_value.h"
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+namespace json_parser {
+
+// Iterates over the elements of a top-level JSON array one at a time.
+// Input is read through a fixed-size refillable buffer, so memory use is
+// bounded by the largest single element rather than the whole document.
+// Comments between elements are not supported.
+class JsonArrayStream {
+ public:
+  static constexpr size_t kDefaultBufferSize = 64 * 1024;
+
+  // Read from a caller-owned stream, which must outlive this object
+  explicit JsonArrayStream(
+      std::istream& input,
+      const JsonParserConfig& config = JsonParserConfig::Strict(),
+      size_t buffer_size = kDefaultBufferSize);
+
+  // Open a file, decompressing it first if it is gzip; throws
+  // JsonFileException if it cannot be opened
+  explicit JsonArrayStream(
+      const std::string& filename,
+      const JsonParserConfig& config = JsonParserConfig::Strict(),
+      size_t buffer_size = kDefaultBufferSize);
+
+  JsonArrayStream(const JsonArrayStream& other) = delete;
+  JsonArrayStream& operator=(const JsonArrayStream& other) = delete;
+  JsonArrayStream(JsonArrayStream&& other) noexcept;
+  JsonArrayStream& operator=(JsonArrayStream&& other) noexcept;
+  ~JsonArrayStream();
+
+  // Parse the next element into value. Returns false once the closing ']'
+  // has been consumed. Throws JsonParseException on malformed input.
+  bool Next(JsonValue& value);
+
+  // Number of elements returned so far
+  size_t Count() const { return count_; }
+  bool Done() const { return state_ == State::kDone; }
+
+ private:
+  enum class State { kStart, kInArray, kDone };
+
+  std::unique_ptr<std::istream> file_;
+  std::istream* input_;
+  JsonParser parser_;
+  std::string buffer_;
+  size_t chunk_size_;
+  size_t position_ = 0;  // Next unread byte in buffer_
+  size_t consumed_ = 0;  // Bytes discarded from the front of buffer_
+  size_t count_ = 0;
+  State state_ = State::kStart;
+
+  // Drop consumed bytes and append the next chunk; false at end of input
+  bool Refill();
+  // Skip whitespace, refilling as needed; false at end of input
+  bool SkipWhitespace();
+  // Length of the element starting at position_, up to the ',' or ']' that
+  // ends it at nesting depth zero
+  size_t ScanElement();
+  void Finish();
+  size_t Offset() const { return consumed_ + position_; }
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_ARRAY_STREAM_H_
@@ -0,0 +1,367 @@
+#ifndef JSON_PARSER_JSON_BIND_H_
+#define JSON_PARSER_JSON_BIND_H_
+
+#include "json_exception.h"
+#include "json_padded_buffer.h"
+#include "json_parser.h"
+#include "json_reader.h"
+#include "json_value.h"
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace json_parser {
+
+// Maps a C++ type to JSON. Specializations provide
+//   static void Read(JsonReader& reader, T& value);
+//   static void Write(std::string& out, const T& value);
+// where Write appends compact JSON to out. Structs get one from JSON_BIND;
+// the standard types below are built in.
+template <typename T, typename Enable = void>
+struct JsonBinder;
+
+namespace internal {
+
+// FNV-1a over the key, mixed with its length. Usable in case labels, so two
+// bound fields that collide fail to compile as duplicate cases.
+constexpr uint64_t KeyHash(const char* key, size_t length) {
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= static_cast<unsigned char>(key[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash ^ (static_cast<uint64_t>(length) << 56);
+}
+
+// Append helpers shared by the binders. Strings are quoted and escaped;
+// non-finite doubles are written as null, like JsonWriter does.
+void AppendString(std::string& out, const char* data, size_t length);
+void AppendInt64(std::string& out, int64_t value);
+void AppendUInt64(std::string& out, uint64_t value);
+void AppendDouble(std::string& out, double value);
+void AppendValue(std::string& out, const JsonValue& value);
+
+}  // namespace internal
+
+template <>
+struct JsonBinder<bool> {
+  static void Read(JsonReader& reader, bool& value) {
+    value = reader.ReadBool();
+  }
+  static void Write(std::string& out, bool value) {
+    if (value) {
+      out.append("true", 4);
+    } else {
+      out.append("false", 5);
+    }
+  }
+};
+
+template <typename T>
+struct JsonBinder<T, std::enable_if_t<std::is_integral<T>::value &&
+                                      !std::is_same<T, bool>::value>> {
+  static void Read(JsonReader& reader, T& value) {
+    if constexpr (std::is_signed<T>::value) {
+      int64_t number = reader.ReadInt64();
+      if (number < static_cast<int64_t>(std::numeric_limits<T>::min()) ||
+          number > static_cast<int64_t>(std::numeric_limits<T>::max())) {
+        throw JsonTypeException("Integer out of range: " +
+                                std::to_string(number));
+      }
+      value = static_cast<T>(number);
+    } else {
+      uint64_t number = reader.ReadUInt64();
+      if (number > static_cast<uint64_t>(std::numeric_limits<T>::max())) {
+        throw JsonTypeException("Integer out of range: " +
+                                std::to_string(number));
+      }
+      value = static_cast<T>(number);
+    }
+  }
+  static void Write(std::string& out, T value) {
+    if constexpr (std::is_signed<T>::value) {
+      internal::AppendInt64(out, static_cast<int64_t>(value));
+    } else {
+      internal::AppendUInt64(out, static_cast<uint64_t>(value));
+    }
+  }
+};
+
+template <typename T>
+struct JsonBinder<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+  static void Read(JsonReader& reader, T& value) {
+    value = static_cast<T>(reader.ReadDouble());
+  }
+  static void Write(std::string& out, T value) {
+    internal::AppendDouble(out, static_cast<double>(value));
+  }
+};
+
+template <>
+struct JsonBinder<std::string> {
+  static void Read(JsonReader& reader, std::string& value) {
+    reader.ReadString(value);
+  }
+  static void Write(std::string& out, const std::string& value) {
+    internal::AppendString(out, value.data(), value.size());
+  }
+};
+
+template <>
+struct JsonBinder<JsonValue> {
+  static void Read(JsonReader& reader, JsonValue& value) {
+    value = reader.ReadValue();
+  }
+  static void Write(std::string& out, const JsonValue& value) {
+    internal::AppendValue(out, value);
+  }
+};
+
+template <typename T>
+struct JsonBinder<std::vector<T>> {
+  static void Read(JsonReader& reader, std::vector<T>& value) {
+    value.clear();
+    reader.BeginArray();
+    while (reader.NextElement()) {
+      value.emplace_back();
+      JsonBinder<T>::Read(reader, value.back());
+    }
+  }
+  static void Write(std::string& out, const std::vector<T>& value) {
+    out += '[';
+    for (size_t i = 0; i < value.size(); ++i) {
+      if (i > 0) {
+        out += ',';
+      }
+      JsonBinder<T>::Write(out, value[i]);
+    }
+    out += ']';
+  }
+};
+
+namespace internal {
+
+template <typename Map>
+void WriteMap(std::string& out, const Map& map) {
+  out += '{';
+  bool first = true;
+  for (const auto& entry : map) {
+    if (!first) {
+      out += ',';
+    }
+    first = false;
+    AppendString(out, entry.first.data(), entry.first.size());
+    out += ':';
+    JsonBinder<typename Map::mapped_type>::Write(out, entry.second);
+  }
+  out += '}';
+}
+
+}  // namespace internal
+
+template <typename T>
+struct JsonBinder<std::map<std::string, T>> {
+  static void Read(JsonReader& reader, std::map<std::string, T>& value) {
+    value.clear();
+    std::string key;
+    reader.BeginObject();
+    while (reader.NextKey(key)) {
+      JsonBinder<T>::Read(reader, value[key]);
+    }
+  }
+  static void Write(std::string& out, const std::map<std::string, T>& value) {
+    internal::WriteMap(out, value);
+  }
+};
+
+template <typename T>
+struct JsonBinder<std::unordered_map<std::string, T>> {
+  static void Read(JsonReader& reader,
+                   std::unordered_map<std::string, T>& value) {
+    value.clear();
+    std::string key;
+    reader.BeginObject();
+    while (reader.NextKey(key)) {
+      JsonBinder<T>::Read(reader, value[key]);
+    }
+  }
+  static void Write(std::string& out,
+                    const std::unordered_map<std::string, T>& value) {
+    internal::WriteMap(out, value);
+  }
+};
+
+// null maps to an empty optional
+template <typename T>
+struct JsonBinder<std::optional<T>> {
+  static void Read(JsonReader& reader, std::optional<T>& value) {
+    if (reader.PeekType() == JsonValueType::kNull) {
+      reader.ReadNull();
+      value.reset();
+      return;
+    }
+    value.emplace();
+    JsonBinder<T>::Read(reader, *value);
+  }
+  static void Write(std::string& out, const std::optional<T>& value) {
+    if (value) {
+      JsonBinder<T>::Write(out, *value);
+    } else {
+      out.append("null", 4);
+    }
+  }
+};
+
+// Entry points for decoding JSON text straight into bound types and
+// encoding them straight to compact JSON text
+class JsonBind {
+ public:
+  template <typename T>
+  static void Read(const PaddedJsonBuffer& json, T& value,
+                   const JsonParserConfig& config = JsonParserConfig::Strict()) {
+    JsonReader reader(json, config);
+    JsonBinder<T>::Read(reader, value);
+    reader.ExpectEnd();
+  }
+
+  template <typename T>
+  static void Read(const std::string& json, T& value,
+                   const JsonParserConfig& config = JsonParserConfig::Strict()) {
+    Read(PaddedJsonBuffer(json), value, config);
+  }
+
+  template <typename T>
+  static T Parse(const std::string& json,
+                 const JsonParserConfig& config = JsonParserConfig::Strict()) {
+    T value{};
+    Read(json, value, config);
+    return value;
+  }
+
+  // Append the compact encoding of value to out
+  template <typename T>
+  static void Write(const T& value, std::string& out) {
+    JsonBinder<T>::Write(out, value);
+  }
+
+  template <typename T>
+  static std::string Write(const T& value) {
+    std::string out;
+    Write(value, out);
+    return out;
+  }
+
+ private:
+  JsonBind() = default;  // Utility class, no instantiation
+};
+
+}  // namespace json_parser
+
+// Binds the listed members of Type to JSON object members of the same name.
+// Use at global scope, after binding any nested struct types:
+//
+//   struct Point { int x; int y; };
+//   JSON_BIND(Point, x, y);
+//
+// Keys dispatch through a switch on their compile-time hash; unknown keys
+// are validated and skipped. Missing keys leave the member untouched.
+// Writing emits members in the listed order, copying each precomputed
+// quoted key fragment instead of escaping the name at run time.
+#define JSON_BIND(Type, ...)                                                 \
+  namespace json_parser {                                                    \
+  template <>                                                                \
+  struct JsonBinder<Type> {                                                  \
+    static void Read(JsonReader& reader, Type& value) {                      \
+      std::string key;                                                       \
+      reader.BeginObject();                                                  \
+      while (reader.NextKey(key)) {                                          \
+        switch (internal::KeyHash(key.data(), key.size())) {                 \
+          JSON_BIND_FOR_EACH(JSON_BIND_READ_FIELD, __VA_ARGS__)              \
+          default:                                                           \
+            reader.SkipValue();                                              \
+            break;                                                           \
+        }                                                                    \
+      }                                                                      \
+    }                                                                        \
+    static void Write(std::string& out, const Type& value) {                 \
+      bool first = true;                                                     \
+      out += '{';                                                            \
+      JSON_BIND_FOR_EACH(JSON_BIND_WRITE_FIELD, __VA_ARGS__)                 \
+      out += '}';                                                            \
+    }                                                                        \
+  };                                                                         \
+  }                                                                          \
+  static_assert(true, "")
+
+#define JSON_BIND_READ_FIELD(field)                                          \
+  case internal::KeyHash(#field, sizeof(#field) - 1):                        \
+    if (key == #field) {                                                     \
+      JsonBinder<decltype(value.field)>::Read(reader, value.field);          \
+    } else {                                                                 \
+      reader.SkipValue();                                                    \
+    }                                                                        \
+    break;
+
+#define JSON_BIND_WRITE_FIELD(field)                                         \
+  {                                                                          \
+    static constexpr char kKey[] = ",\"" #field "\":";                       \
+    size_t skip = first ? 1 : 0;                                             \
+    out.append(kKey + skip, sizeof(kKey) - 1 - skip);                        \
+    first = false;                                                           \
+    JsonBinder<decltype(value.field)>::Write(out, value.field);              \
+  }
+
+// Applies m to each of up to 32 arguments
+#define JSON_BIND_NARGS(...)                                                 \
+  JSON_BIND_NARGS_IMPL(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23,  \
+                       22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10,   \
+                       9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define JSON_BIND_NARGS_IMPL(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11,   \
+                             _12, _13, _14, _15, _16, _17, _18, _19, _20,    \
+                             _21, _22, _23, _24, _25, _26, _27, _28, _29,    \
+                             _30, _31, _32, N, ...)                          \
+  N
+#define JSON_BIND_CONCAT(a, b) JSON_BIND_CONCAT_IMPL(a, b)
+#define JSON_BIND_CONCAT_IMPL(a, b) a##b
+#define JSON_BIND_FOR_EACH(m, ...)                                           \
+  JSON_BIND_CONCAT(JSON_BIND_FE_, JSON_BIND_NARGS(__VA_ARGS__))(m, __VA_ARGS__)
+#define JSON_BIND_FE_1(m, x) m(x)
+#define JSON_BIND_FE_2(m, x, ...) m(x) JSON_BIND_FE_1(m, __VA_ARGS__)
+#define JSON_BIND_FE_3(m, x, ...) m(x) JSON_BIND_FE_2(m, __VA_ARGS__)
+#define JSON_BIND_FE_4(m, x, ...) m(x) JSON_BIND_FE_3(m, __VA_ARGS__)
+#define JSON_BIND_FE_5(m, x, ...) m(x) JSON_BIND_FE_4(m, __VA_ARGS__)
+#define JSON_BIND_FE_6(m, x, ...) m(x) JSON_BIND_FE_5(m, __VA_ARGS__)
+#define JSON_BIND_FE_7(m, x, ...) m(x) JSON_BIND_FE_6(m, __VA_ARGS__)
+#define JSON_BIND_FE_8(m, x, ...) m(x) JSON_BIND_FE_7(m, __VA_ARGS__)
+#define JSON_BIND_FE_9(m, x, ...) m(x) JSON_BIND_FE_8(m, __VA_ARGS__)
+#define JSON_BIND_FE_10(m, x, ...) m(x) JSON_BIND_FE_9(m, __VA_ARGS__)
+#define JSON_BIND_FE_11(m, x, ...) m(x) JSON_BIND_FE_10(m, __VA_ARGS__)
+#define JSON_BIND_FE_12(m, x, ...) m(x) JSON_BIND_FE_11(m, __VA_ARGS__)
+#define JSON_BIND_FE_13(m, x, ...) m(x) JSON_BIND_FE_12(m, __VA_ARGS__)
+#define JSON_BIND_FE_14(m, x, ...) m(x) JSON_BIND_FE_13(m, __VA_ARGS__)
+#define JSON_BIND_FE_15(m, x, ...) m(x) JSON_BIND_FE_14(m, __VA_ARGS__)
+#define JSON_BIND_FE_16(m, x, ...) m(x) JSON_BIND_FE_15(m, __VA_ARGS__)
+#define JSON_BIND_FE_17(m, x, ...) m(x) JSON_BIND_FE_16(m, __VA_ARGS__)
+#define JSON_BIND_FE_18(m, x, ...) m(x) JSON_BIND_FE_17(m, __VA_ARGS__)
+#define JSON_BIND_FE_19(m, x, ...) m(x) JSON_BIND_FE_18(m, __VA_ARGS__)
+#define JSON_BIND_FE_20(m, x, ...) m(x) JSON_BIND_FE_19(m, __VA_ARGS__)
+#define JSON_BIND_FE_21(m, x, ...) m(x) JSON_BIND_FE_20(m, __VA_ARGS__)
+#define JSON_BIND_FE_22(m, x, ...) m(x) JSON_BIND_FE_21(m, __VA_ARGS__)
+#define JSON_BIND_FE_23(m, x, ...) m(x) JSON_BIND_FE_22(m, __VA_ARGS__)
+#define JSON_BIND_FE_24(m, x, ...) m(x) JSON_BIND_FE_23(m, __VA_ARGS__)
+#define JSON_BIND_FE_25(m, x, ...) m(x) JSON_BIND_FE_24(m, __VA_ARGS__)
+#define JSON_BIND_FE_26(m, x, ...) m(x) JSON_BIND_FE_25(m, __VA_ARGS__)
+#define JSON_BIND_FE_27(m, x, ...) m(x) JSON_BIND_FE_26(m, __VA_ARGS__)
+#define JSON_BIND_FE_28(m, x, ...) m(x) JSON_BIND_FE_27(m, __VA_ARGS__)
+#define JSON_BIND_FE_29(m, x, ...) m(x) JSON_BIND_FE_28(m, __VA_ARGS__)
+#define JSON_BIND_FE_30(m, x, ...) m(x) JSON_BIND_FE_29(m, __VA_ARGS__)
+#define JSON_BIND_FE_31(m, x, ...) m(x) JSON_BIND_FE_30(m, __VA_ARGS__)
+#define JSON_BIND_FE_32(m, x, ...) m(x) JSON_BIND_FE_31(m, __VA_ARGS__)
+
+#endif  // JSON_PARSER_JSON_BIND_H_
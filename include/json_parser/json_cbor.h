@@ -0,0 +1,161 @@
+#ifndef JSON_PARSER_JSON_CBOR_H_
+#define JSON_PARSER_JSON_CBOR_H_
+
+#include "json_exception.h"
+#include "json_output_buffer.h"
+#include "json_padded_buffer.h"
+#include "json_parser.h"
+#include "json_value.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace json_parser {
+
+// Streaming CBOR (RFC 8949) encoder appending to a JsonOutputBuffer.
+// Containers are either definite (count up front) or indefinite (closed
+// with WriteBreak), the latter for producers that do not know the size.
+class JsonCborWriter {
+ public:
+  explicit JsonCborWriter(JsonOutputBuffer& out) : out_(out) {}
+
+  void WriteNull();
+  void WriteBool(bool value);
+  void WriteInt(int64_t value);
+  void WriteUInt(uint64_t value);
+  void WriteDouble(double value);
+  // Integral values become integers; others use single precision when that
+  // is lossless, double otherwise
+  void WriteNumber(double value);
+  void WriteTextString(const char* data, size_t length);
+  void WriteTextString(const std::string& str) {
+    WriteTextString(str.data(), str.size());
+  }
+  void WriteByteString(const char* data, size_t length);
+  void WriteTag(uint64_t tag);
+  void BeginArray(uint64_t count);
+  void BeginMap(uint64_t count);
+  void BeginIndefiniteArray();
+  void BeginIndefiniteMap();
+  void WriteBreak();
+
+  // Encode a whole JsonValue tree using definite lengths
+  void WriteValue(const JsonValue& value);
+
+ private:
+  JsonOutputBuffer& out_;
+
+  void WriteHead(uint8_t major, uint64_t argument);
+};
+
+enum class JsonCborType {
+  kUnsigned,
+  kNegative,
+  kByteString,
+  kTextString,
+  kArray,
+  kMap,
+  kTag,
+  kBoolean,
+  kNull,
+  kUndefined,
+  kSimple,
+  kFloat,
+  kBreak
+};
+
+// Zero-copy CBOR decoder over caller-owned memory. Definite-length strings
+// come back as views into the input; indefinite-length strings are joined
+// into the caller's scratch string, which the view then refers to.
+// Malformed or truncated input throws JsonParseException; reading a type
+// other than the one present throws JsonTypeException.
+class JsonCborReader {
+ public:
+  static constexpr int64_t kIndefinite = -1;
+
+  JsonCborReader(const char* data, size_t size, size_t max_depth = 1000);
+  explicit JsonCborReader(const std::string& data, size_t max_depth = 1000)
+      : JsonCborReader(data.data(), data.size(), max_depth) {}
+
+  JsonCborType PeekType() const;
+
+  void ReadNull();  // Accepts null and undefined
+  bool ReadBool();
+  int64_t ReadInt64();
+  uint64_t ReadUInt64();
+  // Accepts integers as well as half, single and double floats
+  double ReadDouble();
+  // Read any number. Returns true and sets integer when it is an integer
+  // that fits in int64_t; otherwise returns false and sets number.
+  bool ReadNumber(int64_t& integer, double& number);
+  std::string_view ReadTextString(std::string& scratch);
+  std::string_view ReadByteString(std::string& scratch);
+  uint64_t ReadTag();
+
+  // Element or entry count, or kIndefinite. Indefinite containers end at a
+  // break: loop while !AtBreak(), then call ReadBreak().
+  int64_t ReadArrayHeader();
+  int64_t ReadMapHeader();
+  bool AtBreak() const;
+  void ReadBreak();
+
+  // Skip the next value, including any container contents
+  void Skip();
+
+  // Decode the next value as a JsonValue. Tags are dropped, byte strings
+  // become base64url text, integer map keys become their decimal text.
+  JsonValue ReadValue();
+
+  bool AtEnd() const { return position_ >= size_; }
+  size_t Position() const { return position_; }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t position_ = 0;
+  size_t max_depth_;
+
+  [[noreturn]] void Fail(const std::string& message) const;
+  [[noreturn]] void TypeMismatch(const char* expected) const;
+  uint8_t PeekByte() const;
+  const uint8_t* Take(size_t length);
+  uint64_t ReadBigEndian(size_t length);
+  // Consume the head of the next item, returning its argument. Sets
+  // indefinite for the 0x1f additional-information form.
+  uint64_t ReadHead(uint8_t& major, bool& indefinite);
+  std::string_view ReadString(uint8_t major, std::string& scratch);
+  std::string ReadKey();
+  void Skip(size_t depth);
+  JsonValue ReadValue(size_t depth);
+};
+
+// Whole-document CBOR conversion, plus streaming transcoding between JSON
+// text and CBOR that never builds a JsonValue tree
+class JsonCbor {
+ public:
+  static std::string Encode(const JsonValue& value);
+  static void Encode(const JsonValue& value, JsonOutputBuffer& out);
+  static JsonValue Decode(const std::string& data);
+  static JsonValue Decode(const char* data, size_t size);
+
+  // JSON text to CBOR. Containers use indefinite lengths so nothing needs
+  // to be buffered; integer literals that fit in 64 bits stay exact.
+  static std::string FromJson(
+      const std::string& json,
+      const JsonParserConfig& config = JsonParserConfig::Strict());
+  static void FromJson(
+      const PaddedJsonBuffer& json, JsonOutputBuffer& out,
+      const JsonParserConfig& config = JsonParserConfig::Strict());
+
+  // CBOR to compact JSON text, with the conversions of ReadValue()
+  static std::string ToJson(const std::string& data);
+  static std::string ToJson(const char* data, size_t size);
+
+ private:
+  JsonCbor() = default;  // Utility class, no instantiation
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_CBOR_H_
@@ -0,0 +1,39 @@
+#ifndef JSON_PARSER_JSON_DIFF_H_
+#define JSON_PARSER_JSON_DIFF_H_
+
+#include "json_patch.h"
+#include "json_value.h"
+
+#include <cstddef>
+
+namespace json_parser {
+
+// Configuration for JsonDiff
+struct JsonDiffConfig {
+  // Array sections needing more cells than this in the LCS table are
+  // anchored on elements that occur once on each side instead, which is
+  // near linear but may emit a few more operations
+  size_t max_lcs_cells = size_t{1} << 22;
+};
+
+// Returns a JSON Patch that turns source into target when applied.
+//
+// Subtrees that source and target share (the same underlying container,
+// as after copying a JsonValue) are skipped without being visited. Other
+// subtrees are compared by structural hash first (JsonValue::Hash, which
+// caches them on both documents), and equal ones are confirmed with
+// operator== and skipped without being diffed. Objects are compared member
+// by member; arrays have their common prefix and suffix trimmed and the
+// rest aligned by a longest common subsequence over element hashes, so
+// inserting or removing a few elements costs a few operations. Replaced
+// elements are diffed recursively rather than replaced whole.
+//
+// Values in the patch share storage with target, like any JsonValue copy.
+// Operations are emitted in a deterministic order: for each object,
+// removals, then changes, then additions, each by key.
+JsonPatch JsonDiff(const JsonValue& source, const JsonValue& target,
+                   const JsonDiffConfig& config = JsonDiffConfig());
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_DIFF_H_
@@ -56,6 +56,29 @@ class JsonFileException : public JsonException {
       : JsonException("JSON File Error: Cannot open file '" + filename + "'") {}
 };
 
+// Exception thrown for malformed JSON path expressions
+class JsonPathException : public JsonException {
+ public:
+  explicit JsonPathException(const std::string& message)
+      : JsonException("JSON Path Error: " + message) {}
+};
+
+// Exception thrown for unsupported or malformed schemas, and for documents
+// rejected while parsing against a schema
+class JsonSchemaException : public JsonException {
+ public:
+  explicit JsonSchemaException(const std::string& message)
+      : JsonException("JSON Schema Error: " + message) {}
+};
+
+// Exception thrown for malformed JSON Patch documents and for operations
+// that fail while a patch is applied
+class JsonPatchException : public JsonException {
+ public:
+  explicit JsonPatchException(const std::string& message)
+      : JsonException("JSON Patch Error: " + message) {}
+};
+
 }  // namespace json_parser
 
 #endif  // JSON_PARSER_JSON_EXCEPTION_H_
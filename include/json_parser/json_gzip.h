@@ -0,0 +1,72 @@
+#ifndef JSON_PARSER_JSON_GZIP_H_
+#define JSON_PARSER_JSON_GZIP_H_
+
+#include "json_exception.h"
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace json_parser {
+
+// Reads a gzip file as a stream of decompressed bytes. A background thread
+// inflates the next block while the caller consumes the current one, so
+// decompression overlaps with parsing. Corrupt or truncated input throws
+// JsonException from the read that reaches it. Requires zlib at build time
+// (JsonGzip::Available()); otherwise construction throws JsonException.
+class JsonGzipInputStream : public std::istream {
+ public:
+  static constexpr size_t kDefaultBufferSize = 256 * 1024;
+
+  // Throws JsonFileException if the file cannot be opened
+  explicit JsonGzipInputStream(const std::string& filename,
+                               size_t buffer_size = kDefaultBufferSize);
+  ~JsonGzipInputStream() override;
+
+ private:
+  class Buffer;
+  std::unique_ptr<Buffer> buffer_;
+};
+
+// Writes a gzip file. Bytes written to the stream are compressed on a
+// background thread, one block while the caller fills the next. Call
+// Close() to finish the file and surface write errors; the destructor
+// closes too but cannot report failures.
+class JsonGzipOutputStream : public std::ostream {
+ public:
+  static constexpr size_t kDefaultBufferSize = 256 * 1024;
+
+  // level is a zlib compression level from 1 (fastest) to 9 (smallest).
+  // Throws JsonFileException if the file cannot be created.
+  explicit JsonGzipOutputStream(const std::string& filename, int level = 6,
+                                size_t buffer_size = kDefaultBufferSize);
+  ~JsonGzipOutputStream() override;
+
+  void Close();
+
+ private:
+  class Buffer;
+  std::unique_ptr<Buffer> buffer_;
+};
+
+// gzip helpers used by JsonParser::ParseFile and JsonWriter::WriteToFile
+class JsonGzip {
+ public:
+  // Whether the library was built with zlib
+  static bool Available();
+
+  // Whether the file starts with the gzip magic bytes
+  static bool IsGzipFile(const std::string& filename);
+
+  // Whether the name ends in ".gz"
+  static bool HasGzipExtension(const std::string& filename);
+
+ private:
+  JsonGzip() = default;  // Utility class, no instantiation
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_GZIP_H_
@@ -0,0 +1,124 @@
+#ifndef JSON_PARSER_JSON_MSGPACK_H_
+#define JSON_PARSER_JSON_MSGPACK_H_
+
+#include "json_exception.h"
+#include "json_output_buffer.h"
+#include "json_value.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace json_parser {
+
+// Streaming MessagePack encoder appending to a JsonOutputBuffer. Container
+// headers carry their element count, so callers pass it up front; a map of
+// n entries is followed by n key/value pairs.
+class JsonMsgPackWriter {
+ public:
+  explicit JsonMsgPackWriter(JsonOutputBuffer& out) : out_(out) {}
+
+  void WriteNil();
+  void WriteBool(bool value);
+  void WriteInt(int64_t value);
+  void WriteUInt(uint64_t value);
+  void WriteDouble(double value);
+  // Integral values become the smallest integer encoding; others use
+  // float32 when that is lossless, float64 otherwise
+  void WriteNumber(double value);
+  void WriteString(const char* data, size_t length);
+  void WriteString(const std::string& str) {
+    WriteString(str.data(), str.size());
+  }
+  void WriteBinary(const char* data, size_t length);
+  void BeginArray(uint32_t count);
+  void BeginMap(uint32_t count);
+
+  // Encode a whole JsonValue tree
+  void WriteValue(const JsonValue& value);
+
+ private:
+  JsonOutputBuffer& out_;
+
+  template <typename T>
+  void Put(uint8_t marker, T value);
+  void WriteLength(size_t length, uint8_t fix_base, size_t fix_limit,
+                   uint8_t marker8, uint8_t marker16, uint8_t marker32);
+};
+
+enum class JsonMsgPackType {
+  kNil,
+  kBoolean,
+  kInteger,
+  kFloat,
+  kString,
+  kBinary,
+  kArray,
+  kMap,
+  kExtension
+};
+
+// Zero-copy MessagePack decoder over caller-owned memory. Strings and
+// binary data come back as views into the input, which must outlive them.
+// Malformed or truncated input throws JsonParseException; reading a type
+// other than the one present throws JsonTypeException.
+class JsonMsgPackReader {
+ public:
+  JsonMsgPackReader(const char* data, size_t size, size_t max_depth = 1000);
+  explicit JsonMsgPackReader(const std::string& data,
+                             size_t max_depth = 1000)
+      : JsonMsgPackReader(data.data(), data.size(), max_depth) {}
+
+  JsonMsgPackType PeekType() const;
+
+  void ReadNil();
+  bool ReadBool();
+  int64_t ReadInt64();
+  uint64_t ReadUInt64();
+  // Accepts integers as well as floats
+  double ReadDouble();
+  std::string_view ReadString();
+  std::string_view ReadBinary();
+  uint32_t ReadArrayHeader();
+  uint32_t ReadMapHeader();
+
+  // Skip the next value, including any container contents
+  void Skip();
+
+  // Decode the next value as a JsonValue. Binary data becomes a string;
+  // map keys must be strings and extension types are rejected.
+  JsonValue ReadValue();
+
+  bool AtEnd() const { return position_ >= size_; }
+  size_t Position() const { return position_; }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t position_ = 0;
+  size_t max_depth_;
+
+  [[noreturn]] void Fail(const std::string& message) const;
+  uint8_t PeekByte() const;
+  const uint8_t* Take(size_t length);
+  uint64_t ReadBigEndian(size_t length);
+  [[noreturn]] void TypeMismatch(const char* expected) const;
+  void Skip(size_t depth);
+  JsonValue ReadValue(size_t depth);
+};
+
+// Whole-document MessagePack conversion for JsonValue
+class JsonMsgPack {
+ public:
+  static std::string Encode(const JsonValue& value);
+  static void Encode(const JsonValue& value, JsonOutputBuffer& out);
+  static JsonValue Decode(const std::string& data);
+  static JsonValue Decode(const char* data, size_t size);
+
+ private:
+  JsonMsgPack() = default;  // Utility class, no instantiation
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_MSGPACK_H_
@@ -18,9 +18,14 @@ class JsonObject {
       std::unordered_map<std::string, JsonValue>::const_iterator;
 
   JsonObject() = default;
-  JsonObject(const JsonObject& other) = default;
+  // Copies are never frozen
+  JsonObject(const JsonObject& other) : values_(other.values_) {}
   JsonObject(JsonObject&& other) noexcept = default;
-  JsonObject& operator=(const JsonObject& other) = default;
+  JsonObject& operator=(const JsonObject& other) {
+    values_ = other.values_;
+    hash_cache_ = other.hash_cache_;
+    return *this;
+  }
   JsonObject& operator=(JsonObject&& other) noexcept = default;
   ~JsonObject() = default;
 
@@ -38,17 +43,30 @@ class JsonObject {
   void Insert(const std::string& key, const JsonValue& value);
   void Insert(const std::string& key, JsonValue&& value);
   void Erase(const std::string& key);
-  void Clear() { values_.clear(); }
+  void Clear() {
+    hash_cache_.Invalidate();
+    values_.clear();
+  }
 
   // Lookup
   bool Contains(const std::string& key) const;
   bool Has(const std::string& key) const { return Contains(key); }
   size_t Count(const std::string& key) const;
 
+  // Single-lookup access; returns nullptr if the key is missing
+  JsonValue* Find(const std::string& key);
+  const JsonValue* Find(const std::string& key) const;
+
   // Iterators
-  Iterator Begin() { return values_.begin(); }
+  Iterator Begin() {
+    hash_cache_.Invalidate();
+    return values_.begin();
+  }
   ConstIterator Begin() const { return values_.cbegin(); }
-  Iterator End() { return values_.end(); }
+  Iterator End() {
+    hash_cache_.Invalidate();
+    return values_.end();
+  }
   ConstIterator End() const { return values_.cend(); }
 
   // Get all keys
@@ -63,7 +81,16 @@ class JsonObject {
   bool operator!=(const JsonObject& other) const;
 
  private:
+  friend class JsonValue;
+  friend class internal::JsonInterner;
+
   std::unordered_map<std::string, JsonValue> values_;
+  // Structural hash; cleared by modifiers and by accessors that return
+  // mutable references or iterators, never by const access
+  internal::HashCache hash_cache_;
+  // Set on interned containers, which JsonValue copies before handing out
+  // a mutable reference unless it holds the only one
+  bool frozen_ = false;
 };
 
 }  // namespace json_parser
@@ -0,0 +1,114 @@
+#ifndef JSON_PARSER_JSON_OUTPUT_BUFFER_H_
+#define JSON_PARSER_JSON_OUTPUT_BUFFER_H_
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace json_parser {
+
+// Contiguous growable byte buffer that serializers append to. Without a
+// sink it accumulates the whole output in memory. With a sink (a stream or
+// a file descriptor) it drains whenever it grows past the flush threshold,
+// which bounds memory for large outputs.
+//
+// A file-descriptor buffer can also gather: long runs passed to
+// AppendReference are then recorded as pointers instead of being copied,
+// and Flush() hands the copied and referenced segments to writev in order.
+class JsonOutputBuffer {
+ public:
+  static constexpr size_t kDefaultFlushThreshold = 64 * 1024;
+  // Runs shorter than this are copied even when gathering, since a
+  // segment costs more than copying a few bytes
+  static constexpr size_t kMinReferenceLength = 4096;
+
+  JsonOutputBuffer() = default;
+  explicit JsonOutputBuffer(std::ostream& sink,
+                            size_t flush_threshold = kDefaultFlushThreshold);
+  // Drains to an open file descriptor, which is not closed. Write errors
+  // throw JsonException from Flush(). See AppendReference for gather.
+  explicit JsonOutputBuffer(int fd,
+                            size_t flush_threshold = kDefaultFlushThreshold,
+                            bool gather = false);
+  JsonOutputBuffer(const JsonOutputBuffer&) = delete;
+  JsonOutputBuffer& operator=(const JsonOutputBuffer&) = delete;
+  // Flushes any buffered bytes to the sink
+  ~JsonOutputBuffer();
+
+  void Append(char c) {
+    data_.push_back(c);
+    MaybeFlush();
+  }
+
+  void Append(const char* data, size_t length) {
+    data_.append(data, length);
+    MaybeFlush();
+  }
+
+  void Append(const std::string& str) { Append(str.data(), str.size()); }
+
+  // Like Append, but a gathering buffer keeps a pointer to runs of at least
+  // kMinReferenceLength bytes instead of copying them. The bytes must then
+  // stay unchanged until the next Flush(), which writes them in place.
+  void AppendReference(const char* data, size_t length) {
+    if (gather_ && length >= kMinReferenceLength) {
+      AddReference(data, length);
+    } else {
+      Append(data, length);
+    }
+  }
+
+  // Grow by length bytes and return a pointer to them, for writers that
+  // fill fixed-size fields in place. The pointer is valid until the next
+  // call on the buffer.
+  char* Extend(size_t length) {
+    size_t old_size = data_.size();
+    data_.resize(old_size + length);
+    return &data_[old_size];
+  }
+
+  // Write buffered bytes to the sink. No-op without a sink.
+  void Flush();
+
+  // Bytes currently buffered. Data() covers only the bytes appended since
+  // the last referenced run; TakeString() always returns all of them.
+  const char* Data() const { return data_.data(); }
+  size_t Size() const { return segment_bytes_ + data_.size(); }
+  void Clear();
+
+  // Move the buffered bytes out, leaving the buffer empty
+  std::string TakeString();
+
+ private:
+  // A referenced run, or (data == nullptr) a copied run in owned_[owned]
+  struct Segment {
+    const char* data;
+    size_t length;
+    size_t owned;
+  };
+
+  std::string data_;
+  std::ostream* sink_ = nullptr;
+  int fd_ = -1;
+  size_t flush_threshold_ = kDefaultFlushThreshold;
+  bool gather_ = false;
+  // Runs completed before the current data_, in output order
+  std::vector<Segment> segments_;
+  std::vector<std::string> owned_;
+  size_t segment_bytes_ = 0;
+
+  void MaybeFlush() {
+    if ((sink_ != nullptr || fd_ >= 0) && Size() >= flush_threshold_) {
+      Flush();
+    }
+  }
+  void AddReference(const char* data, size_t length);
+  // Move data_ to the segment list
+  void SealData();
+  void WriteSegments();
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_OUTPUT_BUFFER_H_
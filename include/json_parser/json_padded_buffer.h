@@ -0,0 +1,52 @@
+#ifndef JSON_PARSER_JSON_PADDED_BUFFER_H_
+#define JSON_PARSER_JSON_PADDED_BUFFER_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace json_parser {
+
+// Input buffer that guarantees kPadding readable zero bytes after the end
+// of the JSON text. The parser relies on this to drop per-byte bounds checks
+// in its inner loops and to use over-reading SIMD loads.
+class PaddedJsonBuffer {
+ public:
+  static constexpr size_t kPadding = 64;
+
+  PaddedJsonBuffer() = default;
+  explicit PaddedJsonBuffer(const std::string& json);
+  PaddedJsonBuffer(const char* data, size_t length);
+  PaddedJsonBuffer(const PaddedJsonBuffer& other);
+  PaddedJsonBuffer(PaddedJsonBuffer&& other) noexcept;
+  PaddedJsonBuffer& operator=(const PaddedJsonBuffer& other);
+  PaddedJsonBuffer& operator=(PaddedJsonBuffer&& other) noexcept;
+  ~PaddedJsonBuffer() = default;
+
+  // Wrap caller-owned memory without copying. The caller guarantees that
+  // data[length, length + kPadding) is readable and zero-filled, and that
+  // the memory outlives the buffer.
+  static PaddedJsonBuffer View(const char* data, size_t length);
+
+  // Read a whole file into a padded buffer
+  static PaddedJsonBuffer FromFile(const std::string& filename);
+
+  // Accessors
+  const char* Data() const { return data_; }
+  size_t Size() const { return length_; }
+  bool Empty() const { return length_ == 0; }
+  bool OwnsData() const { return storage_ != nullptr; }
+
+ private:
+  std::unique_ptr<char[]> storage_;
+  const char* data_ = kEmpty;
+  size_t length_ = 0;
+
+  static const char kEmpty[kPadding];
+
+  void Assign(const char* data, size_t length);
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_PADDED_BUFFER_H_
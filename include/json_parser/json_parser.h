@@ -2,12 +2,20 @@
 #define JSON_PARSER_JSON_PARSER_H_
 
 #include "json_exception.h"
+#include "json_padded_buffer.h"
 #include "json_value.h"
 
+#include <cstdint>
 #include <string>
 
 namespace json_parser {
 
+class JsonProjection;
+
+namespace internal {
+class JsonInterner;
+}  // namespace internal
+
 // Parser configuration
 struct JsonParserConfig {
   bool allow_comments = false;
@@ -15,6 +23,10 @@ struct JsonParserConfig {
   bool strict_mode = true;
   size_t max_depth = 1000;
   size_t max_string_length = 1000000;
+  // Share one container between equal object and array subtrees as they
+  // are parsed (see JsonUtils::Intern). Saves memory on documents that
+  // repeat the same records; costs a hash and lookup per container.
+  bool intern_subtrees = false;
 
   static JsonParserConfig Strict() {
     JsonParserConfig config;
@@ -41,12 +53,28 @@ class JsonParser {
   JsonValue ParseString(const std::string& json);
   JsonValue ParseString(const char* json, size_t length);
 
-  // Parse JSON from file (instance method)
+  // Parse JSON from a padded buffer without copying it
+  JsonValue ParseString(const PaddedJsonBuffer& json);
+
+  // Parse keeping only the object members selected by projection; the rest
+  // is validated and skipped without being materialized
+  JsonValue ParseString(const std::string& json,
+                        const JsonProjection& projection);
+  JsonValue ParseString(const PaddedJsonBuffer& json,
+                        const JsonProjection& projection);
+
+  // Parse JSON from file (instance method). gzip files are recognized by
+  // their magic bytes and decompressed on a background thread.
   JsonValue ParseFileImpl(const std::string& filename);
 
   // Static convenience methods
   static JsonValue Parse(const std::string& json,
                          const JsonParserConfig& config = JsonParserConfig::Strict());
+  static JsonValue Parse(const PaddedJsonBuffer& json,
+                         const JsonParserConfig& config = JsonParserConfig::Strict());
+  static JsonValue Parse(const std::string& json,
+                         const JsonProjection& projection,
+                         const JsonParserConfig& config = JsonParserConfig::Strict());
   static JsonValue ParseFile(const std::string& filename,
                              const JsonParserConfig& config = JsonParserConfig::Strict());
 
@@ -56,13 +84,20 @@ class JsonParser {
 
  private:
   JsonParserConfig config_;
-  std::string input_;
-  size_t position_;
-  size_t line_;
-  size_t column_;
+  // Input is always padded, so reads at [length_, length_ + kPadding) yield
+  // '\0' and the hot paths only check bounds when they see a zero byte.
+  const char* input_ = nullptr;
+  size_t length_ = 0;
+  size_t position_ = 0;
+  size_t line_ = 1;
+  size_t column_ = 1;
+  // Active field mask, or nullptr when the whole subtree is kept
+  const JsonProjection* projection_ = nullptr;
+  // Canonical subtrees of the current parse when intern_subtrees is set
+  internal::JsonInterner* interner_ = nullptr;
 
   // Initialize parser state
-  void Initialize(const std::string& input);
+  void Initialize(const PaddedJsonBuffer& input);
 
   // Parse methods
   JsonValue ParseValue();
@@ -70,9 +105,21 @@ class JsonParser {
   JsonArray ParseArray();
   std::string ParseString();
   double ParseNumber();
+  // Reads four hex digits of a \u escape
+  uint32_t ParseHex4();
   bool ParseBoolean();
   void ParseNull();
 
+  // Parse the value at the current position under mask, or skip it if the
+  // mask excludes it. Returns false if the value was skipped.
+  bool ParseMaskedValue(const JsonProjection* mask, JsonValue& value);
+
+  // Validating skips used for members excluded by the projection
+  void SkipValue();
+  void SkipObject();
+  void SkipArray();
+  void SkipString();
+
   // Utility methods
   void SkipWhitespace();
   void SkipComments();
@@ -80,8 +127,9 @@ class JsonParser {
   char Next();
   char Peek(size_t offset = 1) const;
   bool Expect(char c);
-  bool Match(const std::string& str);
+  bool Match(const char* literal, size_t length);
   void Advance(size_t count = 1);
+  bool AtEnd() const { return position_ >= length_; }
 
   // Error reporting
   void ThrowParseError(const std::string& message) const;
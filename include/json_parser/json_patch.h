@@ -0,0 +1,91 @@
+#ifndef JSON_PARSER_JSON_PATCH_H_
+#define JSON_PARSER_JSON_PATCH_H_
+
+#include "json_exception.h"
+#include "json_value.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace json_parser {
+
+// One compiled RFC 6902 operation. Pointers are decoded into reference
+// tokens once, when the operation is added to a patch.
+struct JsonPatchOperation {
+  enum class Type { kAdd, kRemove, kReplace, kMove, kCopy, kTest };
+  Type type = Type::kAdd;
+  std::string path;                       // JSON Pointer text
+  std::string from;                       // kMove, kCopy
+  std::vector<std::string> path_tokens;   // Decoded path
+  std::vector<std::string> from_tokens;   // Decoded from
+  JsonValue value;                        // kAdd, kReplace, kTest
+};
+
+// RFC 6902 JSON Patch applied to a JsonValue in place.
+//
+// Values are moved, not copied: remove and move relink the existing
+// subtree, and applying an rvalue patch moves its values into the
+// document. Consecutive operations reuse the containers resolved for the
+// previous path, so updates to siblings walk the shared prefix once.
+//
+// Application is atomic. Each change is logged with the value it
+// displaced, and if an operation fails (a missing path, a failed test)
+// the log is replayed backwards before JsonPatchException is thrown, so
+// the document is left as it was.
+class JsonPatch {
+ public:
+  JsonPatch() = default;
+
+  // Compile an RFC 6902 document (an array of operation objects). Throws
+  // JsonPatchException if it is malformed.
+  static JsonPatch Compile(const JsonValue& patch);
+  static JsonPatch Compile(const std::string& json);
+
+  // Append operations. Pointers are validated here.
+  JsonPatch& Add(const std::string& path, JsonValue value);
+  JsonPatch& Remove(const std::string& path);
+  JsonPatch& Replace(const std::string& path, JsonValue value);
+  JsonPatch& Move(const std::string& from, const std::string& path);
+  JsonPatch& Copy(const std::string& from, const std::string& path);
+  JsonPatch& Test(const std::string& path, JsonValue value);
+
+  const std::vector<JsonPatchOperation>& Operations() const {
+    return operations_;
+  }
+  size_t Size() const { return operations_.size(); }
+  bool Empty() const { return operations_.empty(); }
+
+  // The RFC 6902 document for this patch
+  JsonValue ToJsonValue() const;
+
+  // Apply to document. The lvalue form deep-copies the values it inserts so
+  // the patch can be reused; the rvalue form moves them out of the patch.
+  void Apply(JsonValue& document) const&;
+  void Apply(JsonValue& document) &&;
+
+  // Apply several patches in one pass, sharing path resolution between
+  // them. The batch is atomic as a whole.
+  static void ApplyBatch(JsonValue& document,
+                         const std::vector<JsonPatch>& patches);
+
+  // RFC 7396 JSON Merge Patch: members of patch replace those of target,
+  // null members delete them, and nested objects merge recursively. The
+  // rvalue form moves the patch's values into target.
+  static void ApplyMergePatch(JsonValue& target, const JsonValue& patch);
+  static void ApplyMergePatch(JsonValue& target, JsonValue&& patch);
+
+  // RFC 6901 pointer encoding and decoding of reference tokens
+  static std::vector<std::string> ParsePointer(const std::string& pointer);
+  static std::string EscapeToken(const std::string& token);
+
+ private:
+  std::vector<JsonPatchOperation> operations_;
+
+  JsonPatch& Append(JsonPatchOperation::Type type, const std::string& from,
+                    const std::string& path, JsonValue value);
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_PATCH_H_
@@ -0,0 +1,91 @@
+#ifndef JSON_PARSER_JSON_PATH_H_
+#define JSON_PARSER_JSON_PATH_H_
+
+#include "json_exception.h"
+#include "json_padded_buffer.h"
+#include "json_parser.h"
+#include "json_value.h"
+
+#include <string>
+#include <vector>
+
+namespace json_parser {
+
+// One step of a compiled path
+struct JsonPathSegment {
+  enum class Type { kKey, kIndex, kWildcard, kSlice };
+
+  Type type = Type::kKey;
+  std::string key;       // kKey
+  long long index = 0;   // kIndex; negative counts from the end
+  // JSON Pointer tokens made of digits address an object key or an array
+  // index, depending on the container they are applied to
+  bool key_or_index = false;
+  long long slice_start = 0;  // kSlice bounds, Python-style
+  long long slice_end = 0;
+  long long slice_step = 1;
+  bool has_slice_start = false;
+  bool has_slice_end = false;
+};
+
+// Compiled path expression. Accepted syntaxes:
+//   JSONPath:      $.store.books[*].title, $['key'], $.items[1:10:2]
+//   JSON Pointer:  /store/books/0/title
+//   Dotted paths:  store.books[0].title
+class JsonPath {
+ public:
+  JsonPath() = default;
+
+  // Throws JsonPathException if the expression is malformed
+  static JsonPath Compile(const std::string& expression);
+
+  // Compiles a JsonUtils::GetByPath path: keys separated by '.', each
+  // optionally followed by [n] indices. Keys are literal, so "a.*" names
+  // the member "*" and '$' or '/' are ordinary characters; an empty key
+  // between two dots names the member "". Throws JsonPathException if an
+  // index is not a non-negative integer.
+  static JsonPath CompileDotted(const std::string& path);
+
+  // Evaluate against raw JSON text. Subtrees that cannot match are skipped
+  // by jumping over balanced brackets; only matched values are parsed.
+  // Throws JsonParseException if the text is malformed along the way.
+  std::vector<JsonValue> Select(
+      const PaddedJsonBuffer& json,
+      const JsonParserConfig& config = JsonParserConfig::Strict()) const;
+  std::vector<JsonValue> Select(
+      const std::string& json,
+      const JsonParserConfig& config = JsonParserConfig::Strict()) const;
+
+  // Evaluate against a parsed document with one lookup per segment.
+  // Find returns the first match or nullptr; FindAll returns every match
+  // of wildcard and slice segments in container iteration order.
+  const JsonValue* Find(const JsonValue& root) const;
+  JsonValue* Find(JsonValue& root) const;
+  std::vector<const JsonValue*> FindAll(const JsonValue& root) const;
+
+  const std::vector<JsonPathSegment>& Segments() const { return segments_; }
+  const std::string& Expression() const { return expression_; }
+  bool IsRoot() const { return segments_.empty(); }
+  // True if the path can match at most one value
+  bool IsSingular() const { return singular_; }
+
+ private:
+  std::string expression_;
+  std::vector<JsonPathSegment> segments_;
+  bool singular_ = true;
+
+  void CompilePointer(const std::string& expression);
+  void CompileDottedKeys(const std::string& path);
+  void CompileJsonPath(const std::string& expression);
+  // Value is JsonValue or const JsonValue; the mutable walk goes through
+  // the mutable accessors. CollectMatches returns false once visit asks to
+  // stop.
+  template <typename Value>
+  Value* FindFirst(Value& root) const;
+  template <typename Value, typename Visit>
+  bool CollectMatches(Value& value, size_t depth, const Visit& visit) const;
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_PATH_H_
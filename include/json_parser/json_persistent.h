@@ -0,0 +1,128 @@
+#ifndef JSON_PARSER_JSON_PERSISTENT_H_
+#define JSON_PARSER_JSON_PERSISTENT_H_
+
+#include "json_exception.h"
+#include "json_path.h"
+#include "json_value.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <variant>
+
+namespace json_parser {
+
+namespace internal {
+struct PersistentObject;
+struct PersistentArray;
+}  // namespace internal
+
+// Immutable JSON value. Every update returns a new version that shares all
+// untouched nodes with the old one, which stays valid and unchanged, so
+// many versions of one large document cost little more than one, and
+// readers on other threads need no locking.
+//
+// Objects are hash array mapped tries with 32-way bitmap nodes; arrays are
+// 32-way relaxed radix-balanced tries with a separate tail. Lookups and
+// updates, including inserting or erasing array elements at any index,
+// copy one node per level, O(log32 n), and pushing to an array usually
+// only copies its tail.
+//
+// Type mismatches throw JsonTypeException, missing keys JsonKeyException
+// and out-of-range indices JsonException.
+class JsonPersistentValue {
+ public:
+  JsonPersistentValue() = default;
+  explicit JsonPersistentValue(std::nullptr_t) {}
+  explicit JsonPersistentValue(bool b) : value_(b) {}
+  explicit JsonPersistentValue(double num) : value_(num) {}
+  explicit JsonPersistentValue(int num) : value_(static_cast<double>(num)) {}
+  explicit JsonPersistentValue(const std::string& str);
+  explicit JsonPersistentValue(const char* str);
+
+  // Empty containers
+  static JsonPersistentValue Object();
+  static JsonPersistentValue Array();
+
+  // Deep conversions from and to the mutable DOM
+  static JsonPersistentValue FromJsonValue(const JsonValue& value);
+  JsonValue ToJsonValue() const;
+
+  JsonValueType GetType() const;
+  bool IsObject() const { return GetType() == JsonValueType::kObject; }
+  bool IsArray() const { return GetType() == JsonValueType::kArray; }
+  bool IsString() const { return GetType() == JsonValueType::kString; }
+  bool IsNumber() const { return GetType() == JsonValueType::kNumber; }
+  bool IsBoolean() const { return GetType() == JsonValueType::kBoolean; }
+  bool IsNull() const { return GetType() == JsonValueType::kNull; }
+
+  bool AsBoolean() const;
+  double AsNumber() const;
+  const std::string& AsString() const;
+
+  // Member count of an object or element count of an array
+  size_t Size() const;
+  bool Empty() const { return Size() == 0; }
+
+  // Object members. ForEachMember visits them in hash order, which depends
+  // only on the set of keys.
+  const JsonPersistentValue* Find(const std::string& key) const;
+  bool Contains(const std::string& key) const { return Find(key) != nullptr; }
+  const JsonPersistentValue& operator[](const std::string& key) const;
+  JsonPersistentValue Set(const std::string& key,
+                          JsonPersistentValue value) const;
+  // Returns *this if key is absent
+  JsonPersistentValue Erase(const std::string& key) const;
+  void ForEachMember(
+      const std::function<void(const std::string&,
+                               const JsonPersistentValue&)>& visit) const;
+
+  // Array elements
+  const JsonPersistentValue& operator[](size_t index) const;
+  JsonPersistentValue Set(size_t index, JsonPersistentValue value) const;
+  JsonPersistentValue PushBack(JsonPersistentValue value) const;
+  JsonPersistentValue PopBack() const;
+  // Shift the later elements by one; index may equal Size() for Insert
+  JsonPersistentValue Insert(size_t index, JsonPersistentValue value) const;
+  JsonPersistentValue Erase(size_t index) const;
+
+  // Updates through a singular path (key and index segments), copying only
+  // the containers along it. SetIn replaces the target or adds it as a new
+  // object member; every container before it must exist. Wildcards,
+  // slices and missing parents throw JsonPathException.
+  const JsonPersistentValue* FindIn(const JsonPath& path) const;
+  JsonPersistentValue SetIn(const JsonPath& path,
+                            JsonPersistentValue value) const;
+  JsonPersistentValue EraseIn(const JsonPath& path) const;
+
+  // Deep comparison that skips subtrees the two versions share
+  bool operator==(const JsonPersistentValue& other) const;
+  bool operator!=(const JsonPersistentValue& other) const {
+    return !(*this == other);
+  }
+
+  // True if both refer to the same container or string node, as when one
+  // version was derived from the other without touching this subtree
+  bool SharesStorageWith(const JsonPersistentValue& other) const;
+
+ private:
+  using ObjectPtr = std::shared_ptr<const internal::PersistentObject>;
+  using ArrayPtr = std::shared_ptr<const internal::PersistentArray>;
+
+  std::variant<std::nullptr_t, bool, double, std::shared_ptr<const std::string>,
+               ObjectPtr, ArrayPtr>
+      value_;
+
+  explicit JsonPersistentValue(ObjectPtr object) : value_(std::move(object)) {}
+  explicit JsonPersistentValue(ArrayPtr array) : value_(std::move(array)) {}
+
+  const internal::PersistentObject& ObjectData() const;
+  const internal::PersistentArray& ArrayData() const;
+  JsonPersistentValue SetIn(const JsonPath& path, size_t segment,
+                            const JsonPersistentValue* value) const;
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_PERSISTENT_H_
@@ -0,0 +1,51 @@
+#ifndef JSON_PARSER_JSON_PROJECTION_H_
+#define JSON_PARSER_JSON_PROJECTION_H_
+
+#include "json_exception.h"
+#include "json_path.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace json_parser {
+
+// Field mask tree selecting which object members the parser materializes.
+// Paths use JsonPath syntax restricted to keys and wildcards, e.g.
+// "user.id" or "items[*].sku". Arrays are transparent: a mask applied to an
+// array applies to each of its elements, so "items.sku" is equivalent to
+// "items[*].sku". Members outside the mask are validated and skipped
+// without building strings or containers.
+class JsonProjection {
+ public:
+  JsonProjection() = default;
+  JsonProjection(JsonProjection&& other) noexcept = default;
+  JsonProjection& operator=(JsonProjection&& other) noexcept = default;
+  ~JsonProjection();
+
+  // Build from a list of paths
+  static JsonProjection FromPaths(const std::vector<std::string>& paths);
+
+  // Add a path to the mask. Throws JsonPathException for malformed paths
+  // or paths containing indices or slices.
+  JsonProjection& Include(const std::string& path);
+
+  // Mask for the member named key, or nullptr if it is excluded
+  const JsonProjection* Child(const std::string& key) const;
+
+  // True if the whole subtree under this node is kept
+  bool IncludesAll() const { return include_all_; }
+
+ private:
+  bool include_all_ = false;
+  std::unordered_map<std::string, std::unique_ptr<JsonProjection>> children_;
+  std::unique_ptr<JsonProjection> wildcard_;
+
+  void Insert(const std::vector<JsonPathSegment>& segments, size_t index);
+  std::unique_ptr<JsonProjection> Clone() const;
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_PROJECTION_H_
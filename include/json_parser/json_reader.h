@@ -0,0 +1,87 @@
+#ifndef JSON_PARSER_JSON_READER_H_
+#define JSON_PARSER_JSON_READER_H_
+
+#include "json_exception.h"
+#include "json_padded_buffer.h"
+#include "json_parser.h"
+#include "json_value.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace json_parser {
+
+// Pull reader over JSON text. Callers ask for the token they expect next,
+// so values can be decoded straight into their own types without building
+// a JsonValue tree. Syntax errors throw JsonParseException; asking for a
+// type other than the one present throws JsonTypeException. Comments are
+// not supported.
+class JsonReader {
+ public:
+  // The buffer must outlive the reader
+  explicit JsonReader(const PaddedJsonBuffer& input,
+                      const JsonParserConfig& config = JsonParserConfig::Strict());
+
+  // Type of the next value, without consuming it
+  JsonValueType PeekType();
+
+  // Objects: BeginObject, then NextKey until it returns false. Each true
+  // return must be followed by reading or skipping the member value.
+  void BeginObject();
+  bool NextKey(std::string& key);
+
+  // Arrays: BeginArray, then NextElement until it returns false. Each true
+  // return must be followed by reading or skipping the element.
+  void BeginArray();
+  bool NextElement();
+
+  // Scalars
+  std::string ReadString();
+  void ReadString(std::string& out);
+  double ReadDouble();
+  int64_t ReadInt64();
+  uint64_t ReadUInt64();
+  bool ReadBool();
+  void ReadNull();
+
+  // Read a number. Returns true and sets integer when the literal is an
+  // integer that fits in int64_t; otherwise returns false and sets number.
+  bool ReadNumber(int64_t& integer, double& number);
+
+  // Materialize the next value as a JsonValue
+  JsonValue ReadValue();
+
+  // Validate and skip the next value without materializing it
+  void SkipValue();
+
+  // Throws unless only whitespace remains
+  void ExpectEnd();
+
+  size_t Position() const { return position_; }
+
+ private:
+  const char* input_;
+  size_t length_;
+  size_t position_ = 0;
+  JsonParserConfig config_;
+  // One entry per open container: true until its first member is read
+  std::vector<bool> first_;
+
+  [[noreturn]] void Fail(const std::string& message) const;
+  void SkipWhitespace();
+  void ExpectType(JsonValueType expected);
+  void PushContainer();
+  void SkipString();
+  // Validates the number at position_ and returns its end. Sets is_integer
+  // if it has no fraction or exponent.
+  size_t ScanNumber(bool& is_integer) const;
+  double ParseDouble(size_t end);
+  // Parses the integer literal [position_, end); false on overflow
+  bool ParseInteger(size_t end, int64_t& value) const;
+  uint32_t ReadHex4();
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_READER_H_
@@ -0,0 +1,56 @@
+#ifndef JSON_PARSER_JSON_SCHEMA_H_
+#define JSON_PARSER_JSON_SCHEMA_H_
+
+#include "json_exception.h"
+#include "json_padded_buffer.h"
+#include "json_parser.h"
+#include "json_value.h"
+
+#include <memory>
+#include <string>
+
+namespace json_parser {
+
+// JSON Schema (draft 2020-12 subset) compiled into a flat validation
+// program. Supported keywords:
+//   type, enum, const,
+//   minimum, maximum, exclusiveMinimum, exclusiveMaximum, multipleOf,
+//   minLength, maxLength, pattern,
+//   items, prefixItems, contains, minItems, maxItems, uniqueItems,
+//   properties, patternProperties, additionalProperties, required,
+//   minProperties, maxProperties, propertyNames, dependentRequired,
+//   allOf, anyOf, oneOf, not, if/then/else, $ref (local "#..." only), $defs.
+// Annotation keywords are ignored; keywords that would change the result
+// but are not supported (unevaluated*, $dynamicRef) are rejected at compile
+// time. Compiled schemas are immutable and cheap to copy.
+class JsonSchema {
+ public:
+  // Throw JsonSchemaException for unsupported or malformed schemas
+  static JsonSchema Compile(const JsonValue& schema);
+  static JsonSchema Compile(const std::string& schema_json);
+
+  // Check value against the schema. On failure, error (if given) receives
+  // the instance location and the failing keyword.
+  bool Validate(const JsonValue& value, std::string* error = nullptr) const;
+
+  // Parse json while validating it. Each value is checked as soon as it has
+  // been read, so an invalid document is rejected with JsonSchemaException
+  // before the rest of it is materialized.
+  JsonValue ParseValidated(
+      const PaddedJsonBuffer& json,
+      const JsonParserConfig& config = JsonParserConfig::Strict()) const;
+  JsonValue ParseValidated(
+      const std::string& json,
+      const JsonParserConfig& config = JsonParserConfig::Strict()) const;
+
+  struct Program;
+
+ private:
+  explicit JsonSchema(std::shared_ptr<const Program> program);
+
+  std::shared_ptr<const Program> program_;
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_SCHEMA_H_
@@ -0,0 +1,121 @@
+#ifndef JSON_PARSER_JSON_SNAPSHOT_H_
+#define JSON_PARSER_JSON_SNAPSHOT_H_
+
+#include "json_exception.h"
+#include "json_value.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace json_parser {
+
+// Read-only view of one value inside a JsonSnapshot. Views are three words
+// (the snapshot's base and size, and the value's ref) and valid as long as
+// the snapshot they came from. Every offset is checked against the snapshot
+// size, so corrupt input throws JsonParseException instead of reading out
+// of bounds; type mismatches throw JsonTypeException.
+class JsonSnapshotView {
+ public:
+  JsonValueType GetType() const;
+  bool IsObject() const { return GetType() == JsonValueType::kObject; }
+  bool IsArray() const { return GetType() == JsonValueType::kArray; }
+  bool IsString() const { return GetType() == JsonValueType::kString; }
+  bool IsNumber() const { return GetType() == JsonValueType::kNumber; }
+  bool IsBoolean() const { return GetType() == JsonValueType::kBoolean; }
+  bool IsNull() const { return GetType() == JsonValueType::kNull; }
+
+  double AsNumber() const;
+  bool AsBoolean() const;
+  // Points into the snapshot; no copy is made
+  std::string_view AsString() const;
+
+  // Element count of an array or member count of an object
+  size_t Size() const;
+
+  // Array elements
+  JsonSnapshotView operator[](size_t index) const { return At(index); }
+  JsonSnapshotView At(size_t index) const;
+
+  // Object members, in bytewise key order. Lookups binary-search the
+  // sorted key table.
+  std::string_view KeyAt(size_t index) const;
+  JsonSnapshotView ValueAt(size_t index) const;
+  std::optional<JsonSnapshotView> Find(std::string_view key) const;
+  JsonSnapshotView operator[](std::string_view key) const;
+  bool Contains(std::string_view key) const { return Find(key).has_value(); }
+
+  // Copy the subtree into a JsonValue
+  JsonValue ToJsonValue() const;
+
+ private:
+  friend class JsonSnapshot;
+
+  JsonSnapshotView(const char* base, size_t size, uint64_t ref)
+      : base_(base), size_(size), ref_(ref) {}
+
+  const char* base_;
+  size_t size_;
+  uint64_t ref_;
+
+  uint64_t Tag() const { return ref_ & 7; }
+  uint64_t Offset() const { return ref_ >> 3; }
+  void Expect(JsonValueType type) const;
+  uint64_t Load(uint64_t offset) const;
+  // Offset of a container's first entry, after checking it holds count
+  // entries of entry_size bytes
+  uint64_t Entries(uint64_t& count, size_t entry_size) const;
+  std::string_view StringAt(uint64_t offset) const;
+  JsonValue ToJsonValue(size_t depth) const;
+};
+
+// Position-independent binary snapshot of a document, designed to be
+// mapped into memory and queried without parsing or allocation.
+//
+// Layout (little-endian, every record 8-byte aligned):
+//   header: "JSNP", u32 version, u64 total size, u64 root ref, u64 reserved
+//   ref:    u64 (offset << 3 | tag); null/false/true carry no offset
+//   number: f64
+//   string: u64 length, bytes, NUL
+//   array:  u64 count, ref[count]
+//   object: u64 count, {u64 key string offset, ref}[count] sorted by key
+// Object keys are stored once per distinct key.
+class JsonSnapshot {
+ public:
+  JsonSnapshot(JsonSnapshot&& other) noexcept;
+  JsonSnapshot& operator=(JsonSnapshot&& other) noexcept;
+  JsonSnapshot(const JsonSnapshot&) = delete;
+  JsonSnapshot& operator=(const JsonSnapshot&) = delete;
+  ~JsonSnapshot();
+
+  // Serialize a document into the snapshot format
+  static std::string Encode(const JsonValue& value);
+  static void WriteFile(const JsonValue& value, const std::string& filename);
+
+  // Map a snapshot file read-only. Falls back to reading it into memory on
+  // platforms without mmap.
+  static JsonSnapshot Open(const std::string& filename);
+
+  // View caller-owned bytes, which must outlive the snapshot
+  static JsonSnapshot FromBuffer(const char* data, size_t size);
+
+  JsonSnapshotView Root() const;
+  size_t Size() const { return size_; }
+
+ private:
+  JsonSnapshot() = default;
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  void* mapping_ = nullptr;
+  std::unique_ptr<char[]> storage_;
+
+  void ValidateHeader() const;
+  void Release();
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_SNAPSHOT_H_
@@ -0,0 +1,113 @@
+#ifndef JSON_PARSER_JSON_STREAM_WRITER_H_
+#define JSON_PARSER_JSON_STREAM_WRITER_H_
+
+#include "json_exception.h"
+#include "json_output_buffer.h"
+#include "json_value.h"
+#include "json_writer.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json_parser {
+
+// Writes JSON token by token, without building a JsonValue tree, so output
+// of any size needs only the output buffer's memory. Calls are checked
+// against the open containers: a key outside an object, a value where a
+// key is due, a mismatched End call or a second top-level value throws
+// JsonException. Formatting follows JsonWriterConfig (pretty_print,
+// indent_size, escape_unicode, max_depth, canonical) and matches
+// JsonWriter's layout. In canonical mode keys are written in the order
+// given; subtrees passed to Value are sorted like JsonWriter sorts them.
+//
+//   JsonStreamWriter writer(fd);
+//   writer.BeginArray();
+//   for (const Row& row : rows) {
+//     writer.BeginObject().Key("id").Int64(row.id).EndObject();
+//   }
+//   writer.EndArray();
+class JsonStreamWriter {
+ public:
+  // Append to a caller-owned buffer, which drains to its own sink if it
+  // has one
+  explicit JsonStreamWriter(JsonOutputBuffer& out,
+                            const JsonWriterConfig& config = JsonWriterConfig::Compact());
+  // Write to a stream or an open file descriptor (not closed), flushing
+  // whenever flush_threshold bytes are buffered
+  explicit JsonStreamWriter(std::ostream& os,
+                            const JsonWriterConfig& config = JsonWriterConfig::Compact(),
+                            size_t flush_threshold = JsonOutputBuffer::kDefaultFlushThreshold);
+  explicit JsonStreamWriter(int fd,
+                            const JsonWriterConfig& config = JsonWriterConfig::Compact(),
+                            size_t flush_threshold = JsonOutputBuffer::kDefaultFlushThreshold);
+  JsonStreamWriter(const JsonStreamWriter&) = delete;
+  JsonStreamWriter& operator=(const JsonStreamWriter&) = delete;
+  ~JsonStreamWriter();
+
+  // Containers
+  JsonStreamWriter& BeginObject();
+  JsonStreamWriter& EndObject();
+  JsonStreamWriter& BeginArray();
+  JsonStreamWriter& EndArray();
+
+  // Object member name; must be followed by exactly one value
+  JsonStreamWriter& Key(std::string_view key);
+
+  // Scalars
+  JsonStreamWriter& String(std::string_view value);
+  JsonStreamWriter& Int64(int64_t value);
+  JsonStreamWriter& UInt64(uint64_t value);
+  JsonStreamWriter& Double(double value);
+  JsonStreamWriter& Bool(bool value);
+  JsonStreamWriter& Null();
+
+  // Write an existing subtree in place, with JsonWriter. As with
+  // JsonWriter::WriteToBuffer, a gathering buffer references long strings
+  // of value, which must then outlive the buffer's next Flush().
+  JsonStreamWriter& Value(const JsonValue& value);
+
+  // Push buffered bytes to the stream or descriptor
+  void Flush();
+
+  // Nesting depth of the current position; 0 at top level
+  size_t Depth() const { return depth_; }
+
+  // True once a complete top-level value has been written
+  bool IsComplete() const { return depth_ == 0 && complete_; }
+
+ private:
+  std::unique_ptr<JsonOutputBuffer> owned_;
+  JsonOutputBuffer* out_;
+  // Writes numbers and Value subtrees
+  JsonWriter writer_;
+  // writer_'s configuration, with the canonical overrides applied
+  const JsonWriterConfig& config_;
+  // One bit per open container, set for objects
+  std::vector<uint64_t> nesting_;
+  size_t depth_ = 0;
+  // The innermost container has no members yet
+  bool first_ = true;
+  // A key was written and its value is due
+  bool after_key_ = false;
+  bool complete_ = false;
+  std::string newline_indent_;
+
+  bool InObject() const {
+    return depth_ > 0 &&
+           ((nesting_[(depth_ - 1) / 64] >> ((depth_ - 1) % 64)) & 1) != 0;
+  }
+  void InitIndent();
+  void BeforeValue();
+  void AfterValue();
+  void Push(bool is_object);
+  void Pop(bool is_object);
+  void WriteNewline(size_t depth);
+};
+
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_JSON_STREAM_WRITER_H_
@@ -3,6 +3,7 @@
 
 #include "json_value.h"
 
+#include <cstddef>
 #include <string>
 
 namespace json_parser {
@@ -22,7 +23,9 @@ class JsonUtils {
                               const std::string& default_val = "");
   static bool AsBool(const JsonValue& value, bool default_val = false);
 
-  // Path-based access (e.g., "user.name" or "items[0]")
+  // Path-based access (e.g., "user.name" or "items[0]"). Keys are literal
+  // (see JsonPath::CompileDotted); a malformed index yields nullptr.
+  // Compiles the path on every call; use JsonPath directly to reuse it.
   static JsonValue* GetByPath(JsonValue& root, const std::string& path);
   static const JsonValue* GetByPath(const JsonValue& root,
                                      const std::string& path);
@@ -31,6 +34,13 @@ class JsonUtils {
   // Deep copy
   static JsonValue DeepCopy(const JsonValue& value);
 
+  // Replace equal object and array subtrees of value by one shared
+  // container each (hash-consing). Interned containers are copied on
+  // write: JsonValue::AsObject and AsArray give the value they are called
+  // on its own copy first, so editing one occurrence leaves the others
+  // unchanged. Returns the number of containers replaced.
+  static size_t Intern(JsonValue& value);
+
   // Merge two JSON objects
   static JsonObject Merge(const JsonObject& obj1, const JsonObject& obj2,
                           bool overwrite = true);
@@ -1,9 +1,13 @@
 #ifndef JSON_PARSER_JSON_VALUE_H_
 #define JSON_PARSER_JSON_VALUE_H_
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <variant>
+#include <vector>
 
 namespace json_parser {
 
@@ -11,6 +15,58 @@ namespace json_parser {
 class JsonObject;
 class JsonArray;
 
+namespace internal {
+
+class JsonInterner;
+
+// Lazily computed structural hash of a container (see JsonValue::Hash).
+//
+// Containers do not own links to their parents and may be shared, so each
+// cache keeps weak links to the caches of the containers whose hashes were
+// computed from it. Clearing a valid cache clears those as well, and
+// theirs in turn: a modification retires the hash of the container and of
+// the ancestors that included it, and every other cached hash stays valid.
+// Modifying a container with nothing cached (building, parsing) stops at
+// once.
+class HashCache {
+ public:
+  HashCache() = default;
+  // Copies start empty, since the children they share only know the
+  // original as a container hashed from them. Moves clear the source.
+  HashCache(const HashCache& other) noexcept;
+  HashCache(HashCache&& other) noexcept;
+  HashCache& operator=(const HashCache& other) noexcept;
+  HashCache& operator=(HashCache&& other) noexcept;
+  ~HashCache() = default;
+
+  // Sets *hash and returns true if a hash is cached
+  bool Get(uint64_t* hash) const;
+  void Set(uint64_t hash) const;
+  // Records that parent's hash was computed from this container's
+  void AddDependent(std::weak_ptr<const HashCache> parent) const;
+  // Called before the owning container is modified
+  void Invalidate() const {
+    if (valid_.load(std::memory_order_acquire)) {
+      InvalidateSlow();
+    }
+  }
+
+ private:
+  mutable std::atomic<uint64_t> hash_{0};
+  mutable std::atomic<bool> valid_{false};
+  // Guards the dependents, which concurrent readers may add to
+  mutable std::atomic<bool> locked_{false};
+  // Nearly every container has one parent, kept inline; shared ones spill
+  // into more_dependents_, which is compacted as it grows
+  mutable std::weak_ptr<const HashCache> dependent_;
+  mutable std::vector<std::weak_ptr<const HashCache>> more_dependents_;
+  mutable size_t compacted_size_ = 0;
+
+  void InvalidateSlow() const;
+};
+
+}  // namespace internal
+
 // JSON value types
 enum class JsonValueType {
   kObject,
@@ -53,7 +109,9 @@ class JsonValue {
   bool IsBoolean() const { return type_ == JsonValueType::kBoolean; }
   bool IsNull() const { return type_ == JsonValueType::kNull; }
 
-  // Type-safe accessors
+  // Type-safe accessors. The mutable container accessors first give this
+  // value its own copy of an interned container other values share (see
+  // JsonUtils::Intern), so changes stay with this occurrence.
   JsonObject& AsObject();
   const JsonObject& AsObject() const;
   JsonArray& AsArray();
@@ -73,11 +131,25 @@ class JsonValue {
   double AsNumberOrDefault(double default_val) const;
   bool AsBooleanOrDefault(bool default_val) const;
 
-  // Comparison operators
+  // Comparison operators. Containers shared by both sides compare equal
+  // without being visited, and containers whose hashes are both cached
+  // compare unequal at once if the hashes differ. Numbers compare exactly,
+  // except that 0 and -0 are equal.
   bool operator==(const JsonValue& other) const;
   bool operator!=(const JsonValue& other) const;
 
-  // String representation
+  // 64-bit structural hash, consistent with operator== (member order does
+  // not matter). Container hashes are cached. Modifying a container, or
+  // taking a mutable reference or iterator into it, clears its hash and the
+  // hashes of the containers that were hashed from it; const access clears
+  // nothing. References into a container taken before it was hashed must
+  // not be used to modify it afterwards. Hashes are not stable across
+  // processes.
+  uint64_t Hash() const;
+
+  // String representation. ToString indents nested entries two spaces
+  // past indent; ToCompactString has no whitespace. Both size the result
+  // exactly before writing it.
   std::string ToString(int indent = 0) const;
   std::string ToCompactString() const;
 
@@ -89,9 +161,24 @@ class JsonValue {
 
   // Helper methods for type checking in accessors
   void ValidateType(JsonValueType expected) const;
+  // Links a container child's hash cache to its parent's (see HashCache)
+  static void AddDependent(
+      const JsonValue& child,
+      const std::weak_ptr<const internal::HashCache>& parent);
 };
 
 }  // namespace json_parser
 
+namespace std {
+
+template <>
+struct hash<json_parser::JsonValue> {
+  size_t operator()(const json_parser::JsonValue& value) const {
+    return static_cast<size_t>(value.Hash());
+  }
+};
+
+}  // namespace std
+
 #endif  // JSON_PARSER_JSON_VALUE_H_
 
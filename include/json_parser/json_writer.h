@@ -3,7 +3,10 @@
 
 #include "json_value.h"
 #include "json_exception.h"
+#include "json_output_buffer.h"
 
+#include <cstddef>
+#include <functional>
 #include <iosfwd>
 #include <string>
 
@@ -15,7 +18,20 @@ struct JsonWriterConfig {
   int indent_size = 2;
   bool escape_unicode = false;
   bool sort_keys = false;
+  // RFC 8785 JSON Canonicalization Scheme, for signing and content hashing:
+  // no whitespace, keys sorted by UTF-16 code units, numbers as ECMAScript
+  // prints them and only the escapes JSON requires. Overrides pretty_print,
+  // escape_unicode and sort_keys. Non-finite numbers throw JsonException.
+  bool canonical = false;
   int max_depth = 1000;
+  // Arrays and objects with at least parallel_min_elements entries are
+  // serialized in chunks on this many threads (0 means one per hardware
+  // thread) and spliced back in order, so the output is byte-for-byte the
+  // same as with one thread. Only the outermost such container is split.
+  // The threads come from a library-wide pool that is started on first use
+  // and kept, so repeated writes do not pay for thread creation.
+  int threads = 1;
+  size_t parallel_min_elements = 65536;
 
   static JsonWriterConfig Compact() {
     JsonWriterConfig config;
@@ -23,6 +39,14 @@ struct JsonWriterConfig {
     return config;
   }
 
+  static JsonWriterConfig Canonical() {
+    JsonWriterConfig config;
+    config.canonical = true;
+    config.pretty_print = false;
+    config.sort_keys = true;
+    return config;
+  }
+
   static JsonWriterConfig Pretty() {
     JsonWriterConfig config;
     config.pretty_print = true;
@@ -42,32 +66,58 @@ class JsonWriter {
   std::string Write(const JsonObject& obj) const;
   std::string Write(const JsonArray& arr) const;
 
-  // Write to stream
+  // Append to a caller-owned buffer. This is the core every other overload
+  // goes through; reusing one buffer across calls avoids reallocating. A
+  // gathering buffer references long strings of the value instead of
+  // copying them, so the value must outlive the buffer's next Flush().
+  void WriteToBuffer(JsonOutputBuffer& out, const JsonValue& value) const;
+  void WriteToBuffer(JsonOutputBuffer& out, const JsonObject& obj) const;
+  void WriteToBuffer(JsonOutputBuffer& out, const JsonArray& arr) const;
+
+  // Write to stream, in chunks of JsonOutputBuffer's flush threshold
   void WriteToStream(std::ostream& os, const JsonValue& value) const;
   void WriteToStream(std::ostream& os, const JsonObject& obj) const;
   void WriteToStream(std::ostream& os, const JsonArray& arr) const;
 
-  // Write to file
+  // Write to file. Names ending in ".gz" are gzip-compressed on a
+  // background thread. Otherwise, on POSIX systems, this goes through
+  // WriteToFileDescriptor, so long strings are not copied.
   void WriteToFile(const std::string& filename, const JsonValue& value) const;
 
+  // Write to an open file descriptor, which is not closed. Output is
+  // gathered into segments that reference long strings in place and is
+  // flushed with writev.
+  void WriteToFileDescriptor(int fd, const JsonValue& value) const;
+
   // Update configuration
-  void SetConfig(const JsonWriterConfig& config) { config_ = config; }
+  void SetConfig(const JsonWriterConfig& config);
   const JsonWriterConfig& GetConfig() const { return config_; }
 
  private:
+  // Writes subtrees passed to JsonStreamWriter::Value in place
+  friend class JsonStreamWriter;
+
   JsonWriterConfig config_;
+  // A newline followed by spaces, sliced to emit line breaks plus
+  // indentation in one append
+  std::string newline_indent_;
 
   // Helper methods
-  void WriteValue(std::ostream& os, const JsonValue& value, int indent,
+  void WriteValue(JsonOutputBuffer& out, const JsonValue& value, int indent,
                   int depth) const;
-  void WriteObject(std::ostream& os, const JsonObject& obj, int indent,
+  void WriteObject(JsonOutputBuffer& out, const JsonObject& obj, int indent,
                    int depth) const;
-  void WriteArray(std::ostream& os, const JsonArray& arr, int indent,
+  void WriteArray(JsonOutputBuffer& out, const JsonArray& arr, int indent,
                   int depth) const;
-  void WriteString(std::ostream& os, const std::string& str) const;
-  void WriteNumber(std::ostream& os, double num) const;
-  void WriteIndent(std::ostream& os, int indent) const;
-  std::string EscapeString(const std::string& str) const;
+  void WriteString(JsonOutputBuffer& out, const std::string& str) const;
+  void WriteNumber(JsonOutputBuffer& out, double num) const;
+  void WriteNewline(JsonOutputBuffer& out, int indent) const;
+  bool ShouldWriteInParallel(size_t count) const;
+  // Writes count container entries, each preceded by its separator and
+  // indentation, using worker threads. write_entry(out, i) writes entry i.
+  void WriteInParallel(
+      JsonOutputBuffer& out, size_t count, int indent,
+      const std::function<void(JsonOutputBuffer&, size_t)>& write_entry) const;
 };
 
 }  // namespace json_parser
@@ -1,10 +1,14 @@
 #include "json_parser/json_array.h"
 #include "json_parser/json_exception.h"
+#include "json_to_string.h"
+
+#include <utility>
 
 namespace json_parser {
 
 // Element access
 JsonValue& JsonArray::operator[](size_t index) {
+  hash_cache_.Invalidate();
   if (index >= values_.size()) {
     throw JsonException("Array index out of bounds: " +
                         std::to_string(index));
@@ -21,6 +25,7 @@ const JsonValue& JsonArray::operator[](size_t index) const {
 }
 
 JsonValue& JsonArray::At(size_t index) {
+  hash_cache_.Invalidate();
   if (index >= values_.size()) {
     throw JsonException("Array index out of bounds: " +
                         std::to_string(index));
@@ -37,6 +42,7 @@ const JsonValue& JsonArray::At(size_t index) const {
 }
 
 JsonValue& JsonArray::Front() {
+  hash_cache_.Invalidate();
   if (values_.empty()) {
     throw JsonException("Array is empty");
   }
@@ -51,6 +57,7 @@ const JsonValue& JsonArray::Front() const {
 }
 
 JsonValue& JsonArray::Back() {
+  hash_cache_.Invalidate();
   if (values_.empty()) {
     throw JsonException("Array is empty");
   }
@@ -66,14 +73,17 @@ const JsonValue& JsonArray::Back() const {
 
 // Modifiers
 void JsonArray::PushBack(const JsonValue& value) {
+  hash_cache_.Invalidate();
   values_.push_back(value);
 }
 
 void JsonArray::PushBack(JsonValue&& value) {
+  hash_cache_.Invalidate();
   values_.push_back(std::move(value));
 }
 
 void JsonArray::PopBack() {
+  hash_cache_.Invalidate();
   if (values_.empty()) {
     throw JsonException("Cannot pop from empty array");
   }
@@ -81,6 +91,7 @@ void JsonArray::PopBack() {
 }
 
 void JsonArray::Insert(size_t index, const JsonValue& value) {
+  hash_cache_.Invalidate();
   if (index > values_.size()) {
     throw JsonException("Array index out of bounds: " +
                         std::to_string(index));
@@ -88,7 +99,17 @@ void JsonArray::Insert(size_t index, const JsonValue& value) {
   values_.insert(values_.begin() + index, value);
 }
 
+void JsonArray::Insert(size_t index, JsonValue&& value) {
+  hash_cache_.Invalidate();
+  if (index > values_.size()) {
+    throw JsonException("Array index out of bounds: " +
+                        std::to_string(index));
+  }
+  values_.insert(values_.begin() + index, std::move(value));
+}
+
 void JsonArray::Erase(size_t index) {
+  hash_cache_.Invalidate();
   if (index >= values_.size()) {
     throw JsonException("Array index out of bounds: " +
                         std::to_string(index));
@@ -98,45 +119,27 @@ void JsonArray::Erase(size_t index) {
 
 // String representation
 std::string JsonArray::ToString(int indent) const {
-  if (values_.empty()) {
-    return "[]";
-  }
-
-  std::string result = "[\n";
-  std::string indent_str(indent + 2, ' ');
-
-  for (size_t i = 0; i < values_.size(); ++i) {
-    if (i > 0) {
-      result += ",\n";
-    }
-    result += indent_str + values_[i].ToString(indent + 2);
-  }
-
-  result += "\n" + std::string(indent, ' ') + "]";
-  return result;
+  return internal::ToJsonString(*this, /*pretty=*/true, indent);
 }
 
 std::string JsonArray::ToCompactString() const {
-  if (values_.empty()) {
-    return "[]";
-  }
-
-  std::string result = "[";
-  for (size_t i = 0; i < values_.size(); ++i) {
-    if (i > 0) {
-      result += ",";
-    }
-    result += values_[i].ToCompactString();
-  }
-  result += "]";
-  return result;
+  return internal::ToJsonString(*this, /*pretty=*/false, 0);
 }
 
 // Comparison
 bool JsonArray::operator==(const JsonArray& other) const {
+  if (this == &other) {
+    return true;
+  }
   if (values_.size() != other.values_.size()) {
     return false;
   }
+  uint64_t hash = 0;
+  uint64_t other_hash = 0;
+  if (hash_cache_.Get(&hash) && other.hash_cache_.Get(&other_hash) &&
+      hash != other_hash) {
+    return false;
+  }
 
   for (size_t i = 0; i < values_.size(); ++i) {
     if (values_[i] != other.values_[i]) {
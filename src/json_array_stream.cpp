@@ -0,0 +1,169 @@
+#include "json_parser/json_array_stream.h"
+#include "json_parser/json_exception.h"
+#include "json_parser/json_gzip.h"
+
+#include <cctype>
+#include <fstream>
+#include <istream>
+#include <utility>
+
+namespace json_parser {
+
+JsonArrayStream::JsonArrayStream(std::istream& input,
+                                 const JsonParserConfig& config,
+                                 size_t buffer_size)
+    : input_(&input),
+      parser_(config),
+      chunk_size_(buffer_size > 0 ? buffer_size : 1) {}
+
+JsonArrayStream::JsonArrayStream(const std::string& filename,
+                                 const JsonParserConfig& config,
+                                 size_t buffer_size)
+    : parser_(config), chunk_size_(buffer_size > 0 ? buffer_size : 1) {
+  if (JsonGzip::IsGzipFile(filename)) {
+    // Elements are parsed while the next block is inflated
+    file_.reset(new JsonGzipInputStream(filename));
+  } else {
+    std::unique_ptr<std::ifstream> file(
+        new std::ifstream(filename, std::ios::binary));
+    if (!file->is_open()) {
+      throw JsonFileException(filename);
+    }
+    file_ = std::move(file);
+  }
+  input_ = file_.get();
+}
+
+JsonArrayStream::JsonArrayStream(JsonArrayStream&& other) noexcept = default;
+JsonArrayStream& JsonArrayStream::operator=(JsonArrayStream&& other) noexcept =
+    default;
+JsonArrayStream::~JsonArrayStream() = default;
+
+bool JsonArrayStream::Next(JsonValue& value) {
+  if (state_ == State::kDone) {
+    return false;
+  }
+
+  if (state_ == State::kStart) {
+    if (!SkipWhitespace() || buffer_[position_] != '[') {
+      throw JsonParseException("Root value is not an array", Offset());
+    }
+    ++position_;
+    if (!SkipWhitespace()) {
+      throw JsonParseException("Unexpected end of input", Offset());
+    }
+    if (buffer_[position_] == ']') {
+      ++position_;
+      Finish();
+      return false;
+    }
+    state_ = State::kInArray;
+  } else {
+    if (!SkipWhitespace()) {
+      throw JsonParseException("Unexpected end of input", Offset());
+    }
+    char c = buffer_[position_++];
+    if (c == ']') {
+      Finish();
+      return false;
+    }
+    if (c != ',') {
+      throw JsonParseException("Expected ',' or ']' in array", Offset() - 1);
+    }
+  }
+
+  size_t length = ScanElement();
+  try {
+    value = parser_.ParseString(buffer_.data() + position_, length);
+  } catch (const JsonParseException& e) {
+    throw JsonParseException(
+        "In array element " + std::to_string(count_) + ": " + e.what(),
+        Offset() + e.GetPosition());
+  }
+  position_ += length;
+  ++count_;
+  return true;
+}
+
+bool JsonArrayStream::Refill() {
+  if (position_ > 0) {
+    buffer_.erase(0, position_);
+    consumed_ += position_;
+    position_ = 0;
+  }
+  if (!*input_) {
+    return false;
+  }
+
+  size_t old_size = buffer_.size();
+  buffer_.resize(old_size + chunk_size_);
+  input_->read(&buffer_[old_size], static_cast<std::streamsize>(chunk_size_));
+  size_t read = static_cast<size_t>(input_->gcount());
+  buffer_.resize(old_size + read);
+  return read > 0;
+}
+
+bool JsonArrayStream::SkipWhitespace() {
+  while (true) {
+    while (position_ < buffer_.size() &&
+           std::isspace(static_cast<unsigned char>(buffer_[position_]))) {
+      ++position_;
+    }
+    if (position_ < buffer_.size()) {
+      return true;
+    }
+    if (!Refill()) {
+      return false;
+    }
+  }
+}
+
+size_t JsonArrayStream::ScanElement() {
+  size_t depth = 0;
+  bool in_string = false;
+  bool escaped = false;
+  size_t i = 0;
+
+  while (true) {
+    // Refill only compacts bytes before position_, so i stays valid
+    if (position_ + i >= buffer_.size()) {
+      if (!Refill()) {
+        throw JsonParseException("Unexpected end of input", Offset() + i);
+      }
+      continue;
+    }
+
+    char c = buffer_[position_ + i];
+    if (in_string) {
+      if (escaped) {
+        escaped = false;
+      } else if (c == '\\') {
+        escaped = true;
+      } else if (c == '"') {
+        in_string = false;
+      }
+    } else if (c == '"') {
+      in_string = true;
+    } else if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      if (depth == 0) {
+        return i;
+      }
+      --depth;
+    } else if (c == ',' && depth == 0) {
+      return i;
+    }
+    ++i;
+  }
+}
+
+void JsonArrayStream::Finish() {
+  state_ = State::kDone;
+  if (SkipWhitespace()) {
+    throw JsonParseException("Unexpected characters after JSON value",
+                             Offset());
+  }
+}
+
+}  // namespace json_parser
@@ -0,0 +1,35 @@
+#include "json_parser/json_bind.h"
+#include "json_parser/json_writer.h"
+#include "json_escape.h"
+#include "json_number_format.h"
+
+namespace json_parser {
+namespace internal {
+
+void AppendString(std::string& out, const char* data, size_t length) {
+  out += '"';
+  AppendEscaped(out, data, length, false);
+  out += '"';
+}
+
+void AppendInt64(std::string& out, int64_t value) {
+  char buffer[kMaxNumberLength];
+  out.append(buffer, FormatInt64(buffer, value) - buffer);
+}
+
+void AppendUInt64(std::string& out, uint64_t value) {
+  char buffer[kMaxNumberLength];
+  out.append(buffer, FormatUInt64(buffer, value) - buffer);
+}
+
+void AppendDouble(std::string& out, double value) {
+  char buffer[kMaxNumberLength];
+  out.append(buffer, FormatDouble(buffer, value) - buffer);
+}
+
+void AppendValue(std::string& out, const JsonValue& value) {
+  out += JsonWriter(JsonWriterConfig::Compact()).Write(value);
+}
+
+}  // namespace internal
+}  // namespace json_parser
@@ -0,0 +1,881 @@
+#include "json_parser/json_cbor.h"
+#include "json_parser/json_array.h"
+#include "json_parser/json_bind.h"
+#include "json_parser/json_exception.h"
+#include "json_parser/json_object.h"
+#include "json_parser/json_reader.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace json_parser {
+
+namespace {
+
+constexpr size_t kMaxTranscodeDepth = 1000;
+
+const char* TypeName(JsonCborType type) {
+  switch (type) {
+    case JsonCborType::kUnsigned:
+      return "unsigned integer";
+    case JsonCborType::kNegative:
+      return "negative integer";
+    case JsonCborType::kByteString:
+      return "byte string";
+    case JsonCborType::kTextString:
+      return "text string";
+    case JsonCborType::kArray:
+      return "array";
+    case JsonCborType::kMap:
+      return "map";
+    case JsonCborType::kTag:
+      return "tag";
+    case JsonCborType::kBoolean:
+      return "boolean";
+    case JsonCborType::kNull:
+      return "null";
+    case JsonCborType::kUndefined:
+      return "undefined";
+    case JsonCborType::kSimple:
+      return "simple value";
+    case JsonCborType::kFloat:
+      return "float";
+    case JsonCborType::kBreak:
+      return "break";
+  }
+  return "unknown";
+}
+
+double DecodeHalf(uint16_t half) {
+  int exponent = (half >> 10) & 0x1f;
+  int mantissa = half & 0x3ff;
+  double value;
+  if (exponent == 0) {
+    value = std::ldexp(mantissa, -24);
+  } else if (exponent != 31) {
+    value = std::ldexp(mantissa + 1024, exponent - 25);
+  } else {
+    value = mantissa == 0 ? std::numeric_limits<double>::infinity()
+                          : std::numeric_limits<double>::quiet_NaN();
+  }
+  return (half & 0x8000) ? -value : value;
+}
+
+// RFC 8949 section 6.1 recommends base64url for byte strings in JSON
+std::string Base64Url(std::string_view bytes) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+  std::string result;
+  result.reserve((bytes.size() + 2) / 3 * 4);
+  size_t i = 0;
+  for (; i + 2 < bytes.size(); i += 3) {
+    uint32_t chunk = (static_cast<uint8_t>(bytes[i]) << 16) |
+                     (static_cast<uint8_t>(bytes[i + 1]) << 8) |
+                     static_cast<uint8_t>(bytes[i + 2]);
+    result += kAlphabet[(chunk >> 18) & 0x3f];
+    result += kAlphabet[(chunk >> 12) & 0x3f];
+    result += kAlphabet[(chunk >> 6) & 0x3f];
+    result += kAlphabet[chunk & 0x3f];
+  }
+  size_t rest = bytes.size() - i;
+  if (rest > 0) {
+    uint32_t chunk = static_cast<uint8_t>(bytes[i]) << 16;
+    if (rest == 2) {
+      chunk |= static_cast<uint8_t>(bytes[i + 1]) << 8;
+    }
+    result += kAlphabet[(chunk >> 18) & 0x3f];
+    result += kAlphabet[(chunk >> 12) & 0x3f];
+    if (rest == 2) {
+      result += kAlphabet[(chunk >> 6) & 0x3f];
+    }
+  }
+  return result;
+}
+
+void TranscodeJson(JsonReader& reader, JsonCborWriter& writer,
+                   std::string& scratch) {
+  switch (reader.PeekType()) {
+    case JsonValueType::kObject:
+      reader.BeginObject();
+      writer.BeginIndefiniteMap();
+      while (reader.NextKey(scratch)) {
+        writer.WriteTextString(scratch);
+        TranscodeJson(reader, writer, scratch);
+      }
+      writer.WriteBreak();
+      break;
+    case JsonValueType::kArray:
+      reader.BeginArray();
+      writer.BeginIndefiniteArray();
+      while (reader.NextElement()) {
+        TranscodeJson(reader, writer, scratch);
+      }
+      writer.WriteBreak();
+      break;
+    case JsonValueType::kString:
+      reader.ReadString(scratch);
+      writer.WriteTextString(scratch);
+      break;
+    case JsonValueType::kNumber: {
+      int64_t integer = 0;
+      double number = 0;
+      if (reader.ReadNumber(integer, number)) {
+        writer.WriteInt(integer);
+      } else {
+        writer.WriteNumber(number);
+      }
+      break;
+    }
+    case JsonValueType::kBoolean:
+      writer.WriteBool(reader.ReadBool());
+      break;
+    case JsonValueType::kNull:
+      reader.ReadNull();
+      writer.WriteNull();
+      break;
+  }
+}
+
+void TranscodeCborKey(JsonCborReader& reader, std::string& out,
+                      std::string& scratch) {
+  while (reader.PeekType() == JsonCborType::kTag) {
+    reader.ReadTag();
+  }
+  switch (reader.PeekType()) {
+    case JsonCborType::kTextString: {
+      std::string_view key = reader.ReadTextString(scratch);
+      internal::AppendString(out, key.data(), key.size());
+      break;
+    }
+    case JsonCborType::kUnsigned:
+      out += '"';
+      internal::AppendUInt64(out, reader.ReadUInt64());
+      out += '"';
+      break;
+    case JsonCborType::kNegative:
+      out += '"';
+      internal::AppendInt64(out, reader.ReadInt64());
+      out += '"';
+      break;
+    default:
+      throw JsonTypeException("CBOR map keys must be strings or integers at "
+                              "position " + std::to_string(reader.Position()));
+  }
+}
+
+void TranscodeCbor(JsonCborReader& reader, std::string& out,
+                   std::string& scratch, size_t depth) {
+  if (depth > kMaxTranscodeDepth) {
+    throw JsonParseException("Maximum nesting depth exceeded",
+                             reader.Position());
+  }
+  switch (reader.PeekType()) {
+    case JsonCborType::kUnsigned:
+      internal::AppendUInt64(out, reader.ReadUInt64());
+      break;
+    case JsonCborType::kNegative:
+    case JsonCborType::kFloat: {
+      int64_t integer = 0;
+      double number = 0;
+      if (reader.ReadNumber(integer, number)) {
+        internal::AppendInt64(out, integer);
+      } else {
+        internal::AppendDouble(out, number);
+      }
+      break;
+    }
+    case JsonCborType::kTextString: {
+      std::string_view text = reader.ReadTextString(scratch);
+      internal::AppendString(out, text.data(), text.size());
+      break;
+    }
+    case JsonCborType::kByteString: {
+      std::string encoded = Base64Url(reader.ReadByteString(scratch));
+      internal::AppendString(out, encoded.data(), encoded.size());
+      break;
+    }
+    case JsonCborType::kArray: {
+      int64_t count = reader.ReadArrayHeader();
+      out += '[';
+      for (int64_t i = 0; count == JsonCborReader::kIndefinite
+                              ? !reader.AtBreak()
+                              : i < count;
+           ++i) {
+        if (i > 0) {
+          out += ',';
+        }
+        TranscodeCbor(reader, out, scratch, depth + 1);
+      }
+      if (count == JsonCborReader::kIndefinite) {
+        reader.ReadBreak();
+      }
+      out += ']';
+      break;
+    }
+    case JsonCborType::kMap: {
+      int64_t count = reader.ReadMapHeader();
+      out += '{';
+      for (int64_t i = 0; count == JsonCborReader::kIndefinite
+                              ? !reader.AtBreak()
+                              : i < count;
+           ++i) {
+        if (i > 0) {
+          out += ',';
+        }
+        TranscodeCborKey(reader, out, scratch);
+        out += ':';
+        TranscodeCbor(reader, out, scratch, depth + 1);
+      }
+      if (count == JsonCborReader::kIndefinite) {
+        reader.ReadBreak();
+      }
+      out += '}';
+      break;
+    }
+    case JsonCborType::kTag:
+      reader.ReadTag();
+      TranscodeCbor(reader, out, scratch, depth + 1);
+      break;
+    case JsonCborType::kBoolean:
+      out += reader.ReadBool() ? "true" : "false";
+      break;
+    case JsonCborType::kNull:
+    case JsonCborType::kUndefined:
+      reader.ReadNull();
+      out += "null";
+      break;
+    case JsonCborType::kSimple:
+    case JsonCborType::kBreak:
+      throw JsonTypeException(std::string("Cannot convert CBOR ") +
+                              TypeName(reader.PeekType()) +
+                              " to JSON at position " +
+                              std::to_string(reader.Position()));
+  }
+}
+
+}  // namespace
+
+void JsonCborWriter::WriteHead(uint8_t major, uint64_t argument) {
+  uint8_t type = static_cast<uint8_t>(major << 5);
+  if (argument < 24) {
+    out_.Append(static_cast<char>(type | argument));
+    return;
+  }
+  size_t length;
+  uint8_t info;
+  if (argument <= 0xff) {
+    length = 1;
+    info = 24;
+  } else if (argument <= 0xffff) {
+    length = 2;
+    info = 25;
+  } else if (argument <= 0xffffffff) {
+    length = 4;
+    info = 26;
+  } else {
+    length = 8;
+    info = 27;
+  }
+  char* out = out_.Extend(1 + length);
+  out[0] = static_cast<char>(type | info);
+  for (size_t i = 0; i < length; ++i) {
+    out[1 + i] = static_cast<char>(argument >> (8 * (length - 1 - i)));
+  }
+}
+
+void JsonCborWriter::WriteNull() { out_.Append(static_cast<char>(0xf6)); }
+
+void JsonCborWriter::WriteBool(bool value) {
+  out_.Append(static_cast<char>(value ? 0xf5 : 0xf4));
+}
+
+void JsonCborWriter::WriteInt(int64_t value) {
+  if (value >= 0) {
+    WriteHead(0, static_cast<uint64_t>(value));
+  } else {
+    // Major type 1 encodes -1 - n, which is ~n in two's complement
+    WriteHead(1, ~static_cast<uint64_t>(value));
+  }
+}
+
+void JsonCborWriter::WriteUInt(uint64_t value) { WriteHead(0, value); }
+
+void JsonCborWriter::WriteDouble(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  char* out = out_.Extend(9);
+  out[0] = static_cast<char>(0xfb);
+  for (size_t i = 0; i < 8; ++i) {
+    out[1 + i] = static_cast<char>(bits >> (56 - 8 * i));
+  }
+}
+
+void JsonCborWriter::WriteNumber(double value) {
+  // Negative zero takes the float path, which keeps its sign
+  if (std::trunc(value) == value && value >= -9.2233720368547758e18 &&
+      value < 1.8446744073709552e19 && !(value == 0 && std::signbit(value))) {
+    if (value >= 0) {
+      WriteUInt(static_cast<uint64_t>(value));
+    } else {
+      WriteInt(static_cast<int64_t>(value));
+    }
+    return;
+  }
+  float narrow = static_cast<float>(value);
+  if (static_cast<double>(narrow) != value) {
+    WriteDouble(value);
+    return;
+  }
+  uint32_t bits;
+  std::memcpy(&bits, &narrow, sizeof(bits));
+  char* out = out_.Extend(5);
+  out[0] = static_cast<char>(0xfa);
+  for (size_t i = 0; i < 4; ++i) {
+    out[1 + i] = static_cast<char>(bits >> (24 - 8 * i));
+  }
+}
+
+void JsonCborWriter::WriteTextString(const char* data, size_t length) {
+  WriteHead(3, length);
+  out_.Append(data, length);
+}
+
+void JsonCborWriter::WriteByteString(const char* data, size_t length) {
+  WriteHead(2, length);
+  out_.Append(data, length);
+}
+
+void JsonCborWriter::WriteTag(uint64_t tag) { WriteHead(6, tag); }
+
+void JsonCborWriter::BeginArray(uint64_t count) { WriteHead(4, count); }
+
+void JsonCborWriter::BeginMap(uint64_t count) { WriteHead(5, count); }
+
+void JsonCborWriter::BeginIndefiniteArray() {
+  out_.Append(static_cast<char>(0x9f));
+}
+
+void JsonCborWriter::BeginIndefiniteMap() {
+  out_.Append(static_cast<char>(0xbf));
+}
+
+void JsonCborWriter::WriteBreak() { out_.Append(static_cast<char>(0xff)); }
+
+void JsonCborWriter::WriteValue(const JsonValue& value) {
+  switch (value.GetType()) {
+    case JsonValueType::kObject: {
+      const JsonObject& obj = value.AsObject();
+      BeginMap(obj.Size());
+      for (auto it = obj.Begin(); it != obj.End(); ++it) {
+        WriteTextString(it->first);
+        WriteValue(it->second);
+      }
+      break;
+    }
+    case JsonValueType::kArray: {
+      const JsonArray& arr = value.AsArray();
+      BeginArray(arr.Size());
+      for (size_t i = 0; i < arr.Size(); ++i) {
+        WriteValue(arr[i]);
+      }
+      break;
+    }
+    case JsonValueType::kString:
+      WriteTextString(value.AsString());
+      break;
+    case JsonValueType::kNumber:
+      WriteNumber(value.AsNumber());
+      break;
+    case JsonValueType::kBoolean:
+      WriteBool(value.AsBoolean());
+      break;
+    case JsonValueType::kNull:
+      WriteNull();
+      break;
+  }
+}
+
+JsonCborReader::JsonCborReader(const char* data, size_t size,
+                               size_t max_depth)
+    : data_(reinterpret_cast<const uint8_t*>(data)),
+      size_(size),
+      max_depth_(max_depth) {}
+
+JsonCborType JsonCborReader::PeekType() const {
+  uint8_t initial = PeekByte();
+  uint8_t info = initial & 0x1f;
+  switch (initial >> 5) {
+    case 0:
+      return JsonCborType::kUnsigned;
+    case 1:
+      return JsonCborType::kNegative;
+    case 2:
+      return JsonCborType::kByteString;
+    case 3:
+      return JsonCborType::kTextString;
+    case 4:
+      return JsonCborType::kArray;
+    case 5:
+      return JsonCborType::kMap;
+    case 6:
+      return JsonCborType::kTag;
+    default:
+      break;
+  }
+  switch (info) {
+    case 20:
+    case 21:
+      return JsonCborType::kBoolean;
+    case 22:
+      return JsonCborType::kNull;
+    case 23:
+      return JsonCborType::kUndefined;
+    case 25:
+    case 26:
+    case 27:
+      return JsonCborType::kFloat;
+    case 31:
+      return JsonCborType::kBreak;
+    case 28:
+    case 29:
+    case 30:
+      Fail("Invalid CBOR additional information");
+    default:
+      return JsonCborType::kSimple;
+  }
+}
+
+void JsonCborReader::ReadNull() {
+  JsonCborType type = PeekType();
+  if (type != JsonCborType::kNull && type != JsonCborType::kUndefined) {
+    TypeMismatch("null");
+  }
+  ++position_;
+}
+
+bool JsonCborReader::ReadBool() {
+  if (PeekType() != JsonCborType::kBoolean) {
+    TypeMismatch("boolean");
+  }
+  return data_[position_++] == 0xf5;
+}
+
+int64_t JsonCborReader::ReadInt64() {
+  JsonCborType type = PeekType();
+  if (type != JsonCborType::kUnsigned && type != JsonCborType::kNegative) {
+    TypeMismatch("integer");
+  }
+  size_t start = position_;
+  uint8_t major;
+  bool indefinite;
+  uint64_t argument = ReadHead(major, indefinite);
+  if (argument > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+    position_ = start;
+    throw JsonTypeException("Integer out of range at position " +
+                            std::to_string(start));
+  }
+  return major == 0 ? static_cast<int64_t>(argument)
+                    : -1 - static_cast<int64_t>(argument);
+}
+
+uint64_t JsonCborReader::ReadUInt64() {
+  if (PeekType() != JsonCborType::kUnsigned) {
+    TypeMismatch("unsigned integer");
+  }
+  uint8_t major;
+  bool indefinite;
+  return ReadHead(major, indefinite);
+}
+
+double JsonCborReader::ReadDouble() {
+  int64_t integer = 0;
+  double number = 0;
+  if (ReadNumber(integer, number)) {
+    return static_cast<double>(integer);
+  }
+  return number;
+}
+
+bool JsonCborReader::ReadNumber(int64_t& integer, double& number) {
+  JsonCborType type = PeekType();
+  if (type != JsonCborType::kUnsigned && type != JsonCborType::kNegative &&
+      type != JsonCborType::kFloat) {
+    TypeMismatch("number");
+  }
+  uint8_t info = PeekByte() & 0x1f;
+  uint8_t major;
+  bool indefinite;
+  uint64_t argument = ReadHead(major, indefinite);
+
+  if (type == JsonCborType::kFloat) {
+    if (info == 25) {
+      number = DecodeHalf(static_cast<uint16_t>(argument));
+    } else if (info == 26) {
+      uint32_t bits = static_cast<uint32_t>(argument);
+      float value;
+      std::memcpy(&value, &bits, sizeof(value));
+      number = value;
+    } else {
+      std::memcpy(&number, &argument, sizeof(number));
+    }
+    return false;
+  }
+
+  if (argument <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+    integer = major == 0 ? static_cast<int64_t>(argument)
+                         : -1 - static_cast<int64_t>(argument);
+    return true;
+  }
+  number = major == 0 ? static_cast<double>(argument)
+                      : -1.0 - static_cast<double>(argument);
+  return false;
+}
+
+std::string_view JsonCborReader::ReadTextString(std::string& scratch) {
+  if (PeekType() != JsonCborType::kTextString) {
+    TypeMismatch("text string");
+  }
+  return ReadString(3, scratch);
+}
+
+std::string_view JsonCborReader::ReadByteString(std::string& scratch) {
+  if (PeekType() != JsonCborType::kByteString) {
+    TypeMismatch("byte string");
+  }
+  return ReadString(2, scratch);
+}
+
+uint64_t JsonCborReader::ReadTag() {
+  if (PeekType() != JsonCborType::kTag) {
+    TypeMismatch("tag");
+  }
+  uint8_t major;
+  bool indefinite;
+  return ReadHead(major, indefinite);
+}
+
+int64_t JsonCborReader::ReadArrayHeader() {
+  if (PeekType() != JsonCborType::kArray) {
+    TypeMismatch("array");
+  }
+  uint8_t major;
+  bool indefinite;
+  uint64_t count = ReadHead(major, indefinite);
+  if (indefinite) {
+    return kIndefinite;
+  }
+  // Every element takes at least one byte
+  if (count > size_ - position_) {
+    Fail("CBOR array length exceeds input");
+  }
+  return static_cast<int64_t>(count);
+}
+
+int64_t JsonCborReader::ReadMapHeader() {
+  if (PeekType() != JsonCborType::kMap) {
+    TypeMismatch("map");
+  }
+  uint8_t major;
+  bool indefinite;
+  uint64_t count = ReadHead(major, indefinite);
+  if (indefinite) {
+    return kIndefinite;
+  }
+  if (count > (size_ - position_) / 2) {
+    Fail("CBOR map length exceeds input");
+  }
+  return static_cast<int64_t>(count);
+}
+
+bool JsonCborReader::AtBreak() const {
+  return PeekByte() == 0xff;
+}
+
+void JsonCborReader::ReadBreak() {
+  if (!AtBreak()) {
+    TypeMismatch("break");
+  }
+  ++position_;
+}
+
+void JsonCborReader::Skip() { Skip(0); }
+
+JsonValue JsonCborReader::ReadValue() { return ReadValue(0); }
+
+void JsonCborReader::Fail(const std::string& message) const {
+  throw JsonParseException(message, position_);
+}
+
+void JsonCborReader::TypeMismatch(const char* expected) const {
+  throw JsonTypeException(std::string("Expected ") + expected + ", got " +
+                          TypeName(PeekType()) + " at position " +
+                          std::to_string(position_));
+}
+
+uint8_t JsonCborReader::PeekByte() const {
+  if (position_ >= size_) {
+    Fail("Unexpected end of CBOR input");
+  }
+  return data_[position_];
+}
+
+const uint8_t* JsonCborReader::Take(size_t length) {
+  if (length > size_ - position_) {
+    Fail("Unexpected end of CBOR input");
+  }
+  const uint8_t* start = data_ + position_;
+  position_ += length;
+  return start;
+}
+
+uint64_t JsonCborReader::ReadBigEndian(size_t length) {
+  const uint8_t* bytes = Take(length);
+  uint64_t value = 0;
+  for (size_t i = 0; i < length; ++i) {
+    value = (value << 8) | bytes[i];
+  }
+  return value;
+}
+
+uint64_t JsonCborReader::ReadHead(uint8_t& major, bool& indefinite) {
+  uint8_t initial = PeekByte();
+  major = initial >> 5;
+  uint8_t info = initial & 0x1f;
+  indefinite = false;
+  if (info < 24) {
+    ++position_;
+    return info;
+  }
+  if (info <= 27) {
+    ++position_;
+    return ReadBigEndian(size_t{1} << (info - 24));
+  }
+  if (info == 31 && (major == 2 || major == 3 || major == 4 || major == 5)) {
+    ++position_;
+    indefinite = true;
+    return 0;
+  }
+  Fail("Invalid CBOR additional information");
+}
+
+std::string_view JsonCborReader::ReadString(uint8_t major,
+                                            std::string& scratch) {
+  uint8_t chunk_major;
+  bool indefinite;
+  uint64_t length = ReadHead(chunk_major, indefinite);
+  if (!indefinite) {
+    const uint8_t* bytes = Take(length);
+    return std::string_view(reinterpret_cast<const char*>(bytes), length);
+  }
+
+  // Indefinite strings are a sequence of definite chunks of the same type
+  scratch.clear();
+  while (!AtBreak()) {
+    if ((PeekByte() >> 5) != major) {
+      Fail("Invalid chunk in indefinite-length CBOR string");
+    }
+    length = ReadHead(chunk_major, indefinite);
+    if (indefinite) {
+      Fail("Nested indefinite-length CBOR string");
+    }
+    scratch.append(reinterpret_cast<const char*>(Take(length)), length);
+  }
+  ++position_;
+  return scratch;
+}
+
+std::string JsonCborReader::ReadKey() {
+  while (PeekType() == JsonCborType::kTag) {
+    ReadTag();
+  }
+  std::string scratch;
+  switch (PeekType()) {
+    case JsonCborType::kTextString:
+      return std::string(ReadTextString(scratch));
+    case JsonCborType::kUnsigned:
+      return std::to_string(ReadUInt64());
+    case JsonCborType::kNegative:
+      return std::to_string(ReadInt64());
+    default:
+      throw JsonTypeException("CBOR map keys must be strings or integers at "
+                              "position " + std::to_string(position_));
+  }
+}
+
+void JsonCborReader::Skip(size_t depth) {
+  if (depth > max_depth_) {
+    Fail("Maximum nesting depth exceeded");
+  }
+  std::string scratch;
+  switch (PeekType()) {
+    case JsonCborType::kByteString:
+    case JsonCborType::kTextString:
+      ReadString(PeekByte() >> 5, scratch);
+      break;
+    case JsonCborType::kArray: {
+      int64_t count = ReadArrayHeader();
+      if (count == kIndefinite) {
+        while (!AtBreak()) {
+          Skip(depth + 1);
+        }
+        ++position_;
+      } else {
+        for (int64_t i = 0; i < count; ++i) {
+          Skip(depth + 1);
+        }
+      }
+      break;
+    }
+    case JsonCborType::kMap: {
+      int64_t count = ReadMapHeader();
+      if (count == kIndefinite) {
+        while (!AtBreak()) {
+          Skip(depth + 1);
+          Skip(depth + 1);
+        }
+        ++position_;
+      } else {
+        for (int64_t i = 0; i < count; ++i) {
+          Skip(depth + 1);
+          Skip(depth + 1);
+        }
+      }
+      break;
+    }
+    case JsonCborType::kTag:
+      ReadTag();
+      Skip(depth + 1);
+      break;
+    case JsonCborType::kBreak:
+      Fail("Unexpected CBOR break");
+    default: {
+      // Integers, simple values and floats: the head is the whole item
+      uint8_t major;
+      bool indefinite;
+      ReadHead(major, indefinite);
+      break;
+    }
+  }
+}
+
+JsonValue JsonCborReader::ReadValue(size_t depth) {
+  if (depth > max_depth_) {
+    Fail("Maximum nesting depth exceeded");
+  }
+  std::string scratch;
+  switch (PeekType()) {
+    case JsonCborType::kUnsigned:
+    case JsonCborType::kNegative:
+    case JsonCborType::kFloat:
+      return JsonValue(ReadDouble());
+    case JsonCborType::kTextString:
+      return JsonValue(std::string(ReadTextString(scratch)));
+    case JsonCborType::kByteString:
+      return JsonValue(Base64Url(ReadByteString(scratch)));
+    case JsonCborType::kArray: {
+      int64_t count = ReadArrayHeader();
+      JsonValue result{JsonArray()};
+      JsonArray& arr = result.AsArray();
+      if (count == kIndefinite) {
+        while (!AtBreak()) {
+          arr.PushBack(ReadValue(depth + 1));
+        }
+        ++position_;
+      } else {
+        arr.Reserve(static_cast<size_t>(count));
+        for (int64_t i = 0; i < count; ++i) {
+          arr.PushBack(ReadValue(depth + 1));
+        }
+      }
+      return result;
+    }
+    case JsonCborType::kMap: {
+      int64_t count = ReadMapHeader();
+      JsonValue result{JsonObject()};
+      JsonObject& obj = result.AsObject();
+      for (int64_t i = 0; count == kIndefinite ? !AtBreak() : i < count;
+           ++i) {
+        std::string key = ReadKey();
+        obj.Insert(key, ReadValue(depth + 1));
+      }
+      if (count == kIndefinite) {
+        ++position_;
+      }
+      return result;
+    }
+    case JsonCborType::kTag:
+      ReadTag();
+      return ReadValue(depth + 1);
+    case JsonCborType::kBoolean:
+      return JsonValue(ReadBool());
+    case JsonCborType::kNull:
+    case JsonCborType::kUndefined:
+      ReadNull();
+      return JsonValue(nullptr);
+    case JsonCborType::kSimple:
+    case JsonCborType::kBreak:
+      break;
+  }
+  throw JsonTypeException(std::string("Cannot convert CBOR ") +
+                          TypeName(PeekType()) + " at position " +
+                          std::to_string(position_));
+}
+
+std::string JsonCbor::Encode(const JsonValue& value) {
+  JsonOutputBuffer out;
+  Encode(value, out);
+  return out.TakeString();
+}
+
+void JsonCbor::Encode(const JsonValue& value, JsonOutputBuffer& out) {
+  JsonCborWriter(out).WriteValue(value);
+}
+
+JsonValue JsonCbor::Decode(const std::string& data) {
+  return Decode(data.data(), data.size());
+}
+
+JsonValue JsonCbor::Decode(const char* data, size_t size) {
+  JsonCborReader reader(data, size);
+  JsonValue value = reader.ReadValue();
+  if (!reader.AtEnd()) {
+    throw JsonParseException("Unexpected bytes after CBOR value",
+                             reader.Position());
+  }
+  return value;
+}
+
+std::string JsonCbor::FromJson(const std::string& json,
+                               const JsonParserConfig& config) {
+  JsonOutputBuffer out;
+  FromJson(PaddedJsonBuffer(json), out, config);
+  return out.TakeString();
+}
+
+void JsonCbor::FromJson(const PaddedJsonBuffer& json, JsonOutputBuffer& out,
+                        const JsonParserConfig& config) {
+  JsonReader reader(json, config);
+  JsonCborWriter writer(out);
+  std::string scratch;
+  TranscodeJson(reader, writer, scratch);
+  reader.ExpectEnd();
+}
+
+std::string JsonCbor::ToJson(const std::string& data) {
+  return ToJson(data.data(), data.size());
+}
+
+std::string JsonCbor::ToJson(const char* data, size_t size) {
+  JsonCborReader reader(data, size);
+  std::string out;
+  std::string scratch;
+  TranscodeCbor(reader, out, scratch, 0);
+  if (!reader.AtEnd()) {
+    throw JsonParseException("Unexpected bytes after CBOR value",
+                             reader.Position());
+  }
+  return out;
+}
+
+}  // namespace json_parser
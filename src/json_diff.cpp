@@ -0,0 +1,343 @@
+#include "json_parser/json_diff.h"
+#include "json_parser/json_object.h"
+#include "json_parser/json_array.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace json_parser {
+
+namespace {
+
+// One step of an array alignment: keep a[a_index] as b[b_index], delete
+// a[a_index] or insert b[b_index]
+struct Edit {
+  enum class Kind { kKeep, kDelete, kInsert };
+  Kind kind;
+  size_t a_index;
+  size_t b_index;
+};
+
+class Differ {
+ public:
+  Differ(const JsonDiffConfig& config, JsonPatch& patch)
+      : config_(config), patch_(patch) {}
+
+  void Diff(const JsonValue& a, const JsonValue& b) {
+    if (a.GetType() != b.GetType()) {
+      patch_.Replace(path_, b);
+      return;
+    }
+    if (SameContainer(a, b) || Unchanged(a, b)) {
+      return;
+    }
+    switch (a.GetType()) {
+      case JsonValueType::kObject:
+        DiffObjects(a.AsObject(), b.AsObject());
+        break;
+      case JsonValueType::kArray:
+        DiffArrays(a.AsArray(), b.AsArray());
+        break;
+      default:
+        patch_.Replace(path_, b);
+        break;
+    }
+  }
+
+ private:
+  const JsonDiffConfig& config_;
+  JsonPatch& patch_;
+  // Pointer to the value being compared, extended and truncated as the
+  // walk descends and returns
+  std::string path_;
+
+  // Shared containers are skipped without being hashed or visited
+  static bool SameContainer(const JsonValue& a, const JsonValue& b) {
+    if (a.IsObject() && b.IsObject()) {
+      return &a.AsObject() == &b.AsObject();
+    }
+    return a.IsArray() && b.IsArray() && &a.AsArray() == &b.AsArray();
+  }
+
+  // True if a and b are equal. Containers are compared by their cached
+  // hashes first, which rules most changed ones out at once; equal hashes
+  // almost always mean equal subtrees, and operator== confirms it without
+  // the differ's bookkeeping, stopping at shared containers.
+  static bool Unchanged(const JsonValue& a, const JsonValue& b) {
+    if ((a.IsObject() || a.IsArray()) && a.Hash() != b.Hash()) {
+      return false;
+    }
+    return a == b;
+  }
+
+  void PushToken(const std::string& token) {
+    path_.push_back('/');
+    path_ += JsonPatch::EscapeToken(token);
+  }
+
+  void DiffObjects(const JsonObject& a, const JsonObject& b) {
+    std::vector<const std::string*> removed;
+    std::vector<const std::string*> common;
+    std::vector<const std::string*> added;
+    for (auto it = a.Begin(); it != a.End(); ++it) {
+      (b.Contains(it->first) ? common : removed).push_back(&it->first);
+    }
+    for (auto it = b.Begin(); it != b.End(); ++it) {
+      if (!a.Contains(it->first)) {
+        added.push_back(&it->first);
+      }
+    }
+    auto by_key = [](const std::string* x, const std::string* y) {
+      return *x < *y;
+    };
+    std::sort(removed.begin(), removed.end(), by_key);
+    std::sort(common.begin(), common.end(), by_key);
+    std::sort(added.begin(), added.end(), by_key);
+
+    const size_t base = path_.size();
+    for (const std::string* key : removed) {
+      PushToken(*key);
+      patch_.Remove(path_);
+      path_.resize(base);
+    }
+    for (const std::string* key : common) {
+      const JsonValue& value_a = a[*key];
+      const JsonValue& value_b = b[*key];
+      if (SameContainer(value_a, value_b) || Unchanged(value_a, value_b)) {
+        continue;
+      }
+      PushToken(*key);
+      Diff(value_a, value_b);
+      path_.resize(base);
+    }
+    for (const std::string* key : added) {
+      PushToken(*key);
+      patch_.Add(path_, b[*key]);
+      path_.resize(base);
+    }
+  }
+
+  void DiffArrays(const JsonArray& a, const JsonArray& b) {
+    std::vector<uint64_t> hash_a(a.Size());
+    std::vector<uint64_t> hash_b(b.Size());
+    for (size_t i = 0; i < a.Size(); ++i) {
+      hash_a[i] = a[i].Hash();
+    }
+    for (size_t i = 0; i < b.Size(); ++i) {
+      hash_b[i] = b[i].Hash();
+    }
+    std::vector<Edit> script;
+    Align(hash_a, 0, a.Size(), hash_b, 0, b.Size(), script);
+    EmitArrayEdits(a, b, script);
+  }
+
+  // Appends an alignment of hash_a[a_lo, a_hi) with hash_b[b_lo, b_hi)
+  void Align(const std::vector<uint64_t>& hash_a, size_t a_lo, size_t a_hi,
+             const std::vector<uint64_t>& hash_b, size_t b_lo, size_t b_hi,
+             std::vector<Edit>& script) {
+    // Common prefix and suffix
+    while (a_lo < a_hi && b_lo < b_hi && hash_a[a_lo] == hash_b[b_lo]) {
+      script.push_back({Edit::Kind::kKeep, a_lo++, b_lo++});
+    }
+    size_t suffix = 0;
+    while (a_hi - suffix > a_lo && b_hi - suffix > b_lo &&
+           hash_a[a_hi - suffix - 1] == hash_b[b_hi - suffix - 1]) {
+      ++suffix;
+    }
+    const size_t n = a_hi - suffix - a_lo;
+    const size_t m = b_hi - suffix - b_lo;
+
+    if (n == 0 || m == 0) {
+      AppendReplacement(a_lo, n, b_lo, m, script);
+    } else if ((n + 1) * (m + 1) <= config_.max_lcs_cells) {
+      AlignLcs(hash_a, a_lo, n, hash_b, b_lo, m, script);
+    } else {
+      AlignAnchors(hash_a, a_lo, n, hash_b, b_lo, m, script);
+    }
+
+    for (size_t k = suffix; k > 0; --k) {
+      script.push_back({Edit::Kind::kKeep, a_hi - k, b_hi - k});
+    }
+  }
+
+  static void AppendReplacement(size_t a_lo, size_t n, size_t b_lo, size_t m,
+                                std::vector<Edit>& script) {
+    for (size_t i = 0; i < n; ++i) {
+      script.push_back({Edit::Kind::kDelete, a_lo + i, 0});
+    }
+    for (size_t j = 0; j < m; ++j) {
+      script.push_back({Edit::Kind::kInsert, 0, b_lo + j});
+    }
+  }
+
+  static void AlignLcs(const std::vector<uint64_t>& hash_a, size_t a_lo,
+                       size_t n, const std::vector<uint64_t>& hash_b,
+                       size_t b_lo, size_t m, std::vector<Edit>& script) {
+    // lengths[i * (m + 1) + j]: LCS length of a[i..n) and b[j..m)
+    std::vector<uint32_t> lengths((n + 1) * (m + 1), 0);
+    for (size_t i = n; i-- > 0;) {
+      for (size_t j = m; j-- > 0;) {
+        uint32_t& cell = lengths[i * (m + 1) + j];
+        if (hash_a[a_lo + i] == hash_b[b_lo + j]) {
+          cell = lengths[(i + 1) * (m + 1) + j + 1] + 1;
+        } else {
+          cell = std::max(lengths[(i + 1) * (m + 1) + j],
+                          lengths[i * (m + 1) + j + 1]);
+        }
+      }
+    }
+    size_t i = 0;
+    size_t j = 0;
+    while (i < n && j < m) {
+      if (hash_a[a_lo + i] == hash_b[b_lo + j]) {
+        script.push_back({Edit::Kind::kKeep, a_lo + i++, b_lo + j++});
+      } else if (lengths[(i + 1) * (m + 1) + j] >=
+                 lengths[i * (m + 1) + j + 1]) {
+        script.push_back({Edit::Kind::kDelete, a_lo + i++, 0});
+      } else {
+        script.push_back({Edit::Kind::kInsert, 0, b_lo + j++});
+      }
+    }
+    AppendReplacement(a_lo + i, n - i, b_lo + j, m - j, script);
+  }
+
+  // For sections too large for the LCS table: elements occurring exactly
+  // once on each side anchor the alignment (the longest increasing run of
+  // them), and the gaps between anchors are aligned recursively
+  void AlignAnchors(const std::vector<uint64_t>& hash_a, size_t a_lo,
+                    size_t n, const std::vector<uint64_t>& hash_b,
+                    size_t b_lo, size_t m, std::vector<Edit>& script) {
+    // Per hash: occurrences in a, occurrences in b, and their positions
+    struct Count {
+      size_t in_a = 0;
+      size_t in_b = 0;
+      size_t a_index = 0;
+      size_t b_index = 0;
+    };
+    std::unordered_map<uint64_t, Count> counts;
+    for (size_t i = a_lo; i < a_lo + n; ++i) {
+      Count& count = counts[hash_a[i]];
+      ++count.in_a;
+      count.a_index = i;
+    }
+    for (size_t j = b_lo; j < b_lo + m; ++j) {
+      auto it = counts.find(hash_b[j]);
+      if (it != counts.end()) {
+        ++it->second.in_b;
+        it->second.b_index = j;
+      }
+    }
+    std::vector<std::pair<size_t, size_t>> candidates;
+    for (size_t i = a_lo; i < a_lo + n; ++i) {
+      const Count& count = counts[hash_a[i]];
+      if (count.in_a == 1 && count.in_b == 1) {
+        candidates.emplace_back(i, count.b_index);
+      }
+    }
+
+    // Longest run of candidates increasing in b (patience sorting)
+    std::vector<size_t> tails;
+    std::vector<size_t> previous(candidates.size(), SIZE_MAX);
+    for (size_t k = 0; k < candidates.size(); ++k) {
+      auto pos = std::lower_bound(
+          tails.begin(), tails.end(), candidates[k].second,
+          [&](size_t t, size_t b) { return candidates[t].second < b; });
+      if (pos != tails.begin()) {
+        previous[k] = *(pos - 1);
+      }
+      if (pos == tails.end()) {
+        tails.push_back(k);
+      } else {
+        *pos = k;
+      }
+    }
+    std::vector<std::pair<size_t, size_t>> anchors;
+    for (size_t k = tails.empty() ? SIZE_MAX : tails.back(); k != SIZE_MAX;
+         k = previous[k]) {
+      anchors.push_back(candidates[k]);
+    }
+    std::reverse(anchors.begin(), anchors.end());
+
+    if (anchors.empty()) {
+      AppendReplacement(a_lo, n, b_lo, m, script);
+      return;
+    }
+    size_t a_pos = a_lo;
+    size_t b_pos = b_lo;
+    for (const auto& anchor : anchors) {
+      Align(hash_a, a_pos, anchor.first, hash_b, b_pos, anchor.second,
+            script);
+      script.push_back({Edit::Kind::kKeep, anchor.first, anchor.second});
+      a_pos = anchor.first + 1;
+      b_pos = anchor.second + 1;
+    }
+    Align(hash_a, a_pos, a_lo + n, hash_b, b_pos, b_lo + m, script);
+  }
+
+  // Turns the alignment into operations on the array as it evolves. A run
+  // of deletions next to a run of insertions pairs them up, and each pair
+  // is diffed in place rather than removed and re-added.
+  void EmitArrayEdits(const JsonArray& a, const JsonArray& b,
+                      const std::vector<Edit>& script) {
+    const size_t base = path_.size();
+    size_t position = 0;
+    auto at = [&](size_t index) {
+      path_.resize(base);
+      PushToken(std::to_string(index));
+    };
+
+    size_t k = 0;
+    while (k < script.size()) {
+      if (script[k].kind == Edit::Kind::kKeep) {
+        // Aligned on equal hashes, so almost always unchanged
+        const JsonValue& kept_a = a[script[k].a_index];
+        const JsonValue& kept_b = b[script[k].b_index];
+        if (kept_a != kept_b) {
+          at(position);
+          Diff(kept_a, kept_b);
+        }
+        ++position;
+        ++k;
+        continue;
+      }
+      std::vector<size_t> deleted;
+      std::vector<size_t> inserted;
+      for (; k < script.size() && script[k].kind != Edit::Kind::kKeep; ++k) {
+        if (script[k].kind == Edit::Kind::kDelete) {
+          deleted.push_back(script[k].a_index);
+        } else {
+          inserted.push_back(script[k].b_index);
+        }
+      }
+      const size_t paired = std::min(deleted.size(), inserted.size());
+      for (size_t p = 0; p < paired; ++p) {
+        at(position++);
+        Diff(a[deleted[p]], b[inserted[p]]);
+      }
+      for (size_t p = paired; p < deleted.size(); ++p) {
+        at(position);
+        patch_.Remove(path_);
+      }
+      for (size_t p = paired; p < inserted.size(); ++p) {
+        at(position++);
+        patch_.Add(path_, b[inserted[p]]);
+      }
+    }
+    path_.resize(base);
+  }
+};
+
+}  // namespace
+
+JsonPatch JsonDiff(const JsonValue& source, const JsonValue& target,
+                   const JsonDiffConfig& config) {
+  JsonPatch patch;
+  Differ(config, patch).Diff(source, target);
+  return patch;
+}
+
+}  // namespace json_parser
@@ -0,0 +1,213 @@
+#ifndef JSON_PARSER_SRC_JSON_ESCAPE_H_
+#define JSON_PARSER_SRC_JSON_ESCAPE_H_
+
+// Internal string escaping shared by JsonWriter and the binders. Unlike
+// json_scan.h these routines take an explicit length and never read past
+// it, since strings being written are not padded.
+
+#include "json_parser/json_output_buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace json_parser {
+namespace internal {
+
+// What each byte becomes inside a string literal: 0 copies it verbatim,
+// 'u' writes \u00XX, and anything else is the letter after a backslash.
+struct EscapeTable {
+  char replacement[256] = {};
+
+  constexpr EscapeTable() {
+    for (int c = 0; c < 0x20; ++c) {
+      replacement[c] = 'u';
+    }
+    replacement[static_cast<unsigned char>('"')] = '"';
+    replacement[static_cast<unsigned char>('\\')] = '\\';
+    replacement[static_cast<unsigned char>('\b')] = 'b';
+    replacement[static_cast<unsigned char>('\f')] = 'f';
+    replacement[static_cast<unsigned char>('\n')] = 'n';
+    replacement[static_cast<unsigned char>('\r')] = 'r';
+    replacement[static_cast<unsigned char>('\t')] = 't';
+  }
+};
+
+inline constexpr EscapeTable kEscapeTable;
+
+// Index of the first byte in [data + pos, data + length) that needs an
+// escape: a control character, '"' or '\\', plus any non-ASCII byte when
+// escape_unicode is set. Returns length if there is none.
+inline size_t FindEscape(const char* data, size_t length, size_t pos,
+                         bool escape_unicode) {
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i max_control = _mm_set1_epi8(0x1F);
+  const int unicode_mask = escape_unicode ? 0xFFFF : 0;
+  for (; pos + 16 <= length; pos += 16) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+    // Unsigned c <= 0x1F, as max(c, 0x1F) == 0x1F
+    __m128i control =
+        _mm_cmpeq_epi8(_mm_max_epu8(chunk, max_control), max_control);
+    __m128i special = _mm_or_si128(
+        control, _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                              _mm_cmpeq_epi8(chunk, backslash)));
+    // The sign bit of each byte is set exactly for non-ASCII bytes
+    int mask = _mm_movemask_epi8(special) |
+               (_mm_movemask_epi8(chunk) & unicode_mask);
+    if (mask != 0) {
+      return pos + __builtin_ctz(mask);
+    }
+  }
+#endif
+  for (; pos < length; ++pos) {
+    unsigned char c = static_cast<unsigned char>(data[pos]);
+    if (kEscapeTable.replacement[c] != 0 || (escape_unicode && c >= 0x80)) {
+      return pos;
+    }
+  }
+  return length;
+}
+
+// Length of data[0, length) once escaped by AppendEscaped without
+// escape_unicode, so callers can size their output up front
+inline size_t EscapedLength(const char* data, size_t length) {
+  size_t escaped = length;
+  size_t pos = FindEscape(data, length, 0, false);
+  while (pos < length) {
+    unsigned char c = static_cast<unsigned char>(data[pos]);
+    escaped += kEscapeTable.replacement[c] == 'u' ? 5 : 1;
+    pos = FindEscape(data, length, pos + 1, false);
+  }
+  return escaped;
+}
+
+// Decodes the UTF-8 sequence at data[pos]. Returns its length, or 0 if it
+// is malformed, overlong, a surrogate or beyond U+10FFFF.
+inline size_t DecodeUtf8(const char* data, size_t length, size_t pos,
+                         uint32_t& code_point) {
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(data + pos);
+  size_t available = length - pos;
+  size_t size;
+  uint32_t min;
+  if (p[0] >= 0xC0 && p[0] < 0xE0) {
+    size = 2;
+    min = 0x80;
+    code_point = p[0] & 0x1F;
+  } else if (p[0] >= 0xE0 && p[0] < 0xF0) {
+    size = 3;
+    min = 0x800;
+    code_point = p[0] & 0x0F;
+  } else if (p[0] >= 0xF0 && p[0] < 0xF8) {
+    size = 4;
+    min = 0x10000;
+    code_point = p[0] & 0x07;
+  } else {
+    return 0;
+  }
+  if (available < size) {
+    return 0;
+  }
+  for (size_t i = 1; i < size; ++i) {
+    if ((p[i] & 0xC0) != 0x80) {
+      return 0;
+    }
+    code_point = (code_point << 6) | (p[i] & 0x3F);
+  }
+  if (code_point < min || code_point > 0x10FFFF ||
+      (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+    return 0;
+  }
+  return size;
+}
+
+inline void AppendBytes(std::string& out, const char* data, size_t length) {
+  out.append(data, length);
+}
+
+inline void AppendBytes(JsonOutputBuffer& out, const char* data,
+                        size_t length) {
+  out.Append(data, length);
+}
+
+// Unescaped runs of the input. Only JsonOutputBuffer can reference them
+// instead of copying, and only when the caller allows it.
+inline void AppendRun(std::string& out, const char* data, size_t length,
+                      bool /*reference*/) {
+  out.append(data, length);
+}
+
+inline void AppendRun(JsonOutputBuffer& out, const char* data, size_t length,
+                      bool reference) {
+  if (reference) {
+    out.AppendReference(data, length);
+  } else {
+    out.Append(data, length);
+  }
+}
+
+// Appends str escaped for use inside a string literal, without the
+// surrounding quotes. Runs that need no escaping are copied in bulk. With
+// escape_unicode, non-ASCII code points become \uXXXX escapes (surrogate
+// pairs above U+FFFF) and each byte of malformed UTF-8 becomes \ufffd.
+// With reference_runs, a gathering JsonOutputBuffer may keep pointers into
+// data rather than copies, so data must outlive the buffer's next Flush().
+template <typename Output>
+void AppendEscaped(Output& out, const char* data, size_t length,
+                   bool escape_unicode, bool reference_runs = false) {
+  static const char kHex[] = "0123456789abcdef";
+  size_t run_start = 0;
+  size_t pos = FindEscape(data, length, 0, escape_unicode);
+  while (pos < length) {
+    AppendRun(out, data + run_start, pos - run_start, reference_runs);
+    unsigned char c = static_cast<unsigned char>(data[pos]);
+    char replacement = kEscapeTable.replacement[c];
+    if (c < 0x80 && replacement != 'u') {
+      char escape[2] = {'\\', replacement};
+      AppendBytes(out, escape, 2);
+      ++pos;
+    } else if (c < 0x80) {
+      char escape[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+      AppendBytes(out, escape, 6);
+      ++pos;
+    } else {
+      uint32_t code_point;
+      size_t size = DecodeUtf8(data, length, pos, code_point);
+      if (size == 0) {
+        code_point = 0xFFFD;
+        size = 1;
+      }
+      uint32_t units[2] = {code_point, 0};
+      size_t count = 1;
+      if (code_point >= 0x10000) {
+        code_point -= 0x10000;
+        units[0] = 0xD800 | (code_point >> 10);
+        units[1] = 0xDC00 | (code_point & 0x3FF);
+        count = 2;
+      }
+      for (size_t i = 0; i < count; ++i) {
+        char escape[6] = {'\\', 'u',
+                          kHex[(units[i] >> 12) & 0xF],
+                          kHex[(units[i] >> 8) & 0xF],
+                          kHex[(units[i] >> 4) & 0xF],
+                          kHex[units[i] & 0xF]};
+        AppendBytes(out, escape, 6);
+      }
+      pos += size;
+    }
+    run_start = pos;
+    pos = FindEscape(data, length, pos, escape_unicode);
+  }
+  AppendRun(out, data + run_start, length - run_start, reference_runs);
+}
+
+}  // namespace internal
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_SRC_JSON_ESCAPE_H_
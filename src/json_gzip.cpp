@@ -0,0 +1,325 @@
+#include "json_parser/json_gzip.h"
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(JSON_PARSER_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace json_parser {
+
+#if defined(JSON_PARSER_HAVE_ZLIB)
+
+namespace {
+
+// One half of a double buffer, handed between the caller's thread and the
+// background thread
+struct Block {
+  std::vector<char> data;
+  size_t length = 0;
+  bool ready = false;  // Holds data for the other side
+  std::string error;
+};
+
+}  // namespace
+
+// Background thread fills blocks with gzread; underflow() hands them to the
+// stream in order and returns each to the thread once it is consumed
+class JsonGzipInputStream::Buffer : public std::streambuf {
+ public:
+  Buffer(const std::string& filename, size_t buffer_size) {
+    file_ = gzopen(filename.c_str(), "rb");
+    if (file_ == nullptr) {
+      throw JsonFileException(filename);
+    }
+    gzbuffer(file_, 128 * 1024);
+    for (Block& block : blocks_) {
+      block.data.resize(buffer_size > 0 ? buffer_size : 1);
+    }
+    thread_ = std::thread([this] { Inflate(); });
+  }
+
+  ~Buffer() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+    gzclose(file_);
+  }
+
+ protected:
+  int_type underflow() override {
+    if (gptr() < egptr()) {
+      return traits_type::to_int_type(*gptr());
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (holding_) {
+      blocks_[consumed_ % 2].ready = false;
+      ++consumed_;
+      holding_ = false;
+      changed_.notify_all();
+    }
+    Block& block = blocks_[consumed_ % 2];
+    changed_.wait(lock, [&] { return block.ready; });
+    if (!block.error.empty()) {
+      throw JsonException("gzip read failed: " + block.error);
+    }
+    if (block.length == 0) {
+      // End of input; the empty block stays ready so later reads see EOF
+      return traits_type::eof();
+    }
+    holding_ = true;
+    setg(block.data.data(), block.data.data(),
+         block.data.data() + block.length);
+    return traits_type::to_int_type(*gptr());
+  }
+
+ private:
+  gzFile file_ = nullptr;
+  Block blocks_[2];
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::thread thread_;
+  size_t consumed_ = 0;
+  bool holding_ = false;
+  bool stop_ = false;
+
+  void Inflate() {
+    for (size_t index = 0;; ++index) {
+      Block& block = blocks_[index % 2];
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [&] { return stop_ || !block.ready; });
+        if (stop_) {
+          return;
+        }
+      }
+      int read = gzread(file_, block.data.data(),
+                        static_cast<unsigned>(block.data.size()));
+      std::string error;
+      if (read < 0) {
+        int code = Z_OK;
+        error = gzerror(file_, &code);
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        block.length = read > 0 ? static_cast<size_t>(read) : 0;
+        block.error = error;
+        block.ready = true;
+      }
+      changed_.notify_all();
+      if (read <= 0) {
+        return;
+      }
+    }
+  }
+};
+
+// overflow() and sync() pass the filled block to the background thread,
+// which gzwrites it while the stream fills the other one
+class JsonGzipOutputStream::Buffer : public std::streambuf {
+ public:
+  Buffer(const std::string& filename, int level, size_t buffer_size)
+      : filename_(filename) {
+    if (level < 1 || level > 9) {
+      level = 6;
+    }
+    std::string mode = "wb" + std::to_string(level);
+    file_ = gzopen(filename.c_str(), mode.c_str());
+    if (file_ == nullptr) {
+      throw JsonFileException(filename);
+    }
+    gzbuffer(file_, 128 * 1024);
+    for (Block& block : blocks_) {
+      block.data.resize(buffer_size > 0 ? buffer_size : 1);
+    }
+    SetPutArea();
+    thread_ = std::thread([this] { Deflate(); });
+  }
+
+  ~Buffer() override {
+    try {
+      Close();
+    } catch (const JsonException&) {
+    }
+  }
+
+  void Close() {
+    if (closed_) {
+      return;
+    }
+    closed_ = true;
+    std::string error;
+    try {
+      Submit();
+    } catch (const JsonException& e) {
+      error = e.what();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+    if (error.empty()) {
+      error = error_;
+    }
+    if (gzclose(file_) != Z_OK && error.empty()) {
+      error = "cannot finish '" + filename_ + "'";
+    }
+    if (!error.empty()) {
+      throw JsonException("gzip write failed: " + error);
+    }
+  }
+
+ protected:
+  int_type overflow(int_type c) override {
+    Submit();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  int sync() override {
+    Submit();
+    return 0;
+  }
+
+ private:
+  std::string filename_;
+  gzFile file_ = nullptr;
+  Block blocks_[2];
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::thread thread_;
+  size_t filling_ = 0;  // Block the stream writes into
+  bool stop_ = false;
+  bool closed_ = false;
+  std::string error_;
+
+  void SetPutArea() {
+    Block& block = blocks_[filling_ % 2];
+    setp(block.data.data(), block.data.data() + block.data.size());
+  }
+
+  // Hand the filled block to the background thread and switch to the
+  // other one once the thread has finished with it
+  void Submit() {
+    size_t length = static_cast<size_t>(pptr() - pbase());
+    if (length == 0) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    Block& next = blocks_[(filling_ + 1) % 2];
+    changed_.wait(lock, [&] { return !next.ready; });
+    if (!error_.empty()) {
+      throw JsonException("gzip write failed: " + error_);
+    }
+    Block& block = blocks_[filling_ % 2];
+    block.length = length;
+    block.ready = true;
+    ++filling_;
+    lock.unlock();
+    changed_.notify_all();
+    SetPutArea();
+  }
+
+  void Deflate() {
+    for (size_t index = 0;; ++index) {
+      Block& block = blocks_[index % 2];
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [&] { return stop_ || block.ready; });
+        if (!block.ready) {
+          return;
+        }
+      }
+      std::string error;
+      if (error_.empty() &&
+          gzwrite(file_, block.data.data(),
+                  static_cast<unsigned>(block.length)) !=
+              static_cast<int>(block.length)) {
+        int code = Z_OK;
+        error = gzerror(file_, &code);
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error.empty()) {
+          error_ = error;
+        }
+        block.ready = false;
+      }
+      changed_.notify_all();
+    }
+  }
+};
+
+JsonGzipInputStream::JsonGzipInputStream(const std::string& filename,
+                                         size_t buffer_size)
+    : std::istream(nullptr), buffer_(new Buffer(filename, buffer_size)) {
+  rdbuf(buffer_.get());
+  // Let decompression errors reach the caller instead of looking like EOF
+  exceptions(std::ios::badbit);
+}
+
+JsonGzipOutputStream::JsonGzipOutputStream(const std::string& filename,
+                                           int level, size_t buffer_size)
+    : std::ostream(nullptr),
+      buffer_(new Buffer(filename, level, buffer_size)) {
+  rdbuf(buffer_.get());
+  exceptions(std::ios::badbit);
+}
+
+void JsonGzipOutputStream::Close() { buffer_->Close(); }
+
+bool JsonGzip::Available() { return true; }
+
+#else  // !JSON_PARSER_HAVE_ZLIB
+
+class JsonGzipInputStream::Buffer : public std::streambuf {};
+class JsonGzipOutputStream::Buffer : public std::streambuf {};
+
+JsonGzipInputStream::JsonGzipInputStream(const std::string& /*filename*/,
+                                         size_t /*buffer_size*/)
+    : std::istream(nullptr) {
+  throw JsonException("gzip support requires building with zlib");
+}
+
+JsonGzipOutputStream::JsonGzipOutputStream(const std::string& /*filename*/,
+                                           int /*level*/,
+                                           size_t /*buffer_size*/)
+    : std::ostream(nullptr) {
+  throw JsonException("gzip support requires building with zlib");
+}
+
+void JsonGzipOutputStream::Close() {}
+
+bool JsonGzip::Available() { return false; }
+
+#endif  // JSON_PARSER_HAVE_ZLIB
+
+JsonGzipInputStream::~JsonGzipInputStream() = default;
+
+JsonGzipOutputStream::~JsonGzipOutputStream() = default;
+
+bool JsonGzip::IsGzipFile(const std::string& filename) {
+  std::ifstream file(filename, std::ios::binary);
+  unsigned char magic[2] = {0, 0};
+  file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+  return file.gcount() == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+}
+
+bool JsonGzip::HasGzipExtension(const std::string& filename) {
+  return filename.size() >= 3 &&
+         filename.compare(filename.size() - 3, 3, ".gz") == 0;
+}
+
+}  // namespace json_parser
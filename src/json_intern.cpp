@@ -0,0 +1,84 @@
+#include "json_intern.h"
+#include "json_parser/json_object.h"
+#include "json_parser/json_array.h"
+
+namespace json_parser {
+namespace internal {
+
+namespace {
+
+const void* ContainerAddress(const JsonValue& value) {
+  if (value.IsObject()) {
+    return &value.AsObject();
+  }
+  if (value.IsArray()) {
+    return &value.AsArray();
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+bool JsonInterner::IsFrozen(const JsonValue& value) {
+  if (value.IsObject()) {
+    return value.AsObject().frozen_;
+  }
+  return value.IsArray() && value.AsArray().frozen_;
+}
+
+void JsonInterner::Freeze(const JsonValue& value) {
+  if (value.IsObject()) {
+    const_cast<JsonObject&>(value.AsObject()).frozen_ = true;
+  } else {
+    const_cast<JsonArray&>(value.AsArray()).frozen_ = true;
+  }
+}
+
+bool JsonInterner::InternNode(JsonValue& value) {
+  const void* address = ContainerAddress(value);
+  if (address == nullptr) {
+    return false;
+  }
+  auto inserted = canonical_.insert(value);
+  if (inserted.second) {
+    Freeze(value);
+    return false;
+  }
+  if (ContainerAddress(*inserted.first) == address) {
+    return false;
+  }
+  value = *inserted.first;
+  return true;
+}
+
+size_t JsonInterner::InternTree(JsonValue& value) {
+  const void* address = ContainerAddress(value);
+  if (address == nullptr || visited_.count(address) != 0) {
+    return 0;
+  }
+  if (IsFrozen(value)) {
+    // Interned before, so its descendants are canonical already
+    visited_.insert(address);
+    return InternNode(value) ? 1 : 0;
+  }
+  size_t replaced = 0;
+  if (value.IsObject()) {
+    JsonObject& obj = value.AsObject();
+    for (auto it = obj.Begin(); it != obj.End(); ++it) {
+      replaced += InternTree(it->second);
+    }
+  } else {
+    JsonArray& arr = value.AsArray();
+    for (auto it = arr.Begin(); it != arr.End(); ++it) {
+      replaced += InternTree(*it);
+    }
+  }
+  if (InternNode(value)) {
+    return replaced + 1;
+  }
+  visited_.insert(address);
+  return replaced;
+}
+
+}  // namespace internal
+}  // namespace json_parser
@@ -0,0 +1,43 @@
+#ifndef JSON_PARSER_SRC_JSON_INTERN_H_
+#define JSON_PARSER_SRC_JSON_INTERN_H_
+
+#include "json_parser/json_value.h"
+
+#include <cstddef>
+#include <unordered_set>
+
+namespace json_parser {
+namespace internal {
+
+// Hash-consing table for object and array subtrees. Equal containers are
+// found by their cached structural hash and replaced by the first one seen,
+// so a document ends up holding one shared container per distinct subtree.
+// Canonical containers are frozen: JsonValue's mutable accessors copy them
+// before handing them out, so editing one occurrence leaves the others
+// alone. Strings are stored inline in JsonValue and cannot be shared.
+class JsonInterner {
+ public:
+  // Replaces the container in value by an equal canonical one seen before,
+  // or records it as canonical. Its children must already be interned, so
+  // comparing them stops at shared containers. Returns true if replaced.
+  bool InternNode(JsonValue& value);
+
+  // Interns every container in value bottom up. Returns the number of
+  // containers replaced.
+  size_t InternTree(JsonValue& value);
+
+ private:
+  static bool IsFrozen(const JsonValue& value);
+  // Takes const access: the mutable accessors would copy a container that
+  // an earlier interner froze
+  static void Freeze(const JsonValue& value);
+
+  std::unordered_set<JsonValue> canonical_;
+  // Containers already interned, so shared subtrees are walked once
+  std::unordered_set<const void*> visited_;
+};
+
+}  // namespace internal
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_SRC_JSON_INTERN_H_
@@ -0,0 +1,547 @@
+#include "json_parser/json_msgpack.h"
+#include "json_parser/json_array.h"
+#include "json_parser/json_exception.h"
+#include "json_parser/json_object.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace json_parser {
+
+namespace {
+
+const char* TypeName(JsonMsgPackType type) {
+  switch (type) {
+    case JsonMsgPackType::kNil:
+      return "nil";
+    case JsonMsgPackType::kBoolean:
+      return "boolean";
+    case JsonMsgPackType::kInteger:
+      return "integer";
+    case JsonMsgPackType::kFloat:
+      return "float";
+    case JsonMsgPackType::kString:
+      return "string";
+    case JsonMsgPackType::kBinary:
+      return "binary";
+    case JsonMsgPackType::kArray:
+      return "array";
+    case JsonMsgPackType::kMap:
+      return "map";
+    case JsonMsgPackType::kExtension:
+      return "extension";
+  }
+  return "unknown";
+}
+
+}  // namespace
+
+template <typename T>
+void JsonMsgPackWriter::Put(uint8_t marker, T value) {
+  char* out = out_.Extend(1 + sizeof(T));
+  out[0] = static_cast<char>(marker);
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    size_t shift = 8 * (sizeof(T) - 1 - i);
+    out[1 + i] = static_cast<char>(static_cast<uint64_t>(value) >> shift);
+  }
+}
+
+void JsonMsgPackWriter::WriteNil() { out_.Append(static_cast<char>(0xc0)); }
+
+void JsonMsgPackWriter::WriteBool(bool value) {
+  out_.Append(static_cast<char>(value ? 0xc3 : 0xc2));
+}
+
+void JsonMsgPackWriter::WriteInt(int64_t value) {
+  if (value >= 0) {
+    WriteUInt(static_cast<uint64_t>(value));
+  } else if (value >= -32) {
+    out_.Append(static_cast<char>(value));  // Negative fixint
+  } else if (value >= std::numeric_limits<int8_t>::min()) {
+    Put(0xd0, static_cast<uint8_t>(value));
+  } else if (value >= std::numeric_limits<int16_t>::min()) {
+    Put(0xd1, static_cast<uint16_t>(value));
+  } else if (value >= std::numeric_limits<int32_t>::min()) {
+    Put(0xd2, static_cast<uint32_t>(value));
+  } else {
+    Put(0xd3, static_cast<uint64_t>(value));
+  }
+}
+
+void JsonMsgPackWriter::WriteUInt(uint64_t value) {
+  if (value < 0x80) {
+    out_.Append(static_cast<char>(value));  // Positive fixint
+  } else if (value <= 0xff) {
+    Put(0xcc, static_cast<uint8_t>(value));
+  } else if (value <= 0xffff) {
+    Put(0xcd, static_cast<uint16_t>(value));
+  } else if (value <= 0xffffffff) {
+    Put(0xce, static_cast<uint32_t>(value));
+  } else {
+    Put(0xcf, value);
+  }
+}
+
+void JsonMsgPackWriter::WriteDouble(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  Put(0xcb, bits);
+}
+
+void JsonMsgPackWriter::WriteNumber(double value) {
+  // Negative zero takes the float path, which keeps its sign
+  if (std::trunc(value) == value && value >= -9.2233720368547758e18 &&
+      value < 1.8446744073709552e19 && !(value == 0 && std::signbit(value))) {
+    if (value >= 0) {
+      WriteUInt(static_cast<uint64_t>(value));
+    } else {
+      WriteInt(static_cast<int64_t>(value));
+    }
+    return;
+  }
+  float narrow = static_cast<float>(value);
+  if (static_cast<double>(narrow) == value) {
+    uint32_t bits;
+    std::memcpy(&bits, &narrow, sizeof(bits));
+    Put(0xca, bits);
+  } else {
+    WriteDouble(value);
+  }
+}
+
+void JsonMsgPackWriter::WriteString(const char* data, size_t length) {
+  WriteLength(length, 0xa0, 32, 0xd9, 0xda, 0xdb);
+  out_.Append(data, length);
+}
+
+void JsonMsgPackWriter::WriteBinary(const char* data, size_t length) {
+  WriteLength(length, 0, 0, 0xc4, 0xc5, 0xc6);
+  out_.Append(data, length);
+}
+
+void JsonMsgPackWriter::BeginArray(uint32_t count) {
+  WriteLength(count, 0x90, 16, 0, 0xdc, 0xdd);
+}
+
+void JsonMsgPackWriter::BeginMap(uint32_t count) {
+  WriteLength(count, 0x80, 16, 0, 0xde, 0xdf);
+}
+
+void JsonMsgPackWriter::WriteValue(const JsonValue& value) {
+  switch (value.GetType()) {
+    case JsonValueType::kObject: {
+      const JsonObject& obj = value.AsObject();
+      BeginMap(static_cast<uint32_t>(obj.Size()));
+      for (auto it = obj.Begin(); it != obj.End(); ++it) {
+        WriteString(it->first);
+        WriteValue(it->second);
+      }
+      break;
+    }
+    case JsonValueType::kArray: {
+      const JsonArray& arr = value.AsArray();
+      BeginArray(static_cast<uint32_t>(arr.Size()));
+      for (size_t i = 0; i < arr.Size(); ++i) {
+        WriteValue(arr[i]);
+      }
+      break;
+    }
+    case JsonValueType::kString:
+      WriteString(value.AsString());
+      break;
+    case JsonValueType::kNumber:
+      WriteNumber(value.AsNumber());
+      break;
+    case JsonValueType::kBoolean:
+      WriteBool(value.AsBoolean());
+      break;
+    case JsonValueType::kNull:
+      WriteNil();
+      break;
+  }
+}
+
+// Fixed-size forms are used when fix_limit allows, then the 8-bit form if
+// the format has one (marker8 != 0), then 16 and 32 bits
+void JsonMsgPackWriter::WriteLength(size_t length, uint8_t fix_base,
+                                    size_t fix_limit, uint8_t marker8,
+                                    uint8_t marker16, uint8_t marker32) {
+  if (length < fix_limit) {
+    out_.Append(static_cast<char>(fix_base | length));
+  } else if (marker8 != 0 && length <= 0xff) {
+    Put(marker8, static_cast<uint8_t>(length));
+  } else if (length <= 0xffff) {
+    Put(marker16, static_cast<uint16_t>(length));
+  } else if (length <= 0xffffffff) {
+    Put(marker32, static_cast<uint32_t>(length));
+  } else {
+    throw JsonException("MessagePack length exceeds 32 bits");
+  }
+}
+
+JsonMsgPackReader::JsonMsgPackReader(const char* data, size_t size,
+                                     size_t max_depth)
+    : data_(reinterpret_cast<const uint8_t*>(data)),
+      size_(size),
+      max_depth_(max_depth) {}
+
+JsonMsgPackType JsonMsgPackReader::PeekType() const {
+  uint8_t marker = PeekByte();
+  if (marker <= 0x7f || marker >= 0xe0) {
+    return JsonMsgPackType::kInteger;
+  }
+  if (marker <= 0x8f) {
+    return JsonMsgPackType::kMap;
+  }
+  if (marker <= 0x9f) {
+    return JsonMsgPackType::kArray;
+  }
+  if (marker <= 0xbf) {
+    return JsonMsgPackType::kString;
+  }
+  switch (marker) {
+    case 0xc0:
+      return JsonMsgPackType::kNil;
+    case 0xc2:
+    case 0xc3:
+      return JsonMsgPackType::kBoolean;
+    case 0xc4:
+    case 0xc5:
+    case 0xc6:
+      return JsonMsgPackType::kBinary;
+    case 0xc7:
+    case 0xc8:
+    case 0xc9:
+    case 0xd4:
+    case 0xd5:
+    case 0xd6:
+    case 0xd7:
+    case 0xd8:
+      return JsonMsgPackType::kExtension;
+    case 0xca:
+    case 0xcb:
+      return JsonMsgPackType::kFloat;
+    case 0xcc:
+    case 0xcd:
+    case 0xce:
+    case 0xcf:
+    case 0xd0:
+    case 0xd1:
+    case 0xd2:
+    case 0xd3:
+      return JsonMsgPackType::kInteger;
+    case 0xd9:
+    case 0xda:
+    case 0xdb:
+      return JsonMsgPackType::kString;
+    case 0xdc:
+    case 0xdd:
+      return JsonMsgPackType::kArray;
+    case 0xde:
+    case 0xdf:
+      return JsonMsgPackType::kMap;
+    default:
+      Fail("Invalid MessagePack marker");
+  }
+}
+
+void JsonMsgPackReader::ReadNil() {
+  if (PeekType() != JsonMsgPackType::kNil) {
+    TypeMismatch("nil");
+  }
+  ++position_;
+}
+
+bool JsonMsgPackReader::ReadBool() {
+  if (PeekType() != JsonMsgPackType::kBoolean) {
+    TypeMismatch("boolean");
+  }
+  return data_[position_++] == 0xc3;
+}
+
+int64_t JsonMsgPackReader::ReadInt64() {
+  if (PeekType() != JsonMsgPackType::kInteger) {
+    TypeMismatch("integer");
+  }
+  uint8_t marker = data_[position_++];
+  if (marker <= 0x7f) {
+    return marker;
+  }
+  if (marker >= 0xe0) {
+    return static_cast<int8_t>(marker);
+  }
+  switch (marker) {
+    case 0xcc:
+      return static_cast<int64_t>(ReadBigEndian(1));
+    case 0xcd:
+      return static_cast<int64_t>(ReadBigEndian(2));
+    case 0xce:
+      return static_cast<int64_t>(ReadBigEndian(4));
+    case 0xcf: {
+      uint64_t value = ReadBigEndian(8);
+      if (value > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        position_ -= 9;
+        throw JsonTypeException("Integer out of range at position " +
+                                std::to_string(position_));
+      }
+      return static_cast<int64_t>(value);
+    }
+    case 0xd0:
+      return static_cast<int8_t>(ReadBigEndian(1));
+    case 0xd1:
+      return static_cast<int16_t>(ReadBigEndian(2));
+    case 0xd2:
+      return static_cast<int32_t>(ReadBigEndian(4));
+    default:
+      return static_cast<int64_t>(ReadBigEndian(8));
+  }
+}
+
+uint64_t JsonMsgPackReader::ReadUInt64() {
+  if (PeekType() != JsonMsgPackType::kInteger) {
+    TypeMismatch("integer");
+  }
+  uint8_t marker = PeekByte();
+  if (marker == 0xcf) {
+    ++position_;
+    return ReadBigEndian(8);
+  }
+  size_t start = position_;
+  int64_t value = ReadInt64();
+  if (value < 0) {
+    position_ = start;
+    throw JsonTypeException("Expected unsigned integer at position " +
+                            std::to_string(start));
+  }
+  return static_cast<uint64_t>(value);
+}
+
+double JsonMsgPackReader::ReadDouble() {
+  JsonMsgPackType type = PeekType();
+  if (type == JsonMsgPackType::kInteger) {
+    uint8_t marker = PeekByte();
+    if (marker == 0xcf) {
+      return static_cast<double>(ReadUInt64());
+    }
+    return static_cast<double>(ReadInt64());
+  }
+  if (type != JsonMsgPackType::kFloat) {
+    TypeMismatch("number");
+  }
+  if (data_[position_++] == 0xca) {
+    uint32_t bits = static_cast<uint32_t>(ReadBigEndian(4));
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+  uint64_t bits = ReadBigEndian(8);
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+std::string_view JsonMsgPackReader::ReadString() {
+  if (PeekType() != JsonMsgPackType::kString) {
+    TypeMismatch("string");
+  }
+  uint8_t marker = data_[position_++];
+  size_t length;
+  if (marker <= 0xbf) {
+    length = marker & 0x1f;
+  } else {
+    length = ReadBigEndian(size_t{1} << (marker - 0xd9));
+  }
+  return std::string_view(reinterpret_cast<const char*>(Take(length)), length);
+}
+
+std::string_view JsonMsgPackReader::ReadBinary() {
+  if (PeekType() != JsonMsgPackType::kBinary) {
+    TypeMismatch("binary");
+  }
+  uint8_t marker = data_[position_++];
+  size_t length = ReadBigEndian(size_t{1} << (marker - 0xc4));
+  return std::string_view(reinterpret_cast<const char*>(Take(length)), length);
+}
+
+uint32_t JsonMsgPackReader::ReadArrayHeader() {
+  if (PeekType() != JsonMsgPackType::kArray) {
+    TypeMismatch("array");
+  }
+  uint8_t marker = data_[position_++];
+  if (marker <= 0x9f) {
+    return marker & 0x0f;
+  }
+  return static_cast<uint32_t>(ReadBigEndian(marker == 0xdc ? 2 : 4));
+}
+
+uint32_t JsonMsgPackReader::ReadMapHeader() {
+  if (PeekType() != JsonMsgPackType::kMap) {
+    TypeMismatch("map");
+  }
+  uint8_t marker = data_[position_++];
+  if (marker <= 0x8f) {
+    return marker & 0x0f;
+  }
+  return static_cast<uint32_t>(ReadBigEndian(marker == 0xde ? 2 : 4));
+}
+
+void JsonMsgPackReader::Skip() { Skip(0); }
+
+JsonValue JsonMsgPackReader::ReadValue() { return ReadValue(0); }
+
+void JsonMsgPackReader::Fail(const std::string& message) const {
+  throw JsonParseException(message, position_);
+}
+
+void JsonMsgPackReader::TypeMismatch(const char* expected) const {
+  throw JsonTypeException(std::string("Expected ") + expected + ", got " +
+                          TypeName(PeekType()) + " at position " +
+                          std::to_string(position_));
+}
+
+uint8_t JsonMsgPackReader::PeekByte() const {
+  if (position_ >= size_) {
+    Fail("Unexpected end of MessagePack input");
+  }
+  return data_[position_];
+}
+
+const uint8_t* JsonMsgPackReader::Take(size_t length) {
+  if (length > size_ - position_) {
+    Fail("Unexpected end of MessagePack input");
+  }
+  const uint8_t* start = data_ + position_;
+  position_ += length;
+  return start;
+}
+
+uint64_t JsonMsgPackReader::ReadBigEndian(size_t length) {
+  const uint8_t* bytes = Take(length);
+  uint64_t value = 0;
+  for (size_t i = 0; i < length; ++i) {
+    value = (value << 8) | bytes[i];
+  }
+  return value;
+}
+
+void JsonMsgPackReader::Skip(size_t depth) {
+  if (depth > max_depth_) {
+    Fail("Maximum nesting depth exceeded");
+  }
+  switch (PeekType()) {
+    case JsonMsgPackType::kNil:
+    case JsonMsgPackType::kBoolean:
+      ++position_;
+      break;
+    case JsonMsgPackType::kInteger:
+    case JsonMsgPackType::kFloat:
+      ReadDouble();
+      break;
+    case JsonMsgPackType::kString:
+      ReadString();
+      break;
+    case JsonMsgPackType::kBinary:
+      ReadBinary();
+      break;
+    case JsonMsgPackType::kArray:
+      for (uint32_t i = ReadArrayHeader(); i > 0; --i) {
+        Skip(depth + 1);
+      }
+      break;
+    case JsonMsgPackType::kMap:
+      for (uint32_t i = ReadMapHeader(); i > 0; --i) {
+        Skip(depth + 1);
+        Skip(depth + 1);
+      }
+      break;
+    case JsonMsgPackType::kExtension: {
+      uint8_t marker = data_[position_++];
+      size_t length;
+      if (marker >= 0xd4) {
+        length = size_t{1} << (marker - 0xd4);
+      } else {
+        length = ReadBigEndian(size_t{1} << (marker - 0xc7));
+      }
+      Take(1 + length);  // Type byte and payload
+      break;
+    }
+  }
+}
+
+JsonValue JsonMsgPackReader::ReadValue(size_t depth) {
+  if (depth > max_depth_) {
+    Fail("Maximum nesting depth exceeded");
+  }
+  switch (PeekType()) {
+    case JsonMsgPackType::kNil:
+      ++position_;
+      return JsonValue(nullptr);
+    case JsonMsgPackType::kBoolean:
+      return JsonValue(ReadBool());
+    case JsonMsgPackType::kInteger:
+    case JsonMsgPackType::kFloat:
+      return JsonValue(ReadDouble());
+    case JsonMsgPackType::kString:
+      return JsonValue(std::string(ReadString()));
+    case JsonMsgPackType::kBinary:
+      return JsonValue(std::string(ReadBinary()));
+    case JsonMsgPackType::kArray: {
+      uint32_t count = ReadArrayHeader();
+      JsonValue result{JsonArray()};
+      JsonArray& arr = result.AsArray();
+      // Each element takes at least one byte, so a count larger than the
+      // remaining input is malformed and must not drive the reservation
+      arr.Reserve(std::min<size_t>(count, size_ - position_));
+      for (uint32_t i = 0; i < count; ++i) {
+        arr.PushBack(ReadValue(depth + 1));
+      }
+      return result;
+    }
+    case JsonMsgPackType::kMap: {
+      uint32_t count = ReadMapHeader();
+      JsonValue result{JsonObject()};
+      JsonObject& obj = result.AsObject();
+      for (uint32_t i = 0; i < count; ++i) {
+        if (PeekType() != JsonMsgPackType::kString) {
+          throw JsonTypeException("MessagePack map keys must be strings at "
+                                  "position " + std::to_string(position_));
+        }
+        std::string key(ReadString());
+        obj.Insert(key, ReadValue(depth + 1));
+      }
+      return result;
+    }
+    case JsonMsgPackType::kExtension:
+      break;
+  }
+  throw JsonTypeException("MessagePack extension types are not supported at "
+                          "position " + std::to_string(position_));
+}
+
+std::string JsonMsgPack::Encode(const JsonValue& value) {
+  JsonOutputBuffer out;
+  Encode(value, out);
+  return out.TakeString();
+}
+
+void JsonMsgPack::Encode(const JsonValue& value, JsonOutputBuffer& out) {
+  JsonMsgPackWriter(out).WriteValue(value);
+}
+
+JsonValue JsonMsgPack::Decode(const std::string& data) {
+  return Decode(data.data(), data.size());
+}
+
+JsonValue JsonMsgPack::Decode(const char* data, size_t size) {
+  JsonMsgPackReader reader(data, size);
+  JsonValue value = reader.ReadValue();
+  if (!reader.AtEnd()) {
+    throw JsonParseException("Unexpected bytes after MessagePack value",
+                             reader.Position());
+  }
+  return value;
+}
+
+}  // namespace json_parser
@@ -0,0 +1,182 @@
+#include "json_number_format.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace json_parser {
+namespace internal {
+
+namespace {
+
+// "00" through "99", so integers are written two digits per division
+constexpr char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+int CountDigits(uint64_t value) {
+  int digits = 1;
+  while (value >= 10000) {
+    value /= 10000;
+    digits += 4;
+  }
+  if (value >= 1000) return digits + 3;
+  if (value >= 100) return digits + 2;
+  if (value >= 10) return digits + 1;
+  return digits;
+}
+
+}  // namespace
+
+char* FormatUInt64(char* buffer, uint64_t value) {
+  char* end = buffer + CountDigits(value);
+  char* p = end;
+  while (value >= 100) {
+    const char* pair = kDigitPairs + (value % 100) * 2;
+    value /= 100;
+    *--p = pair[1];
+    *--p = pair[0];
+  }
+  if (value >= 10) {
+    const char* pair = kDigitPairs + value * 2;
+    *--p = pair[1];
+    *--p = pair[0];
+  } else {
+    *--p = static_cast<char>('0' + value);
+  }
+  return end;
+}
+
+char* FormatInt64(char* buffer, int64_t value) {
+  if (value < 0) {
+    *buffer++ = '-';
+    // Negate in unsigned arithmetic so INT64_MIN does not overflow
+    return FormatUInt64(buffer, 0 - static_cast<uint64_t>(value));
+  }
+  return FormatUInt64(buffer, static_cast<uint64_t>(value));
+}
+
+char* FormatDouble(char* buffer, double value) {
+  if (std::isnan(value) || std::isinf(value)) {
+    std::memcpy(buffer, "null", 4);
+    return buffer + 4;
+  }
+  // Negative zero falls through so its sign survives the round trip
+  if (value == std::trunc(value) && std::fabs(value) < 9.2233720368547758e18 &&
+      !(value == 0 && std::signbit(value))) {
+    return FormatInt64(buffer, static_cast<int64_t>(value));
+  }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  // Shortest round-trip representation (Ryu in libstdc++ and MSVC)
+  return std::to_chars(buffer, buffer + kMaxNumberLength, value).ptr;
+#else
+  // Fewest significant digits that still read back as the same double
+  int length = 0;
+  for (int precision = 15; precision <= 17; ++precision) {
+    length = std::snprintf(buffer, kMaxNumberLength, "%.*g", precision, value);
+    if (std::strtod(buffer, nullptr) == value) {
+      break;
+    }
+  }
+  return buffer + length;
+#endif
+}
+
+char* FormatDoubleEcmaScript(char* buffer, double value) {
+  if (std::isnan(value) || std::isinf(value)) {
+    std::memcpy(buffer, "null", 4);
+    return buffer + 4;
+  }
+  if (value == 0) {
+    *buffer = '0';
+    return buffer + 1;
+  }
+  // Below 2^53 every integer needs all of its digits to round-trip
+  if (value == std::trunc(value) && std::fabs(value) < 9007199254740992.0) {
+    return FormatInt64(buffer, static_cast<int64_t>(value));
+  }
+  if (value < 0) {
+    *buffer++ = '-';
+    value = -value;
+  }
+
+  // Shortest digits and decimal exponent, from d.ddde[+-]x
+  char scientific[kMaxNumberLength];
+  char* scientific_end;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  scientific_end = std::to_chars(scientific, scientific + kMaxNumberLength,
+                                 value, std::chars_format::scientific)
+                       .ptr;
+#else
+  int length = 0;
+  for (int precision = 0; precision <= 16; ++precision) {
+    length = std::snprintf(scientific, kMaxNumberLength, "%.*e", precision,
+                           value);
+    if (std::strtod(scientific, nullptr) == value) {
+      break;
+    }
+  }
+  scientific_end = scientific + length;
+#endif
+  char digits[kMaxNumberLength];
+  int k = 0;
+  const char* p = scientific;
+  for (; p < scientific_end && *p != 'e'; ++p) {
+    if (*p != '.') {
+      digits[k++] = *p;
+    }
+  }
+  // The exponent, which is not NUL-terminated
+  bool negative_exponent = false;
+  int exponent = 0;
+  for (++p; p < scientific_end; ++p) {
+    if (*p == '-') {
+      negative_exponent = true;
+    } else if (*p != '+') {
+      exponent = exponent * 10 + (*p - '0');
+    }
+  }
+  // The position of the decimal point relative to the digits
+  const int n = (negative_exponent ? -exponent : exponent) + 1;
+
+  if (k <= n && n <= 21) {
+    std::memcpy(buffer, digits, k);
+    std::memset(buffer + k, '0', n - k);
+    return buffer + n;
+  }
+  if (0 < n && n <= 21) {
+    std::memcpy(buffer, digits, n);
+    buffer[n] = '.';
+    std::memcpy(buffer + n + 1, digits + n, k - n);
+    return buffer + k + 1;
+  }
+  if (-6 < n && n <= 0) {
+    buffer[0] = '0';
+    buffer[1] = '.';
+    std::memset(buffer + 2, '0', -n);
+    std::memcpy(buffer + 2 - n, digits, k);
+    return buffer + 2 - n + k;
+  }
+  *buffer++ = digits[0];
+  if (k > 1) {
+    *buffer++ = '.';
+    std::memcpy(buffer, digits + 1, k - 1);
+    buffer += k - 1;
+  }
+  *buffer++ = 'e';
+  *buffer++ = n - 1 < 0 ? '-' : '+';
+  return FormatUInt64(buffer, static_cast<uint64_t>(std::abs(n - 1)));
+}
+
+}  // namespace internal
+}  // namespace json_parser
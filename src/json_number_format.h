@@ -0,0 +1,34 @@
+#ifndef JSON_PARSER_SRC_JSON_NUMBER_FORMAT_H_
+#define JSON_PARSER_SRC_JSON_NUMBER_FORMAT_H_
+
+// Internal number formatting shared by JsonWriter, JsonValue::ToString and
+// the binders, so every serializer prints a given number the same way.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace json_parser {
+namespace internal {
+
+// Longest output of any formatter below, with room to spare
+constexpr size_t kMaxNumberLength = 32;
+
+// Each writes at buffer, which must hold kMaxNumberLength bytes, and
+// returns the end of the output. Nothing is NUL-terminated.
+char* FormatUInt64(char* buffer, uint64_t value);
+char* FormatInt64(char* buffer, int64_t value);
+
+// Integral values in int64_t range print as integers. Everything else
+// gets the shortest decimal that reads back as the same double; non-finite
+// values print as null, since JSON cannot represent them.
+char* FormatDouble(char* buffer, double value);
+
+// ECMAScript Number.prototype.toString, as RFC 8785 requires: the shortest
+// round-trip digits, positional from 1e-6 up to 1e21 and otherwise as
+// d.ddde+N. Negative zero prints as 0 and non-finite values as null.
+char* FormatDoubleEcmaScript(char* buffer, double value);
+
+}  // namespace internal
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_SRC_JSON_NUMBER_FORMAT_H_
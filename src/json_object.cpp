@@ -1,5 +1,6 @@
 #include "json_parser/json_object.h"
 #include "json_parser/json_exception.h"
+#include "json_to_string.h"
 
 #include <algorithm>
 
@@ -7,6 +8,7 @@ namespace json_parser {
 
 // Element access
 JsonValue& JsonObject::operator[](const std::string& key) {
+  hash_cache_.Invalidate();
   return values_[key];
 }
 
@@ -19,6 +21,7 @@ const JsonValue& JsonObject::operator[](const std::string& key) const {
 }
 
 JsonValue& JsonObject::At(const std::string& key) {
+  hash_cache_.Invalidate();
   auto it = values_.find(key);
   if (it == values_.end()) {
     throw JsonKeyException(key);
@@ -36,14 +39,17 @@ const JsonValue& JsonObject::At(const std::string& key) const {
 
 // Modifiers
 void JsonObject::Insert(const std::string& key, const JsonValue& value) {
+  hash_cache_.Invalidate();
   values_[key] = value;
 }
 
 void JsonObject::Insert(const std::string& key, JsonValue&& value) {
+  hash_cache_.Invalidate();
   values_[key] = std::move(value);
 }
 
 void JsonObject::Erase(const std::string& key) {
+  hash_cache_.Invalidate();
   values_.erase(key);
 }
 
@@ -56,6 +62,17 @@ size_t JsonObject::Count(const std::string& key) const {
   return values_.count(key);
 }
 
+JsonValue* JsonObject::Find(const std::string& key) {
+  hash_cache_.Invalidate();
+  auto it = values_.find(key);
+  return it == values_.end() ? nullptr : &it->second;
+}
+
+const JsonValue* JsonObject::Find(const std::string& key) const {
+  auto it = values_.find(key);
+  return it == values_.end() ? nullptr : &it->second;
+}
+
 // Get all keys
 std::vector<std::string> JsonObject::GetKeys() const {
   std::vector<std::string> keys;
@@ -68,52 +85,27 @@ std::vector<std::string> JsonObject::GetKeys() const {
 
 // String representation
 std::string JsonObject::ToString(int indent) const {
-  if (values_.empty()) {
-    return "{}";
-  }
-
-  std::string result = "{\n";
-  std::string indent_str(indent + 2, ' ');
-  bool first = true;
-
-  for (const auto& pair : values_) {
-    if (!first) {
-      result += ",\n";
-    }
-    first = false;
-    result += indent_str + "\"" + pair.first + "\": " +
-              pair.second.ToString(indent + 2);
-  }
-
-  result += "\n" + std::string(indent, ' ') + "}";
-  return result;
+  return internal::ToJsonString(*this, /*pretty=*/true, indent);
 }
 
 std::string JsonObject::ToCompactString() const {
-  if (values_.empty()) {
-    return "{}";
-  }
-
-  std::string result = "{";
-  bool first = true;
-
-  for (const auto& pair : values_) {
-    if (!first) {
-      result += ",";
-    }
-    first = false;
-    result += "\"" + pair.first + "\":" + pair.second.ToCompactString();
-  }
-
-  result += "}";
-  return result;
+  return internal::ToJsonString(*this, /*pretty=*/false, 0);
 }
 
 // Comparison
 bool JsonObject::operator==(const JsonObject& other) const {
+  if (this == &other) {
+    return true;
+  }
   if (values_.size() != other.values_.size()) {
     return false;
   }
+  uint64_t hash = 0;
+  uint64_t other_hash = 0;
+  if (hash_cache_.Get(&hash) && other.hash_cache_.Get(&other_hash) &&
+      hash != other_hash) {
+    return false;
+  }
 
   for (const auto& pair : values_) {
     auto it = other.values_.find(pair.first);
@@ -0,0 +1,176 @@
+#include "json_parser/json_output_buffer.h"
+#include "json_parser/json_exception.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace json_parser {
+
+namespace {
+
+long WriteSome(int fd, const char* data, size_t length) {
+#if defined(_WIN32)
+  return _write(fd, data, static_cast<unsigned int>(length));
+#else
+  return static_cast<long>(::write(fd, data, length));
+#endif
+}
+
+[[noreturn]] void ThrowWriteError(int fd) {
+  throw JsonException("Write to file descriptor " + std::to_string(fd) +
+                      " failed");
+}
+
+void WriteAll(int fd, const char* data, size_t length) {
+  size_t written = 0;
+  while (written < length) {
+    long result = WriteSome(fd, data + written, length - written);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      ThrowWriteError(fd);
+    }
+    written += static_cast<size_t>(result);
+  }
+}
+
+}  // namespace
+
+JsonOutputBuffer::JsonOutputBuffer(std::ostream& sink, size_t flush_threshold)
+    : sink_(&sink), flush_threshold_(flush_threshold) {
+  data_.reserve(flush_threshold);
+}
+
+JsonOutputBuffer::JsonOutputBuffer(int fd, size_t flush_threshold,
+                                   bool gather)
+    : fd_(fd), flush_threshold_(flush_threshold), gather_(gather) {
+#if defined(_WIN32)
+  // No writev; referenced runs are copied instead
+  gather_ = false;
+#endif
+  data_.reserve(flush_threshold);
+}
+
+JsonOutputBuffer::~JsonOutputBuffer() {
+  // Destructors must not throw; callers who care about write errors on a
+  // descriptor call Flush() themselves first
+  try {
+    Flush();
+  } catch (const JsonException&) {
+  }
+}
+
+void JsonOutputBuffer::Flush() {
+  if (Size() == 0) {
+    return;
+  }
+  if (sink_ != nullptr) {
+    sink_->write(data_.data(), static_cast<std::streamsize>(data_.size()));
+    data_.clear();
+  } else if (fd_ >= 0) {
+    if (segments_.empty()) {
+      // Clear before writing so a failed write is not retried
+      std::string pending;
+      pending.swap(data_);
+      data_.reserve(flush_threshold_);
+      WriteAll(fd_, pending.data(), pending.size());
+    } else {
+      WriteSegments();
+    }
+  }
+}
+
+void JsonOutputBuffer::Clear() {
+  data_.clear();
+  segments_.clear();
+  owned_.clear();
+  segment_bytes_ = 0;
+}
+
+std::string JsonOutputBuffer::TakeString() {
+  std::string result;
+  if (segments_.empty()) {
+    result = std::move(data_);
+  } else {
+    result.reserve(Size());
+    for (const Segment& segment : segments_) {
+      result.append(segment.data != nullptr ? segment.data
+                                            : owned_[segment.owned].data(),
+                    segment.length);
+    }
+    result += data_;
+  }
+  Clear();
+  return result;
+}
+
+void JsonOutputBuffer::AddReference(const char* data, size_t length) {
+  SealData();
+  segments_.push_back({data, length, 0});
+  segment_bytes_ += length;
+  MaybeFlush();
+}
+
+void JsonOutputBuffer::SealData() {
+  if (data_.empty()) {
+    return;
+  }
+  segment_bytes_ += data_.size();
+  segments_.push_back({nullptr, data_.size(), owned_.size()});
+  owned_.push_back(std::move(data_));
+  data_.clear();
+  data_.reserve(flush_threshold_);
+}
+
+void JsonOutputBuffer::WriteSegments() {
+#if !defined(_WIN32)
+  SealData();
+  std::vector<struct iovec> vectors;
+  vectors.reserve(segments_.size());
+  for (const Segment& segment : segments_) {
+    const char* base = segment.data != nullptr ? segment.data
+                                               : owned_[segment.owned].data();
+    vectors.push_back({const_cast<char*>(base), segment.length});
+  }
+  std::vector<std::string> owned = std::move(owned_);
+  Clear();
+
+  // Partial writes leave the first vectors done and one partly done
+  constexpr size_t kMaxVectors = 1024;  // IOV_MAX on Linux and macOS
+  size_t first = 0;
+  while (first < vectors.size()) {
+    size_t count = std::min(vectors.size() - first, kMaxVectors);
+    ssize_t result =
+        ::writev(fd_, &vectors[first], static_cast<int>(count));
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      ThrowWriteError(fd_);
+    }
+    size_t written = static_cast<size_t>(result);
+    while (first < vectors.size() && written >= vectors[first].iov_len) {
+      written -= vectors[first].iov_len;
+      ++first;
+    }
+    if (written > 0) {
+      vectors[first].iov_base =
+          static_cast<char*>(vectors[first].iov_base) + written;
+      vectors[first].iov_len -= written;
+    }
+  }
+#endif
+}
+
+}  // namespace json_parser
@@ -0,0 +1,91 @@
+#include "json_parser/json_padded_buffer.h"
+#include "json_parser/json_exception.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace json_parser {
+
+const char PaddedJsonBuffer::kEmpty[PaddedJsonBuffer::kPadding] = {};
+
+PaddedJsonBuffer::PaddedJsonBuffer(const std::string& json) {
+  Assign(json.data(), json.length());
+}
+
+PaddedJsonBuffer::PaddedJsonBuffer(const char* data, size_t length) {
+  Assign(data, length);
+}
+
+PaddedJsonBuffer::PaddedJsonBuffer(const PaddedJsonBuffer& other) {
+  Assign(other.data_, other.length_);
+}
+
+PaddedJsonBuffer::PaddedJsonBuffer(PaddedJsonBuffer&& other) noexcept
+    : storage_(std::move(other.storage_)),
+      data_(other.data_),
+      length_(other.length_) {
+  other.data_ = kEmpty;
+  other.length_ = 0;
+}
+
+PaddedJsonBuffer& PaddedJsonBuffer::operator=(const PaddedJsonBuffer& other) {
+  if (this != &other) {
+    Assign(other.data_, other.length_);
+  }
+  return *this;
+}
+
+PaddedJsonBuffer& PaddedJsonBuffer::operator=(
+    PaddedJsonBuffer&& other) noexcept {
+  if (this != &other) {
+    storage_ = std::move(other.storage_);
+    data_ = other.data_;
+    length_ = other.length_;
+    other.data_ = kEmpty;
+    other.length_ = 0;
+  }
+  return *this;
+}
+
+PaddedJsonBuffer PaddedJsonBuffer::View(const char* data, size_t length) {
+  PaddedJsonBuffer buffer;
+  buffer.data_ = data;
+  buffer.length_ = length;
+  return buffer;
+}
+
+PaddedJsonBuffer PaddedJsonBuffer::FromFile(const std::string& filename) {
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    throw JsonFileException(filename);
+  }
+  std::streamsize size = file.tellg();
+  if (size < 0) {
+    throw JsonFileException(filename);
+  }
+  file.seekg(0, std::ios::beg);
+
+  PaddedJsonBuffer buffer;
+  size_t length = static_cast<size_t>(size);
+  buffer.storage_.reset(new char[length + kPadding]);
+  if (length > 0 && !file.read(buffer.storage_.get(), size)) {
+    throw JsonFileException(filename);
+  }
+  std::memset(buffer.storage_.get() + length, 0, kPadding);
+  buffer.data_ = buffer.storage_.get();
+  buffer.length_ = length;
+  return buffer;
+}
+
+void PaddedJsonBuffer::Assign(const char* data, size_t length) {
+  std::unique_ptr<char[]> storage(new char[length + kPadding]);
+  if (length > 0) {
+    std::memcpy(storage.get(), data, length);
+  }
+  std::memset(storage.get() + length, 0, kPadding);
+  storage_ = std::move(storage);
+  data_ = storage_.get();
+  length_ = length;
+}
+
+}  // namespace json_parser
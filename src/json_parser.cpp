@@ -2,41 +2,85 @@
 #include "json_parser/json_exception.h"
 #include "json_parser/json_object.h"
 #include "json_parser/json_array.h"
+#include "json_parser/json_gzip.h"
+#include "json_parser/json_projection.h"
 
 #include <cctype>
-#include <cmath>
-#include <fstream>
-#include <sstream>
+#include <cstdlib>
+#include <cstring>
+
+#include "json_intern.h"
+#include "json_scan.h"
 
 namespace json_parser {
 
+using internal::AppendUtf8;
+using internal::HexDigitValue;
+using internal::IsDigit;
+using internal::ScanStringRun;
+
 // Constructor
 JsonParser::JsonParser(const JsonParserConfig& config) : config_(config) {}
 
 // Parse JSON from string (instance method)
 JsonValue JsonParser::ParseString(const std::string& json) {
+  return ParseString(PaddedJsonBuffer(json));
+}
+
+JsonValue JsonParser::ParseString(const char* json, size_t length) {
+  return ParseString(PaddedJsonBuffer(json, length));
+}
+
+JsonValue JsonParser::ParseString(const PaddedJsonBuffer& json) {
   Initialize(json);
+  internal::JsonInterner interner;
+  interner_ = config_.intern_subtrees ? &interner : nullptr;
   JsonValue result = ParseValue();
   SkipWhitespace();
-  if (position_ < input_.length()) {
+  if (!AtEnd()) {
     ThrowParseError("Unexpected characters after JSON value");
   }
+  interner_ = nullptr;
   return result;
 }
 
-JsonValue JsonParser::ParseString(const char* json, size_t length) {
-  return ParseString(std::string(json, length));
+JsonValue JsonParser::ParseString(const std::string& json,
+                                  const JsonProjection& projection) {
+  return ParseString(PaddedJsonBuffer(json), projection);
+}
+
+JsonValue JsonParser::ParseString(const PaddedJsonBuffer& json,
+                                  const JsonProjection& projection) {
+  Initialize(json);
+  projection_ = projection.IncludesAll() ? nullptr : &projection;
+  internal::JsonInterner interner;
+  interner_ = config_.intern_subtrees ? &interner : nullptr;
+  JsonValue result = ParseValue();
+  SkipWhitespace();
+  if (!AtEnd()) {
+    ThrowParseError("Unexpected characters after JSON value");
+  }
+  projection_ = nullptr;
+  interner_ = nullptr;
+  return result;
 }
 
 // Parse JSON from file (instance method)
 JsonValue JsonParser::ParseFileImpl(const std::string& filename) {
-  std::ifstream file(filename);
-  if (!file.is_open()) {
-    throw JsonFileException(filename);
+  if (!JsonGzip::IsGzipFile(filename)) {
+    return ParseString(PaddedJsonBuffer::FromFile(filename));
+  }
+  // Inflate on the stream's thread while this one copies out blocks. The
+  // text is built with its padding so it can be viewed without a copy.
+  JsonGzipInputStream input(filename);
+  std::string text;
+  char chunk[64 * 1024];
+  while (input.read(chunk, sizeof(chunk)) || input.gcount() > 0) {
+    text.append(chunk, static_cast<size_t>(input.gcount()));
   }
-  std::stringstream buffer;
-  buffer << file.rdbuf();
-  return ParseString(buffer.str());
+  size_t length = text.size();
+  text.append(PaddedJsonBuffer::kPadding, '\0');
+  return ParseString(PaddedJsonBuffer::View(text.data(), length));
 }
 
 // Static convenience methods
@@ -46,6 +90,19 @@ JsonValue JsonParser::Parse(const std::string& json,
   return parser.ParseString(json);
 }
 
+JsonValue JsonParser::Parse(const PaddedJsonBuffer& json,
+                            const JsonParserConfig& config) {
+  JsonParser parser(config);
+  return parser.ParseString(json);
+}
+
+JsonValue JsonParser::Parse(const std::string& json,
+                            const JsonProjection& projection,
+                            const JsonParserConfig& config) {
+  JsonParser parser(config);
+  return parser.ParseString(json, projection);
+}
+
 JsonValue JsonParser::ParseFile(const std::string& filename,
                                  const JsonParserConfig& config) {
   JsonParser parser(config);
@@ -53,11 +110,14 @@ JsonValue JsonParser::ParseFile(const std::string& filename,
 }
 
 // Initialize parser state
-void JsonParser::Initialize(const std::string& input) {
-  input_ = input;
+void JsonParser::Initialize(const PaddedJsonBuffer& input) {
+  input_ = input.Data();
+  length_ = input.Size();
   position_ = 0;
   line_ = 1;
   column_ = 1;
+  projection_ = nullptr;
+  interner_ = nullptr;
 }
 
 // Parse methods
@@ -71,9 +131,17 @@ JsonValue JsonParser::ParseValue() {
   char c = Current();
 
   if (c == '{') {
-    return JsonValue(ParseObject());
+    JsonValue value(ParseObject());
+    if (interner_ != nullptr) {
+      interner_->InternNode(value);
+    }
+    return value;
   } else if (c == '[') {
-    return JsonValue(ParseArray());
+    JsonValue value(ParseArray());
+    if (interner_ != nullptr) {
+      interner_->InternNode(value);
+    }
+    return value;
   } else if (c == '"') {
     return JsonValue(ParseString());
   } else if (c == '-' || (c >= '0' && c <= '9')) {
@@ -120,8 +188,14 @@ JsonObject JsonParser::ParseObject() {
       SkipComments();
     }
 
-    JsonValue value = ParseValue();
-    obj.Insert(key, value);
+    if (projection_ == nullptr) {
+      obj.Insert(key, ParseValue());
+    } else {
+      JsonValue value;
+      if (ParseMaskedValue(projection_->Child(key), value)) {
+        obj.Insert(key, std::move(value));
+      }
+    }
 
     SkipWhitespace();
     if (config_.allow_comments) {
@@ -162,7 +236,15 @@ JsonArray JsonParser::ParseArray() {
       SkipComments();
     }
 
-    JsonValue value = ParseValue();
+    if (projection_ == nullptr) {
+      arr.PushBack(ParseValue());
+    } else {
+      // Arrays are transparent to the mask: it applies to each element
+      JsonValue value;
+      if (ParseMaskedValue(projection_, value)) {
+        arr.PushBack(std::move(value));
+      }
+    }
 
     SkipWhitespace();
     if (config_.allow_comments) {
@@ -192,7 +274,16 @@ std::string JsonParser::ParseString() {
   std::string result;
   result.reserve(64);
 
-  while (position_ < input_.length()) {
+  while (true) {
+    // Plain runs contain no newlines, so only the column advances
+    size_t run = ScanStringRun(input_ + position_);
+    if (run > 0) {
+      result.append(input_ + position_, run);
+      position_ += run;
+      column_ += run;
+      ValidateStringLength(result.length());
+    }
+
     char c = Next();
     if (c == '"') {
       break;
@@ -224,15 +315,18 @@ std::string JsonParser::ParseString() {
           result += '\t';
           break;
         case 'u': {
-          // Unicode escape - simplified implementation
-          for (int i = 0; i < 4; ++i) {
-            if (position_ >= input_.length() ||
-                !std::isxdigit(input_[position_])) {
-              ThrowParseError("Invalid Unicode escape sequence");
+          uint32_t code_point = ParseHex4();
+          if (code_point >= 0xD800 && code_point < 0xDC00 &&
+              input_[position_] == '\\' && input_[position_ + 1] == 'u') {
+            Advance(2);
+            uint32_t low = ParseHex4();
+            if (low < 0xDC00 || low >= 0xE000) {
+              ThrowParseError("Invalid Unicode surrogate pair");
             }
-            Next();
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                         (low - 0xDC00);
           }
-          // For now, we skip the actual Unicode character
+          AppendUtf8(result, code_point);
           break;
         }
         default:
@@ -245,6 +339,7 @@ std::string JsonParser::ParseString() {
       }
       result += c;
     } else {
+      // Embedded '\0' before the end of input
       result += c;
     }
 
@@ -255,6 +350,7 @@ std::string JsonParser::ParseString() {
 }
 
 double JsonParser::ParseNumber() {
+  const size_t start = position_;
   bool negative = false;
 
   if (Current() == '-') {
@@ -262,53 +358,79 @@ double JsonParser::ParseNumber() {
     Next();
   }
 
-  double result = 0.0;
-  while (position_ < input_.length() && std::isdigit(Current())) {
-    result = result * 10 + (Current() - '0');
-    Next();
+  uint64_t mantissa = 0;
+  size_t digits = 0;
+  while (IsDigit(input_[position_])) {
+    mantissa = mantissa * 10 + static_cast<uint64_t>(input_[position_] - '0');
+    ++digits;
+    ++position_;
+    ++column_;
   }
 
-  if (Current() == '.') {
+  // Lookahead reads the padding at the end of input instead of throwing,
+  // so a bare top-level number like "42" parses.
+  bool is_integer = true;
+  if (input_[position_] == '.') {
+    is_integer = false;
     Next();
-    double fraction = 0.0;
-    double divisor = 10.0;
-    while (position_ < input_.length() && std::isdigit(Current())) {
-      fraction += (Current() - '0') / divisor;
-      divisor *= 10.0;
-      Next();
+    while (IsDigit(input_[position_])) {
+      ++position_;
+      ++column_;
     }
-    result += fraction;
   }
 
-  if (Current() == 'e' || Current() == 'E') {
+  if (input_[position_] == 'e' || input_[position_] == 'E') {
+    is_integer = false;
     Next();
-    bool exp_negative = false;
-    if (Current() == '-') {
-      exp_negative = true;
-      Next();
-    } else if (Current() == '+') {
+    if (Current() == '-' || Current() == '+') {
       Next();
     }
-
-    int exponent = 0;
-    while (position_ < input_.length() && std::isdigit(Current())) {
-      exponent = exponent * 10 + (Current() - '0');
-      Next();
+    while (IsDigit(input_[position_])) {
+      ++position_;
+      ++column_;
     }
+  }
 
-    if (exp_negative) {
-      exponent = -exponent;
-    }
-    result *= std::pow(10.0, exponent);
+  // Integers of up to 15 digits are exact in a double
+  if (is_integer && digits <= 15) {
+    double result = static_cast<double>(mantissa);
+    return negative ? -result : result;
   }
 
-  return negative ? -result : result;
+  // Everything else needs correct rounding so written numbers read back
+  // unchanged. strtod needs a terminator right after the scanned span;
+  // otherwise it could read on into text such as "0x1p3".
+  char local[64];
+  std::string heap;
+  size_t length = position_ - start;
+  const char* text = local;
+  if (length < sizeof(local)) {
+    std::memcpy(local, input_ + start, length);
+    local[length] = '\0';
+  } else {
+    heap.assign(input_ + start, length);
+    text = heap.c_str();
+  }
+  return std::strtod(text, nullptr);
+}
+
+uint32_t JsonParser::ParseHex4() {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    int digit = HexDigitValue(input_[position_]);
+    if (digit < 0) {
+      ThrowParseError("Invalid Unicode escape sequence");
+    }
+    value = (value << 4) | static_cast<uint32_t>(digit);
+    Next();
+  }
+  return value;
 }
 
 bool JsonParser::ParseBoolean() {
-  if (Match("true")) {
+  if (Match("true", 4)) {
     return true;
-  } else if (Match("false")) {
+  } else if (Match("false", 5)) {
     return false;
   } else {
     ThrowParseError("Invalid boolean value");
@@ -317,14 +439,157 @@ bool JsonParser::ParseBoolean() {
 }
 
 void JsonParser::ParseNull() {
-  if (!Match("null")) {
+  if (!Match("null", 4)) {
     ThrowParseError("Invalid null value");
   }
 }
 
+bool JsonParser::ParseMaskedValue(const JsonProjection* mask,
+                                  JsonValue& value) {
+  // A partial mask only selects members of containers, so scalars under it
+  // are dropped
+  char c = Current();
+  if (mask == nullptr || (!mask->IncludesAll() && c != '{' && c != '[')) {
+    SkipValue();
+    return false;
+  }
+  const JsonProjection* saved = projection_;
+  projection_ = mask->IncludesAll() ? nullptr : mask;
+  value = ParseValue();
+  projection_ = saved;
+  return true;
+}
+
+void JsonParser::SkipValue() {
+  SkipWhitespace();
+  if (config_.allow_comments) {
+    SkipComments();
+  }
+
+  char c = Current();
+  if (c == '{') {
+    SkipObject();
+  } else if (c == '[') {
+    SkipArray();
+  } else if (c == '"') {
+    SkipString();
+  } else if (c == '-' || IsDigit(c)) {
+    ParseNumber();
+  } else if (c == 't' || c == 'f') {
+    ParseBoolean();
+  } else if (c == 'n') {
+    ParseNull();
+  } else {
+    ThrowParseError("Unexpected character: " + std::string(1, c));
+  }
+}
+
+void JsonParser::SkipObject() {
+  Expect('{');
+  SkipWhitespace();
+  if (config_.allow_comments) {
+    SkipComments();
+  }
+  if (Current() == '}') {
+    Next();
+    return;
+  }
+
+  while (true) {
+    SkipWhitespace();
+    if (config_.allow_comments) {
+      SkipComments();
+    }
+    SkipString();
+    SkipWhitespace();
+    if (config_.allow_comments) {
+      SkipComments();
+    }
+    Expect(':');
+    SkipValue();
+    SkipWhitespace();
+    if (config_.allow_comments) {
+      SkipComments();
+    }
+
+    char c = Current();
+    if (c == '}') {
+      Next();
+      return;
+    } else if (c == ',') {
+      Next();
+    } else {
+      ThrowParseError("Expected ',' or '}' in object");
+    }
+  }
+}
+
+void JsonParser::SkipArray() {
+  Expect('[');
+  SkipWhitespace();
+  if (config_.allow_comments) {
+    SkipComments();
+  }
+  if (Current() == ']') {
+    Next();
+    return;
+  }
+
+  while (true) {
+    SkipValue();
+    SkipWhitespace();
+    if (config_.allow_comments) {
+      SkipComments();
+    }
+
+    char c = Current();
+    if (c == ']') {
+      Next();
+      return;
+    } else if (c == ',') {
+      Next();
+    } else {
+      ThrowParseError("Expected ',' or ']' in array");
+    }
+  }
+}
+
+void JsonParser::SkipString() {
+  Expect('"');
+  size_t length = 0;
+
+  while (true) {
+    size_t run = ScanStringRun(input_ + position_);
+    position_ += run;
+    column_ += run;
+    length += run;
+
+    char c = Next();
+    if (c == '"') {
+      break;
+    } else if (c == '\\') {
+      if (Next() == 'u') {
+        for (int i = 0; i < 4; ++i) {
+          unsigned char hex = static_cast<unsigned char>(input_[position_]);
+          if (!std::isxdigit(hex)) {
+            ThrowParseError("Invalid Unicode escape sequence");
+          }
+          Next();
+        }
+      }
+    } else if ((c == '\n' || c == '\r') && config_.strict_mode) {
+      ThrowParseError("Unescaped newline in string");
+    }
+    ++length;
+  }
+
+  ValidateStringLength(length);
+}
+
 // Utility methods
 void JsonParser::SkipWhitespace() {
-  while (position_ < input_.length() && std::isspace(input_[position_])) {
+  // The padding byte after the end is '\0', which is not whitespace
+  while (std::isspace(static_cast<unsigned char>(input_[position_]))) {
     if (input_[position_] == '\n') {
       line_++;
       column_ = 1;
@@ -336,13 +601,13 @@ void JsonParser::SkipWhitespace() {
 }
 
 void JsonParser::SkipComments() {
-  if (position_ + 1 < input_.length()) {
+  if (position_ + 1 < length_) {
     if (input_[position_] == '/' && input_[position_ + 1] == '/') {
       // Single-line comment
-      while (position_ < input_.length() && input_[position_] != '\n') {
+      while (position_ < length_ && input_[position_] != '\n') {
         position_++;
       }
-      if (position_ < input_.length()) {
+      if (position_ < length_) {
         position_++;  // Skip newline
         line_++;
         column_ = 1;
@@ -350,7 +615,7 @@ void JsonParser::SkipComments() {
     } else if (input_[position_] == '/' && input_[position_ + 1] == '*') {
       // Multi-line comment
       position_ += 2;
-      while (position_ + 1 < input_.length()) {
+      while (position_ + 1 < length_) {
         if (input_[position_] == '*' && input_[position_ + 1] == '/') {
           position_ += 2;
           break;
@@ -368,17 +633,19 @@ void JsonParser::SkipComments() {
 }
 
 char JsonParser::Current() const {
-  if (position_ >= input_.length()) {
+  char c = input_[position_];
+  if (c == '\0' && AtEnd()) {
     ThrowParseError("Unexpected end of input");
   }
-  return input_[position_];
+  return c;
 }
 
 char JsonParser::Next() {
-  if (position_ >= input_.length()) {
+  char c = input_[position_];
+  if (c == '\0' && AtEnd()) {
     ThrowParseError("Unexpected end of input");
   }
-  char c = input_[position_++];
+  ++position_;
   if (c == '\n') {
     line_++;
     column_ = 1;
@@ -390,7 +657,7 @@ char JsonParser::Next() {
 
 char JsonParser::Peek(size_t offset) const {
   size_t pos = position_ + offset;
-  if (pos >= input_.length()) {
+  if (pos >= length_) {
     return '\0';
   }
   return input_[pos];
@@ -405,22 +672,19 @@ bool JsonParser::Expect(char c) {
   return true;
 }
 
-bool JsonParser::Match(const std::string& str) {
-  if (position_ + str.length() > input_.length()) {
+bool JsonParser::Match(const char* literal, size_t length) {
+  // Literals are shorter than the padding, and the zero padding never
+  // matches a literal character, so no bounds check is needed here.
+  if (std::memcmp(input_ + position_, literal, length) != 0) {
     return false;
   }
-  for (size_t i = 0; i < str.length(); ++i) {
-    if (input_[position_ + i] != str[i]) {
-      return false;
-    }
-  }
-  Advance(str.length());
+  Advance(length);
   return true;
 }
 
 void JsonParser::Advance(size_t count) {
   for (size_t i = 0; i < count; ++i) {
-    if (position_ >= input_.length()) {
+    if (position_ >= length_) {
       break;
     }
     if (input_[position_] == '\n') {
@@ -442,9 +706,8 @@ void JsonParser::ThrowParseError(const std::string& message) const {
 
 std::string JsonParser::GetContext() const {
   size_t start = (position_ > 20) ? position_ - 20 : 0;
-  size_t end = (position_ + 20 < input_.length()) ? position_ + 20
-                                                   : input_.length();
-  return input_.substr(start, end - start);
+  size_t end = (position_ + 20 < length_) ? position_ + 20 : length_;
+  return std::string(input_ + start, end - start);
 }
 
 // Validation
@@ -0,0 +1,589 @@
+#include "json_parser/json_patch.h"
+#include "json_parser/json_object.h"
+#include "json_parser/json_array.h"
+#include "json_parser/json_parser.h"
+#include "json_parser/json_utils.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace json_parser {
+
+namespace {
+
+const char* OperationName(JsonPatchOperation::Type type) {
+  switch (type) {
+    case JsonPatchOperation::Type::kAdd:
+      return "add";
+    case JsonPatchOperation::Type::kRemove:
+      return "remove";
+    case JsonPatchOperation::Type::kReplace:
+      return "replace";
+    case JsonPatchOperation::Type::kMove:
+      return "move";
+    case JsonPatchOperation::Type::kCopy:
+      return "copy";
+    case JsonPatchOperation::Type::kTest:
+      return "test";
+  }
+  return "add";
+}
+
+// RFC 6901 array index: "0" or digits without a leading zero. Returns
+// false for anything else, including "-".
+bool ParseIndex(const std::string& token, size_t& index) {
+  if (token.empty() || token.size() > 18 ||
+      (token.size() > 1 && token[0] == '0')) {
+    return false;
+  }
+  index = 0;
+  for (char c : token) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    index = index * 10 + static_cast<size_t>(c - '0');
+  }
+  return true;
+}
+
+JsonValue* Child(JsonValue& value, const std::string& token) {
+  if (value.IsObject()) {
+    return value.AsObject().Find(token);
+  }
+  if (value.IsArray()) {
+    size_t index;
+    JsonArray& arr = value.AsArray();
+    if (ParseIndex(token, index) && index < arr.Size()) {
+      return &arr[index];
+    }
+  }
+  return nullptr;
+}
+
+bool IsProperPrefix(const std::vector<std::string>& prefix,
+                    const std::vector<std::string>& path) {
+  return prefix.size() < path.size() &&
+         std::equal(prefix.begin(), prefix.end(), path.begin());
+}
+
+// Runs operations against one document, keeping the chain of containers
+// along the last resolved path and a log for rolling back
+class PatchApplier {
+ public:
+  explicit PatchApplier(JsonValue& root) : root_(root) {
+    nodes_.push_back(&root);
+  }
+
+  // Applies op. With consumable set, inserted values are moved out of it
+  // rather than deep-copied from op.value.
+  void Run(const JsonPatchOperation& op, JsonValue* consumable) {
+    switch (op.type) {
+      case JsonPatchOperation::Type::kAdd:
+        AddAt(op.path_tokens, op.path, TakeValue(op, consumable));
+        break;
+      case JsonPatchOperation::Type::kRemove:
+        RemoveAt(op.path_tokens, op.path, /*relink=*/false);
+        break;
+      case JsonPatchOperation::Type::kReplace:
+        ReplaceAt(op.path_tokens, op.path, TakeValue(op, consumable));
+        break;
+      case JsonPatchOperation::Type::kMove:
+        // from must exist even when moving it onto itself changes nothing
+        Find(op.from_tokens, op.from);
+        if (op.from_tokens != op.path_tokens) {
+          MoveAt(op);
+        }
+        break;
+      case JsonPatchOperation::Type::kCopy:
+        AddAt(op.path_tokens, op.path,
+              JsonUtils::DeepCopy(Find(op.from_tokens, op.from)));
+        break;
+      case JsonPatchOperation::Type::kTest:
+        if (Find(op.path_tokens, op.path) != op.value) {
+          throw JsonPatchException("Test failed at '" + op.path + "'");
+        }
+        break;
+    }
+  }
+
+  // Undoes every logged change, newest first
+  void Rollback() {
+    for (auto it = undo_.rbegin(); it != undo_.rend(); ++it) {
+      Undo(*it);
+    }
+    undo_.clear();
+  }
+
+ private:
+  // The inverse of one change. tokens points into the operation being
+  // undone; last replaces its final token, as "-" becomes an index. An
+  // insert with reuse_carried puts back the value that undoing the next
+  // change displaced, which is how a move is reversed without copies.
+  struct UndoStep {
+    enum class Kind { kErase, kInsert, kAssign };
+    Kind kind;
+    const std::vector<std::string>* tokens;
+    std::string last;
+    JsonValue value;
+    bool reuse_carried = false;
+  };
+
+  JsonValue& root_;
+  // nodes_[i] is the value reached by the first i tokens of the cached
+  // path; tokens point into the operations, which outlive the applier
+  std::vector<JsonValue*> nodes_;
+  std::vector<const std::string*> tokens_;
+  std::vector<UndoStep> undo_;
+  // Value displaced by the last erase or assign undone
+  JsonValue carried_;
+
+  static JsonValue TakeValue(const JsonPatchOperation& op,
+                             JsonValue* consumable) {
+    if (consumable != nullptr) {
+      return std::move(*consumable);
+    }
+    return JsonUtils::DeepCopy(op.value);
+  }
+
+  // Container holding the last token of tokens, reusing the cached prefix
+  JsonValue& ResolveParent(const std::vector<std::string>& tokens,
+                           const std::string& pointer) {
+    const size_t depth = tokens.size() - 1;
+    size_t common = 0;
+    const size_t limit = std::min(tokens_.size(), depth);
+    while (common < limit && *tokens_[common] == tokens[common]) {
+      ++common;
+    }
+    nodes_.resize(common + 1);
+    tokens_.resize(common);
+    for (size_t i = common; i < depth; ++i) {
+      JsonValue* child = Child(*nodes_.back(), tokens[i]);
+      if (child == nullptr) {
+        throw JsonPatchException("Path not found: '" + pointer + "'");
+      }
+      nodes_.push_back(child);
+      tokens_.push_back(&tokens[i]);
+    }
+    return *nodes_.back();
+  }
+
+  const JsonValue& Find(const std::vector<std::string>& tokens,
+                        const std::string& pointer) {
+    if (tokens.empty()) {
+      return root_;
+    }
+    JsonValue* value = Child(ResolveParent(tokens, pointer), tokens.back());
+    if (value == nullptr) {
+      throw JsonPatchException("Path not found: '" + pointer + "'");
+    }
+    return *value;
+  }
+
+  void ReplaceRoot(JsonValue value) {
+    undo_.push_back({UndoStep::Kind::kAssign, nullptr, std::string(),
+                     std::move(root_)});
+    root_ = std::move(value);
+    nodes_.resize(1);
+    tokens_.clear();
+  }
+
+  // Leaves value untouched when it throws
+  void AddAt(const std::vector<std::string>& tokens,
+             const std::string& pointer, JsonValue&& value) {
+    if (tokens.empty()) {
+      ReplaceRoot(std::move(value));
+      return;
+    }
+    JsonValue& parent = ResolveParent(tokens, pointer);
+    const std::string& token = tokens.back();
+    if (parent.IsObject()) {
+      JsonObject& obj = parent.AsObject();
+      JsonValue* existing = obj.Find(token);
+      if (existing != nullptr) {
+        undo_.push_back(
+            {UndoStep::Kind::kAssign, &tokens, token, std::move(*existing)});
+        *existing = std::move(value);
+      } else {
+        obj.Insert(token, std::move(value));
+        undo_.push_back(
+            {UndoStep::Kind::kErase, &tokens, token, JsonValue()});
+      }
+      return;
+    }
+    if (parent.IsArray()) {
+      JsonArray& arr = parent.AsArray();
+      size_t index = arr.Size();
+      if (token != "-" && (!ParseIndex(token, index) || index > arr.Size())) {
+        throw JsonPatchException("Invalid array index in '" + pointer + "'");
+      }
+      arr.Insert(index, std::move(value));
+      undo_.push_back({UndoStep::Kind::kErase, &tokens,
+                       std::to_string(index), JsonValue()});
+      return;
+    }
+    throw JsonPatchException("Parent of '" + pointer + "' is not a container");
+  }
+
+  // Unlinks the value. With relink it is returned for the caller to add
+  // elsewhere; otherwise the log keeps it.
+  JsonValue RemoveAt(const std::vector<std::string>& tokens,
+                     const std::string& pointer, bool relink) {
+    if (tokens.empty()) {
+      throw JsonPatchException("Cannot remove the document root");
+    }
+    JsonValue& parent = ResolveParent(tokens, pointer);
+    const std::string& token = tokens.back();
+    JsonValue value;
+    if (parent.IsObject()) {
+      JsonObject& obj = parent.AsObject();
+      JsonValue* existing = obj.Find(token);
+      if (existing == nullptr) {
+        throw JsonPatchException("Path not found: '" + pointer + "'");
+      }
+      value = std::move(*existing);
+      obj.Erase(token);
+    } else if (parent.IsArray()) {
+      JsonArray& arr = parent.AsArray();
+      size_t index;
+      if (!ParseIndex(token, index) || index >= arr.Size()) {
+        throw JsonPatchException("Path not found: '" + pointer + "'");
+      }
+      value = std::move(arr[index]);
+      arr.Erase(index);
+    } else {
+      throw JsonPatchException("Path not found: '" + pointer + "'");
+    }
+    if (relink) {
+      undo_.push_back(
+          {UndoStep::Kind::kInsert, &tokens, token, JsonValue(), true});
+      return value;
+    }
+    undo_.push_back(
+        {UndoStep::Kind::kInsert, &tokens, token, std::move(value)});
+    return JsonValue();
+  }
+
+  // Unlinks from and adds it at path. If the add fails, the value goes
+  // back into the removal's undo step so rollback restores it.
+  void MoveAt(const JsonPatchOperation& op) {
+    JsonValue value = RemoveAt(op.from_tokens, op.from, /*relink=*/true);
+    const size_t removal = undo_.size() - 1;
+    try {
+      AddAt(op.path_tokens, op.path, std::move(value));
+    } catch (...) {
+      undo_[removal].value = std::move(value);
+      undo_[removal].reuse_carried = false;
+      throw;
+    }
+  }
+
+  void ReplaceAt(const std::vector<std::string>& tokens,
+                 const std::string& pointer, JsonValue value) {
+    if (tokens.empty()) {
+      ReplaceRoot(std::move(value));
+      return;
+    }
+    JsonValue* existing =
+        Child(ResolveParent(tokens, pointer), tokens.back());
+    if (existing == nullptr) {
+      throw JsonPatchException("Path not found: '" + pointer + "'");
+    }
+    undo_.push_back({UndoStep::Kind::kAssign, &tokens, tokens.back(),
+                     std::move(*existing)});
+    *existing = std::move(value);
+  }
+
+  // The document is back in the state right after this change, so every
+  // container on its path exists again
+  void Undo(UndoStep& step) {
+    if (step.tokens == nullptr || step.tokens->empty()) {
+      carried_ = std::move(root_);
+      root_ = std::move(step.value);
+      return;
+    }
+    JsonValue* parent = &root_;
+    for (size_t i = 0; i + 1 < step.tokens->size(); ++i) {
+      parent = Child(*parent, (*step.tokens)[i]);
+    }
+    size_t index = 0;
+    if (parent->IsArray()) {
+      ParseIndex(step.last, index);
+    }
+    switch (step.kind) {
+      case UndoStep::Kind::kErase:
+        carried_ = std::move(*Child(*parent, step.last));
+        if (parent->IsObject()) {
+          parent->AsObject().Erase(step.last);
+        } else {
+          parent->AsArray().Erase(index);
+        }
+        break;
+      case UndoStep::Kind::kInsert: {
+        JsonValue& value = step.reuse_carried ? carried_ : step.value;
+        if (parent->IsObject()) {
+          parent->AsObject().Insert(step.last, std::move(value));
+        } else {
+          parent->AsArray().Insert(index, std::move(value));
+        }
+        break;
+      }
+      case UndoStep::Kind::kAssign: {
+        JsonValue& target = *Child(*parent, step.last);
+        carried_ = std::move(target);
+        target = std::move(step.value);
+        break;
+      }
+    }
+  }
+};
+
+// A const patch is copied into the target; a mutable one is moved
+JsonValue TakeMergeValue(const JsonValue& value) {
+  return JsonUtils::DeepCopy(value);
+}
+
+JsonValue TakeMergeValue(JsonValue& value) { return std::move(value); }
+
+template <typename Patch>
+void MergeInto(JsonValue& target, Patch& patch) {
+  if (!patch.IsObject()) {
+    target = TakeMergeValue(patch);
+    return;
+  }
+  if (!target.IsObject()) {
+    target = JsonValue{JsonObject()};
+  }
+  JsonObject& obj = target.AsObject();
+  auto& members = patch.AsObject();
+  for (auto it = members.Begin(); it != members.End(); ++it) {
+    if (it->second.IsNull()) {
+      obj.Erase(it->first);
+      continue;
+    }
+    JsonValue* existing = obj.Find(it->first);
+    if (existing == nullptr) {
+      obj.Insert(it->first, JsonValue());
+      existing = obj.Find(it->first);
+    }
+    MergeInto(*existing, it->second);
+  }
+}
+
+}  // namespace
+
+JsonPatch JsonPatch::Compile(const JsonValue& patch) {
+  if (!patch.IsArray()) {
+    throw JsonPatchException("A patch must be an array of operations");
+  }
+  JsonPatch result;
+  const JsonArray& operations = patch.AsArray();
+  for (size_t i = 0; i < operations.Size(); ++i) {
+    const JsonValue& op = operations[i];
+    const std::string where = "operation " + std::to_string(i);
+    if (!op.IsObject()) {
+      throw JsonPatchException(where + " is not an object");
+    }
+    const JsonObject& members = op.AsObject();
+    auto text = [&](const char* name) -> const std::string& {
+      const JsonValue* member = members.Find(name);
+      if (member == nullptr || !member->IsString()) {
+        throw JsonPatchException(where + " needs a string '" + name + "'");
+      }
+      return member->AsString();
+    };
+    auto value = [&]() -> const JsonValue& {
+      const JsonValue* member = members.Find("value");
+      if (member == nullptr) {
+        throw JsonPatchException(where + " needs a 'value'");
+      }
+      return *member;
+    };
+
+    const std::string& name = text("op");
+    if (name == "add") {
+      result.Add(text("path"), value());
+    } else if (name == "remove") {
+      result.Remove(text("path"));
+    } else if (name == "replace") {
+      result.Replace(text("path"), value());
+    } else if (name == "move") {
+      result.Move(text("from"), text("path"));
+    } else if (name == "copy") {
+      result.Copy(text("from"), text("path"));
+    } else if (name == "test") {
+      result.Test(text("path"), value());
+    } else {
+      throw JsonPatchException(where + " has unknown op '" + name + "'");
+    }
+  }
+  return result;
+}
+
+JsonPatch JsonPatch::Compile(const std::string& json) {
+  return Compile(JsonParser::Parse(json));
+}
+
+JsonPatch& JsonPatch::Add(const std::string& path, JsonValue value) {
+  return Append(JsonPatchOperation::Type::kAdd, std::string(), path,
+                std::move(value));
+}
+
+JsonPatch& JsonPatch::Remove(const std::string& path) {
+  return Append(JsonPatchOperation::Type::kRemove, std::string(), path,
+                JsonValue());
+}
+
+JsonPatch& JsonPatch::Replace(const std::string& path, JsonValue value) {
+  return Append(JsonPatchOperation::Type::kReplace, std::string(), path,
+                std::move(value));
+}
+
+JsonPatch& JsonPatch::Move(const std::string& from, const std::string& path) {
+  return Append(JsonPatchOperation::Type::kMove, from, path, JsonValue());
+}
+
+JsonPatch& JsonPatch::Copy(const std::string& from, const std::string& path) {
+  return Append(JsonPatchOperation::Type::kCopy, from, path, JsonValue());
+}
+
+JsonPatch& JsonPatch::Test(const std::string& path, JsonValue value) {
+  return Append(JsonPatchOperation::Type::kTest, std::string(), path,
+                std::move(value));
+}
+
+JsonPatch& JsonPatch::Append(JsonPatchOperation::Type type,
+                             const std::string& from, const std::string& path,
+                             JsonValue value) {
+  JsonPatchOperation op;
+  op.type = type;
+  op.path = path;
+  op.path_tokens = ParsePointer(path);
+  if (type == JsonPatchOperation::Type::kMove ||
+      type == JsonPatchOperation::Type::kCopy) {
+    op.from = from;
+    op.from_tokens = ParsePointer(from);
+  }
+  if (type == JsonPatchOperation::Type::kMove &&
+      IsProperPrefix(op.from_tokens, op.path_tokens)) {
+    throw JsonPatchException("Cannot move '" + from + "' into itself");
+  }
+  op.value = std::move(value);
+  operations_.push_back(std::move(op));
+  return *this;
+}
+
+JsonValue JsonPatch::ToJsonValue() const {
+  JsonValue result{JsonArray()};
+  JsonArray& operations = result.AsArray();
+  operations.Reserve(operations_.size());
+  for (const JsonPatchOperation& op : operations_) {
+    JsonValue entry{JsonObject()};
+    JsonObject& members = entry.AsObject();
+    members.Insert("op", JsonValue(OperationName(op.type)));
+    if (op.type == JsonPatchOperation::Type::kMove ||
+        op.type == JsonPatchOperation::Type::kCopy) {
+      members.Insert("from", JsonValue(op.from));
+    }
+    members.Insert("path", JsonValue(op.path));
+    if (op.type == JsonPatchOperation::Type::kAdd ||
+        op.type == JsonPatchOperation::Type::kReplace ||
+        op.type == JsonPatchOperation::Type::kTest) {
+      members.Insert("value", JsonUtils::DeepCopy(op.value));
+    }
+    operations.PushBack(std::move(entry));
+  }
+  return result;
+}
+
+void JsonPatch::Apply(JsonValue& document) const& {
+  PatchApplier applier(document);
+  try {
+    for (const JsonPatchOperation& op : operations_) {
+      applier.Run(op, nullptr);
+    }
+  } catch (...) {
+    applier.Rollback();
+    throw;
+  }
+}
+
+void JsonPatch::Apply(JsonValue& document) && {
+  PatchApplier applier(document);
+  try {
+    for (JsonPatchOperation& op : operations_) {
+      applier.Run(op, &op.value);
+    }
+  } catch (...) {
+    applier.Rollback();
+    throw;
+  }
+}
+
+void JsonPatch::ApplyBatch(JsonValue& document,
+                           const std::vector<JsonPatch>& patches) {
+  PatchApplier applier(document);
+  try {
+    for (const JsonPatch& patch : patches) {
+      for (const JsonPatchOperation& op : patch.operations_) {
+        applier.Run(op, nullptr);
+      }
+    }
+  } catch (...) {
+    applier.Rollback();
+    throw;
+  }
+}
+
+void JsonPatch::ApplyMergePatch(JsonValue& target, const JsonValue& patch) {
+  MergeInto(target, patch);
+}
+
+void JsonPatch::ApplyMergePatch(JsonValue& target, JsonValue&& patch) {
+  MergeInto(target, patch);
+}
+
+std::vector<std::string> JsonPatch::ParsePointer(const std::string& pointer) {
+  std::vector<std::string> tokens;
+  if (pointer.empty()) {
+    return tokens;
+  }
+  if (pointer[0] != '/') {
+    throw JsonPatchException("Pointer must start with '/': '" + pointer +
+                             "'");
+  }
+  std::string token;
+  for (size_t i = 1; i <= pointer.size(); ++i) {
+    if (i == pointer.size() || pointer[i] == '/') {
+      tokens.push_back(std::move(token));
+      token.clear();
+    } else if (pointer[i] == '~') {
+      char next = i + 1 < pointer.size() ? pointer[i + 1] : '\0';
+      if (next != '0' && next != '1') {
+        throw JsonPatchException("Invalid escape in pointer '" + pointer +
+                                 "'");
+      }
+      token.push_back(next == '0' ? '~' : '/');
+      ++i;
+    } else {
+      token.push_back(pointer[i]);
+    }
+  }
+  return tokens;
+}
+
+std::string JsonPatch::EscapeToken(const std::string& token) {
+  std::string escaped;
+  escaped.reserve(token.size());
+  for (char c : token) {
+    if (c == '~') {
+      escaped += "~0";
+    } else if (c == '/') {
+      escaped += "~1";
+    } else {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+}  // namespace json_parser
@@ -0,0 +1,680 @@
+#include "json_parser/json_path.h"
+#include "json_parser/json_array.h"
+#include "json_parser/json_exception.h"
+#include "json_parser/json_object.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "json_scan.h"
+
+namespace json_parser {
+
+namespace {
+
+using internal::FindQuoteOrBackslash;
+using internal::FindStructural;
+
+long long ParseInteger(const std::string& text,
+                       const std::string& expression) {
+  if (text.empty()) {
+    throw JsonPathException("Missing index in '" + expression + "'");
+  }
+  errno = 0;
+  char* end = nullptr;
+  long long value = std::strtoll(text.c_str(), &end, 10);
+  if (errno != 0 || *end != '\0') {
+    throw JsonPathException("Invalid index '" + text + "' in '" +
+                            expression + "'");
+  }
+  return value;
+}
+
+void ReadDottedSegment(const std::string& expression, size_t& i,
+                       std::vector<JsonPathSegment>& segments) {
+  JsonPathSegment segment;
+  if (i < expression.length() && expression[i] == '*') {
+    segment.type = JsonPathSegment::Type::kWildcard;
+    ++i;
+  } else {
+    size_t start = i;
+    while (i < expression.length() && expression[i] != '.' &&
+           expression[i] != '[') {
+      ++i;
+    }
+    if (i == start) {
+      throw JsonPathException("Empty key in '" + expression + "'");
+    }
+    segment.key = expression.substr(start, i - start);
+  }
+  segments.push_back(std::move(segment));
+}
+
+void ReadBracketSegment(const std::string& expression, size_t& i,
+                        std::vector<JsonPathSegment>& segments) {
+  ++i;  // Skip '['
+  JsonPathSegment segment;
+  size_t n = expression.length();
+
+  if (i < n && (expression[i] == '\'' || expression[i] == '"')) {
+    char quote = expression[i++];
+    while (i < n && expression[i] != quote) {
+      if (expression[i] == '\\' && i + 1 < n) {
+        ++i;
+      }
+      segment.key += expression[i++];
+    }
+    if (i >= n) {
+      throw JsonPathException("Unterminated quoted key in '" + expression +
+                              "'");
+    }
+    ++i;  // Skip closing quote
+  } else if (i < n && expression[i] == '*') {
+    segment.type = JsonPathSegment::Type::kWildcard;
+    ++i;
+  } else {
+    size_t close = expression.find(']', i);
+    if (close == std::string::npos) {
+      throw JsonPathException("Missing ']' in '" + expression + "'");
+    }
+    std::string content = expression.substr(i, close - i);
+    i = close;
+
+    size_t colon = content.find(':');
+    if (colon == std::string::npos) {
+      segment.type = JsonPathSegment::Type::kIndex;
+      segment.index = ParseInteger(content, expression);
+    } else {
+      segment.type = JsonPathSegment::Type::kSlice;
+      std::string start = content.substr(0, colon);
+      std::string rest = content.substr(colon + 1);
+      std::string end = rest;
+      std::string step;
+      size_t second_colon = rest.find(':');
+      if (second_colon != std::string::npos) {
+        end = rest.substr(0, second_colon);
+        step = rest.substr(second_colon + 1);
+      }
+      if (!start.empty()) {
+        segment.has_slice_start = true;
+        segment.slice_start = ParseInteger(start, expression);
+      }
+      if (!end.empty()) {
+        segment.has_slice_end = true;
+        segment.slice_end = ParseInteger(end, expression);
+      }
+      if (!step.empty()) {
+        segment.slice_step = ParseInteger(step, expression);
+        if (segment.slice_step <= 0) {
+          throw JsonPathException("Slice step must be positive in '" +
+                                  expression + "'");
+        }
+      }
+    }
+  }
+
+  if (i >= n || expression[i] != ']') {
+    throw JsonPathException("Missing ']' in '" + expression + "'");
+  }
+  ++i;
+  segments.push_back(std::move(segment));
+}
+
+bool IsArrayIndexToken(const std::string& token) {
+  if (token.empty() || (token.length() > 1 && token[0] == '0')) {
+    return false;
+  }
+  for (char c : token) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+  }
+  return token.length() < 19;  // Fits in long long
+}
+
+// Resolves a key or index segment against a single value. Value is
+// JsonValue or const JsonValue.
+template <typename Value>
+Value* StepInto(Value& value, const JsonPathSegment& segment) {
+  if (value.IsObject()) {
+    if (segment.type != JsonPathSegment::Type::kKey) {
+      return nullptr;
+    }
+    return value.AsObject().Find(segment.key);
+  }
+  if (value.IsArray()) {
+    if (segment.type != JsonPathSegment::Type::kIndex &&
+        !segment.key_or_index) {
+      return nullptr;
+    }
+    auto& arr = value.AsArray();
+    long long size = static_cast<long long>(arr.Size());
+    long long index = segment.index < 0 ? segment.index + size : segment.index;
+    if (index < 0 || index >= size) {
+      return nullptr;
+    }
+    return &arr[static_cast<size_t>(index)];
+  }
+  return nullptr;
+}
+
+inline bool IsScalarDelimiter(char c) {
+  return c == ',' || c == '}' || c == ']' || c == '\0' ||
+         std::isspace(static_cast<unsigned char>(c));
+}
+
+// Evaluates compiled segments directly over raw JSON text
+class TextEvaluator {
+ public:
+  TextEvaluator(const PaddedJsonBuffer& json,
+                const std::vector<JsonPathSegment>& segments,
+                const JsonParserConfig& config, std::vector<JsonValue>& out)
+      : begin_(json.Data()),
+        end_(json.Data() + json.Size()),
+        segments_(segments),
+        parser_(config),
+        out_(out) {}
+
+  void Run() {
+    const char* p = SkipWhitespace(begin_);
+    if (p >= end_) {
+      Fail("Unexpected end of input", p);
+    }
+    Evaluate(p, 0);
+  }
+
+ private:
+  const char* begin_;
+  const char* end_;
+  const std::vector<JsonPathSegment>& segments_;
+  JsonParser parser_;
+  std::vector<JsonValue>& out_;
+
+  [[noreturn]] void Fail(const std::string& message, const char* p) const {
+    throw JsonParseException(message, static_cast<size_t>(p - begin_));
+  }
+
+  const char* SkipWhitespace(const char* p) const {
+    while (std::isspace(static_cast<unsigned char>(*p))) {
+      ++p;
+    }
+    return p;
+  }
+
+  // p points just past the opening quote; returns just past the closing one
+  const char* SkipString(const char* p) const {
+    while (true) {
+      p = FindQuoteOrBackslash(p);
+      if (*p == '"') {
+        return p + 1;
+      }
+      if (*p == '\\') {
+        if (p + 1 >= end_) {
+          Fail("Unterminated string", p);
+        }
+        p += 2;
+      } else if (p >= end_) {
+        Fail("Unterminated string", p);
+      } else {
+        ++p;  // Embedded '\0'
+      }
+    }
+  }
+
+  // Skipped containers are only checked for balanced nesting
+  const char* SkipContainer(const char* p) const {
+    size_t depth = 0;
+    while (true) {
+      p = FindStructural(p);
+      switch (*p) {
+        case '"':
+          p = SkipString(p + 1);
+          break;
+        case '{':
+        case '[':
+          ++depth;
+          ++p;
+          break;
+        case '}':
+        case ']':
+          if (--depth == 0) {
+            return p + 1;
+          }
+          ++p;
+          break;
+        default:
+          if (p >= end_) {
+            Fail("Unexpected end of input", p);
+          }
+          ++p;
+          break;
+      }
+    }
+  }
+
+  const char* SkipValue(const char* p) const {
+    if (*p == '{' || *p == '[') {
+      return SkipContainer(p);
+    }
+    if (*p == '"') {
+      return SkipString(p + 1);
+    }
+    const char* start = p;
+    while (!IsScalarDelimiter(*p)) {
+      ++p;
+    }
+    if (p == start) {
+      Fail(p >= end_ ? "Unexpected end of input" : "Unexpected character", p);
+    }
+    return p;
+  }
+
+  // open and close point at the quotes around a raw object key
+  bool KeyMatches(const char* open, const char* close,
+                  const std::string& key) const {
+    const char* begin = open + 1;
+    size_t length = static_cast<size_t>(close - begin);
+    if (std::memchr(begin, '\\', length) == nullptr) {
+      return length == key.length() &&
+             std::memcmp(begin, key.data(), length) == 0;
+    }
+    // Escaped keys are rare; decode them with the regular parser
+    JsonValue decoded = JsonParser::Parse(std::string(open, close + 1));
+    return decoded.AsString() == key;
+  }
+
+  void Materialize(const char* p) {
+    const char* end = SkipValue(p);
+    out_.push_back(parser_.ParseString(p, static_cast<size_t>(end - p)));
+  }
+
+  void Evaluate(const char* p, size_t depth) {
+    if (depth == segments_.size()) {
+      Materialize(p);
+      return;
+    }
+    if (*p == '{') {
+      EvaluateObject(p, depth);
+    } else if (*p == '[') {
+      EvaluateArray(p, depth);
+    }
+  }
+
+  void EvaluateObject(const char* p, size_t depth) {
+    const JsonPathSegment& segment = segments_[depth];
+    bool wildcard = segment.type == JsonPathSegment::Type::kWildcard;
+    if (!wildcard && segment.type != JsonPathSegment::Type::kKey) {
+      return;
+    }
+
+    p = SkipWhitespace(p + 1);
+    if (*p == '}') {
+      return;
+    }
+    while (true) {
+      if (*p != '"') {
+        Fail("Expected string key in object", p);
+      }
+      const char* key_open = p;
+      p = SkipString(p + 1);
+      const char* key_close = p - 1;
+      p = SkipWhitespace(p);
+      if (*p != ':') {
+        Fail("Expected ':' in object", p);
+      }
+      p = SkipWhitespace(p + 1);
+
+      if (wildcard) {
+        Evaluate(p, depth + 1);
+      } else if (KeyMatches(key_open, key_close, segment.key)) {
+        // The first matching member wins; the rest is never scanned
+        Evaluate(p, depth + 1);
+        return;
+      }
+
+      p = SkipWhitespace(SkipValue(p));
+      if (*p == ',') {
+        p = SkipWhitespace(p + 1);
+      } else if (*p == '}') {
+        return;
+      } else {
+        Fail("Expected ',' or '}' in object", p);
+      }
+    }
+  }
+
+  void EvaluateArray(const char* p, size_t depth) {
+    const JsonPathSegment& segment = segments_[depth];
+    long long start = 0;
+    long long end = -1;  // Exclusive; -1 means unbounded
+    long long step = 1;
+
+    switch (segment.type) {
+      case JsonPathSegment::Type::kKey:
+        if (!segment.key_or_index) {
+          return;
+        }
+        start = segment.index;
+        end = start + 1;
+        break;
+      case JsonPathSegment::Type::kIndex:
+        if (segment.index < 0) {
+          EvaluateArrayFromEnd(p, depth);
+          return;
+        }
+        start = segment.index;
+        end = start + 1;
+        break;
+      case JsonPathSegment::Type::kSlice:
+        if ((segment.has_slice_start && segment.slice_start < 0) ||
+            (segment.has_slice_end && segment.slice_end < 0)) {
+          EvaluateArrayFromEnd(p, depth);
+          return;
+        }
+        start = segment.has_slice_start ? segment.slice_start : 0;
+        end = segment.has_slice_end ? segment.slice_end : -1;
+        step = segment.slice_step;
+        break;
+      case JsonPathSegment::Type::kWildcard:
+        break;
+    }
+    if (end >= 0 && start >= end) {
+      return;
+    }
+
+    p = SkipWhitespace(p + 1);
+    if (*p == ']') {
+      return;
+    }
+    for (long long i = 0;; ++i) {
+      if (i >= start && (i - start) % step == 0) {
+        Evaluate(p, depth + 1);
+      }
+      if (end >= 0 && i + 1 >= end) {
+        return;  // Nothing further can match
+      }
+      p = SkipWhitespace(SkipValue(p));
+      if (*p == ',') {
+        p = SkipWhitespace(p + 1);
+      } else if (*p == ']') {
+        return;
+      } else {
+        Fail("Expected ',' or ']' in array", p);
+      }
+    }
+  }
+
+  // Negative indices need the array length, so record element offsets first
+  void EvaluateArrayFromEnd(const char* p, size_t depth) {
+    std::vector<const char*> elements;
+    p = SkipWhitespace(p + 1);
+    if (*p != ']') {
+      while (true) {
+        elements.push_back(p);
+        p = SkipWhitespace(SkipValue(p));
+        if (*p == ',') {
+          p = SkipWhitespace(p + 1);
+        } else if (*p == ']') {
+          break;
+        } else {
+          Fail("Expected ',' or ']' in array", p);
+        }
+      }
+    }
+
+    const JsonPathSegment& segment = segments_[depth];
+    long long length = static_cast<long long>(elements.size());
+    if (segment.type == JsonPathSegment::Type::kIndex) {
+      long long index = segment.index + length;
+      if (index >= 0 && index < length) {
+        Evaluate(elements[index], depth + 1);
+      }
+      return;
+    }
+
+    long long start = segment.has_slice_start ? segment.slice_start : 0;
+    long long end = segment.has_slice_end ? segment.slice_end : length;
+    if (start < 0) start = std::max(start + length, 0LL);
+    if (end < 0) end = std::max(end + length, 0LL);
+    end = std::min(end, length);
+    for (long long i = start; i < end; i += segment.slice_step) {
+      Evaluate(elements[i], depth + 1);
+    }
+  }
+};
+
+}  // namespace
+
+JsonPath JsonPath::Compile(const std::string& expression) {
+  JsonPath path;
+  path.expression_ = expression;
+  if (!expression.empty() && expression[0] == '/') {
+    path.CompilePointer(expression);
+  } else {
+    path.CompileJsonPath(expression);
+  }
+  for (const JsonPathSegment& segment : path.segments_) {
+    if (segment.type == JsonPathSegment::Type::kWildcard ||
+        segment.type == JsonPathSegment::Type::kSlice) {
+      path.singular_ = false;
+    }
+  }
+  return path;
+}
+
+JsonPath JsonPath::CompileDotted(const std::string& path) {
+  JsonPath compiled;
+  compiled.expression_ = path;
+  compiled.CompileDottedKeys(path);
+  return compiled;
+}
+
+template <typename Value>
+Value* JsonPath::FindFirst(Value& root) const {
+  if (!singular_) {
+    Value* first = nullptr;
+    CollectMatches(root, 0, [&first](Value& match) {
+      first = &match;
+      return false;
+    });
+    return first;
+  }
+
+  Value* current = &root;
+  for (const JsonPathSegment& segment : segments_) {
+    current = StepInto(*current, segment);
+    if (current == nullptr) {
+      return nullptr;
+    }
+  }
+  return current;
+}
+
+const JsonValue* JsonPath::Find(const JsonValue& root) const {
+  return FindFirst(root);
+}
+
+// Walks with the mutable accessors, so the containers on the way drop
+// their cached hashes before the result can be modified
+JsonValue* JsonPath::Find(JsonValue& root) const { return FindFirst(root); }
+
+std::vector<const JsonValue*> JsonPath::FindAll(const JsonValue& root) const {
+  std::vector<const JsonValue*> result;
+  CollectMatches(root, 0, [&result](const JsonValue& match) {
+    result.push_back(&match);
+    return true;
+  });
+  return result;
+}
+
+std::vector<JsonValue> JsonPath::Select(const PaddedJsonBuffer& json,
+                                        const JsonParserConfig& config) const {
+  std::vector<JsonValue> result;
+  TextEvaluator evaluator(json, segments_, config, result);
+  evaluator.Run();
+  return result;
+}
+
+std::vector<JsonValue> JsonPath::Select(const std::string& json,
+                                        const JsonParserConfig& config) const {
+  return Select(PaddedJsonBuffer(json), config);
+}
+
+template <typename Value, typename Visit>
+bool JsonPath::CollectMatches(Value& value, size_t depth,
+                              const Visit& visit) const {
+  if (depth == segments_.size()) {
+    return visit(value);
+  }
+
+  const JsonPathSegment& segment = segments_[depth];
+  if (segment.type == JsonPathSegment::Type::kWildcard) {
+    if (value.IsObject()) {
+      auto& obj = value.AsObject();
+      for (auto it = obj.Begin(); it != obj.End(); ++it) {
+        if (!CollectMatches(it->second, depth + 1, visit)) {
+          return false;
+        }
+      }
+    } else if (value.IsArray()) {
+      auto& arr = value.AsArray();
+      for (auto it = arr.Begin(); it != arr.End(); ++it) {
+        if (!CollectMatches(*it, depth + 1, visit)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  if (segment.type == JsonPathSegment::Type::kSlice) {
+    if (!value.IsArray()) {
+      return true;
+    }
+    auto& arr = value.AsArray();
+    long long length = static_cast<long long>(arr.Size());
+    long long start = segment.has_slice_start ? segment.slice_start : 0;
+    long long end = segment.has_slice_end ? segment.slice_end : length;
+    if (start < 0) start = std::max(start + length, 0LL);
+    if (end < 0) end = std::max(end + length, 0LL);
+    end = std::min(end, length);
+    for (long long i = start; i < end; i += segment.slice_step) {
+      if (!CollectMatches(arr[static_cast<size_t>(i)], depth + 1, visit)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  Value* next = StepInto(value, segment);
+  return next == nullptr || CollectMatches(*next, depth + 1, visit);
+}
+
+void JsonPath::CompilePointer(const std::string& expression) {
+  size_t i = 1;  // Skip leading '/'
+  while (true) {
+    size_t slash = expression.find('/', i);
+    std::string raw = expression.substr(
+        i, slash == std::string::npos ? std::string::npos : slash - i);
+
+    JsonPathSegment segment;
+    for (size_t j = 0; j < raw.length(); ++j) {
+      if (raw[j] != '~') {
+        segment.key += raw[j];
+      } else if (j + 1 < raw.length() && raw[j + 1] == '0') {
+        segment.key += '~';
+        ++j;
+      } else if (j + 1 < raw.length() && raw[j + 1] == '1') {
+        segment.key += '/';
+        ++j;
+      } else {
+        throw JsonPathException("Invalid '~' escape in '" + expression + "'");
+      }
+    }
+    if (IsArrayIndexToken(segment.key)) {
+      segment.key_or_index = true;
+      segment.index = std::stoll(segment.key);
+    }
+    segments_.push_back(std::move(segment));
+
+    if (slash == std::string::npos) {
+      break;
+    }
+    i = slash + 1;
+  }
+}
+
+void JsonPath::CompileDottedKeys(const std::string& path) {
+  if (path.empty()) {
+    return;
+  }
+  size_t i = 0;
+  const size_t n = path.length();
+  while (true) {
+    // Key up to the next '.' or '[', taken as is; it may be empty
+    size_t start = i;
+    while (i < n && path[i] != '.' && path[i] != '[') {
+      ++i;
+    }
+    if (i > start || i == n || path[i] == '.') {
+      JsonPathSegment segment;
+      segment.key = path.substr(start, i - start);
+      segments_.push_back(std::move(segment));
+    }
+    while (i < n && path[i] == '[') {
+      size_t close = path.find(']', i);
+      if (close == std::string::npos) {
+        throw JsonPathException("Missing ']' in '" + path + "'");
+      }
+      std::string digits = path.substr(i + 1, close - i - 1);
+      if (digits.empty() ||
+          digits.find_first_not_of("0123456789") != std::string::npos) {
+        throw JsonPathException("Invalid index '" + digits + "' in '" +
+                                path + "'");
+      }
+      JsonPathSegment segment;
+      segment.type = JsonPathSegment::Type::kIndex;
+      segment.index = ParseInteger(digits, path);
+      segments_.push_back(std::move(segment));
+      i = close + 1;
+    }
+    if (i == n) {
+      return;
+    }
+    if (path[i] != '.') {
+      throw JsonPathException("Unexpected character '" +
+                              std::string(1, path[i]) + "' in '" + path +
+                              "'");
+    }
+    ++i;
+  }
+}
+
+void JsonPath::CompileJsonPath(const std::string& expression) {
+  size_t i = 0;
+  size_t n = expression.length();
+  if (n > 0 && expression[0] == '$') {
+    i = 1;
+  } else if (n > 0 && expression[0] != '[') {
+    // Dotted path without the leading "$."
+    ReadDottedSegment(expression, i, segments_);
+  }
+
+  while (i < n) {
+    if (expression[i] == '.') {
+      ++i;
+      ReadDottedSegment(expression, i, segments_);
+    } else if (expression[i] == '[') {
+      ReadBracketSegment(expression, i, segments_);
+    } else {
+      throw JsonPathException("Unexpected character '" +
+                              std::string(1, expression[i]) + "' in '" +
+                              expression + "'");
+    }
+  }
+}
+
+}  // namespace json_parser
@@ -0,0 +1,1235 @@
+#include "json_parser/json_persistent.h"
+#include "json_parser/json_object.h"
+#include "json_parser/json_array.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace json_parser {
+
+namespace internal {
+
+// Hash array mapped trie node in the compressed (CHAMP) layout: datamap
+// marks slots that hold an entry inline, nodemap slots that hold a child,
+// and each array is indexed by the popcount of the lower bits. Below the
+// last hash bits a node is a collision list that ignores both maps.
+struct HamtEntry {
+  uint64_t hash;
+  std::string key;
+  JsonPersistentValue value;
+};
+
+struct HamtNode {
+  uint32_t datamap = 0;
+  uint32_t nodemap = 0;
+  std::vector<HamtEntry> entries;
+  std::vector<std::shared_ptr<const HamtNode>> children;
+};
+
+struct PersistentObject {
+  std::shared_ptr<const HamtNode> root;  // nullptr when empty
+  size_t size = 0;
+};
+
+// Relaxed radix-balanced trie node: leaves hold up to 32 values, branches
+// up to 32 children. In a regular branch every child but the last is
+// complete, so the index bits pick the child. Inserts and erases before
+// the end relax the branches along their path: sizes[i] then holds the
+// element count of children 0 to i, and lookups scan it from the slot the
+// index bits suggest. Regular branches only have regular descendants.
+struct VectorNode {
+  std::vector<JsonPersistentValue> values;
+  std::vector<std::shared_ptr<const VectorNode>> children;
+  std::vector<size_t> sizes;  // empty unless relaxed
+};
+
+struct PersistentArray {
+  size_t size = 0;
+  // Bits consumed above the leaves; the root is always a branch
+  unsigned shift = 5;
+  std::shared_ptr<const VectorNode> root;
+  // The last 1 to 32 elements, kept outside the trie so appends only copy
+  // this leaf; empty only in an empty array
+  std::shared_ptr<const VectorNode> tail;
+};
+
+}  // namespace internal
+
+namespace {
+
+using internal::HamtEntry;
+using internal::HamtNode;
+using internal::PersistentArray;
+using internal::PersistentObject;
+using internal::VectorNode;
+
+using HamtPtr = std::shared_ptr<const HamtNode>;
+using VectorPtr = std::shared_ptr<const VectorNode>;
+
+constexpr unsigned kBits = 5;
+constexpr size_t kWidth = size_t{1} << kBits;
+constexpr uint64_t kMask = kWidth - 1;
+constexpr unsigned kHashBits = 64;
+
+// FNV-1a with a final mix, so the trie layout and member order are the
+// same on every platform and the low bits used first are well spread
+uint64_t HashKey(const std::string& key) {
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : key) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+uint32_t BitFor(uint64_t hash, unsigned shift) {
+  return uint32_t{1} << ((hash >> shift) & kMask);
+}
+
+size_t SlotIndex(uint32_t map, uint32_t bit) {
+  return std::bitset<32>(map & (bit - 1)).count();
+}
+
+bool Matches(const HamtEntry& entry, uint64_t hash, const std::string& key) {
+  return entry.hash == hash && entry.key == key;
+}
+
+const HamtEntry* HamtFind(const HamtNode* node, uint64_t hash,
+                          const std::string& key) {
+  for (unsigned shift = 0; node != nullptr; shift += kBits) {
+    if (shift >= kHashBits) {
+      for (const HamtEntry& entry : node->entries) {
+        if (Matches(entry, hash, key)) {
+          return &entry;
+        }
+      }
+      return nullptr;
+    }
+    uint32_t bit = BitFor(hash, shift);
+    if (node->datamap & bit) {
+      const HamtEntry& entry = node->entries[SlotIndex(node->datamap, bit)];
+      return Matches(entry, hash, key) ? &entry : nullptr;
+    }
+    if (!(node->nodemap & bit)) {
+      return nullptr;
+    }
+    node = node->children[SlotIndex(node->nodemap, bit)].get();
+  }
+  return nullptr;
+}
+
+// Node holding two entries whose hashes agree below shift
+HamtPtr HamtMerge(HamtEntry a, HamtEntry b, unsigned shift) {
+  auto node = std::make_shared<HamtNode>();
+  if (shift >= kHashBits) {
+    node->entries.push_back(std::move(a));
+    node->entries.push_back(std::move(b));
+    return node;
+  }
+  uint32_t bit_a = BitFor(a.hash, shift);
+  uint32_t bit_b = BitFor(b.hash, shift);
+  if (bit_a == bit_b) {
+    node->nodemap = bit_a;
+    node->children.push_back(HamtMerge(std::move(a), std::move(b),
+                                       shift + kBits));
+  } else {
+    node->datamap = bit_a | bit_b;
+    if (bit_a > bit_b) {
+      std::swap(a, b);
+    }
+    node->entries.push_back(std::move(a));
+    node->entries.push_back(std::move(b));
+  }
+  return node;
+}
+
+HamtPtr HamtInsert(const HamtPtr& node, HamtEntry entry, unsigned shift,
+                   bool& added) {
+  auto copy = node ? std::make_shared<HamtNode>(*node)
+                   : std::make_shared<HamtNode>();
+  if (shift >= kHashBits) {
+    for (HamtEntry& existing : copy->entries) {
+      if (Matches(existing, entry.hash, entry.key)) {
+        existing.value = std::move(entry.value);
+        added = false;
+        return copy;
+      }
+    }
+    copy->entries.push_back(std::move(entry));
+    added = true;
+    return copy;
+  }
+
+  uint32_t bit = BitFor(entry.hash, shift);
+  if (copy->datamap & bit) {
+    size_t index = SlotIndex(copy->datamap, bit);
+    HamtEntry& existing = copy->entries[index];
+    if (Matches(existing, entry.hash, entry.key)) {
+      existing.value = std::move(entry.value);
+      added = false;
+      return copy;
+    }
+    // Two keys now share this slot, so both move one level down
+    HamtPtr child =
+        HamtMerge(std::move(existing), std::move(entry), shift + kBits);
+    copy->entries.erase(copy->entries.begin() + index);
+    copy->datamap ^= bit;
+    copy->nodemap |= bit;
+    copy->children.insert(
+        copy->children.begin() + SlotIndex(copy->nodemap, bit),
+        std::move(child));
+    added = true;
+    return copy;
+  }
+  if (copy->nodemap & bit) {
+    size_t index = SlotIndex(copy->nodemap, bit);
+    copy->children[index] =
+        HamtInsert(copy->children[index], std::move(entry), shift + kBits,
+                   added);
+    return copy;
+  }
+  copy->entries.insert(copy->entries.begin() + SlotIndex(copy->datamap, bit),
+                       std::move(entry));
+  copy->datamap |= bit;
+  added = true;
+  return copy;
+}
+
+bool HoldsSingleEntry(const HamtNode& node) {
+  return node.entries.size() == 1 && node.children.empty();
+}
+
+// Returns node itself if key is absent and nullptr if the node empties. A
+// child left with a single entry is folded into its parent, so a given
+// set of keys always produces the same trie.
+HamtPtr HamtErase(const HamtPtr& node, uint64_t hash, const std::string& key,
+                  unsigned shift, bool& removed) {
+  if (shift >= kHashBits) {
+    for (size_t i = 0; i < node->entries.size(); ++i) {
+      if (Matches(node->entries[i], hash, key)) {
+        removed = true;
+        if (node->entries.size() == 1) {
+          return nullptr;
+        }
+        auto copy = std::make_shared<HamtNode>(*node);
+        copy->entries.erase(copy->entries.begin() + i);
+        return copy;
+      }
+    }
+    return node;
+  }
+
+  uint32_t bit = BitFor(hash, shift);
+  if (node->datamap & bit) {
+    size_t index = SlotIndex(node->datamap, bit);
+    if (!Matches(node->entries[index], hash, key)) {
+      return node;
+    }
+    removed = true;
+    if (HoldsSingleEntry(*node)) {
+      return nullptr;
+    }
+    auto copy = std::make_shared<HamtNode>(*node);
+    copy->entries.erase(copy->entries.begin() + index);
+    copy->datamap ^= bit;
+    return copy;
+  }
+  if (!(node->nodemap & bit)) {
+    return node;
+  }
+
+  size_t index = SlotIndex(node->nodemap, bit);
+  HamtPtr child =
+      HamtErase(node->children[index], hash, key, shift + kBits, removed);
+  if (!removed) {
+    return node;
+  }
+  auto copy = std::make_shared<HamtNode>(*node);
+  if (child != nullptr && !HoldsSingleEntry(*child)) {
+    copy->children[index] = std::move(child);
+    return copy;
+  }
+  copy->children.erase(copy->children.begin() + index);
+  copy->nodemap ^= bit;
+  if (child != nullptr) {
+    copy->entries.insert(
+        copy->entries.begin() + SlotIndex(copy->datamap, bit),
+        child->entries.front());
+    copy->datamap |= bit;
+  } else if (copy->entries.empty() && copy->children.empty()) {
+    return nullptr;
+  }
+  return copy;
+}
+
+void HamtForEach(
+    const HamtNode* node,
+    const std::function<void(const std::string&, const JsonPersistentValue&)>&
+        visit) {
+  if (node == nullptr) {
+    return;
+  }
+  for (const HamtEntry& entry : node->entries) {
+    visit(entry.key, entry.value);
+  }
+  for (const HamtPtr& child : node->children) {
+    HamtForEach(child.get(), visit);
+  }
+}
+
+// Tries holding the same keys have the same shape, so they are compared
+// node by node and shared nodes are skipped. Only collision lists, whose
+// order depends on insertion, are compared as sets.
+bool HamtEqual(const HamtNode* a, const HamtNode* b, unsigned shift) {
+  if (a == b) {
+    return true;
+  }
+  if (a == nullptr || b == nullptr ||
+      a->entries.size() != b->entries.size()) {
+    return false;
+  }
+  if (shift >= kHashBits) {
+    for (const HamtEntry& entry : a->entries) {
+      const HamtEntry* other = nullptr;
+      for (const HamtEntry& candidate : b->entries) {
+        if (candidate.key == entry.key) {
+          other = &candidate;
+          break;
+        }
+      }
+      if (other == nullptr || other->value != entry.value) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (a->datamap != b->datamap || a->nodemap != b->nodemap) {
+    return false;
+  }
+  for (size_t i = 0; i < a->entries.size(); ++i) {
+    if (a->entries[i].hash != b->entries[i].hash ||
+        a->entries[i].key != b->entries[i].key ||
+        a->entries[i].value != b->entries[i].value) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < a->children.size(); ++i) {
+    if (!HamtEqual(a->children[i].get(), b->children[i].get(),
+                   shift + kBits)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t TailOffset(size_t size) {
+  return size < kWidth ? 0 : ((size - 1) >> kBits) << kBits;
+}
+
+// Elements held in the trie, ahead of the tail
+size_t TrieSize(const PersistentArray& arr) {
+  return arr.size - arr.tail->values.size();
+}
+
+// Values of a leaf or children of a branch
+size_t EntryCount(const VectorNode& node, unsigned level) {
+  return level == 0 ? node.values.size() : node.children.size();
+}
+
+size_t NodeSize(const VectorNode& node, unsigned level) {
+  if (level == 0) {
+    return node.values.size();
+  }
+  if (!node.sizes.empty()) {
+    return node.sizes.back();
+  }
+  if (node.children.empty()) {
+    return 0;
+  }
+  return ((node.children.size() - 1) << level) +
+         NodeSize(*node.children.back(), level - kBits);
+}
+
+// Size table of a branch, computed for a regular one
+std::vector<size_t> SizeTable(const VectorNode& node, unsigned level) {
+  if (!node.sizes.empty() || node.children.empty()) {
+    return node.sizes;
+  }
+  std::vector<size_t> sizes(node.children.size());
+  for (size_t i = 0; i + 1 < sizes.size(); ++i) {
+    sizes[i] = (i + 1) << level;
+  }
+  sizes.back() = NodeSize(node, level);
+  return sizes;
+}
+
+// Slot of the child of a branch at level that holds index, which is made
+// relative to that child. Children hold at most 1 << level elements, so
+// the slot is never before the one the index bits give.
+size_t ChildFor(const VectorNode& node, unsigned level, size_t& index) {
+  size_t slot = (index >> level) & kMask;
+  if (node.sizes.empty()) {
+    index &= (size_t{1} << level) - 1;
+    return slot;
+  }
+  while (node.sizes[slot] <= index) {
+    ++slot;
+  }
+  if (slot > 0) {
+    index -= node.sizes[slot - 1];
+  }
+  return slot;
+}
+
+// Leaf holding index, which is made relative to it
+const VectorNode* LeafFor(const PersistentArray& arr, size_t& index) {
+  const size_t trie_size = TrieSize(arr);
+  if (index >= trie_size) {
+    index -= trie_size;
+    return arr.tail.get();
+  }
+  const VectorNode* node = arr.root.get();
+  for (unsigned level = arr.shift; level > 0; level -= kBits) {
+    node = node->children[ChildFor(*node, level, index)].get();
+  }
+  return node;
+}
+
+// Chain of single-child branches from level down to leaf
+VectorPtr NewPath(unsigned level, VectorPtr leaf) {
+  if (level == 0) {
+    return leaf;
+  }
+  auto node = std::make_shared<VectorNode>();
+  node->children.push_back(NewPath(level - kBits, std::move(leaf)));
+  return node;
+}
+
+// Adds a full leaf after the last leaf under a branch; nullptr if the
+// branch has no room. A regular branch without room is complete, so
+// regular branches stay regular.
+VectorPtr AppendLeaf(unsigned level, const VectorNode& node, VectorPtr leaf) {
+  VectorPtr last;
+  if (level > kBits && !node.children.empty()) {
+    last = AppendLeaf(level - kBits, *node.children.back(), leaf);
+  }
+  if (last == nullptr && node.children.size() == kWidth) {
+    return nullptr;
+  }
+  auto copy = std::make_shared<VectorNode>(node);
+  if (last != nullptr) {
+    copy->children.back() = std::move(last);
+  } else {
+    copy->children.push_back(NewPath(level - kBits, std::move(leaf)));
+    if (!copy->sizes.empty()) {
+      copy->sizes.push_back(copy->sizes.back());
+    }
+  }
+  if (!copy->sizes.empty()) {
+    copy->sizes.back() += kWidth;
+  }
+  return copy;
+}
+
+// Appends a full leaf to the trie, growing a new root above a full one
+void PushLeaf(PersistentArray& arr, VectorPtr leaf) {
+  VectorPtr root = AppendLeaf(arr.shift, *arr.root, leaf);
+  if (root == nullptr) {
+    auto grown = std::make_shared<VectorNode>();
+    grown->children.push_back(arr.root);
+    grown->children.push_back(NewPath(arr.shift, std::move(leaf)));
+    if (!arr.root->sizes.empty()) {
+      grown->sizes = {arr.root->sizes.back(), arr.root->sizes.back() + kWidth};
+    }
+    root = std::move(grown);
+    arr.shift += kBits;
+  }
+  arr.root = std::move(root);
+}
+
+// Removes the last leaf, holding count elements, under a branch; nullptr
+// if the branch empties
+VectorPtr DropLastLeaf(unsigned level, const VectorNode& node, size_t count) {
+  VectorPtr last;
+  if (level > kBits) {
+    last = DropLastLeaf(level - kBits, *node.children.back(), count);
+  }
+  if (last == nullptr && node.children.size() == 1) {
+    return nullptr;
+  }
+  auto copy = std::make_shared<VectorNode>(node);
+  if (last != nullptr) {
+    copy->children.back() = std::move(last);
+    if (!copy->sizes.empty()) {
+      copy->sizes.back() -= count;
+    }
+  } else {
+    copy->children.pop_back();
+    if (!copy->sizes.empty()) {
+      copy->sizes.pop_back();
+    }
+  }
+  return copy;
+}
+
+// After the trie changed: an emptied trie gets an empty root, and roots
+// with a single child give way to it
+void ShrinkRoot(PersistentArray& arr) {
+  if (arr.root == nullptr) {
+    arr.root = std::make_shared<VectorNode>();
+    arr.shift = kBits;
+  }
+  while (arr.shift > kBits && arr.root->children.size() == 1) {
+    arr.root = arr.root->children.front();
+    arr.shift -= kBits;
+  }
+}
+
+VectorPtr AssocAt(unsigned level, const VectorNode& node, size_t index,
+                  JsonPersistentValue value) {
+  auto copy = std::make_shared<VectorNode>(node);
+  if (level == 0) {
+    copy->values[index] = std::move(value);
+  } else {
+    size_t slot = ChildFor(node, level, index);
+    copy->children[slot] =
+        AssocAt(level - kBits, *node.children[slot], index, std::move(value));
+  }
+  return copy;
+}
+
+// Node holding the entries of a followed by those of b
+VectorPtr Concat(unsigned level, const VectorNode& a, const VectorNode& b) {
+  auto joined = std::make_shared<VectorNode>(a);
+  if (level == 0) {
+    joined->values.insert(joined->values.end(), b.values.begin(),
+                          b.values.end());
+    return joined;
+  }
+  joined->sizes = SizeTable(a, level);
+  const size_t offset = joined->sizes.back();
+  for (size_t size : SizeTable(b, level)) {
+    joined->sizes.push_back(offset + size);
+  }
+  joined->children.insert(joined->children.end(), b.children.begin(),
+                          b.children.end());
+  return joined;
+}
+
+// Joins the child at slot of a relaxed branch with a neighbour once it is
+// below half width and both fit in one node, which keeps the trie dense
+// under erases
+void MergeUnderfull(VectorNode& node, unsigned level, size_t slot) {
+  const unsigned child_level = level - kBits;
+  const size_t count = EntryCount(*node.children[slot], child_level);
+  if (count >= kWidth / 2) {
+    return;
+  }
+  size_t left;
+  if (slot + 1 < node.children.size() &&
+      count + EntryCount(*node.children[slot + 1], child_level) <= kWidth) {
+    left = slot;
+  } else if (slot > 0 &&
+             count + EntryCount(*node.children[slot - 1], child_level) <=
+                 kWidth) {
+    left = slot - 1;
+  } else {
+    return;
+  }
+  node.children[left] = Concat(child_level, *node.children[left],
+                               *node.children[left + 1]);
+  node.children.erase(node.children.begin() + left + 1);
+  node.sizes.erase(node.sizes.begin() + left);
+}
+
+// Removes the element at index under node; nullptr if the node empties
+VectorPtr EraseAt(unsigned level, const VectorNode& node, size_t index) {
+  auto copy = std::make_shared<VectorNode>(node);
+  if (level == 0) {
+    copy->values.erase(copy->values.begin() + index);
+    return copy->values.empty() ? nullptr : copy;
+  }
+  copy->sizes = SizeTable(node, level);
+  const size_t slot = ChildFor(node, level, index);
+  VectorPtr child = EraseAt(level - kBits, *node.children[slot], index);
+  for (size_t i = slot; i < copy->sizes.size(); ++i) {
+    --copy->sizes[i];
+  }
+  if (child == nullptr) {
+    copy->children.erase(copy->children.begin() + slot);
+    copy->sizes.erase(copy->sizes.begin() + slot);
+    return copy->children.empty() ? nullptr : copy;
+  }
+  copy->children[slot] = std::move(child);
+  MergeUnderfull(*copy, level, slot);
+  return copy;
+}
+
+// Moves the upper half of an overfull node into a new one
+VectorPtr SplitHalf(VectorNode& node, unsigned level) {
+  auto upper = std::make_shared<VectorNode>();
+  const size_t half = EntryCount(node, level) / 2;
+  if (level == 0) {
+    upper->values.assign(node.values.begin() + half, node.values.end());
+    node.values.erase(node.values.begin() + half, node.values.end());
+    return upper;
+  }
+  upper->children.assign(node.children.begin() + half, node.children.end());
+  node.children.erase(node.children.begin() + half, node.children.end());
+  const size_t offset = node.sizes[half - 1];
+  for (size_t i = half; i < node.sizes.size(); ++i) {
+    upper->sizes.push_back(node.sizes[i] - offset);
+  }
+  node.sizes.erase(node.sizes.begin() + half, node.sizes.end());
+  return upper;
+}
+
+// Inserts value before the element at index under node. A node that
+// overflows is split and its upper half returned through upper.
+VectorPtr InsertAt(unsigned level, const VectorNode& node, size_t index,
+                   JsonPersistentValue value, VectorPtr& upper) {
+  auto copy = std::make_shared<VectorNode>(node);
+  if (level == 0) {
+    copy->values.insert(copy->values.begin() + index, std::move(value));
+  } else {
+    copy->sizes = SizeTable(node, level);
+    const size_t slot = ChildFor(node, level, index);
+    VectorPtr split;
+    copy->children[slot] = InsertAt(level - kBits, *node.children[slot],
+                                    index, std::move(value), split);
+    for (size_t i = slot; i < copy->sizes.size(); ++i) {
+      ++copy->sizes[i];
+    }
+    if (split != nullptr) {
+      const size_t lower_end =
+          copy->sizes[slot] - NodeSize(*split, level - kBits);
+      copy->children.insert(copy->children.begin() + slot + 1,
+                            std::move(split));
+      copy->sizes.insert(copy->sizes.begin() + slot, lower_end);
+    }
+  }
+  if (EntryCount(*copy, level) > kWidth) {
+    upper = SplitHalf(*copy, level);
+  }
+  return copy;
+}
+
+// Builds the trie bottom-up in the layout successive appends would give
+std::shared_ptr<const PersistentArray> BuildArray(
+    std::vector<JsonPersistentValue> values) {
+  auto arr = std::make_shared<PersistentArray>();
+  arr->size = values.size();
+  const size_t tail_offset = TailOffset(arr->size);
+
+  std::vector<VectorPtr> level;
+  for (size_t i = 0; i < tail_offset; i += kWidth) {
+    auto leaf = std::make_shared<VectorNode>();
+    leaf->values.assign(std::make_move_iterator(values.begin() + i),
+                        std::make_move_iterator(values.begin() + i + kWidth));
+    level.push_back(std::move(leaf));
+  }
+  auto tail = std::make_shared<VectorNode>();
+  tail->values.assign(std::make_move_iterator(values.begin() + tail_offset),
+                      std::make_move_iterator(values.end()));
+  arr->tail = std::move(tail);
+
+  while (level.size() > kWidth) {
+    std::vector<VectorPtr> parents;
+    for (size_t i = 0; i < level.size(); i += kWidth) {
+      auto branch = std::make_shared<VectorNode>();
+      size_t end = std::min(level.size(), i + kWidth);
+      branch->children.assign(std::make_move_iterator(level.begin() + i),
+                              std::make_move_iterator(level.begin() + end));
+      parents.push_back(std::move(branch));
+    }
+    level = std::move(parents);
+    arr->shift += kBits;
+  }
+  auto root = std::make_shared<VectorNode>();
+  root->children = std::move(level);
+  arr->root = std::move(root);
+  return arr;
+}
+
+void CollectLeaves(const VectorNode& node, unsigned level,
+                   std::vector<const VectorNode*>& leaves) {
+  if (level == 0) {
+    leaves.push_back(&node);
+    return;
+  }
+  for (const VectorPtr& child : node.children) {
+    CollectLeaves(*child, level - kBits, leaves);
+  }
+}
+
+// Compares the values of two leaf sequences however they are split
+bool LeavesEqual(const std::vector<const VectorNode*>& a,
+                 const std::vector<const VectorNode*>& b) {
+  size_t leaf_a = 0;
+  size_t leaf_b = 0;
+  size_t at_a = 0;
+  size_t at_b = 0;
+  while (true) {
+    while (leaf_a < a.size() && at_a == a[leaf_a]->values.size()) {
+      ++leaf_a;
+      at_a = 0;
+    }
+    while (leaf_b < b.size() && at_b == b[leaf_b]->values.size()) {
+      ++leaf_b;
+      at_b = 0;
+    }
+    if (leaf_a == a.size() || leaf_b == b.size()) {
+      return leaf_a == a.size() && leaf_b == b.size();
+    }
+    if (a[leaf_a]->values[at_a++] != b[leaf_b]->values[at_b++]) {
+      return false;
+    }
+  }
+}
+
+// Compares two subtrees at level holding as many elements. Regular
+// branches of one size, and relaxed ones with one size table, split their
+// elements alike, so shared children can be skipped; other pairs are
+// compared element by element.
+bool VectorEqual(const VectorNode* a, const VectorNode* b, unsigned level) {
+  if (a == b) {
+    return true;
+  }
+  if (level == 0) {
+    return a->values == b->values;
+  }
+  if (a->sizes != b->sizes || a->children.size() != b->children.size()) {
+    std::vector<const VectorNode*> leaves_a;
+    std::vector<const VectorNode*> leaves_b;
+    CollectLeaves(*a, level, leaves_a);
+    CollectLeaves(*b, level, leaves_b);
+    return LeavesEqual(leaves_a, leaves_b);
+  }
+  for (size_t i = 0; i < a->children.size(); ++i) {
+    if (!VectorEqual(a->children[i].get(), b->children[i].get(),
+                     level - kBits)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const char* TypeName(JsonValueType type) {
+  switch (type) {
+    case JsonValueType::kObject:
+      return "object";
+    case JsonValueType::kArray:
+      return "array";
+    case JsonValueType::kString:
+      return "string";
+    case JsonValueType::kNumber:
+      return "number";
+    case JsonValueType::kBoolean:
+      return "boolean";
+    case JsonValueType::kNull:
+      return "null";
+  }
+  return "null";
+}
+
+void ExpectType(JsonValueType actual, JsonValueType expected) {
+  if (actual != expected) {
+    throw JsonTypeException(std::string("Expected different type, got: ") +
+                            TypeName(actual));
+  }
+}
+
+// Index selected by a path step on an array, or -1 if it selects none
+long long PathIndex(const JsonPathSegment& step, size_t size) {
+  if (step.type != JsonPathSegment::Type::kIndex && !step.key_or_index) {
+    return -1;
+  }
+  long long count = static_cast<long long>(size);
+  long long index = step.index < 0 ? step.index + count : step.index;
+  return index < 0 || index >= count ? -1 : index;
+}
+
+}  // namespace
+
+JsonPersistentValue::JsonPersistentValue(const std::string& str)
+    : value_(std::make_shared<const std::string>(str)) {}
+
+JsonPersistentValue::JsonPersistentValue(const char* str)
+    : value_(std::make_shared<const std::string>(str)) {}
+
+JsonPersistentValue JsonPersistentValue::Object() {
+  return JsonPersistentValue(std::make_shared<const PersistentObject>());
+}
+
+JsonPersistentValue JsonPersistentValue::Array() {
+  return JsonPersistentValue(BuildArray({}));
+}
+
+JsonPersistentValue JsonPersistentValue::FromJsonValue(
+    const JsonValue& value) {
+  switch (value.GetType()) {
+    case JsonValueType::kObject: {
+      const JsonObject& obj = value.AsObject();
+      auto result = std::make_shared<PersistentObject>();
+      for (auto it = obj.Begin(); it != obj.End(); ++it) {
+        bool added = false;
+        result->root = HamtInsert(
+            result->root,
+            HamtEntry{HashKey(it->first), it->first,
+                      FromJsonValue(it->second)},
+            0, added);
+      }
+      result->size = obj.Size();
+      return JsonPersistentValue(ObjectPtr(std::move(result)));
+    }
+    case JsonValueType::kArray: {
+      const JsonArray& arr = value.AsArray();
+      std::vector<JsonPersistentValue> values;
+      values.reserve(arr.Size());
+      for (size_t i = 0; i < arr.Size(); ++i) {
+        values.push_back(FromJsonValue(arr[i]));
+      }
+      return JsonPersistentValue(BuildArray(std::move(values)));
+    }
+    case JsonValueType::kString:
+      return JsonPersistentValue(value.AsString());
+    case JsonValueType::kNumber:
+      return JsonPersistentValue(value.AsNumber());
+    case JsonValueType::kBoolean:
+      return JsonPersistentValue(value.AsBoolean());
+    case JsonValueType::kNull:
+      break;
+  }
+  return JsonPersistentValue();
+}
+
+JsonValue JsonPersistentValue::ToJsonValue() const {
+  switch (GetType()) {
+    case JsonValueType::kObject: {
+      JsonValue result{JsonObject()};
+      JsonObject& obj = result.AsObject();
+      ForEachMember(
+          [&obj](const std::string& key, const JsonPersistentValue& value) {
+            obj.Insert(key, value.ToJsonValue());
+          });
+      return result;
+    }
+    case JsonValueType::kArray: {
+      JsonValue result{JsonArray()};
+      JsonArray& arr = result.AsArray();
+      const size_t size = Size();
+      arr.Reserve(size);
+      for (size_t i = 0; i < size; ++i) {
+        arr.PushBack((*this)[i].ToJsonValue());
+      }
+      return result;
+    }
+    case JsonValueType::kString:
+      return JsonValue(AsString());
+    case JsonValueType::kNumber:
+      return JsonValue(AsNumber());
+    case JsonValueType::kBoolean:
+      return JsonValue(AsBoolean());
+    case JsonValueType::kNull:
+      break;
+  }
+  return JsonValue(nullptr);
+}
+
+JsonValueType JsonPersistentValue::GetType() const {
+  switch (value_.index()) {
+    case 1:
+      return JsonValueType::kBoolean;
+    case 2:
+      return JsonValueType::kNumber;
+    case 3:
+      return JsonValueType::kString;
+    case 4:
+      return JsonValueType::kObject;
+    case 5:
+      return JsonValueType::kArray;
+    default:
+      return JsonValueType::kNull;
+  }
+}
+
+bool JsonPersistentValue::AsBoolean() const {
+  ExpectType(GetType(), JsonValueType::kBoolean);
+  return std::get<bool>(value_);
+}
+
+double JsonPersistentValue::AsNumber() const {
+  ExpectType(GetType(), JsonValueType::kNumber);
+  return std::get<double>(value_);
+}
+
+const std::string& JsonPersistentValue::AsString() const {
+  ExpectType(GetType(), JsonValueType::kString);
+  return *std::get<std::shared_ptr<const std::string>>(value_);
+}
+
+const internal::PersistentObject& JsonPersistentValue::ObjectData() const {
+  ExpectType(GetType(), JsonValueType::kObject);
+  return *std::get<ObjectPtr>(value_);
+}
+
+const internal::PersistentArray& JsonPersistentValue::ArrayData() const {
+  ExpectType(GetType(), JsonValueType::kArray);
+  return *std::get<ArrayPtr>(value_);
+}
+
+size_t JsonPersistentValue::Size() const {
+  if (IsArray()) {
+    return ArrayData().size;
+  }
+  return ObjectData().size;
+}
+
+const JsonPersistentValue* JsonPersistentValue::Find(
+    const std::string& key) const {
+  const HamtEntry* entry =
+      HamtFind(ObjectData().root.get(), HashKey(key), key);
+  return entry != nullptr ? &entry->value : nullptr;
+}
+
+const JsonPersistentValue& JsonPersistentValue::operator[](
+    const std::string& key) const {
+  const JsonPersistentValue* value = Find(key);
+  if (value == nullptr) {
+    throw JsonKeyException(key);
+  }
+  return *value;
+}
+
+JsonPersistentValue JsonPersistentValue::Set(const std::string& key,
+                                             JsonPersistentValue value) const {
+  const PersistentObject& obj = ObjectData();
+  auto result = std::make_shared<PersistentObject>();
+  bool added = false;
+  result->root = HamtInsert(
+      obj.root, HamtEntry{HashKey(key), key, std::move(value)}, 0, added);
+  result->size = obj.size + (added ? 1 : 0);
+  return JsonPersistentValue(ObjectPtr(std::move(result)));
+}
+
+JsonPersistentValue JsonPersistentValue::Erase(const std::string& key) const {
+  const PersistentObject& obj = ObjectData();
+  if (obj.root == nullptr) {
+    return *this;
+  }
+  bool removed = false;
+  HamtPtr root = HamtErase(obj.root, HashKey(key), key, 0, removed);
+  if (!removed) {
+    return *this;
+  }
+  auto result = std::make_shared<PersistentObject>();
+  result->root = std::move(root);
+  result->size = obj.size - 1;
+  return JsonPersistentValue(ObjectPtr(std::move(result)));
+}
+
+void JsonPersistentValue::ForEachMember(
+    const std::function<void(const std::string&, const JsonPersistentValue&)>&
+        visit) const {
+  HamtForEach(ObjectData().root.get(), visit);
+}
+
+const JsonPersistentValue& JsonPersistentValue::operator[](
+    size_t index) const {
+  const PersistentArray& arr = ArrayData();
+  if (index >= arr.size) {
+    throw JsonException("Array index out of bounds: " +
+                        std::to_string(index));
+  }
+  const VectorNode* leaf = LeafFor(arr, index);
+  return leaf->values[index];
+}
+
+JsonPersistentValue JsonPersistentValue::Set(size_t index,
+                                             JsonPersistentValue value) const {
+  const PersistentArray& arr = ArrayData();
+  if (index >= arr.size) {
+    throw JsonException("Array index out of bounds: " +
+                        std::to_string(index));
+  }
+  auto result = std::make_shared<PersistentArray>(arr);
+  const size_t trie_size = TrieSize(arr);
+  if (index >= trie_size) {
+    auto tail = std::make_shared<VectorNode>(*arr.tail);
+    tail->values[index - trie_size] = std::move(value);
+    result->tail = std::move(tail);
+  } else {
+    result->root = AssocAt(arr.shift, *arr.root, index, std::move(value));
+  }
+  return JsonPersistentValue(ArrayPtr(std::move(result)));
+}
+
+JsonPersistentValue JsonPersistentValue::PushBack(
+    JsonPersistentValue value) const {
+  const PersistentArray& arr = ArrayData();
+  auto result = std::make_shared<PersistentArray>(arr);
+  result->size = arr.size + 1;
+  if (arr.tail->values.size() < kWidth) {
+    auto tail = std::make_shared<VectorNode>();
+    tail->values.reserve(arr.tail->values.size() + 1);
+    tail->values.insert(tail->values.end(), arr.tail->values.begin(),
+                        arr.tail->values.end());
+    tail->values.push_back(std::move(value));
+    result->tail = std::move(tail);
+    return JsonPersistentValue(ArrayPtr(std::move(result)));
+  }
+
+  // The tail is full and becomes the trie's last leaf
+  PushLeaf(*result, arr.tail);
+  auto tail = std::make_shared<VectorNode>();
+  tail->values.push_back(std::move(value));
+  result->tail = std::move(tail);
+  return JsonPersistentValue(ArrayPtr(std::move(result)));
+}
+
+JsonPersistentValue JsonPersistentValue::PopBack() const {
+  if (ArrayData().size == 0) {
+    throw JsonException("Cannot pop from an empty array");
+  }
+  return Erase(ArrayData().size - 1);
+}
+
+JsonPersistentValue JsonPersistentValue::Insert(
+    size_t index, JsonPersistentValue value) const {
+  const PersistentArray& arr = ArrayData();
+  if (index > arr.size) {
+    throw JsonException("Array index out of bounds: " +
+                        std::to_string(index));
+  }
+  auto result = std::make_shared<PersistentArray>(arr);
+  result->size = arr.size + 1;
+  const size_t trie_size = TrieSize(arr);
+  if (index < trie_size) {
+    VectorPtr upper;
+    VectorPtr root =
+        InsertAt(arr.shift, *arr.root, index, std::move(value), upper);
+    if (upper != nullptr) {
+      auto grown = std::make_shared<VectorNode>();
+      const size_t lower_size = NodeSize(*root, arr.shift);
+      grown->sizes = {lower_size,
+                      lower_size + NodeSize(*upper, arr.shift)};
+      grown->children.push_back(std::move(root));
+      grown->children.push_back(std::move(upper));
+      root = std::move(grown);
+      result->shift = arr.shift + kBits;
+    }
+    result->root = std::move(root);
+    return JsonPersistentValue(ArrayPtr(std::move(result)));
+  }
+
+  // An overfull tail hands its first 32 elements to the trie
+  auto tail = std::make_shared<VectorNode>(*arr.tail);
+  tail->values.insert(tail->values.begin() + (index - trie_size),
+                      std::move(value));
+  if (tail->values.size() > kWidth) {
+    auto leaf = std::make_shared<VectorNode>();
+    leaf->values.assign(std::make_move_iterator(tail->values.begin()),
+                        std::make_move_iterator(tail->values.begin() + kWidth));
+    tail->values.erase(tail->values.begin(), tail->values.begin() + kWidth);
+    PushLeaf(*result, std::move(leaf));
+  }
+  result->tail = std::move(tail);
+  return JsonPersistentValue(ArrayPtr(std::move(result)));
+}
+
+JsonPersistentValue JsonPersistentValue::Erase(size_t index) const {
+  const PersistentArray& arr = ArrayData();
+  if (index >= arr.size) {
+    throw JsonException("Array index out of bounds: " +
+                        std::to_string(index));
+  }
+  if (arr.size == 1) {
+    return Array();
+  }
+  auto result = std::make_shared<PersistentArray>(arr);
+  result->size = arr.size - 1;
+  const size_t trie_size = TrieSize(arr);
+  if (index < trie_size) {
+    result->root = EraseAt(arr.shift, *arr.root, index);
+  } else if (arr.tail->values.size() > 1) {
+    auto tail = std::make_shared<VectorNode>(*arr.tail);
+    tail->values.erase(tail->values.begin() + (index - trie_size));
+    result->tail = std::move(tail);
+    return JsonPersistentValue(ArrayPtr(std::move(result)));
+  } else {
+    // The tail empties, so the trie's last leaf becomes the tail
+    VectorPtr leaf = arr.root;
+    for (unsigned level = arr.shift; level > 0; level -= kBits) {
+      leaf = leaf->children.back();
+    }
+    result->root =
+        DropLastLeaf(arr.shift, *arr.root, leaf->values.size());
+    result->tail = std::move(leaf);
+  }
+  ShrinkRoot(*result);
+  return JsonPersistentValue(ArrayPtr(std::move(result)));
+}
+
+const JsonPersistentValue* JsonPersistentValue::FindIn(
+    const JsonPath& path) const {
+  const JsonPersistentValue* current = this;
+  for (const JsonPathSegment& step : path.Segments()) {
+    if (current->IsObject()) {
+      if (step.type != JsonPathSegment::Type::kKey) {
+        return nullptr;
+      }
+      current = current->Find(step.key);
+    } else if (current->IsArray()) {
+      long long index = PathIndex(step, current->Size());
+      if (index < 0) {
+        return nullptr;
+      }
+      current = &(*current)[static_cast<size_t>(index)];
+    } else {
+      return nullptr;
+    }
+    if (current == nullptr) {
+      return nullptr;
+    }
+  }
+  return current;
+}
+
+JsonPersistentValue JsonPersistentValue::SetIn(
+    const JsonPath& path, JsonPersistentValue value) const {
+  if (!path.IsSingular()) {
+    throw JsonPathException("Updates need a singular path: " +
+                            path.Expression());
+  }
+  if (path.IsRoot()) {
+    return value;
+  }
+  return SetIn(path, 0, &value);
+}
+
+JsonPersistentValue JsonPersistentValue::EraseIn(const JsonPath& path) const {
+  if (!path.IsSingular()) {
+    throw JsonPathException("Updates need a singular path: " +
+                            path.Expression());
+  }
+  if (path.IsRoot()) {
+    throw JsonPathException("Cannot erase the root");
+  }
+  return SetIn(path, 0, nullptr);
+}
+
+JsonPersistentValue JsonPersistentValue::SetIn(
+    const JsonPath& path, size_t segment,
+    const JsonPersistentValue* value) const {
+  const JsonPathSegment& step = path.Segments()[segment];
+  const bool last = segment + 1 == path.Segments().size();
+
+  if (IsObject()) {
+    if (step.type != JsonPathSegment::Type::kKey) {
+      throw JsonPathException("Index step on an object in path " +
+                              path.Expression());
+    }
+    if (last) {
+      return value != nullptr ? Set(step.key, *value) : Erase(step.key);
+    }
+    const JsonPersistentValue* child = Find(step.key);
+    if (child == nullptr) {
+      throw JsonPathException("No member '" + step.key + "' in path " +
+                              path.Expression());
+    }
+    return Set(step.key, child->SetIn(path, segment + 1, value));
+  }
+
+  if (IsArray()) {
+    const size_t size = Size();
+    // A JSON Pointer "-" addresses the position after the last element
+    if (last && value != nullptr && step.type == JsonPathSegment::Type::kKey &&
+        step.key == "-") {
+      return PushBack(*value);
+    }
+    long long index = PathIndex(step, size);
+    if (index < 0) {
+      throw JsonPathException("No such element in path " +
+                              path.Expression());
+    }
+    const size_t position = static_cast<size_t>(index);
+    if (!last) {
+      return Set(position, (*this)[position].SetIn(path, segment + 1, value));
+    }
+    if (value != nullptr) {
+      return Set(position, *value);
+    }
+    return Erase(position);
+  }
+
+  throw JsonPathException("Path " + path.Expression() +
+                          " steps into a scalar");
+}
+
+bool JsonPersistentValue::operator==(const JsonPersistentValue& other) const {
+  if (value_.index() != other.value_.index()) {
+    return false;
+  }
+  switch (GetType()) {
+    case JsonValueType::kObject: {
+      const PersistentObject& a = ObjectData();
+      const PersistentObject& b = other.ObjectData();
+      return a.size == b.size && HamtEqual(a.root.get(), b.root.get(), 0);
+    }
+    case JsonValueType::kArray: {
+      const PersistentArray& a = ArrayData();
+      const PersistentArray& b = other.ArrayData();
+      if (a.size != b.size) {
+        return false;
+      }
+      if (a.shift == b.shift &&
+          a.tail->values.size() == b.tail->values.size()) {
+        return a.tail->values == b.tail->values &&
+               VectorEqual(a.root.get(), b.root.get(), a.shift);
+      }
+      std::vector<const VectorNode*> leaves_a;
+      std::vector<const VectorNode*> leaves_b;
+      CollectLeaves(*a.root, a.shift, leaves_a);
+      CollectLeaves(*b.root, b.shift, leaves_b);
+      leaves_a.push_back(a.tail.get());
+      leaves_b.push_back(b.tail.get());
+      return LeavesEqual(leaves_a, leaves_b);
+    }
+    case JsonValueType::kString:
+      return SharesStorageWith(other) || AsString() == other.AsString();
+    case JsonValueType::kNumber:
+      return AsNumber() == other.AsNumber();
+    case JsonValueType::kBoolean:
+      return AsBoolean() == other.AsBoolean();
+    case JsonValueType::kNull:
+      return true;
+  }
+  return false;
+}
+
+bool JsonPersistentValue::SharesStorageWith(
+    const JsonPersistentValue& other) const {
+  if (value_.index() != other.value_.index()) {
+    return false;
+  }
+  switch (GetType()) {
+    case JsonValueType::kObject:
+      return std::get<ObjectPtr>(value_) == std::get<ObjectPtr>(other.value_);
+    case JsonValueType::kArray:
+      return std::get<ArrayPtr>(value_) == std::get<ArrayPtr>(other.value_);
+    case JsonValueType::kString:
+      return std::get<std::shared_ptr<const std::string>>(value_) ==
+             std::get<std::shared_ptr<const std::string>>(other.value_);
+    default:
+      return false;
+  }
+}
+
+}  // namespace json_parser
@@ -0,0 +1,96 @@
+#include "json_parser/json_projection.h"
+#include "json_parser/json_exception.h"
+
+namespace json_parser {
+
+JsonProjection::~JsonProjection() = default;
+
+JsonProjection JsonProjection::FromPaths(
+    const std::vector<std::string>& paths) {
+  JsonProjection projection;
+  for (const std::string& path : paths) {
+    projection.Include(path);
+  }
+  return projection;
+}
+
+JsonProjection& JsonProjection::Include(const std::string& path) {
+  // Arrays are transparent, so "[*]" steps add nothing; dropping them keeps
+  // them from being read as "any member" wildcards
+  std::string normalized = path;
+  for (size_t pos = normalized.find("[*]"); pos != std::string::npos;
+       pos = normalized.find("[*]", pos)) {
+    normalized.erase(pos, 3);
+  }
+  if (!normalized.empty() && normalized[0] == '.') {
+    normalized.insert(0, "$");
+  }
+
+  JsonPath compiled = JsonPath::Compile(normalized);
+  for (const JsonPathSegment& segment : compiled.Segments()) {
+    if (segment.type == JsonPathSegment::Type::kIndex ||
+        segment.type == JsonPathSegment::Type::kSlice) {
+      throw JsonPathException("Projection paths may only contain keys and "
+                              "wildcards: '" + path + "'");
+    }
+  }
+  Insert(compiled.Segments(), 0);
+  return *this;
+}
+
+const JsonProjection* JsonProjection::Child(const std::string& key) const {
+  if (include_all_) {
+    return this;
+  }
+  auto it = children_.find(key);
+  if (it != children_.end()) {
+    return it->second.get();
+  }
+  return wildcard_.get();
+}
+
+void JsonProjection::Insert(const std::vector<JsonPathSegment>& segments,
+                            size_t index) {
+  if (include_all_) {
+    return;
+  }
+  if (index == segments.size()) {
+    include_all_ = true;
+    children_.clear();
+    wildcard_.reset();
+    return;
+  }
+
+  const JsonPathSegment& segment = segments[index];
+  if (segment.type == JsonPathSegment::Type::kWildcard) {
+    if (!wildcard_) {
+      wildcard_.reset(new JsonProjection());
+    }
+    wildcard_->Insert(segments, index + 1);
+    // Named children shadow the wildcard in Child(), so they need its paths
+    for (auto& child : children_) {
+      child.second->Insert(segments, index + 1);
+    }
+  } else {
+    std::unique_ptr<JsonProjection>& child = children_[segment.key];
+    if (!child) {
+      child = wildcard_ ? wildcard_->Clone()
+                        : std::unique_ptr<JsonProjection>(new JsonProjection());
+    }
+    child->Insert(segments, index + 1);
+  }
+}
+
+std::unique_ptr<JsonProjection> JsonProjection::Clone() const {
+  std::unique_ptr<JsonProjection> copy(new JsonProjection());
+  copy->include_all_ = include_all_;
+  for (const auto& child : children_) {
+    copy->children_[child.first] = child.second->Clone();
+  }
+  if (wildcard_) {
+    copy->wildcard_ = wildcard_->Clone();
+  }
+  return copy;
+}
+
+}  // namespace json_parser
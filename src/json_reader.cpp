@@ -0,0 +1,529 @@
+#include "json_parser/json_reader.h"
+#include "json_parser/json_exception.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "json_scan.h"
+
+namespace json_parser {
+
+using internal::AppendUtf8;
+using internal::HexDigitValue;
+using internal::IsDigit;
+using internal::ScanStringRun;
+
+namespace {
+
+const char* TypeName(JsonValueType type) {
+  switch (type) {
+    case JsonValueType::kObject:
+      return "object";
+    case JsonValueType::kArray:
+      return "array";
+    case JsonValueType::kString:
+      return "string";
+    case JsonValueType::kNumber:
+      return "number";
+    case JsonValueType::kBoolean:
+      return "boolean";
+    case JsonValueType::kNull:
+      return "null";
+  }
+  return "unknown";
+}
+
+}  // namespace
+
+JsonReader::JsonReader(const PaddedJsonBuffer& input,
+                       const JsonParserConfig& config)
+    : input_(input.Data()), length_(input.Size()), config_(config) {}
+
+JsonValueType JsonReader::PeekType() {
+  SkipWhitespace();
+  char c = input_[position_];
+  switch (c) {
+    case '{':
+      return JsonValueType::kObject;
+    case '[':
+      return JsonValueType::kArray;
+    case '"':
+      return JsonValueType::kString;
+    case 't':
+    case 'f':
+      return JsonValueType::kBoolean;
+    case 'n':
+      return JsonValueType::kNull;
+    default:
+      if (c == '-' || IsDigit(c)) {
+        return JsonValueType::kNumber;
+      }
+      if (c == '\0' && position_ >= length_) {
+        Fail("Unexpected end of input");
+      }
+      Fail("Unexpected character: " + std::string(1, c));
+  }
+}
+
+void JsonReader::BeginObject() {
+  ExpectType(JsonValueType::kObject);
+  ++position_;
+  PushContainer();
+}
+
+bool JsonReader::NextKey(std::string& key) {
+  if (first_.empty()) {
+    Fail("NextKey called outside of an object");
+  }
+  SkipWhitespace();
+  char c = input_[position_];
+  if (c == '}') {
+    ++position_;
+    first_.pop_back();
+    return false;
+  }
+  if (!first_.back()) {
+    if (c != ',') {
+      Fail("Expected ',' or '}' in object");
+    }
+    ++position_;
+    SkipWhitespace();
+  }
+  first_.back() = false;
+
+  if (input_[position_] != '"') {
+    Fail("Expected string key in object");
+  }
+  ReadString(key);
+  SkipWhitespace();
+  if (input_[position_] != ':') {
+    Fail("Expected ':' in object");
+  }
+  ++position_;
+  return true;
+}
+
+void JsonReader::BeginArray() {
+  ExpectType(JsonValueType::kArray);
+  ++position_;
+  PushContainer();
+}
+
+bool JsonReader::NextElement() {
+  if (first_.empty()) {
+    Fail("NextElement called outside of an array");
+  }
+  SkipWhitespace();
+  char c = input_[position_];
+  if (c == ']') {
+    ++position_;
+    first_.pop_back();
+    return false;
+  }
+  if (!first_.back()) {
+    if (c != ',') {
+      Fail("Expected ',' or ']' in array");
+    }
+    ++position_;
+  }
+  first_.back() = false;
+  return true;
+}
+
+std::string JsonReader::ReadString() {
+  std::string result;
+  ReadString(result);
+  return result;
+}
+
+void JsonReader::ReadString(std::string& out) {
+  ExpectType(JsonValueType::kString);
+  ++position_;
+  out.clear();
+
+  while (true) {
+    size_t run = ScanStringRun(input_ + position_);
+    out.append(input_ + position_, run);
+    position_ += run;
+
+    char c = input_[position_++];
+    if (c == '"') {
+      break;
+    } else if (c == '\\') {
+      char esc = input_[position_++];
+      switch (esc) {
+        case '"':
+        case '\\':
+        case '/':
+          out += esc;
+          break;
+        case 'b':
+          out += '\b';
+          break;
+        case 'f':
+          out += '\f';
+          break;
+        case 'n':
+          out += '\n';
+          break;
+        case 'r':
+          out += '\r';
+          break;
+        case 't':
+          out += '\t';
+          break;
+        case 'u': {
+          uint32_t code_point = ReadHex4();
+          if (code_point >= 0xD800 && code_point < 0xDC00 &&
+              input_[position_] == '\\' && input_[position_ + 1] == 'u') {
+            position_ += 2;
+            uint32_t low = ReadHex4();
+            if (low < 0xDC00 || low >= 0xE000) {
+              Fail("Invalid Unicode surrogate pair");
+            }
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                         (low - 0xDC00);
+          }
+          AppendUtf8(out, code_point);
+          break;
+        }
+        default:
+          --position_;
+          Fail("Invalid escape sequence");
+      }
+    } else if (c == '\0' && position_ > length_) {
+      --position_;
+      Fail("Unterminated string");
+    } else if ((c == '\n' || c == '\r') && config_.strict_mode) {
+      Fail("Unescaped newline in string");
+    } else {
+      out += c;
+    }
+
+    if (out.length() > config_.max_string_length) {
+      Fail("String length exceeds maximum allowed");
+    }
+  }
+}
+
+double JsonReader::ReadDouble() {
+  ExpectType(JsonValueType::kNumber);
+  bool is_integer = false;
+  return ParseDouble(ScanNumber(is_integer));
+}
+
+int64_t JsonReader::ReadInt64() {
+  ExpectType(JsonValueType::kNumber);
+  bool is_integer = false;
+  size_t end = ScanNumber(is_integer);
+
+  int64_t integer = 0;
+  if (is_integer) {
+    if (!ParseInteger(end, integer)) {
+      throw JsonTypeException("Integer out of range at position " +
+                              std::to_string(position_));
+    }
+    position_ = end;
+    return integer;
+  }
+
+  size_t start = position_;
+  double value = ParseDouble(end);
+  if (value < -9.2233720368547758e18 || value >= 9.2233720368547758e18 ||
+      value != std::trunc(value)) {
+    throw JsonTypeException("Expected integer at position " +
+                            std::to_string(start));
+  }
+  return static_cast<int64_t>(value);
+}
+
+bool JsonReader::ReadNumber(int64_t& integer, double& number) {
+  ExpectType(JsonValueType::kNumber);
+  bool is_integer = false;
+  size_t end = ScanNumber(is_integer);
+  if (is_integer && ParseInteger(end, integer)) {
+    position_ = end;
+    return true;
+  }
+  number = ParseDouble(end);
+  return false;
+}
+
+uint64_t JsonReader::ReadUInt64() {
+  ExpectType(JsonValueType::kNumber);
+  if (input_[position_] == '-') {
+    throw JsonTypeException("Expected unsigned integer at position " +
+                            std::to_string(position_));
+  }
+  bool is_integer = false;
+  size_t end = ScanNumber(is_integer);
+
+  if (is_integer) {
+    uint64_t value = 0;
+    for (size_t i = position_; i < end; ++i) {
+      uint64_t digit = static_cast<uint64_t>(input_[i] - '0');
+      if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+        throw JsonTypeException("Integer out of range at position " +
+                                std::to_string(position_));
+      }
+      value = value * 10 + digit;
+    }
+    position_ = end;
+    return value;
+  }
+
+  size_t start = position_;
+  double value = ParseDouble(end);
+  if (value >= 1.8446744073709552e19 || value != std::trunc(value)) {
+    throw JsonTypeException("Expected unsigned integer at position " +
+                            std::to_string(start));
+  }
+  return static_cast<uint64_t>(value);
+}
+
+bool JsonReader::ReadBool() {
+  ExpectType(JsonValueType::kBoolean);
+  if (std::memcmp(input_ + position_, "true", 4) == 0) {
+    position_ += 4;
+    return true;
+  }
+  if (std::memcmp(input_ + position_, "false", 5) == 0) {
+    position_ += 5;
+    return false;
+  }
+  Fail("Invalid boolean value");
+}
+
+void JsonReader::ReadNull() {
+  ExpectType(JsonValueType::kNull);
+  if (std::memcmp(input_ + position_, "null", 4) != 0) {
+    Fail("Invalid null value");
+  }
+  position_ += 4;
+}
+
+JsonValue JsonReader::ReadValue() {
+  SkipWhitespace();
+  size_t start = position_;
+  SkipValue();
+  JsonParser parser(config_);
+  return parser.ParseString(input_ + start, position_ - start);
+}
+
+void JsonReader::SkipValue() {
+  switch (PeekType()) {
+    case JsonValueType::kObject: {
+      ++position_;
+      PushContainer();
+      while (true) {
+        SkipWhitespace();
+        char c = input_[position_];
+        if (c == '}') {
+          ++position_;
+          break;
+        }
+        if (!first_.back()) {
+          if (c != ',') {
+            Fail("Expected ',' or '}' in object");
+          }
+          ++position_;
+          SkipWhitespace();
+        }
+        first_.back() = false;
+        if (input_[position_] != '"') {
+          Fail("Expected string key in object");
+        }
+        SkipString();
+        SkipWhitespace();
+        if (input_[position_] != ':') {
+          Fail("Expected ':' in object");
+        }
+        ++position_;
+        SkipValue();
+      }
+      first_.pop_back();
+      break;
+    }
+    case JsonValueType::kArray:
+      BeginArray();
+      while (NextElement()) {
+        SkipValue();
+      }
+      break;
+    case JsonValueType::kString:
+      SkipString();
+      break;
+    case JsonValueType::kNumber: {
+      bool is_integer = false;
+      position_ = ScanNumber(is_integer);
+      break;
+    }
+    case JsonValueType::kBoolean:
+      ReadBool();
+      break;
+    case JsonValueType::kNull:
+      ReadNull();
+      break;
+  }
+}
+
+void JsonReader::ExpectEnd() {
+  SkipWhitespace();
+  if (position_ < length_) {
+    Fail("Unexpected characters after JSON value");
+  }
+}
+
+void JsonReader::Fail(const std::string& message) const {
+  throw JsonParseException(message, position_);
+}
+
+void JsonReader::SkipWhitespace() {
+  // The padding byte after the end is '\0', which is not whitespace
+  while (std::isspace(static_cast<unsigned char>(input_[position_]))) {
+    ++position_;
+  }
+}
+
+void JsonReader::ExpectType(JsonValueType expected) {
+  JsonValueType actual = PeekType();
+  if (actual != expected) {
+    throw JsonTypeException(std::string("Expected ") + TypeName(expected) +
+                            ", got " + TypeName(actual) + " at position " +
+                            std::to_string(position_));
+  }
+}
+
+void JsonReader::PushContainer() {
+  if (first_.size() >= config_.max_depth) {
+    Fail("Maximum nesting depth exceeded");
+  }
+  first_.push_back(true);
+}
+
+void JsonReader::SkipString() {
+  ++position_;  // Opening quote
+  size_t length = 0;
+  while (true) {
+    size_t run = ScanStringRun(input_ + position_);
+    position_ += run;
+    length += run;
+
+    char c = input_[position_++];
+    if (c == '"') {
+      break;
+    } else if (c == '\\') {
+      char esc = input_[position_++];
+      if (esc == 'u') {
+        ReadHex4();
+      } else if (std::strchr("\"\\/bfnrt", esc) == nullptr || esc == '\0') {
+        --position_;
+        Fail("Invalid escape sequence");
+      }
+    } else if (c == '\0' && position_ > length_) {
+      --position_;
+      Fail("Unterminated string");
+    } else if ((c == '\n' || c == '\r') && config_.strict_mode) {
+      Fail("Unescaped newline in string");
+    }
+    ++length;
+  }
+  if (length > config_.max_string_length) {
+    Fail("String length exceeds maximum allowed");
+  }
+}
+
+size_t JsonReader::ScanNumber(bool& is_integer) const {
+  size_t i = position_;
+  if (input_[i] == '-') {
+    ++i;
+  }
+  if (input_[i] == '0') {
+    ++i;
+  } else if (IsDigit(input_[i])) {
+    while (IsDigit(input_[i])) {
+      ++i;
+    }
+  } else {
+    throw JsonParseException("Invalid number", i);
+  }
+
+  is_integer = true;
+  if (input_[i] == '.') {
+    is_integer = false;
+    ++i;
+    if (!IsDigit(input_[i])) {
+      throw JsonParseException("Invalid number", i);
+    }
+    while (IsDigit(input_[i])) {
+      ++i;
+    }
+  }
+  if (input_[i] == 'e' || input_[i] == 'E') {
+    is_integer = false;
+    ++i;
+    if (input_[i] == '+' || input_[i] == '-') {
+      ++i;
+    }
+    if (!IsDigit(input_[i])) {
+      throw JsonParseException("Invalid number", i);
+    }
+    while (IsDigit(input_[i])) {
+      ++i;
+    }
+  }
+  return i;
+}
+
+double JsonReader::ParseDouble(size_t end) {
+  // strtod needs a terminator right after the validated span; otherwise it
+  // could read on into text such as "0x1p3" that JSON does not allow
+  char local[64];
+  std::string heap;
+  size_t length = end - position_;
+  const char* text = local;
+  if (length < sizeof(local)) {
+    std::memcpy(local, input_ + position_, length);
+    local[length] = '\0';
+  } else {
+    heap.assign(input_ + position_, length);
+    text = heap.c_str();
+  }
+  position_ = end;
+  return std::strtod(text, nullptr);
+}
+
+bool JsonReader::ParseInteger(size_t end, int64_t& value) const {
+  bool negative = input_[position_] == '-';
+  uint64_t limit = negative
+      ? static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + 1
+      : static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+  uint64_t magnitude = 0;
+  for (size_t i = position_ + (negative ? 1 : 0); i < end; ++i) {
+    uint64_t digit = static_cast<uint64_t>(input_[i] - '0');
+    if (magnitude > (limit - digit) / 10) {
+      return false;
+    }
+    magnitude = magnitude * 10 + digit;
+  }
+  value = negative ? static_cast<int64_t>(0 - magnitude)
+                   : static_cast<int64_t>(magnitude);
+  return true;
+}
+
+uint32_t JsonReader::ReadHex4() {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    int digit = HexDigitValue(input_[position_]);
+    if (digit < 0) {
+      Fail("Invalid Unicode escape sequence");
+    }
+    value = (value << 4) | static_cast<uint32_t>(digit);
+    ++position_;
+  }
+  return value;
+}
+}  // namespace json_parser
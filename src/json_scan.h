@@ -0,0 +1,152 @@
+#ifndef JSON_PARSER_SRC_JSON_SCAN_H_
+#define JSON_PARSER_SRC_JSON_SCAN_H_
+
+// Internal scanning primitives shared by the parser, the path evaluator and
+// the reader. All of them assume input from a PaddedJsonBuffer: the 16-byte
+// loads may read up to 15 bytes past the end, which the zero padding makes
+// safe, and a '\0' byte always stops a scan.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace json_parser {
+namespace internal {
+
+inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Value of a hex digit, or -1
+inline int HexDigitValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Encodes a decoded \u escape as UTF-8
+inline void AppendUtf8(std::string& out, uint32_t code_point) {
+  if (code_point < 0x80) {
+    out += static_cast<char>(code_point);
+  } else if (code_point < 0x800) {
+    out += static_cast<char>(0xC0 | (code_point >> 6));
+    out += static_cast<char>(0x80 | (code_point & 0x3F));
+  } else if (code_point < 0x10000) {
+    out += static_cast<char>(0xE0 | (code_point >> 12));
+    out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (code_point & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (code_point >> 18));
+    out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (code_point & 0x3F));
+  }
+}
+
+// Bytes that end a plain run inside a string literal. '\0' is included so
+// the scan stops at the padding after the end of input.
+inline bool IsStringSpecial(char c) {
+  return c == '"' || c == '\\' || c == '\n' || c == '\r' || c == '\0';
+}
+
+// Returns the length of the run of bytes at p that can be copied verbatim
+// into a string value. The 16-byte loads may read past the end of input;
+// PaddedJsonBuffer guarantees those bytes are readable zeros, and a zero
+// byte always terminates the scan.
+inline size_t ScanStringRun(const char* p) {
+  const char* start = p;
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i carriage_return = _mm_set1_epi8('\r');
+  const __m128i zero = _mm_setzero_si128();
+  while (true) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                     _mm_cmpeq_epi8(chunk, backslash)),
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, newline),
+                                  _mm_cmpeq_epi8(chunk, carriage_return)),
+                     _mm_cmpeq_epi8(chunk, zero)));
+    int mask = _mm_movemask_epi8(special);
+    if (mask != 0) {
+      return static_cast<size_t>(p - start) + __builtin_ctz(mask);
+    }
+    p += 16;
+  }
+#else
+  while (!IsStringSpecial(*p)) {
+    ++p;
+  }
+  return static_cast<size_t>(p - start);
+#endif
+}
+
+// Returns the first '"', '\\' or '\0' at or after p. The 16-byte loads rely
+// on the zero padding of PaddedJsonBuffer; a '\0' always ends the scan.
+inline const char* FindQuoteOrBackslash(const char* p) {
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i zero = _mm_setzero_si128();
+  while (true) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    int mask = _mm_movemask_epi8(
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                  _mm_cmpeq_epi8(chunk, backslash)),
+                     _mm_cmpeq_epi8(chunk, zero)));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 16;
+  }
+#else
+  while (*p != '"' && *p != '\\' && *p != '\0') {
+    ++p;
+  }
+  return p;
+#endif
+}
+
+// Returns the first byte at or after p that can change bracket nesting:
+// '"', '{', '}', '[', ']' or '\0'
+inline const char* FindStructural(const char* p) {
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i open_curly = _mm_set1_epi8('{');
+  const __m128i close_curly = _mm_set1_epi8('}');
+  const __m128i open_square = _mm_set1_epi8('[');
+  const __m128i close_square = _mm_set1_epi8(']');
+  while (true) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i brackets = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, open_curly),
+                     _mm_cmpeq_epi8(chunk, close_curly)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, open_square),
+                     _mm_cmpeq_epi8(chunk, close_square)));
+    int mask = _mm_movemask_epi8(_mm_or_si128(
+        brackets, _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                               _mm_cmpeq_epi8(chunk, zero))));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 16;
+  }
+#else
+  while (*p != '"' && *p != '{' && *p != '}' && *p != '[' && *p != ']' &&
+         *p != '\0') {
+    ++p;
+  }
+  return p;
+#endif
+}
+
+}  // namespace internal
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_SRC_JSON_SCAN_H_
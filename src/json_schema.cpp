@@ -0,0 +1,1003 @@
+#include "json_parser/json_schema.h"
+#include "json_parser/json_array.h"
+#include "json_parser/json_exception.h"
+#include "json_parser/json_object.h"
+#include "json_parser/json_path.h"
+#include "json_parser/json_reader.h"
+
+#include <cmath>
+#include <cstdint>
+#include <regex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace json_parser {
+
+// Every schema becomes a node: a contiguous run of ops checked in order.
+// Operands index side tables (values, strings, regexes, node lists), so
+// validation is a loop over a flat array with no keyword lookups.
+struct JsonSchema::Program {
+  enum class OpCode : uint8_t {
+    kFalse,
+    kType,               // a: type mask
+    kConst,              // a: value
+    kEnum,               // values [a, a + b)
+    kMinimum,            // number: limit
+    kMaximum,
+    kExclusiveMinimum,
+    kExclusiveMaximum,
+    kMultipleOf,
+    kMinLength,          // number: limit, in code points
+    kMaxLength,
+    kPattern,            // a: regex
+    kMinItems,           // number: limit
+    kMaxItems,
+    kUniqueItems,
+    kItems,              // prefix node_lists [a, a + b), c: rest node
+    kContains,           // a: node, b: min, c: max
+    kMinProperties,      // number: limit
+    kMaxProperties,
+    kRequired,           // strings [a, a + b)
+    kProperties,         // a: object table
+    kPropertyNames,      // a: node
+    kDependentRequired,  // a: trigger string, strings [b, b + c)
+    kDependentSchema,    // a: trigger string, b: node
+    kAllOf,              // node_lists [a, a + b)
+    kAnyOf,
+    kOneOf,
+    kNot,                // a: node
+    kIfThenElse,         // a: if, b: then, c: else
+    kRef,                // a: ref slot
+  };
+
+  struct Op {
+    OpCode code;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t c = 0;
+    double number = 0;
+  };
+
+  struct Node {
+    uint32_t begin = 0;
+    uint32_t end = 0;
+  };
+
+  struct ObjectTable {
+    std::unordered_map<std::string, uint32_t> properties;
+    std::vector<std::pair<uint32_t, uint32_t>> patterns;  // regex, node
+    uint32_t additional;
+  };
+
+  static constexpr uint32_t kNoNode = UINT32_MAX;
+
+  // Node 0 is the root schema
+  std::vector<Node> nodes;
+  std::vector<Op> ops;
+  std::vector<uint32_t> node_lists;
+  std::vector<uint32_t> refs;
+  std::vector<JsonValue> values;
+  std::vector<std::string> strings;
+  std::vector<std::regex> patterns;
+  std::vector<ObjectTable> objects;
+};
+
+namespace {
+
+using Program = JsonSchema::Program;
+using OpCode = Program::OpCode;
+using Op = Program::Op;
+constexpr uint32_t kNoNode = Program::kNoNode;
+
+constexpr int kMaxValidationDepth = 1000;
+
+enum TypeBit : uint32_t {
+  kTypeObject = 1 << 0,
+  kTypeArray = 1 << 1,
+  kTypeString = 1 << 2,
+  kTypeNumber = 1 << 3,
+  kTypeInteger = 1 << 4,
+  kTypeBoolean = 1 << 5,
+  kTypeNull = 1 << 6,
+};
+
+uint32_t TypeBits(JsonValueType type) {
+  switch (type) {
+    case JsonValueType::kObject:
+      return kTypeObject;
+    case JsonValueType::kArray:
+      return kTypeArray;
+    case JsonValueType::kString:
+      return kTypeString;
+    case JsonValueType::kNumber:
+      return kTypeNumber;
+    case JsonValueType::kBoolean:
+      return kTypeBoolean;
+    case JsonValueType::kNull:
+      return kTypeNull;
+  }
+  return 0;
+}
+
+uint32_t TypeBits(const JsonValue& value) {
+  uint32_t bits = TypeBits(value.GetType());
+  if (value.IsNumber() && std::trunc(value.AsNumber()) == value.AsNumber()) {
+    bits |= kTypeInteger;
+  }
+  return bits;
+}
+
+size_t CodePointCount(const std::string& str) {
+  size_t count = 0;
+  for (char c : str) {
+    if ((static_cast<unsigned char>(c) & 0xC0) != 0x80) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+// Instance location and keyword of the first failed check. The path is
+// assembled while unwinding, so passing checks never build strings.
+struct Failure {
+  std::string path;
+  const char* keyword = "";
+};
+
+bool Reject(Failure* failure, const char* keyword) {
+  if (failure != nullptr) {
+    failure->keyword = keyword;
+  }
+  return false;
+}
+
+void AppendPointerToken(std::string& path, const std::string& token) {
+  path += '/';
+  for (char c : token) {
+    if (c == '~') {
+      path += "~0";
+    } else if (c == '/') {
+      path += "~1";
+    } else {
+      path += c;
+    }
+  }
+}
+
+void PrependToken(Failure* failure, const std::string& token) {
+  if (failure != nullptr) {
+    std::string prefix;
+    AppendPointerToken(prefix, token);
+    failure->path.insert(0, prefix);
+  }
+}
+
+std::string Describe(const std::string& path, const char* keyword) {
+  return "value at '" + path + "' fails '" + keyword + "'";
+}
+
+class SchemaCompiler {
+ public:
+  SchemaCompiler(const JsonValue& root, Program& program)
+      : root_(root), program_(program) {}
+
+  void CompileRoot() {
+    Compile(root_);
+    // Resolving may compile new subschemas, which can add more refs
+    for (size_t i = 0; i < pending_refs_.size(); ++i) {
+      const std::string& ref = pending_refs_[i].second;
+      const JsonValue* target = &root_;
+      if (ref.size() > 1) {
+        if (ref[1] != '/') {
+          throw JsonSchemaException("Only JSON Pointer $ref fragments are "
+                                    "supported: '" + ref + "'");
+        }
+        target = JsonPath::Compile(ref.substr(1)).Find(root_);
+        if (target == nullptr) {
+          throw JsonSchemaException("Unresolvable $ref: '" + ref + "'");
+        }
+      }
+      uint32_t node = Compile(*target);
+      program_.refs[pending_refs_[i].first] = node;
+    }
+  }
+
+ private:
+  const JsonValue& root_;
+  Program& program_;
+  std::unordered_map<const JsonValue*, uint32_t> compiled_;
+  std::vector<std::pair<uint32_t, std::string>> pending_refs_;
+
+  uint32_t Compile(const JsonValue& schema) {
+    auto found = compiled_.find(&schema);
+    if (found != compiled_.end()) {
+      return found->second;
+    }
+    uint32_t index = static_cast<uint32_t>(program_.nodes.size());
+    program_.nodes.emplace_back();
+    compiled_[&schema] = index;
+
+    std::vector<Op> ops;
+    if (schema.IsBoolean()) {
+      if (!schema.AsBoolean()) {
+        ops.push_back({OpCode::kFalse});
+      }
+    } else if (schema.IsObject()) {
+      CompileKeywords(schema.AsObject(), ops);
+    } else {
+      throw JsonSchemaException("Schema must be an object or a boolean");
+    }
+
+    // Subschemas were appended while compiling, so this node's ops go last
+    Program::Node& node = program_.nodes[index];
+    node.begin = static_cast<uint32_t>(program_.ops.size());
+    program_.ops.insert(program_.ops.end(), ops.begin(), ops.end());
+    node.end = static_cast<uint32_t>(program_.ops.size());
+    return index;
+  }
+
+  void CompileKeywords(const JsonObject& schema, std::vector<Op>& ops) {
+    for (const char* keyword : {"unevaluatedProperties", "unevaluatedItems",
+                                "$dynamicRef", "$recursiveRef"}) {
+      if (schema.Contains(keyword)) {
+        throw JsonSchemaException(std::string("Unsupported keyword: ") +
+                                  keyword);
+      }
+    }
+
+    // Cheap checks first so most invalid values fail fast
+    if (const JsonValue* type = schema.Find("type")) {
+      ops.push_back({OpCode::kType, CompileType(*type)});
+    }
+    if (const JsonValue* value = schema.Find("const")) {
+      Op op{OpCode::kConst, static_cast<uint32_t>(program_.values.size())};
+      program_.values.push_back(*value);
+      ops.push_back(op);
+    }
+    if (const JsonValue* values = schema.Find("enum")) {
+      const JsonArray& array = ExpectArray(*values, "enum");
+      Op op{OpCode::kEnum, static_cast<uint32_t>(program_.values.size()),
+            static_cast<uint32_t>(array.Size())};
+      for (size_t i = 0; i < array.Size(); ++i) {
+        program_.values.push_back(array[i]);
+      }
+      ops.push_back(op);
+    }
+
+    CompileNumber(schema, "minimum", OpCode::kMinimum, ops);
+    CompileNumber(schema, "maximum", OpCode::kMaximum, ops);
+    CompileNumber(schema, "exclusiveMinimum", OpCode::kExclusiveMinimum, ops);
+    CompileNumber(schema, "exclusiveMaximum", OpCode::kExclusiveMaximum, ops);
+    if (CompileNumber(schema, "multipleOf", OpCode::kMultipleOf, ops) &&
+        ops.back().number <= 0) {
+      throw JsonSchemaException("multipleOf must be greater than 0");
+    }
+
+    CompileCount(schema, "minLength", OpCode::kMinLength, ops);
+    CompileCount(schema, "maxLength", OpCode::kMaxLength, ops);
+    if (const JsonValue* pattern = schema.Find("pattern")) {
+      ops.push_back({OpCode::kPattern, CompileRegex(*pattern)});
+    }
+
+    CompileCount(schema, "minItems", OpCode::kMinItems, ops);
+    CompileCount(schema, "maxItems", OpCode::kMaxItems, ops);
+    if (const JsonValue* unique = schema.Find("uniqueItems")) {
+      if (!unique->IsBoolean()) {
+        throw JsonSchemaException("uniqueItems must be a boolean");
+      }
+      if (unique->AsBoolean()) {
+        ops.push_back({OpCode::kUniqueItems});
+      }
+    }
+
+    CompileCount(schema, "minProperties", OpCode::kMinProperties, ops);
+    CompileCount(schema, "maxProperties", OpCode::kMaxProperties, ops);
+    if (const JsonValue* required = schema.Find("required")) {
+      uint32_t count = 0;
+      uint32_t start = CompileStrings(*required, "required", count);
+      ops.push_back({OpCode::kRequired, start, count});
+    }
+    if (const JsonValue* dependent = schema.Find("dependentRequired")) {
+      const JsonObject& triggers = ExpectObject(*dependent, "dependentRequired");
+      for (auto it = triggers.Begin(); it != triggers.End(); ++it) {
+        uint32_t count = 0;
+        uint32_t start = CompileStrings(it->second, "dependentRequired", count);
+        ops.push_back({OpCode::kDependentRequired, AddString(it->first), start,
+                       count});
+      }
+    }
+
+    // Applicators
+    const JsonValue* prefix = schema.Find("prefixItems");
+    const JsonValue* items = schema.Find("items");
+    if (prefix != nullptr || items != nullptr) {
+      Op op{OpCode::kItems, 0, 0, kNoNode};
+      if (prefix != nullptr) {
+        op.a = CompileNodeList(*prefix, "prefixItems", op.b);
+      }
+      if (items != nullptr) {
+        if (items->IsArray()) {
+          throw JsonSchemaException("items must be a schema; use prefixItems "
+                                    "for tuples");
+        }
+        op.c = Compile(*items);
+      }
+      ops.push_back(op);
+    }
+    if (const JsonValue* contains = schema.Find("contains")) {
+      Op op{OpCode::kContains, Compile(*contains), 1, UINT32_MAX};
+      if (const JsonValue* min = schema.Find("minContains")) {
+        op.b = static_cast<uint32_t>(ExpectCount(*min, "minContains"));
+      }
+      if (const JsonValue* max = schema.Find("maxContains")) {
+        op.c = static_cast<uint32_t>(ExpectCount(*max, "maxContains"));
+      }
+      ops.push_back(op);
+    }
+
+    const JsonValue* properties = schema.Find("properties");
+    const JsonValue* patterns = schema.Find("patternProperties");
+    const JsonValue* additional = schema.Find("additionalProperties");
+    if (properties != nullptr || patterns != nullptr || additional != nullptr) {
+      Program::ObjectTable table;
+      table.additional = kNoNode;
+      if (properties != nullptr) {
+        const JsonObject& members = ExpectObject(*properties, "properties");
+        for (auto it = members.Begin(); it != members.End(); ++it) {
+          table.properties[it->first] = Compile(it->second);
+        }
+      }
+      if (patterns != nullptr) {
+        const JsonObject& members =
+            ExpectObject(*patterns, "patternProperties");
+        for (auto it = members.Begin(); it != members.End(); ++it) {
+          uint32_t regex = CompileRegex(JsonValue(it->first));
+          table.patterns.emplace_back(regex, Compile(it->second));
+        }
+      }
+      if (additional != nullptr) {
+        table.additional = Compile(*additional);
+      }
+      ops.push_back({OpCode::kProperties,
+                     static_cast<uint32_t>(program_.objects.size())});
+      program_.objects.push_back(std::move(table));
+    }
+    if (const JsonValue* names = schema.Find("propertyNames")) {
+      ops.push_back({OpCode::kPropertyNames, Compile(*names)});
+    }
+    if (const JsonValue* dependent = schema.Find("dependentSchemas")) {
+      const JsonObject& triggers = ExpectObject(*dependent, "dependentSchemas");
+      for (auto it = triggers.Begin(); it != triggers.End(); ++it) {
+        ops.push_back({OpCode::kDependentSchema, AddString(it->first),
+                       Compile(it->second)});
+      }
+    }
+
+    CompileNodeListOp(schema, "allOf", OpCode::kAllOf, ops);
+    CompileNodeListOp(schema, "anyOf", OpCode::kAnyOf, ops);
+    CompileNodeListOp(schema, "oneOf", OpCode::kOneOf, ops);
+    if (const JsonValue* negated = schema.Find("not")) {
+      ops.push_back({OpCode::kNot, Compile(*negated)});
+    }
+    if (const JsonValue* condition = schema.Find("if")) {
+      Op op{OpCode::kIfThenElse, Compile(*condition), kNoNode, kNoNode};
+      if (const JsonValue* then_schema = schema.Find("then")) {
+        op.b = Compile(*then_schema);
+      }
+      if (const JsonValue* else_schema = schema.Find("else")) {
+        op.c = Compile(*else_schema);
+      }
+      ops.push_back(op);
+    }
+    if (const JsonValue* ref = schema.Find("$ref")) {
+      if (!ref->IsString() || ref->AsString().empty() ||
+          ref->AsString()[0] != '#') {
+        throw JsonSchemaException("Only local $ref values starting with '#' "
+                                  "are supported");
+      }
+      uint32_t slot = static_cast<uint32_t>(program_.refs.size());
+      program_.refs.push_back(kNoNode);
+      pending_refs_.emplace_back(slot, ref->AsString());
+      ops.push_back({OpCode::kRef, slot});
+    }
+  }
+
+  uint32_t CompileType(const JsonValue& type) {
+    if (type.IsString()) {
+      return TypeName(type.AsString());
+    }
+    uint32_t mask = 0;
+    const JsonArray& names = ExpectArray(type, "type");
+    for (size_t i = 0; i < names.Size(); ++i) {
+      if (!names[i].IsString()) {
+        throw JsonSchemaException("type entries must be strings");
+      }
+      mask |= TypeName(names[i].AsString());
+    }
+    return mask;
+  }
+
+  static uint32_t TypeName(const std::string& name) {
+    if (name == "object") return kTypeObject;
+    if (name == "array") return kTypeArray;
+    if (name == "string") return kTypeString;
+    if (name == "number") return kTypeNumber | kTypeInteger;
+    if (name == "integer") return kTypeInteger;
+    if (name == "boolean") return kTypeBoolean;
+    if (name == "null") return kTypeNull;
+    throw JsonSchemaException("Unknown type: '" + name + "'");
+  }
+
+  bool CompileNumber(const JsonObject& schema, const char* keyword,
+                     OpCode code, std::vector<Op>& ops) {
+    const JsonValue* value = schema.Find(keyword);
+    if (value == nullptr) {
+      return false;
+    }
+    if (!value->IsNumber()) {
+      throw JsonSchemaException(std::string(keyword) + " must be a number");
+    }
+    Op op{code};
+    op.number = value->AsNumber();
+    ops.push_back(op);
+    return true;
+  }
+
+  void CompileCount(const JsonObject& schema, const char* keyword,
+                    OpCode code, std::vector<Op>& ops) {
+    if (const JsonValue* value = schema.Find(keyword)) {
+      Op op{code};
+      op.number = ExpectCount(*value, keyword);
+      ops.push_back(op);
+    }
+  }
+
+  static double ExpectCount(const JsonValue& value, const char* keyword) {
+    if (!value.IsNumber() || value.AsNumber() < 0 ||
+        std::trunc(value.AsNumber()) != value.AsNumber()) {
+      throw JsonSchemaException(std::string(keyword) +
+                                " must be a non-negative integer");
+    }
+    return value.AsNumber();
+  }
+
+  static const JsonArray& ExpectArray(const JsonValue& value,
+                                      const char* keyword) {
+    if (!value.IsArray()) {
+      throw JsonSchemaException(std::string(keyword) + " must be an array");
+    }
+    return value.AsArray();
+  }
+
+  static const JsonObject& ExpectObject(const JsonValue& value,
+                                        const char* keyword) {
+    if (!value.IsObject()) {
+      throw JsonSchemaException(std::string(keyword) + " must be an object");
+    }
+    return value.AsObject();
+  }
+
+  uint32_t CompileRegex(const JsonValue& pattern) {
+    if (!pattern.IsString()) {
+      throw JsonSchemaException("pattern must be a string");
+    }
+    try {
+      program_.patterns.emplace_back(pattern.AsString(),
+                                     std::regex::ECMAScript);
+    } catch (const std::regex_error&) {
+      throw JsonSchemaException("Invalid pattern: '" + pattern.AsString() +
+                                "'");
+    }
+    return static_cast<uint32_t>(program_.patterns.size() - 1);
+  }
+
+  uint32_t AddString(const std::string& str) {
+    program_.strings.push_back(str);
+    return static_cast<uint32_t>(program_.strings.size() - 1);
+  }
+
+  uint32_t CompileStrings(const JsonValue& value, const char* keyword,
+                          uint32_t& count) {
+    const JsonArray& array = ExpectArray(value, keyword);
+    uint32_t start = static_cast<uint32_t>(program_.strings.size());
+    for (size_t i = 0; i < array.Size(); ++i) {
+      if (!array[i].IsString()) {
+        throw JsonSchemaException(std::string(keyword) +
+                                  " entries must be strings");
+      }
+      program_.strings.push_back(array[i].AsString());
+    }
+    count = static_cast<uint32_t>(array.Size());
+    return start;
+  }
+
+  uint32_t CompileNodeList(const JsonValue& value, const char* keyword,
+                           uint32_t& count) {
+    const JsonArray& array = ExpectArray(value, keyword);
+    if (array.Empty()) {
+      throw JsonSchemaException(std::string(keyword) + " must not be empty");
+    }
+    // Compile first: subschemas may append their own lists
+    std::vector<uint32_t> nodes;
+    for (size_t i = 0; i < array.Size(); ++i) {
+      nodes.push_back(Compile(array[i]));
+    }
+    uint32_t start = static_cast<uint32_t>(program_.node_lists.size());
+    program_.node_lists.insert(program_.node_lists.end(), nodes.begin(),
+                               nodes.end());
+    count = static_cast<uint32_t>(nodes.size());
+    return start;
+  }
+
+  void CompileNodeListOp(const JsonObject& schema, const char* keyword,
+                         OpCode code, std::vector<Op>& ops) {
+    if (const JsonValue* list = schema.Find(keyword)) {
+      Op op{code};
+      op.a = CompileNodeList(*list, keyword, op.b);
+      ops.push_back(op);
+    }
+  }
+};
+
+class Validator {
+ public:
+  explicit Validator(const Program& program) : program_(program) {}
+
+  // With shallow set, the node's properties/items applicators are skipped
+  // because the inline parser already validated each child.
+  bool Check(uint32_t node, const JsonValue& value, bool shallow,
+             Failure* failure, int depth) const {
+    if (depth > kMaxValidationDepth) {
+      throw JsonSchemaException("Schema recursion exceeds maximum depth");
+    }
+    const Program::Node& range = program_.nodes[node];
+    for (uint32_t i = range.begin; i < range.end; ++i) {
+      if (!CheckOp(program_.ops[i], value, shallow, failure, depth)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool CheckPatterns(const Program::ObjectTable& table, const std::string& key,
+                     const JsonValue& value, Failure* failure,
+                     int depth) const {
+    for (const auto& pattern : table.patterns) {
+      if (std::regex_search(key, program_.patterns[pattern.first]) &&
+          !Check(pattern.second, value, false, failure, depth + 1)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  const Program& program_;
+
+  bool CheckOp(const Op& op, const JsonValue& value, bool shallow,
+               Failure* failure, int depth) const {
+    switch (op.code) {
+      case OpCode::kFalse:
+        return Reject(failure, "false");
+      case OpCode::kType:
+        return (TypeBits(value) & op.a) != 0 || Reject(failure, "type");
+      case OpCode::kConst:
+        return value == program_.values[op.a] || Reject(failure, "const");
+      case OpCode::kEnum:
+        for (uint32_t i = 0; i < op.b; ++i) {
+          if (value == program_.values[op.a + i]) {
+            return true;
+          }
+        }
+        return Reject(failure, "enum");
+      case OpCode::kMinimum:
+        return !value.IsNumber() || value.AsNumber() >= op.number ||
+               Reject(failure, "minimum");
+      case OpCode::kMaximum:
+        return !value.IsNumber() || value.AsNumber() <= op.number ||
+               Reject(failure, "maximum");
+      case OpCode::kExclusiveMinimum:
+        return !value.IsNumber() || value.AsNumber() > op.number ||
+               Reject(failure, "exclusiveMinimum");
+      case OpCode::kExclusiveMaximum:
+        return !value.IsNumber() || value.AsNumber() < op.number ||
+               Reject(failure, "exclusiveMaximum");
+      case OpCode::kMultipleOf: {
+        if (!value.IsNumber()) {
+          return true;
+        }
+        double quotient = value.AsNumber() / op.number;
+        double error = std::fabs(quotient - std::round(quotient));
+        return error <= 1e-9 * std::fmax(1.0, std::fabs(quotient)) ||
+               Reject(failure, "multipleOf");
+      }
+      case OpCode::kMinLength:
+        return !value.IsString() ||
+               CodePointCount(value.AsString()) >= op.number ||
+               Reject(failure, "minLength");
+      case OpCode::kMaxLength:
+        return !value.IsString() ||
+               CodePointCount(value.AsString()) <= op.number ||
+               Reject(failure, "maxLength");
+      case OpCode::kPattern:
+        return !value.IsString() ||
+               std::regex_search(value.AsString(), program_.patterns[op.a]) ||
+               Reject(failure, "pattern");
+      case OpCode::kMinItems:
+        return !value.IsArray() || value.AsArray().Size() >= op.number ||
+               Reject(failure, "minItems");
+      case OpCode::kMaxItems:
+        return !value.IsArray() || value.AsArray().Size() <= op.number ||
+               Reject(failure, "maxItems");
+      case OpCode::kUniqueItems:
+        return !value.IsArray() || Unique(value.AsArray()) ||
+               Reject(failure, "uniqueItems");
+      case OpCode::kItems:
+        return !value.IsArray() || shallow ||
+               CheckItems(op, value.AsArray(), failure, depth);
+      case OpCode::kContains:
+        return !value.IsArray() || CheckContains(op, value.AsArray(), depth) ||
+               Reject(failure, "contains");
+      case OpCode::kMinProperties:
+        return !value.IsObject() || value.AsObject().Size() >= op.number ||
+               Reject(failure, "minProperties");
+      case OpCode::kMaxProperties:
+        return !value.IsObject() || value.AsObject().Size() <= op.number ||
+               Reject(failure, "maxProperties");
+      case OpCode::kRequired:
+        return !value.IsObject() ||
+               HasAll(value.AsObject(), op.a, op.b) ||
+               Reject(failure, "required");
+      case OpCode::kProperties:
+        return !value.IsObject() || shallow ||
+               CheckProperties(program_.objects[op.a], value.AsObject(),
+                               failure, depth);
+      case OpCode::kPropertyNames:
+        return !value.IsObject() ||
+               CheckPropertyNames(op.a, value.AsObject(), failure, depth);
+      case OpCode::kDependentRequired:
+        return !value.IsObject() ||
+               !value.AsObject().Contains(program_.strings[op.a]) ||
+               HasAll(value.AsObject(), op.b, op.c) ||
+               Reject(failure, "dependentRequired");
+      case OpCode::kDependentSchema:
+        return !value.IsObject() ||
+               !value.AsObject().Contains(program_.strings[op.a]) ||
+               Check(op.b, value, false, failure, depth + 1);
+      case OpCode::kAllOf:
+        for (uint32_t i = 0; i < op.b; ++i) {
+          if (!Check(program_.node_lists[op.a + i], value, false, failure,
+                     depth + 1)) {
+            return false;
+          }
+        }
+        return true;
+      case OpCode::kAnyOf:
+        for (uint32_t i = 0; i < op.b; ++i) {
+          if (Check(program_.node_lists[op.a + i], value, false, nullptr,
+                    depth + 1)) {
+            return true;
+          }
+        }
+        return Reject(failure, "anyOf");
+      case OpCode::kOneOf: {
+        uint32_t matches = 0;
+        for (uint32_t i = 0; i < op.b && matches < 2; ++i) {
+          if (Check(program_.node_lists[op.a + i], value, false, nullptr,
+                    depth + 1)) {
+            ++matches;
+          }
+        }
+        return matches == 1 || Reject(failure, "oneOf");
+      }
+      case OpCode::kNot:
+        return !Check(op.a, value, false, nullptr, depth + 1) ||
+               Reject(failure, "not");
+      case OpCode::kIfThenElse: {
+        uint32_t branch =
+            Check(op.a, value, false, nullptr, depth + 1) ? op.b : op.c;
+        return branch == kNoNode ||
+               Check(branch, value, false, failure, depth + 1);
+      }
+      case OpCode::kRef:
+        return Check(program_.refs[op.a], value, false, failure, depth + 1);
+    }
+    return true;
+  }
+
+  static bool Unique(const JsonArray& array) {
+    for (size_t i = 1; i < array.Size(); ++i) {
+      for (size_t j = 0; j < i; ++j) {
+        if (array[i] == array[j]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  bool HasAll(const JsonObject& obj, uint32_t start, uint32_t count) const {
+    for (uint32_t i = 0; i < count; ++i) {
+      if (!obj.Contains(program_.strings[start + i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool CheckItems(const Op& op, const JsonArray& array, Failure* failure,
+                  int depth) const {
+    for (size_t i = 0; i < array.Size(); ++i) {
+      uint32_t node = i < op.b ? program_.node_lists[op.a + i] : op.c;
+      if (node == kNoNode) {
+        break;
+      }
+      if (!Check(node, array[i], false, failure, depth + 1)) {
+        PrependToken(failure, std::to_string(i));
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool CheckContains(const Op& op, const JsonArray& array, int depth) const {
+    uint32_t matches = 0;
+    for (size_t i = 0; i < array.Size(); ++i) {
+      if (Check(op.a, array[i], false, nullptr, depth + 1)) {
+        ++matches;
+      }
+    }
+    return matches >= op.b && matches <= op.c;
+  }
+
+  bool CheckProperties(const Program::ObjectTable& table, const JsonObject& obj,
+                       Failure* failure, int depth) const {
+    for (auto it = obj.Begin(); it != obj.End(); ++it) {
+      auto property = table.properties.find(it->first);
+      bool matched = property != table.properties.end();
+      if (matched &&
+          !Check(property->second, it->second, false, failure, depth + 1)) {
+        PrependToken(failure, it->first);
+        return false;
+      }
+      for (const auto& pattern : table.patterns) {
+        if (std::regex_search(it->first, program_.patterns[pattern.first])) {
+          matched = true;
+          if (!Check(pattern.second, it->second, false, failure, depth + 1)) {
+            PrependToken(failure, it->first);
+            return false;
+          }
+        }
+      }
+      if (!matched && table.additional != kNoNode &&
+          !Check(table.additional, it->second, false, failure, depth + 1)) {
+        PrependToken(failure, it->first);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool CheckPropertyNames(uint32_t node, const JsonObject& obj,
+                          Failure* failure, int depth) const {
+    for (auto it = obj.Begin(); it != obj.End(); ++it) {
+      if (!Check(node, JsonValue(it->first), false, failure, depth + 1)) {
+        if (failure != nullptr) {
+          failure->keyword = "propertyNames";
+        }
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+// Builds the document from a JsonReader, validating each value as soon as
+// it is complete. Children reached through properties, additionalProperties,
+// prefixItems or items are validated as they are read; everything else in a
+// container's schema runs once the container is built.
+class InlineValidator {
+ public:
+  InlineValidator(const Program& program, JsonReader& reader)
+      : program_(program), validator_(program), reader_(reader) {}
+
+  JsonValue Read(uint32_t node) {
+    if (node == kNoNode) {
+      return reader_.ReadValue();
+    }
+    node = FollowRefs(node);
+
+    JsonValueType type = reader_.PeekType();
+    const Program::Node& range = program_.nodes[node];
+    if (range.begin < range.end) {
+      const Op& first = program_.ops[range.begin];
+      // Reject a wrong container or scalar type before reading it. Whether a
+      // number is an integer is only known once it is read.
+      uint32_t bits = TypeBits(type);
+      if (bits == kTypeNumber) {
+        bits |= kTypeInteger;
+      }
+      if (first.code == OpCode::kFalse ||
+          (first.code == OpCode::kType && (bits & first.a) == 0)) {
+        Throw(first.code == OpCode::kFalse ? "false" : "type");
+      }
+    }
+
+    JsonValue value;
+    bool container = false;
+    switch (type) {
+      case JsonValueType::kObject:
+        value = ReadObject(node);
+        container = true;
+        break;
+      case JsonValueType::kArray:
+        value = ReadArray(node);
+        container = true;
+        break;
+      case JsonValueType::kString:
+        value = JsonValue(reader_.ReadString());
+        break;
+      case JsonValueType::kNumber:
+        value = JsonValue(reader_.ReadDouble());
+        break;
+      case JsonValueType::kBoolean:
+        value = JsonValue(reader_.ReadBool());
+        break;
+      case JsonValueType::kNull:
+        reader_.ReadNull();
+        break;
+    }
+
+    Failure failure;
+    if (!validator_.Check(node, value, container, &failure, 0)) {
+      Throw(failure);
+    }
+    return value;
+  }
+
+ private:
+  const Program& program_;
+  Validator validator_;
+  JsonReader& reader_;
+  std::vector<std::string> path_;
+
+  // A schema that is only {"$ref": ...} validates like its target, which
+  // lets the inline walk descend into referenced definitions
+  uint32_t FollowRefs(uint32_t node) const {
+    for (int hops = 0; hops < kMaxValidationDepth; ++hops) {
+      const Program::Node& range = program_.nodes[node];
+      if (range.end - range.begin != 1 ||
+          program_.ops[range.begin].code != OpCode::kRef) {
+        return node;
+      }
+      node = program_.refs[program_.ops[range.begin].a];
+    }
+    throw JsonSchemaException("Schema recursion exceeds maximum depth");
+  }
+
+  const Op* FindOp(uint32_t node, OpCode code) const {
+    const Program::Node& range = program_.nodes[node];
+    for (uint32_t i = range.begin; i < range.end; ++i) {
+      if (program_.ops[i].code == code) {
+        return &program_.ops[i];
+      }
+    }
+    return nullptr;
+  }
+
+  JsonValue ReadObject(uint32_t node) {
+    const Op* op = FindOp(node, OpCode::kProperties);
+    const Program::ObjectTable* table =
+        op != nullptr ? &program_.objects[op->a] : nullptr;
+
+    JsonValue result{JsonObject()};
+    JsonObject& obj = result.AsObject();
+    std::string key;
+    reader_.BeginObject();
+    while (reader_.NextKey(key)) {
+      uint32_t child = kNoNode;
+      bool pattern_matched = false;
+      if (table != nullptr) {
+        auto property = table->properties.find(key);
+        if (property != table->properties.end()) {
+          child = property->second;
+        } else {
+          for (const auto& pattern : table->patterns) {
+            if (std::regex_search(key, program_.patterns[pattern.first])) {
+              pattern_matched = true;
+              break;
+            }
+          }
+          if (!pattern_matched) {
+            child = table->additional;
+          }
+        }
+      }
+
+      path_.push_back(key);
+      JsonValue member = Read(child);
+      Failure failure;
+      if (table != nullptr && !table->patterns.empty() &&
+          !validator_.CheckPatterns(*table, key, member, &failure, 0)) {
+        Throw(failure);
+      }
+      path_.pop_back();
+      obj.Insert(key, std::move(member));
+    }
+    return result;
+  }
+
+  JsonValue ReadArray(uint32_t node) {
+    const Op* op = FindOp(node, OpCode::kItems);
+
+    JsonValue result{JsonArray()};
+    JsonArray& arr = result.AsArray();
+    reader_.BeginArray();
+    for (uint32_t i = 0; reader_.NextElement(); ++i) {
+      uint32_t child = kNoNode;
+      if (op != nullptr) {
+        child = i < op->b ? program_.node_lists[op->a + i] : op->c;
+      }
+      path_.push_back(std::to_string(i));
+      arr.PushBack(Read(child));
+      path_.pop_back();
+    }
+    return result;
+  }
+
+  [[noreturn]] void Throw(const char* keyword) const {
+    Failure failure;
+    failure.keyword = keyword;
+    Throw(failure);
+  }
+
+  [[noreturn]] void Throw(const Failure& failure) const {
+    std::string path;
+    for (const std::string& token : path_) {
+      AppendPointerToken(path, token);
+    }
+    throw JsonSchemaException(Describe(path + failure.path, failure.keyword));
+  }
+};
+
+}  // namespace
+
+JsonSchema::JsonSchema(std::shared_ptr<const Program> program)
+    : program_(std::move(program)) {}
+
+JsonSchema JsonSchema::Compile(const JsonValue& schema) {
+  auto program = std::make_shared<Program>();
+  SchemaCompiler(schema, *program).CompileRoot();
+  return JsonSchema(std::move(program));
+}
+
+JsonSchema JsonSchema::Compile(const std::string& schema_json) {
+  return Compile(JsonParser::Parse(schema_json));
+}
+
+bool JsonSchema::Validate(const JsonValue& value, std::string* error) const {
+  Failure failure;
+  if (Validator(*program_).Check(0, value, false, &failure, 0)) {
+    return true;
+  }
+  if (error != nullptr) {
+    *error = Describe(failure.path, failure.keyword);
+  }
+  return false;
+}
+
+JsonValue JsonSchema::ParseValidated(const PaddedJsonBuffer& json,
+                                     const JsonParserConfig& config) const {
+  JsonReader reader(json, config);
+  JsonValue value = InlineValidator(*program_, reader).Read(0);
+  reader.ExpectEnd();
+  return value;
+}
+
+JsonValue JsonSchema::ParseValidated(const std::string& json,
+                                     const JsonParserConfig& config) const {
+  return ParseValidated(PaddedJsonBuffer(json), config);
+}
+
+}  // namespace json_parser
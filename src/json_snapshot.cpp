@@ -0,0 +1,481 @@
+#include "json_parser/json_snapshot.h"
+#include "json_parser/json_array.h"
+#include "json_parser/json_exception.h"
+#include "json_parser/json_object.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define JSON_PARSER_HAVE_MMAP 1
+#endif
+
+namespace json_parser {
+
+namespace {
+
+constexpr char kMagic[4] = {'J', 'S', 'N', 'P'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 32;
+constexpr size_t kMaxDepth = 1000;
+
+enum Tag : uint64_t {
+  kTagNull = 0,
+  kTagFalse = 1,
+  kTagTrue = 2,
+  kTagNumber = 3,
+  kTagString = 4,
+  kTagArray = 5,
+  kTagObject = 6,
+};
+
+uint64_t LittleEndian(uint64_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return __builtin_bswap64(value);
+#else
+  return value;
+#endif
+}
+
+uint32_t LittleEndian(uint32_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return __builtin_bswap32(value);
+#else
+  return value;
+#endif
+}
+
+[[noreturn]] void Corrupt(uint64_t offset) {
+  throw JsonParseException("Corrupt snapshot", static_cast<size_t>(offset));
+}
+
+// Children are written before their parents, so every record is appended
+// exactly once and only the header needs patching at the end
+class SnapshotEncoder {
+ public:
+  std::string Encode(const JsonValue& root) {
+    out_.assign(kHeaderSize, '\0');
+    uint64_t root_ref = EncodeValue(root, 0);
+    std::memcpy(&out_[0], kMagic, sizeof(kMagic));
+    uint32_t version = LittleEndian(kVersion);
+    std::memcpy(&out_[4], &version, sizeof(version));
+    Store(8, out_.size());
+    Store(16, root_ref);
+    return std::move(out_);
+  }
+
+ private:
+  std::string out_;
+  std::unordered_map<std::string, uint64_t> keys_;
+
+  void Store(size_t offset, uint64_t value) {
+    value = LittleEndian(value);
+    std::memcpy(&out_[offset], &value, sizeof(value));
+  }
+
+  // Start an 8-byte aligned record of length bytes; returns its offset
+  uint64_t Reserve(size_t length) {
+    size_t offset = (out_.size() + 7) & ~size_t{7};
+    out_.resize(offset + length);
+    return offset;
+  }
+
+  uint64_t EncodeString(const std::string& str) {
+    uint64_t offset = Reserve(8 + str.size() + 1);
+    Store(offset, str.size());
+    std::memcpy(&out_[offset + 8], str.data(), str.size());
+    return offset;
+  }
+
+  uint64_t EncodeKey(const std::string& key) {
+    auto found = keys_.find(key);
+    if (found != keys_.end()) {
+      return found->second;
+    }
+    uint64_t offset = EncodeString(key);
+    keys_.emplace(key, offset);
+    return offset;
+  }
+
+  uint64_t EncodeValue(const JsonValue& value, size_t depth) {
+    if (depth > kMaxDepth) {
+      throw JsonException("Maximum depth exceeded during snapshot encoding");
+    }
+    switch (value.GetType()) {
+      case JsonValueType::kNull:
+        return kTagNull;
+      case JsonValueType::kBoolean:
+        return value.AsBoolean() ? kTagTrue : kTagFalse;
+      case JsonValueType::kNumber: {
+        uint64_t bits;
+        double number = value.AsNumber();
+        std::memcpy(&bits, &number, sizeof(bits));
+        uint64_t offset = Reserve(8);
+        Store(offset, bits);
+        return offset << 3 | kTagNumber;
+      }
+      case JsonValueType::kString:
+        return EncodeString(value.AsString()) << 3 | kTagString;
+      case JsonValueType::kArray: {
+        const JsonArray& arr = value.AsArray();
+        std::vector<uint64_t> refs;
+        refs.reserve(arr.Size());
+        for (size_t i = 0; i < arr.Size(); ++i) {
+          refs.push_back(EncodeValue(arr[i], depth + 1));
+        }
+        uint64_t offset = Reserve(8 + 8 * refs.size());
+        Store(offset, refs.size());
+        for (size_t i = 0; i < refs.size(); ++i) {
+          Store(offset + 8 + 8 * i, refs[i]);
+        }
+        return offset << 3 | kTagArray;
+      }
+      case JsonValueType::kObject: {
+        const JsonObject& obj = value.AsObject();
+        std::vector<std::pair<const std::string*, const JsonValue*>> members;
+        members.reserve(obj.Size());
+        for (auto it = obj.Begin(); it != obj.End(); ++it) {
+          members.emplace_back(&it->first, &it->second);
+        }
+        std::sort(members.begin(), members.end(),
+                  [](const auto& a, const auto& b) { return *a.first < *b.first; });
+
+        std::vector<std::pair<uint64_t, uint64_t>> entries;
+        entries.reserve(members.size());
+        for (const auto& member : members) {
+          uint64_t key = EncodeKey(*member.first);
+          entries.emplace_back(key, EncodeValue(*member.second, depth + 1));
+        }
+        uint64_t offset = Reserve(8 + 16 * entries.size());
+        Store(offset, entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+          Store(offset + 8 + 16 * i, entries[i].first);
+          Store(offset + 16 + 16 * i, entries[i].second);
+        }
+        return offset << 3 | kTagObject;
+      }
+    }
+    return kTagNull;
+  }
+};
+
+}  // namespace
+
+JsonValueType JsonSnapshotView::GetType() const {
+  switch (Tag()) {
+    case kTagNull:
+      return JsonValueType::kNull;
+    case kTagFalse:
+    case kTagTrue:
+      return JsonValueType::kBoolean;
+    case kTagNumber:
+      return JsonValueType::kNumber;
+    case kTagString:
+      return JsonValueType::kString;
+    case kTagArray:
+      return JsonValueType::kArray;
+    case kTagObject:
+      return JsonValueType::kObject;
+    default:
+      Corrupt(Offset());
+  }
+}
+
+double JsonSnapshotView::AsNumber() const {
+  Expect(JsonValueType::kNumber);
+  uint64_t bits = Load(Offset());
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+bool JsonSnapshotView::AsBoolean() const {
+  Expect(JsonValueType::kBoolean);
+  return Tag() == kTagTrue;
+}
+
+std::string_view JsonSnapshotView::AsString() const {
+  Expect(JsonValueType::kString);
+  return StringAt(Offset());
+}
+
+size_t JsonSnapshotView::Size() const {
+  JsonValueType type = GetType();
+  if (type != JsonValueType::kArray && type != JsonValueType::kObject) {
+    throw JsonTypeException("Snapshot value is not a container");
+  }
+  uint64_t count;
+  Entries(count, type == JsonValueType::kArray ? 8 : 16);
+  return static_cast<size_t>(count);
+}
+
+JsonSnapshotView JsonSnapshotView::At(size_t index) const {
+  Expect(JsonValueType::kArray);
+  uint64_t count;
+  uint64_t entries = Entries(count, 8);
+  if (index >= count) {
+    throw JsonException("Array index out of range: " + std::to_string(index));
+  }
+  return JsonSnapshotView(base_, size_, Load(entries + 8 * index));
+}
+
+std::string_view JsonSnapshotView::KeyAt(size_t index) const {
+  Expect(JsonValueType::kObject);
+  uint64_t count;
+  uint64_t entries = Entries(count, 16);
+  if (index >= count) {
+    throw JsonException("Member index out of range: " + std::to_string(index));
+  }
+  return StringAt(Load(entries + 16 * index));
+}
+
+JsonSnapshotView JsonSnapshotView::ValueAt(size_t index) const {
+  Expect(JsonValueType::kObject);
+  uint64_t count;
+  uint64_t entries = Entries(count, 16);
+  if (index >= count) {
+    throw JsonException("Member index out of range: " + std::to_string(index));
+  }
+  return JsonSnapshotView(base_, size_, Load(entries + 16 * index + 8));
+}
+
+std::optional<JsonSnapshotView> JsonSnapshotView::Find(
+    std::string_view key) const {
+  Expect(JsonValueType::kObject);
+  uint64_t count;
+  uint64_t entries = Entries(count, 16);
+  uint64_t low = 0;
+  uint64_t high = count;
+  while (low < high) {
+    uint64_t mid = low + (high - low) / 2;
+    int cmp = StringAt(Load(entries + 16 * mid)).compare(key);
+    if (cmp == 0) {
+      return JsonSnapshotView(base_, size_, Load(entries + 16 * mid + 8));
+    }
+    if (cmp < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return std::nullopt;
+}
+
+JsonSnapshotView JsonSnapshotView::operator[](std::string_view key) const {
+  std::optional<JsonSnapshotView> value = Find(key);
+  if (!value) {
+    throw JsonKeyException(std::string(key));
+  }
+  return *value;
+}
+
+JsonValue JsonSnapshotView::ToJsonValue() const { return ToJsonValue(0); }
+
+JsonValue JsonSnapshotView::ToJsonValue(size_t depth) const {
+  // A corrupt snapshot could contain reference cycles
+  if (depth > kMaxDepth) {
+    Corrupt(Offset());
+  }
+  switch (GetType()) {
+    case JsonValueType::kNull:
+      return JsonValue(nullptr);
+    case JsonValueType::kBoolean:
+      return JsonValue(AsBoolean());
+    case JsonValueType::kNumber:
+      return JsonValue(AsNumber());
+    case JsonValueType::kString:
+      return JsonValue(std::string(AsString()));
+    case JsonValueType::kArray: {
+      JsonValue result{JsonArray()};
+      JsonArray& arr = result.AsArray();
+      size_t count = Size();
+      arr.Reserve(count);
+      for (size_t i = 0; i < count; ++i) {
+        arr.PushBack(At(i).ToJsonValue(depth + 1));
+      }
+      return result;
+    }
+    case JsonValueType::kObject: {
+      JsonValue result{JsonObject()};
+      JsonObject& obj = result.AsObject();
+      size_t count = Size();
+      for (size_t i = 0; i < count; ++i) {
+        obj.Insert(std::string(KeyAt(i)), ValueAt(i).ToJsonValue(depth + 1));
+      }
+      return result;
+    }
+  }
+  return JsonValue(nullptr);
+}
+
+void JsonSnapshotView::Expect(JsonValueType type) const {
+  if (GetType() != type) {
+    throw JsonTypeException("Snapshot value has a different type");
+  }
+}
+
+uint64_t JsonSnapshotView::Load(uint64_t offset) const {
+  if (offset < kHeaderSize || offset > size_ - 8) {
+    Corrupt(offset);
+  }
+  uint64_t value;
+  std::memcpy(&value, base_ + offset, sizeof(value));
+  return LittleEndian(value);
+}
+
+uint64_t JsonSnapshotView::Entries(uint64_t& count, size_t entry_size) const {
+  uint64_t offset = Offset();
+  count = Load(offset);
+  if (count > (size_ - offset - 8) / entry_size) {
+    Corrupt(offset);
+  }
+  return offset + 8;
+}
+
+std::string_view JsonSnapshotView::StringAt(uint64_t offset) const {
+  uint64_t length = Load(offset);
+  if (length > size_ - offset - 8) {
+    Corrupt(offset);
+  }
+  return std::string_view(base_ + offset + 8, static_cast<size_t>(length));
+}
+
+JsonSnapshot::JsonSnapshot(JsonSnapshot&& other) noexcept
+    : data_(other.data_),
+      size_(other.size_),
+      mapping_(other.mapping_),
+      storage_(std::move(other.storage_)) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+  other.mapping_ = nullptr;
+}
+
+JsonSnapshot& JsonSnapshot::operator=(JsonSnapshot&& other) noexcept {
+  if (this != &other) {
+    Release();
+    data_ = other.data_;
+    size_ = other.size_;
+    mapping_ = other.mapping_;
+    storage_ = std::move(other.storage_);
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.mapping_ = nullptr;
+  }
+  return *this;
+}
+
+JsonSnapshot::~JsonSnapshot() { Release(); }
+
+std::string JsonSnapshot::Encode(const JsonValue& value) {
+  return SnapshotEncoder().Encode(value);
+}
+
+void JsonSnapshot::WriteFile(const JsonValue& value,
+                             const std::string& filename) {
+  std::string data = Encode(value);
+  std::ofstream file(filename, std::ios::binary);
+  if (!file.is_open()) {
+    throw JsonFileException(filename);
+  }
+  file.write(data.data(), static_cast<std::streamsize>(data.size()));
+  if (!file) {
+    throw JsonFileException(filename);
+  }
+}
+
+JsonSnapshot JsonSnapshot::Open(const std::string& filename) {
+  JsonSnapshot snapshot;
+#ifdef JSON_PARSER_HAVE_MMAP
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw JsonFileException(filename);
+  }
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    throw JsonFileException(filename);
+  }
+  size_t size = static_cast<size_t>(info.st_size);
+  void* mapping = size > 0
+      ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+      : MAP_FAILED;
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    throw JsonFileException(filename);
+  }
+  snapshot.mapping_ = mapping;
+  snapshot.data_ = static_cast<const char*>(mapping);
+  snapshot.size_ = size;
+#else
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    throw JsonFileException(filename);
+  }
+  size_t size = static_cast<size_t>(file.tellg());
+  file.seekg(0);
+  snapshot.storage_.reset(new char[size]);
+  file.read(snapshot.storage_.get(), static_cast<std::streamsize>(size));
+  if (!file || static_cast<size_t>(file.gcount()) != size) {
+    throw JsonFileException(filename);
+  }
+  snapshot.data_ = snapshot.storage_.get();
+  snapshot.size_ = size;
+#endif
+  snapshot.ValidateHeader();
+  return snapshot;
+}
+
+JsonSnapshot JsonSnapshot::FromBuffer(const char* data, size_t size) {
+  JsonSnapshot snapshot;
+  snapshot.data_ = data;
+  snapshot.size_ = size;
+  snapshot.ValidateHeader();
+  return snapshot;
+}
+
+JsonSnapshotView JsonSnapshot::Root() const {
+  uint64_t root;
+  std::memcpy(&root, data_ + 16, sizeof(root));
+  return JsonSnapshotView(data_, size_, LittleEndian(root));
+}
+
+void JsonSnapshot::ValidateHeader() const {
+  if (size_ < kHeaderSize || std::memcmp(data_, kMagic, sizeof(kMagic)) != 0) {
+    throw JsonParseException("Not a JSON snapshot", 0);
+  }
+  uint32_t version;
+  std::memcpy(&version, data_ + 4, sizeof(version));
+  version = LittleEndian(version);
+  if (version != kVersion) {
+    throw JsonParseException("Unsupported snapshot version " +
+                                 std::to_string(version),
+                             4);
+  }
+  uint64_t size;
+  std::memcpy(&size, data_ + 8, sizeof(size));
+  if (LittleEndian(size) != size_) {
+    throw JsonParseException("Truncated snapshot", 8);
+  }
+}
+
+void JsonSnapshot::Release() {
+#ifdef JSON_PARSER_HAVE_MMAP
+  if (mapping_ != nullptr) {
+    ::munmap(mapping_, size_);
+  }
+#endif
+  mapping_ = nullptr;
+  storage_.reset();
+  data_ = nullptr;
+  size_ = 0;
+}
+
+}  // namespace json_parser
@@ -0,0 +1,244 @@
+#include "json_parser/json_stream_writer.h"
+#include "json_escape.h"
+#include "json_number_format.h"
+
+#include <algorithm>
+
+namespace json_parser {
+
+namespace {
+
+constexpr size_t kPrecomputedIndentLevels = 32;
+
+}  // namespace
+
+JsonStreamWriter::JsonStreamWriter(JsonOutputBuffer& out,
+                                   const JsonWriterConfig& config)
+    : out_(&out), writer_(config), config_(writer_.GetConfig()) {
+  InitIndent();
+}
+
+JsonStreamWriter::JsonStreamWriter(std::ostream& os,
+                                   const JsonWriterConfig& config,
+                                   size_t flush_threshold)
+    : owned_(new JsonOutputBuffer(os, flush_threshold)),
+      out_(owned_.get()),
+      writer_(config),
+      config_(writer_.GetConfig()) {
+  InitIndent();
+}
+
+JsonStreamWriter::JsonStreamWriter(int fd, const JsonWriterConfig& config,
+                                   size_t flush_threshold)
+    : owned_(new JsonOutputBuffer(fd, flush_threshold)),
+      out_(owned_.get()),
+      writer_(config),
+      config_(writer_.GetConfig()) {
+  InitIndent();
+}
+
+JsonStreamWriter::~JsonStreamWriter() = default;
+
+JsonStreamWriter& JsonStreamWriter::BeginObject() {
+  BeforeValue();
+  Push(true);
+  out_->Append('{');
+  return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::EndObject() {
+  Pop(true);
+  return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::BeginArray() {
+  BeforeValue();
+  Push(false);
+  out_->Append('[');
+  return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::EndArray() {
+  Pop(false);
+  return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::Key(std::string_view key) {
+  if (!InObject()) {
+    throw JsonException("Key called outside of object context");
+  }
+  if (after_key_) {
+    throw JsonException("Key called where a value was expected");
+  }
+  if (!first_) {
+    out_->Append(',');
+  }
+  first_ = false;
+  if (config_.pretty_print) {
+    WriteNewline(depth_);
+  }
+  out_->Append('"');
+  internal::AppendEscaped(*out_, key.data(), key.size(),
+                          config_.escape_unicode);
+  if (config_.pretty_print) {
+    out_->Append("\": ", 3);
+  } else {
+    out_->Append("\":", 2);
+  }
+  after_key_ = true;
+  return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::String(std::string_view value) {
+  BeforeValue();
+  out_->Append('"');
+  internal::AppendEscaped(*out_, value.data(), value.size(),
+                          config_.escape_unicode);
+  out_->Append('"');
+  AfterValue();
+  return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::Int64(int64_t value) {
+  BeforeValue();
+  char buffer[internal::kMaxNumberLength];
+  char* end = internal::FormatInt64(buffer, value);
+  out_->Append(buffer, static_cast<size_t>(end - buffer));
+  AfterValue();
+  return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::UInt64(uint64_t value) {
+  BeforeValue();
+  char buffer[internal::kMaxNumberLength];
+  char* end = internal::FormatUInt64(buffer, value);
+  out_->Append(buffer, static_cast<size_t>(end - buffer));
+  AfterValue();
+  return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::Double(double value) {
+  BeforeValue();
+  writer_.WriteNumber(*out_, value);
+  AfterValue();
+  return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::Bool(bool value) {
+  BeforeValue();
+  if (value) {
+    out_->Append("true", 4);
+  } else {
+    out_->Append("false", 5);
+  }
+  AfterValue();
+  return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::Null() {
+  BeforeValue();
+  out_->Append("null", 4);
+  AfterValue();
+  return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::Value(const JsonValue& value) {
+  BeforeValue();
+  const int depth = static_cast<int>(depth_);
+  writer_.WriteValue(*out_, value, depth * config_.indent_size, depth);
+  AfterValue();
+  return *this;
+}
+
+void JsonStreamWriter::Flush() { out_->Flush(); }
+
+void JsonStreamWriter::BeforeValue() {
+  if (depth_ == 0) {
+    if (complete_) {
+      throw JsonException("A complete top-level value was already written");
+    }
+    return;
+  }
+  if (InObject()) {
+    if (!after_key_) {
+      throw JsonException("Value in object context requires a Key first");
+    }
+    after_key_ = false;
+    return;
+  }
+  if (!first_) {
+    out_->Append(',');
+  }
+  first_ = false;
+  if (config_.pretty_print) {
+    WriteNewline(depth_);
+  }
+}
+
+void JsonStreamWriter::AfterValue() {
+  if (depth_ == 0) {
+    complete_ = true;
+  }
+}
+
+void JsonStreamWriter::Push(bool is_object) {
+  if (depth_ >= static_cast<size_t>(std::max(config_.max_depth, 0))) {
+    throw JsonException("Maximum depth exceeded during writing");
+  }
+  size_t word = depth_ / 64;
+  uint64_t bit = uint64_t{1} << (depth_ % 64);
+  if (word == nesting_.size()) {
+    nesting_.push_back(0);
+  }
+  if (is_object) {
+    nesting_[word] |= bit;
+  } else {
+    nesting_[word] &= ~bit;
+  }
+  ++depth_;
+  first_ = true;
+}
+
+void JsonStreamWriter::Pop(bool is_object) {
+  if (depth_ == 0 || InObject() != is_object) {
+    throw JsonException(is_object
+                            ? "EndObject called without matching BeginObject"
+                            : "EndArray called without matching BeginArray");
+  }
+  if (after_key_) {
+    throw JsonException("EndObject called before the value of the last Key");
+  }
+  --depth_;
+  if (config_.pretty_print && !first_) {
+    WriteNewline(depth_);
+  }
+  out_->Append(is_object ? '}' : ']');
+  first_ = false;
+  AfterValue();
+}
+
+void JsonStreamWriter::InitIndent() {
+  newline_indent_.assign(1, '\n');
+  if (config_.pretty_print && config_.indent_size > 0) {
+    newline_indent_.append(
+        static_cast<size_t>(config_.indent_size) * kPrecomputedIndentLevels,
+        ' ');
+  }
+}
+
+void JsonStreamWriter::WriteNewline(size_t depth) {
+  size_t indent =
+      depth * static_cast<size_t>(std::max(config_.indent_size, 0));
+  size_t remaining = indent + 1;
+  const size_t slice = newline_indent_.size();
+  const char* data = newline_indent_.data();
+  out_->Append(data, std::min(remaining, slice));
+  remaining -= std::min(remaining, slice);
+  while (remaining > 0) {
+    size_t chunk = std::min(remaining, slice - 1);
+    out_->Append(data + 1, chunk);
+    remaining -= chunk;
+  }
+}
+
+}  // namespace json_parser
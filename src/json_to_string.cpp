@@ -0,0 +1,209 @@
+#include "json_to_string.h"
+#include "json_parser/json_value.h"
+#include "json_parser/json_object.h"
+#include "json_parser/json_array.h"
+#include "json_escape.h"
+#include "json_number_format.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace json_parser {
+namespace internal {
+
+namespace {
+
+// Indentation step of pretty output
+constexpr int kIndentStep = 2;
+
+// Two passes over the same tree: Measure* returns how many bytes Append*
+// will write, so the output string never reallocates
+class ToStringSerializer {
+ public:
+  explicit ToStringSerializer(bool pretty) : pretty_(pretty) {}
+
+  size_t MeasureValue(const JsonValue& value, int indent) const {
+    switch (value.GetType()) {
+      case JsonValueType::kObject:
+        return MeasureObject(value.AsObject(), indent);
+      case JsonValueType::kArray:
+        return MeasureArray(value.AsArray(), indent);
+      case JsonValueType::kString:
+        return MeasureString(value.AsString());
+      case JsonValueType::kNumber: {
+        char buffer[kMaxNumberLength];
+        return static_cast<size_t>(FormatDouble(buffer, value.AsNumber()) -
+                                   buffer);
+      }
+      case JsonValueType::kBoolean:
+        return value.AsBoolean() ? 4 : 5;
+      case JsonValueType::kNull:
+        return 4;
+    }
+    return 4;
+  }
+
+  size_t MeasureObject(const JsonObject& obj, int indent) const {
+    if (obj.Empty()) {
+      return 2;
+    }
+    const int inner = indent + kIndentStep;
+    // Brackets and the commas between members
+    size_t length = 2 + (obj.Size() - 1);
+    for (auto it = obj.Begin(); it != obj.End(); ++it) {
+      length += MeasureString(it->first) + (pretty_ ? 2 : 1) +
+                MeasureValue(it->second, inner);
+    }
+    return length + MeasureNewlines(obj.Size(), indent);
+  }
+
+  size_t MeasureArray(const JsonArray& arr, int indent) const {
+    if (arr.Empty()) {
+      return 2;
+    }
+    const int inner = indent + kIndentStep;
+    size_t length = 2 + (arr.Size() - 1);
+    for (size_t i = 0; i < arr.Size(); ++i) {
+      length += MeasureValue(arr[i], inner);
+    }
+    return length + MeasureNewlines(arr.Size(), indent);
+  }
+
+  void AppendValue(std::string& out, const JsonValue& value,
+                   int indent) const {
+    switch (value.GetType()) {
+      case JsonValueType::kObject:
+        AppendObject(out, value.AsObject(), indent);
+        break;
+      case JsonValueType::kArray:
+        AppendArray(out, value.AsArray(), indent);
+        break;
+      case JsonValueType::kString:
+        AppendString(out, value.AsString());
+        break;
+      case JsonValueType::kNumber: {
+        char buffer[kMaxNumberLength];
+        char* end = FormatDouble(buffer, value.AsNumber());
+        out.append(buffer, static_cast<size_t>(end - buffer));
+        break;
+      }
+      case JsonValueType::kBoolean:
+        if (value.AsBoolean()) {
+          out.append("true", 4);
+        } else {
+          out.append("false", 5);
+        }
+        break;
+      case JsonValueType::kNull:
+        out.append("null", 4);
+        break;
+    }
+  }
+
+  void AppendObject(std::string& out, const JsonObject& obj,
+                    int indent) const {
+    if (obj.Empty()) {
+      out.append("{}", 2);
+      return;
+    }
+    const int inner = indent + kIndentStep;
+    out.push_back('{');
+    bool first = true;
+    for (auto it = obj.Begin(); it != obj.End(); ++it) {
+      if (!first) {
+        out.push_back(',');
+      }
+      first = false;
+      AppendNewline(out, inner);
+      AppendString(out, it->first);
+      if (pretty_) {
+        out.append(": ", 2);
+      } else {
+        out.push_back(':');
+      }
+      AppendValue(out, it->second, inner);
+    }
+    AppendNewline(out, indent);
+    out.push_back('}');
+  }
+
+  void AppendArray(std::string& out, const JsonArray& arr, int indent) const {
+    if (arr.Empty()) {
+      out.append("[]", 2);
+      return;
+    }
+    const int inner = indent + kIndentStep;
+    out.push_back('[');
+    for (size_t i = 0; i < arr.Size(); ++i) {
+      if (i > 0) {
+        out.push_back(',');
+      }
+      AppendNewline(out, inner);
+      AppendValue(out, arr[i], inner);
+    }
+    AppendNewline(out, indent);
+    out.push_back(']');
+  }
+
+ private:
+  bool pretty_;
+
+  static size_t MeasureString(const std::string& str) {
+    return 2 + EscapedLength(str.data(), str.size());
+  }
+
+  static void AppendString(std::string& out, const std::string& str) {
+    out.push_back('"');
+    AppendEscaped(out, str.data(), str.size(), /*escape_unicode=*/false);
+    out.push_back('"');
+  }
+
+  // One line break per entry at the inner indentation, plus the one before
+  // the closing bracket
+  size_t MeasureNewlines(size_t count, int indent) const {
+    if (!pretty_) {
+      return 0;
+    }
+    const size_t outer = static_cast<size_t>(indent);
+    return count * (1 + outer + kIndentStep) + 1 + outer;
+  }
+
+  void AppendNewline(std::string& out, int indent) const {
+    if (pretty_) {
+      out.push_back('\n');
+      out.append(static_cast<size_t>(indent), ' ');
+    }
+  }
+};
+
+}  // namespace
+
+std::string ToJsonString(const JsonValue& value, bool pretty, int indent) {
+  ToStringSerializer serializer(pretty);
+  std::string out;
+  indent = std::max(indent, 0);
+  out.reserve(serializer.MeasureValue(value, indent));
+  serializer.AppendValue(out, value, indent);
+  return out;
+}
+
+std::string ToJsonString(const JsonObject& obj, bool pretty, int indent) {
+  ToStringSerializer serializer(pretty);
+  std::string out;
+  indent = std::max(indent, 0);
+  out.reserve(serializer.MeasureObject(obj, indent));
+  serializer.AppendObject(out, obj, indent);
+  return out;
+}
+
+std::string ToJsonString(const JsonArray& arr, bool pretty, int indent) {
+  ToStringSerializer serializer(pretty);
+  std::string out;
+  indent = std::max(indent, 0);
+  out.reserve(serializer.MeasureArray(arr, indent));
+  serializer.AppendArray(out, arr, indent);
+  return out;
+}
+
+}  // namespace internal
+}  // namespace json_parser
@@ -0,0 +1,28 @@
+#ifndef JSON_PARSER_SRC_JSON_TO_STRING_H_
+#define JSON_PARSER_SRC_JSON_TO_STRING_H_
+
+// Internal serializer behind the ToString and ToCompactString members of
+// JsonValue, JsonObject and JsonArray. It measures the exact output length
+// first, reserves it once, then appends every token into that string.
+
+#include <string>
+
+namespace json_parser {
+
+class JsonValue;
+class JsonObject;
+class JsonArray;
+
+namespace internal {
+
+// Pretty output puts each member on its own line, indented two spaces past
+// indent, with the closing bracket at indent. Compact output has no
+// whitespace and ignores indent. Members keep their storage order.
+std::string ToJsonString(const JsonValue& value, bool pretty, int indent);
+std::string ToJsonString(const JsonObject& obj, bool pretty, int indent);
+std::string ToJsonString(const JsonArray& arr, bool pretty, int indent);
+
+}  // namespace internal
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_SRC_JSON_TO_STRING_H_
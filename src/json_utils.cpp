@@ -1,12 +1,13 @@
 #include "json_parser/json_utils.h"
 #include "json_parser/json_parser.h"
+#include "json_parser/json_path.h"
 #include "json_parser/json_writer.h"
 #include "json_parser/json_exception.h"
 #include "json_parser/json_object.h"
 #include "json_parser/json_array.h"
+#include "json_intern.h"
 
 #include <algorithm>
-#include <sstream>
 
 namespace json_parser {
 
@@ -64,51 +65,32 @@ bool JsonUtils::AsBool(const JsonValue& value, bool default_val) {
   return default_val;
 }
 
+namespace {
+
+// GetByPath treats a malformed path as one that matches nothing
+bool CompilePath(const std::string& path, JsonPath* compiled) {
+  try {
+    *compiled = JsonPath::CompileDotted(path);
+  } catch (const JsonPathException&) {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+// For repeated lookups compile the path once with JsonPath::CompileDotted.
+// The mutable overload walks with the mutable accessors, so cached hashes
+// along the path are dropped before the result can be modified.
 JsonValue* JsonUtils::GetByPath(JsonValue& root, const std::string& path) {
-  const JsonValue* const_result = GetByPath(static_cast<const JsonValue&>(root),
-                                            path);
-  return const_cast<JsonValue*>(const_result);
+  JsonPath compiled;
+  return CompilePath(path, &compiled) ? compiled.Find(root) : nullptr;
 }
 
 const JsonValue* JsonUtils::GetByPath(const JsonValue& root,
                                        const std::string& path) {
-  const JsonValue* current = &root;
-  std::istringstream iss(path);
-  std::string segment;
-
-  while (std::getline(iss, segment, '.')) {
-    size_t bracket_pos = segment.find('[');
-    if (bracket_pos != std::string::npos) {
-      // Array access
-      std::string key = segment.substr(0, bracket_pos);
-      if (!key.empty()) {
-        if (!current->IsObject()) {
-          return nullptr;
-        }
-        current = &current->AsObject().At(key);
-      }
-
-      std::string index_str = segment.substr(bracket_pos + 1);
-      index_str.pop_back();  // Remove ']'
-      size_t index = std::stoul(index_str);
-
-      if (!current->IsArray() || index >= current->AsArray().Size()) {
-        return nullptr;
-      }
-      current = &current->AsArray()[index];
-    } else {
-      // Object key access
-      if (!current->IsObject()) {
-        return nullptr;
-      }
-      if (!current->AsObject().Contains(segment)) {
-        return nullptr;
-      }
-      current = &current->AsObject().At(segment);
-    }
-  }
-
-  return current;
+  JsonPath compiled;
+  return CompilePath(path, &compiled) ? compiled.Find(root) : nullptr;
 }
 
 bool JsonUtils::HasPath(const JsonValue& root, const std::string& path) {
@@ -144,6 +126,11 @@ JsonValue JsonUtils::DeepCopy(const JsonValue& value) {
   return JsonValue(nullptr);
 }
 
+size_t JsonUtils::Intern(JsonValue& value) {
+  internal::JsonInterner interner;
+  return interner.InternTree(value);
+}
+
 JsonObject JsonUtils::Merge(const JsonObject& obj1, const JsonObject& obj2,
                             bool overwrite) {
   JsonObject result = obj1;
@@ -2,10 +2,13 @@
 #include "json_parser/json_exception.h"
 #include "json_parser/json_object.h"
 #include "json_parser/json_array.h"
+#include "json_to_string.h"
 
-#include <cmath>
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <utility>
 
 namespace json_parser {
 
@@ -69,7 +72,17 @@ JsonValue& JsonValue::operator=(JsonValue&& other) noexcept {
 // Type-safe accessors
 JsonObject& JsonValue::AsObject() {
   ValidateType(JsonValueType::kObject);
-  return *std::get<std::shared_ptr<JsonObject>>(value_);
+  std::shared_ptr<JsonObject>& obj =
+      std::get<std::shared_ptr<JsonObject>>(value_);
+  if (obj->frozen_) {
+    // Interned: copy it unless no other value shares it
+    if (obj.use_count() > 1) {
+      obj = std::make_shared<JsonObject>(*obj);
+    } else {
+      obj->frozen_ = false;
+    }
+  }
+  return *obj;
 }
 
 const JsonObject& JsonValue::AsObject() const {
@@ -79,7 +92,16 @@ const JsonObject& JsonValue::AsObject() const {
 
 JsonArray& JsonValue::AsArray() {
   ValidateType(JsonValueType::kArray);
-  return *std::get<std::shared_ptr<JsonArray>>(value_);
+  std::shared_ptr<JsonArray>& arr =
+      std::get<std::shared_ptr<JsonArray>>(value_);
+  if (arr->frozen_) {
+    if (arr.use_count() > 1) {
+      arr = std::make_shared<JsonArray>(*arr);
+    } else {
+      arr->frozen_ = false;
+    }
+  }
+  return *arr;
 }
 
 const JsonArray& JsonValue::AsArray() const {
@@ -173,8 +195,7 @@ bool JsonValue::operator==(const JsonValue& other) const {
       return std::get<std::string>(value_) ==
              std::get<std::string>(other.value_);
     case JsonValueType::kNumber:
-      return std::abs(std::get<double>(value_) -
-                      std::get<double>(other.value_)) < 1e-9;
+      return std::get<double>(value_) == std::get<double>(other.value_);
     case JsonValueType::kBoolean:
       return std::get<bool>(value_) == std::get<bool>(other.value_);
     case JsonValueType::kNull:
@@ -187,55 +208,221 @@ bool JsonValue::operator!=(const JsonValue& other) const {
   return !(*this == other);
 }
 
-// String representation
-std::string JsonValue::ToString(int indent) const {
+// Hashing
+namespace {
+
+uint64_t MixHash(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return x;
+}
+
+// Holds a HashCache's lock; it is only contended by concurrent readers
+// hashing a shared subtree, and only briefly
+class SpinLockGuard {
+ public:
+  explicit SpinLockGuard(std::atomic<bool>& locked) : locked_(locked) {
+    while (locked_.exchange(true, std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+  ~SpinLockGuard() { locked_.store(false, std::memory_order_release); }
+
+ private:
+  std::atomic<bool>& locked_;
+};
+
+bool SameOwner(const std::weak_ptr<const internal::HashCache>& a,
+               const std::weak_ptr<const internal::HashCache>& b) {
+  return !a.owner_before(b) && !b.owner_before(a);
+}
+
+}  // namespace
+
+namespace internal {
+
+HashCache::HashCache(const HashCache& /*other*/) noexcept {}
+
+HashCache::HashCache(HashCache&& other) noexcept { other.Invalidate(); }
+
+HashCache& HashCache::operator=(const HashCache& other) noexcept {
+  if (this != &other) {
+    Invalidate();
+  }
+  return *this;
+}
+
+HashCache& HashCache::operator=(HashCache&& other) noexcept {
+  if (this != &other) {
+    Invalidate();
+    other.Invalidate();
+  }
+  return *this;
+}
+
+bool HashCache::Get(uint64_t* hash) const {
+  if (!valid_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  *hash = hash_.load(std::memory_order_relaxed);
+  return true;
+}
+
+void HashCache::Set(uint64_t hash) const {
+  // Concurrent readers may race to cache the same node; they store the
+  // same hash, so the last store wins harmlessly
+  hash_.store(hash, std::memory_order_relaxed);
+  valid_.store(true, std::memory_order_release);
+}
+
+void HashCache::AddDependent(std::weak_ptr<const HashCache> parent) const {
+  SpinLockGuard guard(locked_);
+  if (dependent_.expired()) {
+    dependent_ = std::move(parent);
+    return;
+  }
+  // A parent hashed again registers again; the common repeats are caught
+  // here and the rest by compaction
+  if (SameOwner(dependent_, parent) ||
+      (!more_dependents_.empty() &&
+       SameOwner(more_dependents_.back(), parent))) {
+    return;
+  }
+  more_dependents_.push_back(std::move(parent));
+  if (more_dependents_.size() < std::max<size_t>(8, 2 * compacted_size_)) {
+    return;
+  }
+  auto expired_or_first = [this](const std::weak_ptr<const HashCache>& p) {
+    return p.expired() || SameOwner(p, dependent_);
+  };
+  more_dependents_.erase(
+      std::remove_if(more_dependents_.begin(), more_dependents_.end(),
+                     expired_or_first),
+      more_dependents_.end());
+  std::sort(more_dependents_.begin(), more_dependents_.end(),
+            [](const std::weak_ptr<const HashCache>& a,
+               const std::weak_ptr<const HashCache>& b) {
+              return a.owner_before(b);
+            });
+  more_dependents_.erase(std::unique(more_dependents_.begin(),
+                                     more_dependents_.end(), SameOwner),
+                         more_dependents_.end());
+  compacted_size_ = more_dependents_.size();
+}
+
+void HashCache::InvalidateSlow() const {
+  valid_.store(false, std::memory_order_release);
+  std::weak_ptr<const HashCache> dependent;
+  std::vector<std::weak_ptr<const HashCache>> more_dependents;
+  {
+    SpinLockGuard guard(locked_);
+    dependent.swap(dependent_);
+    more_dependents.swap(more_dependents_);
+    compacted_size_ = 0;
+  }
+  // Parents re-register when they are hashed again
+  if (std::shared_ptr<const HashCache> parent = dependent.lock()) {
+    parent->Invalidate();
+  }
+  for (const std::weak_ptr<const HashCache>& weak : more_dependents) {
+    if (std::shared_ptr<const HashCache> parent = weak.lock()) {
+      parent->Invalidate();
+    }
+  }
+}
+
+}  // namespace internal
+
+void JsonValue::AddDependent(
+    const JsonValue& child,
+    const std::weak_ptr<const internal::HashCache>& parent) {
+  // Frozen containers are only changed after being copied or unfrozen by
+  // the mutable accessors, which reach them through the parent's, so
+  // their parents need no link
+  if (child.type_ == JsonValueType::kObject) {
+    const JsonObject& obj = *std::get<std::shared_ptr<JsonObject>>(
+        child.value_);
+    if (!obj.frozen_) {
+      obj.hash_cache_.AddDependent(parent);
+    }
+  } else if (child.type_ == JsonValueType::kArray) {
+    const JsonArray& arr = *std::get<std::shared_ptr<JsonArray>>(
+        child.value_);
+    if (!arr.frozen_) {
+      arr.hash_cache_.AddDependent(parent);
+    }
+  }
+}
+
+uint64_t JsonValue::Hash() const {
   switch (type_) {
-    case JsonValueType::kObject:
-      return std::get<std::shared_ptr<JsonObject>>(value_)->ToString(indent);
-    case JsonValueType::kArray:
-      return std::get<std::shared_ptr<JsonArray>>(value_)->ToString(indent);
-    case JsonValueType::kString: {
-      std::ostringstream oss;
-      oss << "\"";
-      const std::string& str = std::get<std::string>(value_);
-      for (char c : str) {
-        if (c == '"') {
-          oss << "\\\"";
-        } else if (c == '\\') {
-          oss << "\\\\";
-        } else if (c == '\n') {
-          oss << "\\n";
-        } else if (c == '\r') {
-          oss << "\\r";
-        } else if (c == '\t') {
-          oss << "\\t";
-        } else {
-          oss << c;
-        }
+    case JsonValueType::kObject: {
+      const std::shared_ptr<JsonObject>& owner =
+          std::get<std::shared_ptr<JsonObject>>(value_);
+      const JsonObject& obj = *owner;
+      uint64_t hash = 0;
+      if (obj.hash_cache_.Get(&hash)) {
+        return hash;
+      }
+      const std::weak_ptr<const internal::HashCache> self(
+          std::shared_ptr<const internal::HashCache>(owner, &obj.hash_cache_));
+      // Members are unordered, so their hashes are combined by addition
+      hash = MixHash(obj.values_.size() ^ 0x6f626a656374ull);
+      for (const auto& member : obj.values_) {
+        hash += MixHash(std::hash<std::string>()(member.first) ^
+                        MixHash(member.second.Hash()));
+        AddDependent(member.second, self);
       }
-      oss << "\"";
-      return oss.str();
+      obj.hash_cache_.Set(hash);
+      return hash;
     }
+    case JsonValueType::kArray: {
+      const std::shared_ptr<JsonArray>& owner =
+          std::get<std::shared_ptr<JsonArray>>(value_);
+      const JsonArray& arr = *owner;
+      uint64_t hash = 0;
+      if (arr.hash_cache_.Get(&hash)) {
+        return hash;
+      }
+      const std::weak_ptr<const internal::HashCache> self(
+          std::shared_ptr<const internal::HashCache>(owner, &arr.hash_cache_));
+      hash = MixHash(arr.values_.size() ^ 0x6172726179ull);
+      for (const JsonValue& element : arr.values_) {
+        hash = MixHash(hash ^ element.Hash());
+        AddDependent(element, self);
+      }
+      arr.hash_cache_.Set(hash);
+      return hash;
+    }
+    case JsonValueType::kString:
+      return MixHash(std::hash<std::string>()(std::get<std::string>(value_)) ^
+                     0x737472696e67ull);
     case JsonValueType::kNumber: {
-      std::ostringstream oss;
-      double num = std::get<double>(value_);
-      if (num == static_cast<long long>(num)) {
-        oss << static_cast<long long>(num);
-      } else {
-        oss << std::fixed << std::setprecision(6) << num;
+      const double number = std::get<double>(value_);
+      uint64_t bits = 0;
+      if (number != 0.0) {  // 0 and -0 compare equal
+        std::memcpy(&bits, &number, sizeof(bits));
       }
-      return oss.str();
+      return MixHash(bits ^ 0x6e756d626572ull);
     }
     case JsonValueType::kBoolean:
-      return std::get<bool>(value_) ? "true" : "false";
+      return std::get<bool>(value_) ? 0x74727565ull : 0x66616c7365ull;
     case JsonValueType::kNull:
-      return "null";
+      break;
   }
-  return "null";
+  return 0x6e756c6cull;
+}
+
+// String representation
+std::string JsonValue::ToString(int indent) const {
+  return internal::ToJsonString(*this, /*pretty=*/true, indent);
 }
 
 std::string JsonValue::ToCompactString() const {
-  return ToString(0);
+  return internal::ToJsonString(*this, /*pretty=*/false, 0);
 }
 
 // Helper methods
@@ -0,0 +1,52 @@
+#ifndef JSON_PARSER_SRC_JSON_WORKER_POOL_H_
+#define JSON_PARSER_SRC_JSON_WORKER_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace json_parser {
+namespace internal {
+
+// Long-lived worker threads shared by the library, so parallel work does
+// not pay for creating and joining threads on every call. Threads are
+// started on demand and kept until the process exits.
+class WorkerPool {
+ public:
+  // The pool shared by every JsonWriter
+  static WorkerPool& Shared();
+
+  WorkerPool() = default;
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+  // Finishes queued tasks, then joins the threads
+  ~WorkerPool();
+
+  // Starts threads until at least count are running
+  void Reserve(size_t count);
+
+  // Queues task to run on one of the threads. Tasks must not wait for
+  // other tasks of the pool, since they may be queued behind them.
+  void Submit(std::function<void()> task);
+
+  // True on the pool's own threads
+  static bool OnWorkerThread();
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<std::function<void()>> tasks_;
+  std::vector<std::thread> threads_;
+  bool stopping_ = false;
+
+  void Run();
+};
+
+}  // namespace internal
+}  // namespace json_parser
+
+#endif  // JSON_PARSER_SRC_JSON_WORKER_POOL_H_
@@ -2,58 +2,182 @@
 #include "json_parser/json_object.h"
 #include "json_parser/json_array.h"
 #include "json_parser/json_exception.h"
+#include "json_parser/json_gzip.h"
+#include "json_escape.h"
+#include "json_number_format.h"
+#include "json_worker_pool.h"
 
 #include <algorithm>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <fstream>
-#include <iomanip>
-#include <sstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define JSON_PARSER_HAVE_POSIX_IO 1
+#endif
 
 namespace json_parser {
 
-JsonWriter::JsonWriter(const JsonWriterConfig& config) : config_(config) {}
+namespace {
+
+// Indent levels covered by one slice of the precomputed indentation string;
+// deeper levels are written in several slices
+constexpr int kPrecomputedIndentLevels = 32;
+
+// Entries per unit of parallel work, and how many finished units may wait
+// for splicing per thread before workers pause, which bounds memory
+constexpr size_t kParallelChunkSize = 4096;
+constexpr size_t kParallelChunksPerThread = 4;
+
+// Member lists longer than this are released after use rather than kept
+constexpr size_t kMaxRetainedMembers = 4096;
+
+using Member = std::pair<const std::string*, const JsonValue*>;
+
+// Member lists by nesting depth, reused from one object to the next so
+// writing many documents does not allocate one per object. A deque keeps
+// outer lists in place while deeper ones are added.
+thread_local std::deque<std::vector<Member>> t_member_lists;
+
+// RFC 8785 key order: by UTF-16 code units. This is UTF-8 byte order except
+// that code points above U+FFFF (lead bytes 0xF0 and up) become surrogates,
+// which sort before U+E000 through U+FFFF (lead bytes 0xEE and 0xEF).
+bool Utf16Less(const std::string& a, const std::string& b) {
+  const size_t length = std::min(a.size(), b.size());
+  for (size_t i = 0; i < length; ++i) {
+    const unsigned char x = static_cast<unsigned char>(a[i]);
+    const unsigned char y = static_cast<unsigned char>(b[i]);
+    if (x == y) {
+      continue;
+    }
+    if (x >= 0xF0 && (y == 0xEE || y == 0xEF)) {
+      return true;
+    }
+    if (y >= 0xF0 && (x == 0xEE || x == 0xEF)) {
+      return false;
+    }
+    return x < y;
+  }
+  return a.size() < b.size();
+}
+
+}  // namespace
+
+JsonWriter::JsonWriter(const JsonWriterConfig& config) { SetConfig(config); }
+
+void JsonWriter::SetConfig(const JsonWriterConfig& config) {
+  config_ = config;
+  if (config_.canonical) {
+    config_.pretty_print = false;
+    config_.escape_unicode = false;
+    config_.sort_keys = true;
+  }
+  newline_indent_.assign(1, '\n');
+  if (config_.pretty_print && config_.indent_size > 0) {
+    newline_indent_.append(
+        static_cast<size_t>(config_.indent_size) * kPrecomputedIndentLevels,
+        ' ');
+  }
+}
 
 std::string JsonWriter::Write(const JsonValue& value) const {
-  std::ostringstream oss;
-  WriteToStream(oss, value);
-  return oss.str();
+  JsonOutputBuffer out;
+  WriteToBuffer(out, value);
+  return out.TakeString();
 }
 
 std::string JsonWriter::Write(const JsonObject& obj) const {
-  std::ostringstream oss;
-  WriteToStream(oss, obj);
-  return oss.str();
+  JsonOutputBuffer out;
+  WriteToBuffer(out, obj);
+  return out.TakeString();
 }
 
 std::string JsonWriter::Write(const JsonArray& arr) const {
-  std::ostringstream oss;
-  WriteToStream(oss, arr);
-  return oss.str();
+  JsonOutputBuffer out;
+  WriteToBuffer(out, arr);
+  return out.TakeString();
+}
+
+void JsonWriter::WriteToBuffer(JsonOutputBuffer& out,
+                               const JsonValue& value) const {
+  WriteValue(out, value, 0, 0);
+}
+
+void JsonWriter::WriteToBuffer(JsonOutputBuffer& out,
+                               const JsonObject& obj) const {
+  WriteObject(out, obj, 0, 0);
+}
+
+void JsonWriter::WriteToBuffer(JsonOutputBuffer& out,
+                               const JsonArray& arr) const {
+  WriteArray(out, arr, 0, 0);
 }
 
 void JsonWriter::WriteToStream(std::ostream& os, const JsonValue& value) const {
-  WriteValue(os, value, 0, 0);
+  JsonOutputBuffer out(os);
+  WriteValue(out, value, 0, 0);
 }
 
 void JsonWriter::WriteToStream(std::ostream& os,
                                 const JsonObject& obj) const {
-  WriteObject(os, obj, 0, 0);
+  JsonOutputBuffer out(os);
+  WriteObject(out, obj, 0, 0);
 }
 
 void JsonWriter::WriteToStream(std::ostream& os, const JsonArray& arr) const {
-  WriteArray(os, arr, 0, 0);
+  JsonOutputBuffer out(os);
+  WriteArray(out, arr, 0, 0);
 }
 
 void JsonWriter::WriteToFile(const std::string& filename,
                               const JsonValue& value) const {
-  std::ofstream file(filename);
+  if (JsonGzip::HasGzipExtension(filename)) {
+    // Compression of each block overlaps with formatting the next
+    JsonGzipOutputStream file(filename);
+    WriteToStream(file, value);
+    file.Close();
+    return;
+  }
+#if defined(JSON_PARSER_HAVE_POSIX_IO)
+  int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw JsonFileException(filename);
+  }
+  try {
+    WriteToFileDescriptor(fd, value);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  if (::close(fd) != 0) {
+    throw JsonFileException(filename);
+  }
+#else
+  std::ofstream file(filename, std::ios::binary);
   if (!file.is_open()) {
     throw JsonFileException(filename);
   }
   WriteToStream(file, value);
+#endif
 }
 
-void JsonWriter::WriteValue(std::ostream& os, const JsonValue& value,
+void JsonWriter::WriteToFileDescriptor(int fd, const JsonValue& value) const {
+  JsonOutputBuffer out(fd, JsonOutputBuffer::kDefaultFlushThreshold,
+                       /*gather=*/true);
+  WriteValue(out, value, 0, 0);
+  out.Flush();
+}
+
+void JsonWriter::WriteValue(JsonOutputBuffer& out, const JsonValue& value,
                              int indent, int depth) const {
   if (depth > config_.max_depth) {
     throw JsonException("Maximum depth exceeded during writing");
@@ -61,173 +185,279 @@ void JsonWriter::WriteValue(std::ostream& os, const JsonValue& value,
 
   switch (value.GetType()) {
     case JsonValueType::kObject:
-      WriteObject(os, value.AsObject(), indent, depth + 1);
+      WriteObject(out, value.AsObject(), indent, depth + 1);
       break;
     case JsonValueType::kArray:
-      WriteArray(os, value.AsArray(), indent, depth + 1);
+      WriteArray(out, value.AsArray(), indent, depth + 1);
       break;
     case JsonValueType::kString:
-      WriteString(os, value.AsString());
+      WriteString(out, value.AsString());
       break;
     case JsonValueType::kNumber:
-      WriteNumber(os, value.AsNumber());
+      WriteNumber(out, value.AsNumber());
       break;
     case JsonValueType::kBoolean:
-      os << (value.AsBoolean() ? "true" : "false");
+      if (value.AsBoolean()) {
+        out.Append("true", 4);
+      } else {
+        out.Append("false", 5);
+      }
       break;
     case JsonValueType::kNull:
-      os << "null";
+      out.Append("null", 4);
       break;
   }
 }
 
-void JsonWriter::WriteObject(std::ostream& os, const JsonObject& obj,
+void JsonWriter::WriteObject(JsonOutputBuffer& out, const JsonObject& obj,
                               int indent, int depth) const {
   if (obj.Empty()) {
-    os << "{}";
+    out.Append("{}", 2);
     return;
   }
 
-  os << "{";
-  if (config_.pretty_print) {
-    os << "\n";
+  // Each depth has its own list, since nested objects are written while
+  // this one's is in use
+  const size_t level = static_cast<size_t>(std::max(depth, 0));
+  while (t_member_lists.size() <= level) {
+    t_member_lists.emplace_back();
   }
-
-  std::vector<std::string> keys = obj.GetKeys();
-  if (config_.sort_keys) {
-    std::sort(keys.begin(), keys.end());
+  std::vector<Member>& members = t_member_lists[level];
+  members.clear();
+  members.reserve(obj.Size());
+  for (auto it = obj.Begin(); it != obj.End(); ++it) {
+    members.emplace_back(&it->first, &it->second);
+  }
+  if (config_.canonical) {
+    std::sort(members.begin(), members.end(),
+              [](const Member& a, const Member& b) {
+                return Utf16Less(*a.first, *b.first);
+              });
+  } else if (config_.sort_keys) {
+    std::sort(members.begin(), members.end(),
+              [](const Member& a, const Member& b) {
+                return *a.first < *b.first;
+              });
   }
 
-  bool first = true;
-  for (const std::string& key : keys) {
-    if (!first) {
-      os << ",";
-      if (config_.pretty_print) {
-        os << "\n";
-      }
-    }
-    first = false;
-
+  const int inner = indent + config_.indent_size;
+  auto write_member = [&](JsonOutputBuffer& target, size_t i) {
+    WriteString(target, *members[i].first);
     if (config_.pretty_print) {
-      WriteIndent(os, indent + config_.indent_size);
+      target.Append(": ", 2);
+    } else {
+      target.Append(':');
     }
+    WriteValue(target, *members[i].second, inner, depth);
+  };
 
-    WriteString(os, key);
-    os << (config_.pretty_print ? ": " : ":");
-
-    const JsonValue& value = obj.At(key);
-    WriteValue(os, value, indent + config_.indent_size, depth);
+  out.Append('{');
+  if (ShouldWriteInParallel(members.size())) {
+    WriteInParallel(out, members.size(), inner, write_member);
+  } else {
+    for (size_t i = 0; i < members.size(); ++i) {
+      if (i > 0) {
+        out.Append(',');
+      }
+      if (config_.pretty_print) {
+        WriteNewline(out, inner);
+      }
+      write_member(out, i);
+    }
   }
 
   if (config_.pretty_print) {
-    os << "\n";
-    WriteIndent(os, indent);
+    WriteNewline(out, indent);
+  }
+  out.Append('}');
+  if (members.capacity() > kMaxRetainedMembers) {
+    std::vector<Member>().swap(members);
   }
-  os << "}";
 }
 
-void JsonWriter::WriteArray(std::ostream& os, const JsonArray& arr,
+void JsonWriter::WriteArray(JsonOutputBuffer& out, const JsonArray& arr,
                              int indent, int depth) const {
   if (arr.Empty()) {
-    os << "[]";
+    out.Append("[]", 2);
     return;
   }
 
-  os << "[";
-  if (config_.pretty_print) {
-    os << "\n";
-  }
-
-  for (size_t i = 0; i < arr.Size(); ++i) {
-    if (i > 0) {
-      os << ",";
+  const int inner = indent + config_.indent_size;
+  out.Append('[');
+  if (ShouldWriteInParallel(arr.Size())) {
+    WriteInParallel(out, arr.Size(), inner,
+                    [&](JsonOutputBuffer& target, size_t i) {
+                      WriteValue(target, arr[i], inner, depth);
+                    });
+  } else {
+    for (size_t i = 0; i < arr.Size(); ++i) {
+      if (i > 0) {
+        out.Append(',');
+      }
       if (config_.pretty_print) {
-        os << "\n";
+        WriteNewline(out, inner);
       }
+      WriteValue(out, arr[i], inner, depth);
     }
-
-    if (config_.pretty_print) {
-      WriteIndent(os, indent + config_.indent_size);
-    }
-
-    WriteValue(os, arr[i], indent + config_.indent_size, depth);
   }
 
   if (config_.pretty_print) {
-    os << "\n";
-    WriteIndent(os, indent);
+    WriteNewline(out, indent);
   }
-  os << "]";
+  out.Append(']');
 }
 
-void JsonWriter::WriteString(std::ostream& os, const std::string& str) const {
-  os << "\"";
-  os << EscapeString(str);
-  os << "\"";
+void JsonWriter::WriteString(JsonOutputBuffer& out,
+                             const std::string& str) const {
+  out.Append('"');
+  internal::AppendEscaped(out, str.data(), str.size(), config_.escape_unicode,
+                          /*reference_runs=*/true);
+  out.Append('"');
 }
 
-void JsonWriter::WriteNumber(std::ostream& os, double num) const {
-  if (std::isnan(num) || std::isinf(num)) {
-    os << "null";
-    return;
+void JsonWriter::WriteNumber(JsonOutputBuffer& out, double num) const {
+  char buffer[internal::kMaxNumberLength];
+  char* end;
+  if (config_.canonical) {
+    if (!std::isfinite(num)) {
+      throw JsonException("Cannot write non-finite number in canonical JSON");
+    }
+    end = internal::FormatDoubleEcmaScript(buffer, num);
+  } else {
+    end = internal::FormatDouble(buffer, num);
   }
+  out.Append(buffer, static_cast<size_t>(end - buffer));
+}
 
-  if (num == static_cast<long long>(num)) {
-    os << static_cast<long long>(num);
-  } else {
-    os << std::fixed << std::setprecision(6) << num;
-  }
-}
-
-void JsonWriter::WriteIndent(std::ostream& os, int indent) const {
-  for (int i = 0; i < indent; ++i) {
-    os << " ";
-  }
-}
-
-std::string JsonWriter::EscapeString(const std::string& str) const {
-  std::string result;
-  result.reserve(str.length() + 10);
-
-  for (char c : str) {
-    switch (c) {
-      case '"':
-        result += "\\\"";
-        break;
-      case '\\':
-        result += "\\\\";
-        break;
-      case '\b':
-        result += "\\b";
-        break;
-      case '\f':
-        result += "\\f";
-        break;
-      case '\n':
-        result += "\\n";
-        break;
-      case '\r':
-        result += "\\r";
-        break;
-      case '\t':
-        result += "\\t";
-        break;
-      default:
-        if (config_.escape_unicode && (static_cast<unsigned char>(c) > 127)) {
-          // Unicode escape
-          std::ostringstream oss;
-          oss << "\\u" << std::hex << std::setfill('0') << std::setw(4)
-              << static_cast<int>(static_cast<unsigned char>(c));
-          result += oss.str();
-        } else {
-          result += c;
+void JsonWriter::WriteNewline(JsonOutputBuffer& out, int indent) const {
+  // The first slice carries the newline; later ones only spaces
+  size_t remaining = static_cast<size_t>(std::max(indent, 0)) + 1;
+  const size_t slice = newline_indent_.size();
+  const char* data = newline_indent_.data();
+  out.Append(data, std::min(remaining, slice));
+  remaining -= std::min(remaining, slice);
+  while (remaining > 0) {
+    size_t chunk = std::min(remaining, slice - 1);
+    out.Append(data + 1, chunk);
+    remaining -= chunk;
+  }
+}
+
+bool JsonWriter::ShouldWriteInParallel(size_t count) const {
+  return config_.threads != 1 && count >= config_.parallel_min_elements &&
+         count > kParallelChunkSize &&
+         !internal::WorkerPool::OnWorkerThread();
+}
+
+void JsonWriter::WriteInParallel(
+    JsonOutputBuffer& out, size_t count, int indent,
+    const std::function<void(JsonOutputBuffer&, size_t)>& write_entry) const {
+  size_t threads = config_.threads > 0
+                       ? static_cast<size_t>(config_.threads)
+                       : std::max(std::thread::hardware_concurrency(), 1u);
+  const size_t chunk_count =
+      (count + kParallelChunkSize - 1) / kParallelChunkSize;
+  threads = std::min(threads, chunk_count);
+  const size_t window = threads * kParallelChunksPerThread;
+
+  struct Chunk {
+    JsonOutputBuffer buffer;
+    std::exception_ptr error;
+  };
+  std::vector<std::unique_ptr<Chunk>> chunks(chunk_count);
+  std::mutex mutex;
+  std::condition_variable changed;
+  size_t next = 0;
+  size_t spliced = 0;
+  bool abort = false;
+
+  // Pool tasks that have not returned yet; this frame outlives them all
+  size_t running = 0;
+
+  auto work = [&]() {
+    while (true) {
+      size_t index;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] {
+          return abort || next >= chunk_count || next < spliced + window;
+        });
+        if (abort || next >= chunk_count) {
+          // Notify under the lock: once running drops to zero the caller
+          // may return and destroy changed
+          --running;
+          changed.notify_all();
+          return;
         }
-        break;
+        index = next++;
+      }
+
+      std::unique_ptr<Chunk> chunk(new Chunk());
+      try {
+        size_t end = std::min(count, (index + 1) * kParallelChunkSize);
+        for (size_t i = index * kParallelChunkSize; i < end; ++i) {
+          if (i > 0) {
+            chunk->buffer.Append(',');
+          }
+          if (config_.pretty_print) {
+            WriteNewline(chunk->buffer, indent);
+          }
+          write_entry(chunk->buffer, i);
+        }
+      } catch (...) {
+        chunk->error = std::current_exception();
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        chunks[index] = std::move(chunk);
+      }
+      changed.notify_all();
     }
+  };
+
+  auto stop = [&]() {
+    std::unique_lock<std::mutex> lock(mutex);
+    abort = true;
+    changed.notify_all();
+    changed.wait(lock, [&] { return running == 0; });
+  };
+
+  try {
+    internal::WorkerPool& pool = internal::WorkerPool::Shared();
+    pool.Reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++running;
+      }
+      try {
+        pool.Submit(work);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        --running;
+        throw;
+      }
+    }
+    // Splice in order as chunks finish, releasing each one right away
+    for (size_t index = 0; index < chunk_count; ++index) {
+      std::unique_ptr<Chunk> chunk;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return chunks[index] != nullptr; });
+        chunk = std::move(chunks[index]);
+        ++spliced;
+      }
+      changed.notify_all();
+      if (chunk->error) {
+        std::rethrow_exception(chunk->error);
+      }
+      out.Append(chunk->buffer.Data(), chunk->buffer.Size());
+    }
+  } catch (...) {
+    stop();
+    throw;
   }
-
-  return result;
+  stop();
 }
 
 }  // namespace json_parser
-
@@ -89,3 +89,14 @@ TEST_F(JsonArrayTest, EmptyArray) {
   EXPECT_EQ(empty.ToString(), "[]");
 }
 
+TEST_F(JsonArrayTest, ToCompactStringIsCompactWhenNested) {
+  JsonArray inner;
+  inner.PushBack(JsonValue(2.5));
+  inner.PushBack(JsonValue(nullptr));
+  JsonArray outer;
+  outer.PushBack(JsonValue("x"));
+  outer.PushBack(JsonValue(inner));
+  EXPECT_EQ(outer.ToCompactString(), "[\"x\",[2.5,null]]");
+  EXPECT_EQ(outer.ToString(),
+            "[\n  \"x\",\n  [\n    2.5,\n    null\n  ]\n]");
+}
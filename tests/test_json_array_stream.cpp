@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace json_parser;
+
+class JsonArrayStreamTest : public ::testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(JsonArrayStreamTest, IteratesElements) {
+  std::istringstream input(R"([1, "two", {"three": [3, "]"]}, null])");
+  JsonArrayStream stream(input);
+  JsonValue value;
+
+  ASSERT_TRUE(stream.Next(value));
+  EXPECT_EQ(value.AsNumber(), 1);
+  ASSERT_TRUE(stream.Next(value));
+  EXPECT_EQ(value.AsString(), "two");
+  ASSERT_TRUE(stream.Next(value));
+  EXPECT_EQ(value.AsObject()["three"].AsArray()[1].AsString(), "]");
+  ASSERT_TRUE(stream.Next(value));
+  EXPECT_TRUE(value.IsNull());
+  EXPECT_FALSE(stream.Next(value));
+  EXPECT_TRUE(stream.Done());
+  EXPECT_EQ(stream.Count(), 4);
+}
+
+TEST_F(JsonArrayStreamTest, TinyBufferRefills) {
+  std::istringstream input(
+      R"( [ {"name": "a \"quoted\" name"}, [1, [2, [3]]], "x,y" ] )");
+  JsonArrayStream stream(input, JsonParserConfig::Strict(), 3);
+  JsonValue value;
+
+  ASSERT_TRUE(stream.Next(value));
+  EXPECT_EQ(value.AsObject()["name"].AsString(), "a \"quoted\" name");
+  ASSERT_TRUE(stream.Next(value));
+  EXPECT_EQ(value.AsArray().Size(), 2);
+  ASSERT_TRUE(stream.Next(value));
+  EXPECT_EQ(value.AsString(), "x,y");
+  EXPECT_FALSE(stream.Next(value));
+}
+
+TEST_F(JsonArrayStreamTest, EmptyArray) {
+  std::istringstream input("  [ ]  ");
+  JsonArrayStream stream(input);
+  JsonValue value;
+  EXPECT_FALSE(stream.Next(value));
+  EXPECT_EQ(stream.Count(), 0);
+}
+
+TEST_F(JsonArrayStreamTest, ReadsFile) {
+  std::string filename = "json_array_stream_test.json";
+  {
+    std::ofstream file(filename);
+    file << "[";
+    for (int i = 0; i < 1000; ++i) {
+      file << (i > 0 ? "," : "") << R"({"id": )" << i << "}";
+    }
+    file << "]";
+  }
+
+  JsonArrayStream stream(filename, JsonParserConfig::Strict(), 128);
+  JsonValue value;
+  double sum = 0;
+  while (stream.Next(value)) {
+    sum += value.AsObject()["id"].AsNumber();
+  }
+  EXPECT_EQ(stream.Count(), 1000);
+  EXPECT_DOUBLE_EQ(sum, 999 * 1000 / 2);
+  std::remove(filename.c_str());
+}
+
+TEST_F(JsonArrayStreamTest, RejectsMalformedInput) {
+  JsonValue value;
+
+  std::istringstream not_array(R"({"key": 1})");
+  JsonArrayStream stream1(not_array);
+  EXPECT_THROW(stream1.Next(value), JsonParseException);
+
+  std::istringstream truncated("[1, [2, 3");
+  JsonArrayStream stream2(truncated);
+  ASSERT_TRUE(stream2.Next(value));
+  EXPECT_THROW(stream2.Next(value), JsonParseException);
+
+  std::istringstream trailing("[1] 2");
+  JsonArrayStream stream3(trailing);
+  ASSERT_TRUE(stream3.Next(value));
+  EXPECT_THROW(stream3.Next(value), JsonParseException);
+}
+
+TEST_F(JsonArrayStreamTest, MissingFileThrows) {
+  EXPECT_THROW(JsonArrayStream("does_not_exist.json"), JsonFileException);
+}
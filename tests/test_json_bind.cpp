@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace json_parser;
+
+struct BindAddress {
+  std::string city;
+  int zip = 0;
+};
+JSON_BIND(BindAddress, city, zip);
+
+struct BindUser {
+  int64_t id = 0;
+  std::string name;
+  bool active = false;
+  double score = 0;
+  std::vector<std::string> tags;
+  std::optional<BindAddress> address;
+  std::map<std::string, int> counts;
+  std::unordered_map<std::string, std::vector<int>> series;
+  uint8_t level = 0;
+  JsonValue extra;
+};
+JSON_BIND(BindUser, id, name, active, score, tags, address, counts, series,
+          level, extra);
+
+TEST(JsonBindTest, ReadsBoundStruct) {
+  BindUser user = JsonBind::Parse<BindUser>(R"({
+    "id": 42,
+    "name": "Alice",
+    "active": true,
+    "score": 9.5,
+    "tags": ["a", "b"],
+    "address": {"city": "Oslo", "zip": 150},
+    "counts": {"x": 1, "y": 2},
+    "series": {"s": [1, 2, 3]},
+    "level": 7,
+    "extra": {"any": [null]}
+  })");
+
+  EXPECT_EQ(user.id, 42);
+  EXPECT_EQ(user.name, "Alice");
+  EXPECT_TRUE(user.active);
+  EXPECT_DOUBLE_EQ(user.score, 9.5);
+  EXPECT_EQ(user.tags, (std::vector<std::string>{"a", "b"}));
+  ASSERT_TRUE(user.address.has_value());
+  EXPECT_EQ(user.address->city, "Oslo");
+  EXPECT_EQ(user.address->zip, 150);
+  EXPECT_EQ(user.counts.at("y"), 2);
+  EXPECT_EQ(user.series.at("s").size(), 3);
+  EXPECT_EQ(user.level, 7);
+  EXPECT_TRUE(user.extra.AsObject()["any"].AsArray()[0].IsNull());
+}
+
+TEST(JsonBindTest, SkipsUnknownAndKeepsMissing) {
+  BindUser user;
+  user.name = "unchanged";
+  JsonBind::Read(R"({"unknown": {"deep": [1, "}"]}, "id": 5, "address": null,
+                     "nam": 1, "namex": 2})",
+                 user);
+  EXPECT_EQ(user.id, 5);
+  EXPECT_EQ(user.name, "unchanged");
+  EXPECT_FALSE(user.address.has_value());
+}
+
+TEST(JsonBindTest, ReadsContainersAtTopLevel) {
+  std::vector<BindAddress> addresses = JsonBind::Parse<std::vector<BindAddress>>(
+      R"([{"city": "A", "zip": 1}, {"city": "B"}])");
+  ASSERT_EQ(addresses.size(), 2);
+  EXPECT_EQ(addresses[1].city, "B");
+  EXPECT_EQ(addresses[1].zip, 0);
+}
+
+TEST(JsonBindTest, Errors) {
+  BindUser user;
+  EXPECT_THROW(JsonBind::Read(R"({"id": "x"})", user), JsonTypeException);
+  EXPECT_THROW(JsonBind::Read(R"({"level": 300})", user), JsonTypeException);
+  EXPECT_THROW(JsonBind::Read(R"({"id": 1.5})", user), JsonTypeException);
+  EXPECT_THROW(JsonBind::Read(R"({"id": 1)", user), JsonParseException);
+  EXPECT_THROW(JsonBind::Read(R"({"id": 1} x)", user), JsonParseException);
+}
+
+TEST(JsonBindTest, WritesBoundStruct) {
+  BindAddress address{"Oslo \"N\"\n", 150};
+  EXPECT_EQ(JsonBind::Write(address), R"({"city":"Oslo \"N\"\n","zip":150})");
+
+  BindUser user;
+  user.id = -3;
+  user.name = std::string("a\x01", 2);
+  user.score = 0.1;
+  user.tags = {"x"};
+  user.counts = {{"k", 1}};
+  user.level = 200;
+  EXPECT_EQ(JsonBind::Write(user),
+            R"({"id":-3,"name":"a\u0001","active":false,"score":0.1,)"
+            R"("tags":["x"],"address":null,"counts":{"k":1},"series":{},)"
+            R"("level":200,"extra":null})");
+}
+
+TEST(JsonBindTest, WriteRoundTrips) {
+  BindUser user;
+  user.id = 9007199254740993;
+  user.name = "caf\xC3\xA9";
+  user.score = 1.0 / 3.0;
+  user.address = BindAddress{"Rome", 100};
+  user.series["s"] = {1, 2};
+  user.extra = JsonValue(true);
+
+  std::string out = "prefix:";
+  JsonBind::Write(user, out);
+  EXPECT_EQ(out.rfind("prefix:", 0), 0);
+
+  BindUser copy = JsonBind::Parse<BindUser>(out.substr(7));
+  EXPECT_EQ(copy.id, user.id);
+  EXPECT_EQ(copy.name, user.name);
+  EXPECT_EQ(copy.score, user.score);
+  EXPECT_EQ(copy.address->city, "Rome");
+  EXPECT_EQ(copy.series.at("s"), user.series.at("s"));
+  EXPECT_TRUE(copy.extra.AsBoolean());
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+#include <cmath>
+
+using namespace json_parser;
+
+namespace {
+
+std::string Bytes(std::initializer_list<int> bytes) {
+  std::string result;
+  for (int b : bytes) {
+    result += static_cast<char>(b);
+  }
+  return result;
+}
+
+}  // namespace
+
+// Encodings from RFC 8949 Appendix A
+TEST(JsonCborTest, EncodesRfcExamples) {
+  EXPECT_EQ(JsonCbor::Encode(JsonValue(0)), Bytes({0x00}));
+  EXPECT_EQ(JsonCbor::Encode(JsonValue(23)), Bytes({0x17}));
+  EXPECT_EQ(JsonCbor::Encode(JsonValue(24)), Bytes({0x18, 0x18}));
+  EXPECT_EQ(JsonCbor::Encode(JsonValue(1000)), Bytes({0x19, 0x03, 0xe8}));
+  EXPECT_EQ(JsonCbor::Encode(JsonValue(-1000)), Bytes({0x39, 0x03, 0xe7}));
+  EXPECT_EQ(JsonCbor::Encode(JsonValue(1.1)),
+            Bytes({0xfb, 0x3f, 0xf1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a}));
+  EXPECT_EQ(JsonCbor::Encode(JsonValue(100000.5)),
+            Bytes({0xfa, 0x47, 0xc3, 0x50, 0x40}));
+  EXPECT_EQ(JsonCbor::Encode(JsonValue(-0.0)),
+            Bytes({0xfa, 0x80, 0x00, 0x00, 0x00}));
+  EXPECT_TRUE(std::signbit(
+      JsonCbor::Decode(JsonCbor::Encode(JsonValue(-0.0))).AsNumber()));
+  EXPECT_EQ(JsonCbor::Encode(JsonValue(false)), Bytes({0xf4}));
+  EXPECT_EQ(JsonCbor::Encode(JsonValue(nullptr)), Bytes({0xf6}));
+  EXPECT_EQ(JsonCbor::Encode(JsonValue("IETF")),
+            Bytes({0x64, 'I', 'E', 'T', 'F'}));
+  EXPECT_EQ(JsonCbor::Encode(JsonParser::Parse("[1, [2, 3]]")),
+            Bytes({0x82, 0x01, 0x82, 0x02, 0x03}));
+}
+
+TEST(JsonCborTest, DecodesRfcExamples) {
+  EXPECT_EQ(JsonCbor::Decode(Bytes({0xf9, 0x3c, 0x00})).AsNumber(), 1.0);
+  EXPECT_EQ(JsonCbor::Decode(Bytes({0xf9, 0xc4, 0x00})).AsNumber(), -4.0);
+  EXPECT_EQ(JsonCbor::Decode(Bytes({0xf9, 0x00, 0x01})).AsNumber(),
+            5.960464477539063e-8);
+  EXPECT_EQ(JsonCbor::Decode(Bytes({0x3b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                    0x00, 0x63}))
+                .AsNumber(),
+            -100);
+  // Indefinite array holding an indefinite chunked string
+  JsonValue value = JsonCbor::Decode(
+      Bytes({0x9f, 0x7f, 0x62, 's', 't', 0x61, 'r', 0xff, 0xf7, 0xff}));
+  ASSERT_EQ(value.AsArray().Size(), 2);
+  EXPECT_EQ(value.AsArray()[0].AsString(), "str");
+  EXPECT_TRUE(value.AsArray()[1].IsNull());  // undefined
+  // Tag 1 (epoch time) is dropped, byte strings become base64url
+  EXPECT_EQ(JsonCbor::Decode(Bytes({0xc1, 0x1a, 0x51, 0x4b, 0x67, 0xb0}))
+                .AsNumber(),
+            1363896240);
+  EXPECT_EQ(JsonCbor::Decode(Bytes({0x44, 0x01, 0x02, 0x03, 0xfb})).AsString(),
+            "AQID-w");
+}
+
+TEST(JsonCborTest, RoundTripsDocuments) {
+  JsonValue doc = JsonParser::Parse(R"({
+    "name": "sensor-7", "readings": [21.5, -3, 0.1, 1e300],
+    "ok": true, "meta": {"tags": [], "none": null}
+  })");
+  EXPECT_EQ(JsonCbor::Decode(JsonCbor::Encode(doc)), doc);
+}
+
+TEST(JsonCborTest, TranscodesJsonWithoutTree) {
+  std::string json =
+      R"({"id":9007199254740993,"v":[1.5,-2,"x\n",true,null],"e":{}})";
+  std::string cbor = JsonCbor::FromJson(json);
+  EXPECT_EQ(static_cast<uint8_t>(cbor[0]), 0xbf);  // Indefinite map
+  // 2^53 + 1 survives because integer literals are not routed via double
+  JsonCborReader reader(cbor);
+  std::string scratch;
+  EXPECT_EQ(reader.ReadMapHeader(), JsonCborReader::kIndefinite);
+  EXPECT_EQ(reader.ReadTextString(scratch), "id");
+  EXPECT_EQ(reader.ReadInt64(), 9007199254740993);
+
+  EXPECT_EQ(JsonCbor::ToJson(cbor), json);
+  EXPECT_EQ(JsonCbor::Decode(cbor), JsonParser::Parse(json));
+}
+
+TEST(JsonCborTest, ToJsonConversions) {
+  // {1: h'00', "k": -18446744073709551616}
+  std::string cbor = Bytes({0xa2, 0x01, 0x41, 0x00, 0x61, 'k', 0x3b, 0xff,
+                            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff});
+  EXPECT_EQ(JsonCbor::ToJson(cbor), R"({"1":"AA","k":-18446744073709551616})");
+}
+
+TEST(JsonCborTest, RejectsMalformedInput) {
+  EXPECT_THROW(JsonCbor::Decode(Bytes({0x1c})), JsonParseException);
+  EXPECT_THROW(JsonCbor::Decode(Bytes({0x62, 'a'})), JsonParseException);
+  EXPECT_THROW(JsonCbor::Decode(Bytes({0x9f, 0x01})), JsonParseException);
+  EXPECT_THROW(JsonCbor::Decode(Bytes({0x9b, 0xff, 0xff, 0xff, 0xff, 0xff,
+                                       0xff, 0xff, 0xff})),
+               JsonParseException);
+  EXPECT_THROW(JsonCbor::Decode(Bytes({0x7f, 0x41, 0x00, 0xff})),
+               JsonParseException);
+  EXPECT_THROW(JsonCbor::Decode(Bytes({0xff})), JsonTypeException);
+  EXPECT_THROW(JsonCbor::Decode(Bytes({0xa1, 0xf4, 0x01})), JsonTypeException);
+  EXPECT_THROW(JsonCbor::Decode(Bytes({0x01, 0x02})), JsonParseException);
+  EXPECT_THROW(JsonCbor::FromJson("[1,]"), JsonParseException);
+}
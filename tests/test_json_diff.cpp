@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+#include <random>
+#include <string>
+
+using namespace json_parser;
+
+namespace {
+
+JsonValue Json(const std::string& text) { return JsonParser::Parse(text); }
+
+// Diffs source against target and checks the patch reproduces target
+JsonPatch ExpectDiffApplies(const JsonValue& source, const JsonValue& target,
+                            const JsonDiffConfig& config = JsonDiffConfig()) {
+  JsonPatch patch = JsonDiff(source, target, config);
+  JsonValue patched = JsonUtils::DeepCopy(source);
+  patch.Apply(patched);
+  EXPECT_EQ(patched, target) << patch.ToJsonValue().ToCompactString();
+  return patch;
+}
+
+JsonValue RandomValue(std::mt19937& rng, int depth) {
+  const int kind = static_cast<int>(rng() % (depth > 0 ? 6 : 4));
+  switch (kind) {
+    case 0:
+      return JsonValue();
+    case 1:
+      return JsonValue(static_cast<int>(rng() % 4));
+    case 2:
+      return JsonValue(std::string(1, static_cast<char>('a' + rng() % 3)));
+    case 3:
+      return JsonValue(rng() % 2 == 0);
+    case 4: {
+      JsonValue object{JsonObject()};
+      for (int i = static_cast<int>(rng() % 4); i > 0; --i) {
+        object.AsObject().Insert(std::string(1, 'k' + rng() % 4),
+                                 RandomValue(rng, depth - 1));
+      }
+      return object;
+    }
+    default: {
+      JsonValue array{JsonArray()};
+      for (int i = static_cast<int>(rng() % 6); i > 0; --i) {
+        array.AsArray().PushBack(RandomValue(rng, depth - 1));
+      }
+      return array;
+    }
+  }
+}
+
+JsonValue Range(int begin, int end) {
+  JsonValue array{JsonArray()};
+  for (int i = begin; i < end; ++i) {
+    array.AsArray().PushBack(JsonValue(i));
+  }
+  return array;
+}
+
+}  // namespace
+
+TEST(JsonDiffTest, DiffsObjectsByMember) {
+  JsonPatch patch = ExpectDiffApplies(
+      Json(R"({"keep": 1, "gone": 2, "change": {"x": 1, "y": [1]}})"),
+      Json(R"({"keep": 1, "change": {"x": 2, "y": [1]}, "new/key": 3})"));
+  EXPECT_EQ(patch.ToJsonValue(), Json(R"([
+      {"op": "remove", "path": "/gone"},
+      {"op": "replace", "path": "/change/x", "value": 2},
+      {"op": "add", "path": "/new~1key", "value": 3}])"));
+
+  EXPECT_TRUE(JsonDiff(Json(R"({"a": [1, {"b": null}]})"),
+                       Json(R"({"a": [1, {"b": null}]})"))
+                  .Empty());
+  EXPECT_EQ(JsonDiff(Json("[1]"), Json(R"({"a": 1})")).ToJsonValue(),
+            Json(R"([{"op": "replace", "path": "", "value": {"a": 1}}])"));
+  EXPECT_EQ(JsonDiff(Json(R"({"a": 1})"), Json(R"({"a": "1"})")).Size(), 1u);
+}
+
+TEST(JsonDiffTest, AlignsArrayInsertionsAndRemovals) {
+  JsonValue source = Range(0, 1000);
+  JsonValue inserted = Range(0, 1000);
+  inserted.AsArray().Insert(500, JsonValue("new"));
+  EXPECT_EQ(ExpectDiffApplies(source, inserted).ToJsonValue(),
+            Json(R"([{"op": "add", "path": "/500", "value": "new"}])"));
+
+  JsonValue removed = Range(0, 1000);
+  removed.AsArray().Erase(10);
+  removed.AsArray().Erase(700);
+  EXPECT_EQ(ExpectDiffApplies(source, removed).ToJsonValue(),
+            Json(R"([{"op": "remove", "path": "/10"},
+                     {"op": "remove", "path": "/700"}])"));
+
+  // Changed elements are diffed in place, not removed and re-added
+  EXPECT_EQ(ExpectDiffApplies(Json(R"([1, {"a": 1, "b": 2}, 3])"),
+                              Json(R"([1, {"a": 1, "b": 5}, 3])"))
+                .ToJsonValue(),
+            Json(R"([{"op": "replace", "path": "/1/b", "value": 5}])"));
+  ExpectDiffApplies(Json("[1, 2, 3, 4, 5]"), Json("[5, 4, 3, 2, 1]"));
+  ExpectDiffApplies(Json("[1, 1, 2, 2]"), Json("[2, 1, 2, 1, 1]"));
+  ExpectDiffApplies(Json("[]"), Json("[1, [2]]"));
+  ExpectDiffApplies(Json("[1, [2]]"), Json("[]"));
+}
+
+TEST(JsonDiffTest, AnchorsLargeArraysOnUniqueElements) {
+  JsonDiffConfig config;
+  config.max_lcs_cells = 64;
+  JsonValue source = Range(0, 200);
+  JsonValue target{JsonArray()};
+  for (int i = 0; i < 200; ++i) {
+    if (i % 50 == 25) {
+      target.AsArray().PushBack(JsonValue("inserted"));
+    }
+    if (i % 40 != 7) {
+      target.AsArray().PushBack(JsonValue(i));
+    }
+  }
+  JsonPatch patch = ExpectDiffApplies(source, target, config);
+  EXPECT_EQ(patch.Size(), 9u);  // 5 removals and 4 insertions
+
+  // With nothing unique to anchor on it still produces a valid patch
+  ExpectDiffApplies(Json("[1, 1, 1, 2, 2, 2, 3, 3, 3, 1, 1]"),
+                    Json("[2, 2, 1, 1, 3, 3, 3, 2, 1]"), config);
+}
+
+TEST(JsonDiffTest, SkipsSharedSubtrees) {
+  JsonValue source{JsonObject()};
+  JsonValue items = Range(0, 100);
+  for (int i = 0; i < 50; ++i) {
+    source.AsObject().Insert("doc" + std::to_string(i), items);
+  }
+  // Copies share the members' containers with source
+  JsonValue target{JsonObject()};
+  for (auto it = source.AsObject().Begin(); it != source.AsObject().End();
+       ++it) {
+    target.AsObject().Insert(it->first, it->second);
+  }
+  JsonValue changed = Range(0, 100);
+  changed.AsArray()[42] = JsonValue("x");
+  target.AsObject().Insert("doc7", changed);
+
+  EXPECT_EQ(ExpectDiffApplies(source, target).ToJsonValue(),
+            Json(R"([{"op": "replace", "path": "/doc7/42", "value": "x"}])"));
+}
+
+TEST(JsonDiffTest, SkipsUnchangedUnsharedSubtrees) {
+  JsonValue large{JsonArray()};
+  for (int i = 0; i < 500; ++i) {
+    JsonValue row{JsonObject()};
+    row.AsObject().Insert("id", JsonValue(i));
+    row.AsObject().Insert("values", Range(i, i + 10));
+    large.AsArray().PushBack(row);
+  }
+  JsonValue source{JsonObject()};
+  source.AsObject().Insert("large", large);
+  source.AsObject().Insert("rows", large);
+  source.AsObject().Insert("version", JsonValue(1));
+
+  // Deep copies share nothing with source, so only hashes can skip them
+  JsonValue target = JsonUtils::DeepCopy(source);
+  target.AsObject()["version"] = JsonValue(2);
+  target.AsObject()["rows"].AsArray().Insert(250, JsonValue("new"));
+  ASSERT_NE(&target.AsObject().At("large").AsArray(),
+            &source.AsObject().At("large").AsArray());
+
+  EXPECT_EQ(ExpectDiffApplies(source, target).ToJsonValue(),
+            Json(R"([{"op": "add", "path": "/rows/250", "value": "new"},)"
+                 R"( {"op": "replace", "path": "/version", "value": 2}])"));
+  EXPECT_TRUE(JsonDiff(source, JsonUtils::DeepCopy(source)).Empty());
+}
+
+TEST(JsonDiffTest, RandomDocumentsRoundTrip) {
+  std::mt19937 rng(47);
+  JsonDiffConfig small;
+  small.max_lcs_cells = 8;
+  for (int i = 0; i < 300; ++i) {
+    const JsonValue source = RandomValue(rng, 4);
+    const JsonValue target = RandomValue(rng, 4);
+    ExpectDiffApplies(source, target);
+    ExpectDiffApplies(source, target, small);
+    EXPECT_TRUE(JsonDiff(source, JsonUtils::DeepCopy(source)).Empty());
+  }
+}
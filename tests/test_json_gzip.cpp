@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace json_parser;
+
+#if defined(JSON_PARSER_HAVE_ZLIB)
+
+namespace {
+
+JsonValue LargeDocument() {
+  JsonValue rows{JsonArray()};
+  for (int i = 0; i < 5000; ++i) {
+    JsonValue row{JsonObject()};
+    row.AsObject().Insert("id", JsonValue(i));
+    row.AsObject().Insert("name", JsonValue("row " + std::to_string(i)));
+    rows.AsArray().PushBack(std::move(row));
+  }
+  return rows;
+}
+
+std::string ReadBytes(const std::string& filename) {
+  std::ifstream file(filename, std::ios::binary);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+}  // namespace
+
+TEST(JsonGzipTest, WriteToFileAndParseFileRoundTrip) {
+  const std::string filename = "json_gzip_test.json.gz";
+  JsonValue doc = LargeDocument();
+  JsonWriter writer(JsonWriterConfig::Compact());
+  writer.WriteToFile(filename, doc);
+
+  EXPECT_TRUE(JsonGzip::IsGzipFile(filename));
+  std::string compressed = ReadBytes(filename);
+  EXPECT_LT(compressed.size(), writer.Write(doc).size() / 2);
+  EXPECT_EQ(JsonParser::ParseFile(filename), doc);
+  std::remove(filename.c_str());
+}
+
+TEST(JsonGzipTest, StreamsArrayElements) {
+  const std::string filename = "json_gzip_stream_test.json.gz";
+  JsonWriter(JsonWriterConfig::Pretty()).WriteToFile(filename, LargeDocument());
+
+  JsonArrayStream stream(filename, JsonParserConfig::Strict(), 4096);
+  JsonValue element;
+  size_t count = 0;
+  while (stream.Next(element)) {
+    EXPECT_EQ(element.AsObject()["id"].AsNumber(), count);
+    ++count;
+  }
+  EXPECT_EQ(count, 5000);
+  std::remove(filename.c_str());
+}
+
+TEST(JsonGzipTest, SmallBuffersPreserveBytes) {
+  const std::string filename = "json_gzip_bytes_test.gz";
+  std::string text;
+  for (int i = 0; i < 10000; ++i) {
+    text += static_cast<char>(i * 31 % 251);
+  }
+  {
+    JsonGzipOutputStream out(filename, 9, 17);
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    out.Close();
+  }
+  JsonGzipInputStream in(filename, 13);
+  std::stringstream contents;
+  contents << in.rdbuf();
+  EXPECT_EQ(contents.str(), text);
+  std::remove(filename.c_str());
+}
+
+TEST(JsonGzipTest, PlainFilesAreNotDecompressed) {
+  const std::string filename = "json_gzip_plain_test.json";
+  JsonWriter().WriteToFile(filename, JsonParser::Parse(R"({"a": [1, 2]})"));
+  EXPECT_FALSE(JsonGzip::IsGzipFile(filename));
+  EXPECT_EQ(ReadBytes(filename)[0], '{');
+  EXPECT_EQ(JsonParser::ParseFile(filename).AsObject()["a"].AsArray().Size(),
+            2);
+  std::remove(filename.c_str());
+}
+
+TEST(JsonGzipTest, TruncatedInputThrows) {
+  const std::string filename = "json_gzip_truncated_test.json.gz";
+  JsonWriter(JsonWriterConfig::Compact()).WriteToFile(filename, LargeDocument());
+  std::string compressed = ReadBytes(filename);
+  {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file.write(compressed.data(),
+               static_cast<std::streamsize>(compressed.size() / 2));
+  }
+  EXPECT_THROW(JsonParser::ParseFile(filename), JsonException);
+  std::remove(filename.c_str());
+
+  EXPECT_THROW(JsonGzipInputStream("no_such_file.json.gz"), JsonFileException);
+}
+
+#else
+
+TEST(JsonGzipTest, UnavailableWithoutZlib) {
+  EXPECT_FALSE(JsonGzip::Available());
+  EXPECT_THROW(JsonGzipOutputStream("json_gzip_test.json.gz"), JsonException);
+}
+
+#endif  // JSON_PARSER_HAVE_ZLIB
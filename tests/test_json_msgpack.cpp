@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+#include <cmath>
+#include <sstream>
+
+using namespace json_parser;
+
+namespace {
+
+std::string Bytes(std::initializer_list<int> bytes) {
+  std::string result;
+  for (int b : bytes) {
+    result += static_cast<char>(b);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(JsonMsgPackTest, EncodesCompactForms) {
+  EXPECT_EQ(JsonMsgPack::Encode(JsonValue(nullptr)), Bytes({0xc0}));
+  EXPECT_EQ(JsonMsgPack::Encode(JsonValue(true)), Bytes({0xc3}));
+  EXPECT_EQ(JsonMsgPack::Encode(JsonValue(5)), Bytes({0x05}));
+  EXPECT_EQ(JsonMsgPack::Encode(JsonValue(-3)), Bytes({0xfd}));
+  EXPECT_EQ(JsonMsgPack::Encode(JsonValue(200)), Bytes({0xcc, 0xc8}));
+  EXPECT_EQ(JsonMsgPack::Encode(JsonValue(-200)), Bytes({0xd1, 0xff, 0x38}));
+  EXPECT_EQ(JsonMsgPack::Encode(JsonValue(1.5)),
+            Bytes({0xca, 0x3f, 0xc0, 0x00, 0x00}));
+  EXPECT_EQ(JsonMsgPack::Encode(JsonValue(0.1)).size(), 9);
+  EXPECT_EQ(JsonMsgPack::Encode(JsonValue(-0.0)),
+            Bytes({0xca, 0x80, 0x00, 0x00, 0x00}));
+  EXPECT_TRUE(std::signbit(
+      JsonMsgPack::Decode(JsonMsgPack::Encode(JsonValue(-0.0))).AsNumber()));
+  EXPECT_EQ(JsonMsgPack::Encode(JsonValue("ab")), Bytes({0xa2, 'a', 'b'}));
+  EXPECT_EQ(JsonMsgPack::Encode(JsonValue(std::string(40, 'x'))).substr(0, 2),
+            Bytes({0xd9, 40}));
+  EXPECT_EQ(JsonMsgPack::Encode(JsonParser::Parse("[1, [], {}]")),
+            Bytes({0x93, 0x01, 0x90, 0x80}));
+}
+
+TEST(JsonMsgPackTest, RoundTripsDocuments) {
+  JsonValue doc = JsonParser::Parse(R"({
+    "name": "café", "n": -123456789012, "big": 18446744073709550000,
+    "pi": 3.141592653589793, "flags": [true, false, null],
+    "nested": {"list": [1, 2, {"deep": "x"}], "empty": ""}
+  })");
+  EXPECT_EQ(JsonMsgPack::Decode(JsonMsgPack::Encode(doc)), doc);
+
+  JsonArray large;
+  for (int i = 0; i < 70000; ++i) {
+    large.PushBack(JsonValue(i));
+  }
+  JsonValue value(large);
+  std::string encoded = JsonMsgPack::Encode(value);
+  EXPECT_EQ(static_cast<uint8_t>(encoded[0]), 0xdd);
+  EXPECT_EQ(JsonMsgPack::Decode(encoded), value);
+}
+
+TEST(JsonMsgPackTest, EncodesDecodedEscapes) {
+  // \u escapes are decoded to UTF-8 before encoding
+  JsonValue doc = JsonParser::Parse(R"(["caf\u00e9", "\ud83d\ude00"])");
+  std::string encoded = JsonMsgPack::Encode(doc);
+  EXPECT_EQ(encoded.substr(1, 6), Bytes({0xa5, 'c', 'a', 'f', 0xc3, 0xa9}));
+  EXPECT_EQ(JsonMsgPack::Decode(encoded), doc);
+}
+
+TEST(JsonMsgPackTest, StreamingWriterToSink) {
+  std::ostringstream sink;
+  {
+    JsonOutputBuffer out(sink, 8);
+    JsonMsgPackWriter writer(out);
+    writer.BeginMap(2);
+    writer.WriteString("id");
+    writer.WriteInt(-40000);
+    writer.WriteString("blob");
+    writer.WriteBinary("\x00\x01\x02", 3);
+  }
+  std::string data = sink.str();
+
+  JsonMsgPackReader reader(data);
+  EXPECT_EQ(reader.ReadMapHeader(), 2);
+  EXPECT_EQ(reader.ReadString(), "id");
+  EXPECT_EQ(reader.ReadInt64(), -40000);
+  std::string_view key = reader.ReadString();
+  EXPECT_EQ(key, "blob");
+  // Views point into the input rather than copies
+  EXPECT_GE(key.data(), data.data());
+  EXPECT_LT(key.data(), data.data() + data.size());
+  EXPECT_EQ(reader.PeekType(), JsonMsgPackType::kBinary);
+  EXPECT_EQ(reader.ReadBinary(), std::string_view("\x00\x01\x02", 3));
+  EXPECT_TRUE(reader.AtEnd());
+}
+
+TEST(JsonMsgPackTest, ReaderSkipsAndChecksTypes) {
+  std::string data = Bytes({0x92, 0x81, 0xa1, 'k', 0xd4, 0x01, 0x02, 0xcf,
+                            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff});
+  JsonMsgPackReader reader(data);
+  EXPECT_EQ(reader.ReadArrayHeader(), 2);
+  reader.Skip();
+  EXPECT_THROW(reader.ReadInt64(), JsonTypeException);
+  EXPECT_EQ(reader.ReadUInt64(), UINT64_MAX);
+  EXPECT_TRUE(reader.AtEnd());
+}
+
+TEST(JsonMsgPackTest, RejectsMalformedInput) {
+  EXPECT_THROW(JsonMsgPack::Decode(Bytes({0xc1})), JsonParseException);
+  EXPECT_THROW(JsonMsgPack::Decode(Bytes({0xa5, 'a'})), JsonParseException);
+  EXPECT_THROW(JsonMsgPack::Decode(Bytes({0xdd, 0xff, 0xff, 0xff, 0xff})),
+               JsonParseException);
+  EXPECT_THROW(JsonMsgPack::Decode(Bytes({0x01, 0x02})), JsonParseException);
+  EXPECT_THROW(JsonMsgPack::Decode(Bytes({0x81, 0x01, 0x02})),
+               JsonTypeException);
+  EXPECT_THROW(JsonMsgPack::Decode(Bytes({0xd4, 0x01, 0x02})),
+               JsonTypeException);
+  EXPECT_THROW(JsonMsgPack::Decode(""), JsonParseException);
+}
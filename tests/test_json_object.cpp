@@ -78,3 +78,34 @@ TEST_F(JsonObjectTest, EmptyObject) {
   EXPECT_EQ(empty.ToString(), "{}");
 }
 
+
+TEST_F(JsonObjectTest, Find) {
+  JsonObject obj;
+  obj.Insert("key", JsonValue("value"));
+  ASSERT_NE(obj.Find("key"), nullptr);
+  EXPECT_EQ(obj.Find("key")->AsString(), "value");
+  EXPECT_EQ(obj.Find("missing"), nullptr);
+}
+
+TEST_F(JsonObjectTest, ToStringEscapesKeys) {
+  JsonObject obj;
+  obj.Insert("say \"hi\"\n", JsonValue(1));
+  EXPECT_EQ(obj.ToCompactString(), "{\"say \\\"hi\\\"\\n\":1}");
+  EXPECT_EQ(obj.ToString(), "{\n  \"say \\\"hi\\\"\\n\": 1\n}");
+  // The output parses back to the same key
+  EXPECT_EQ(JsonParser::Parse(obj.ToString()).AsObject(), obj);
+}
+
+TEST_F(JsonObjectTest, HashSeesChangesThroughIterators) {
+  JsonValue value = JsonParser::Parse(R"({"a": 1, "b": 2})");
+  const uint64_t hash = value.Hash();
+  for (auto it = value.AsObject().Begin(); it != value.AsObject().End();
+       ++it) {
+    it->second = JsonValue(it->second.AsNumber() * 10);
+  }
+  EXPECT_NE(value.Hash(), hash);
+  EXPECT_EQ(value.Hash(), JsonParser::Parse(R"({"b": 20, "a": 10})").Hash());
+
+  value.AsObject().Clear();
+  EXPECT_EQ(value.Hash(), JsonValue{JsonObject()}.Hash());
+}
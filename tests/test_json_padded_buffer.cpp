@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace json_parser;
+
+class PaddedJsonBufferTest : public ::testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(PaddedJsonBufferTest, CopiesAndPads) {
+  std::string json = R"({"key": "value"})";
+  PaddedJsonBuffer buffer(json);
+  EXPECT_TRUE(buffer.OwnsData());
+  EXPECT_EQ(buffer.Size(), json.size());
+  EXPECT_EQ(std::string(buffer.Data(), buffer.Size()), json);
+  for (size_t i = 0; i < PaddedJsonBuffer::kPadding; ++i) {
+    EXPECT_EQ(buffer.Data()[buffer.Size() + i], '\0');
+  }
+}
+
+TEST_F(PaddedJsonBufferTest, ParseFromBuffer) {
+  PaddedJsonBuffer buffer(std::string(R"({"name": "John", "tags": [1, 2]})"));
+  JsonValue value = JsonParser::Parse(buffer);
+  EXPECT_EQ(value.AsObject()["name"].AsString(), "John");
+  EXPECT_EQ(value.AsObject()["tags"].AsArray().Size(), 2);
+}
+
+TEST_F(PaddedJsonBufferTest, ParseFromView) {
+  std::string json = R"(["a long string that spans several vector loads", 7])";
+  std::vector<char> network(json.size() + PaddedJsonBuffer::kPadding, '\0');
+  std::memcpy(network.data(), json.data(), json.size());
+  PaddedJsonBuffer view = PaddedJsonBuffer::View(network.data(), json.size());
+  EXPECT_FALSE(view.OwnsData());
+
+  JsonValue value = JsonParser::Parse(view);
+  EXPECT_EQ(value.AsArray()[0].AsString(),
+            "a long string that spans several vector loads");
+  EXPECT_EQ(value.AsArray()[1].AsNumber(), 7);
+}
+
+TEST_F(PaddedJsonBufferTest, MoveLeavesSourceEmpty) {
+  PaddedJsonBuffer source(std::string("[1]"));
+  PaddedJsonBuffer target(std::move(source));
+  EXPECT_EQ(target.Size(), 3);
+  EXPECT_TRUE(source.Empty());
+  EXPECT_EQ(source.Data()[0], '\0');
+}
+
+TEST_F(PaddedJsonBufferTest, TruncatedInputThrows) {
+  EXPECT_THROW(JsonParser::Parse(PaddedJsonBuffer(std::string(R"("abc)"))),
+               JsonParseException);
+  EXPECT_THROW(JsonParser::Parse(PaddedJsonBuffer(std::string("tru"))),
+               JsonParseException);
+  EXPECT_THROW(JsonParser::Parse(PaddedJsonBuffer(std::string("[1, "))),
+               JsonParseException);
+}
+
+TEST_F(PaddedJsonBufferTest, TopLevelNumber) {
+  EXPECT_DOUBLE_EQ(JsonParser::Parse("42").AsNumber(), 42);
+  EXPECT_DOUBLE_EQ(JsonParser::Parse("-1.5e2").AsNumber(), -150);
+}
@@ -101,3 +101,34 @@ TEST_F(JsonParserTest, ParseWithConfig) {
   EXPECT_TRUE(value.IsObject());
 }
 
+
+TEST_F(JsonParserTest, ParseUnicodeEscapes) {
+  JsonValue value = JsonParser::Parse(R"(["A\u00e9\u20AC", "\ud83d\ude00", "\u0001"])");
+  EXPECT_EQ(value.AsArray()[0].AsString(), "A\xc3\xa9\xe2\x82\xac");
+  EXPECT_EQ(value.AsArray()[1].AsString(), "\xf0\x9f\x98\x80");
+  EXPECT_EQ(value.AsArray()[2].AsString(), std::string("\x01", 1));
+  EXPECT_THROW(JsonParser::Parse(R"("\u12g4")"), JsonParseException);
+  EXPECT_THROW(JsonParser::Parse(R"("\ud83d\u0041")"), JsonParseException);
+}
+
+TEST_F(JsonParserTest, InternsRepeatedSubtrees) {
+  const std::string json = R"([
+      {"price": {"currency": "USD", "unit": "cents"}, "tags": []},
+      {"price": {"unit": "cents", "currency": "USD"}, "tags": []},
+      {"price": {"currency": "EUR", "unit": "cents"}, "tags": [1]}])";
+  JsonParserConfig config;
+  config.intern_subtrees = true;
+  JsonValue value = JsonParser::Parse(json, config);
+  EXPECT_EQ(value, JsonParser::Parse(json));
+
+  const JsonArray& items = value.AsArray();
+  EXPECT_EQ(&items[0].AsObject(), &items[1].AsObject());
+  EXPECT_NE(&items[0].AsObject()["price"].AsObject(),
+            &items[2].AsObject()["price"].AsObject());
+  EXPECT_NE(&items[0].AsObject()["tags"].AsArray(),
+            &items[2].AsObject()["tags"].AsArray());
+
+  // Without the option every container is separate
+  JsonValue plain = JsonParser::Parse(json);
+  EXPECT_NE(&plain.AsArray()[0].AsObject(), &plain.AsArray()[1].AsObject());
+}
@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+#include <string>
+#include <vector>
+
+using namespace json_parser;
+
+namespace {
+
+JsonValue Json(const std::string& text) { return JsonParser::Parse(text); }
+
+void ExpectPatched(const std::string& document, const std::string& patch,
+                   const std::string& expected) {
+  JsonValue value = Json(document);
+  JsonPatch::Compile(patch).Apply(value);
+  EXPECT_EQ(value, Json(expected)) << patch;
+}
+
+}  // namespace
+
+TEST(JsonPatchTest, AppliesRfc6902Examples) {
+  ExpectPatched(R"({"foo": "bar"})",
+                R"([{"op": "add", "path": "/baz", "value": "qux"}])",
+                R"({"baz": "qux", "foo": "bar"})");
+  ExpectPatched(R"({"foo": ["bar", "baz"]})",
+                R"([{"op": "add", "path": "/foo/1", "value": "qux"}])",
+                R"({"foo": ["bar", "qux", "baz"]})");
+  ExpectPatched(R"({"baz": "qux", "foo": "bar"})",
+                R"([{"op": "remove", "path": "/baz"}])",
+                R"({"foo": "bar"})");
+  ExpectPatched(R"({"foo": ["bar", "qux", "baz"]})",
+                R"([{"op": "remove", "path": "/foo/1"}])",
+                R"({"foo": ["bar", "baz"]})");
+  ExpectPatched(R"({"baz": "qux", "foo": "bar"})",
+                R"([{"op": "replace", "path": "/baz", "value": "boo"}])",
+                R"({"baz": "boo", "foo": "bar"})");
+  ExpectPatched(
+      R"({"foo": {"bar": "baz", "waldo": "fred"}, "qux": {"corge": "grault"}})",
+      R"([{"op": "move", "from": "/foo/waldo", "path": "/qux/thud"}])",
+      R"({"foo": {"bar": "baz"}, "qux": {"corge": "grault", "thud": "fred"}})");
+  ExpectPatched(R"({"foo": ["all", "grass", "cows", "eat"]})",
+                R"([{"op": "move", "from": "/foo/1", "path": "/foo/3"}])",
+                R"({"foo": ["all", "cows", "eat", "grass"]})");
+  ExpectPatched(R"({"foo": ["bar"]})",
+                R"([{"op": "add", "path": "/foo/-", "value": ["abc", "def"]}])",
+                R"({"foo": ["bar", ["abc", "def"]]})");
+  ExpectPatched(R"({"a/b": {"m~n": 1}})",
+                R"([{"op": "copy", "from": "/a~1b/m~0n", "path": "/c"},
+                    {"op": "test", "path": "/c", "value": 1}])",
+                R"({"a/b": {"m~n": 1}, "c": 1})");
+  ExpectPatched(R"({"foo": 1})",
+                R"([{"op": "replace", "path": "", "value": [1, 2]}])",
+                R"([1, 2])");
+}
+
+TEST(JsonPatchTest, FailedPatchLeavesDocumentUnchanged) {
+  const std::string original =
+      R"({"list": [1, 2, 3], "obj": {"a": {"deep": true}}, "n": 5})";
+  JsonValue document = Json(original);
+  JsonPatch patch;
+  patch.Remove("/list/0")
+      .Add("/list/-", JsonValue(9))
+      .Move("/obj/a", "/moved")
+      .Replace("/n", JsonValue("six"))
+      .Copy("/moved", "/obj/copy")
+      .Move("/list", "")
+      .Test("/0", JsonValue(100));
+
+  EXPECT_THROW(patch.Apply(document), JsonPatchException);
+  EXPECT_EQ(document, Json(original));
+
+  // The same patch without the failing test goes through
+  JsonPatch good;
+  good.Remove("/list/0").Add("/list/-", JsonValue(9)).Move("/obj/a", "/moved");
+  good.Apply(document);
+  EXPECT_EQ(document, Json(R"({"list": [2, 3, 9], "obj": {}, "n": 5,
+                               "moved": {"deep": true}})"));
+}
+
+TEST(JsonPatchTest, FailedMoveLeavesDocumentUnchanged) {
+  const std::string original = R"({"a": {"k": 1}, "arr": [1], "s": 2})";
+  const char* const destinations[] = {"/missing/x", "/arr/7", "/s/x"};
+  for (const char* destination : destinations) {
+    JsonValue document = Json(original);
+    JsonPatch patch;
+    patch.Move("/a", destination);
+    EXPECT_THROW(patch.Apply(document), JsonPatchException) << destination;
+    EXPECT_EQ(document, Json(original)) << destination;
+  }
+
+  // A move onto its own path still needs from to exist
+  JsonValue document = Json(original);
+  JsonPatch self;
+  self.Move("/nope", "/nope");
+  EXPECT_THROW(self.Apply(document), JsonPatchException);
+  EXPECT_EQ(document, Json(original));
+}
+
+TEST(JsonPatchTest, ReportsInvalidOperations) {
+  JsonValue document = Json(R"({"a": [1], "s": "x"})");
+  auto fails = [&](const std::string& patch) {
+    EXPECT_THROW(JsonPatch::Compile(patch).Apply(document),
+                 JsonPatchException)
+        << patch;
+  };
+  fails(R"([{"op": "remove", "path": "/missing"}])");
+  fails(R"([{"op": "add", "path": "/a/5", "value": 0}])");
+  fails(R"([{"op": "add", "path": "/a/01", "value": 0}])");
+  fails(R"([{"op": "replace", "path": "/a/1", "value": 0}])");
+  fails(R"([{"op": "add", "path": "/s/x", "value": 0}])");
+  fails(R"([{"op": "add", "path": "/x/y", "value": 0}])");
+  fails(R"([{"op": "test", "path": "/s", "value": "y"}])");
+  fails(R"([{"op": "remove", "path": ""}])");
+  fails(R"([{"op": "move", "from": "/a", "path": "/a/0"}])");
+  fails(R"([{"op": "jump", "path": "/a"}])");
+  fails(R"([{"op": "add", "path": "/a"}])");
+  fails(R"([{"op": "add", "path": "a", "value": 1}])");
+  fails(R"([{"op": "add", "path": "/~2", "value": 1}])");
+  fails(R"({"op": "add"})");
+  EXPECT_EQ(document, Json(R"({"a": [1], "s": "x"})"));
+}
+
+TEST(JsonPatchTest, RvaluePatchMovesValuesIn) {
+  JsonValue document = Json(R"({"items": []})");
+  JsonPatch patch;
+  patch.Add("/items/-", Json(R"({"id": 1})"));
+
+  JsonPatch copy = patch;
+  copy.Apply(document);
+  // The lvalue form deep-copies, so the document does not alias the patch
+  document.AsObject()["items"].AsArray()[0].AsObject()["id"] = JsonValue(2);
+  EXPECT_EQ(copy.Operations()[0].value, Json(R"({"id": 1})"));
+
+  std::move(patch).Apply(document);
+  EXPECT_EQ(document, Json(R"({"items": [{"id": 2}, {"id": 1}]})"));
+  EXPECT_TRUE(patch.Operations()[0].value.IsNull());
+}
+
+TEST(JsonPatchTest, AppliesBatchesAtomically) {
+  JsonValue document = Json(R"({"state": {"a": 0, "b": 0}, "log": []})");
+  std::vector<JsonPatch> batch(3);
+  batch[0].Replace("/state/a", JsonValue(1)).Add("/log/-", JsonValue("a"));
+  batch[1].Replace("/state/b", JsonValue(2)).Add("/log/-", JsonValue("b"));
+  batch[2].Test("/state/a", JsonValue(1)).Remove("/log/0");
+  JsonPatch::ApplyBatch(document, batch);
+  EXPECT_EQ(document,
+            Json(R"({"state": {"a": 1, "b": 2}, "log": ["b"]})"));
+
+  batch[2].Test("/state/a", JsonValue(7));
+  EXPECT_THROW(JsonPatch::ApplyBatch(document, batch), JsonPatchException);
+  EXPECT_EQ(document,
+            Json(R"({"state": {"a": 1, "b": 2}, "log": ["b"]})"));
+}
+
+TEST(JsonPatchTest, RoundTripsThroughJson) {
+  JsonPatch patch;
+  patch.Add("/a~1b", JsonValue(1)).Move("/x", "/y").Test("/a~1b", JsonValue(1));
+  JsonPatch again = JsonPatch::Compile(patch.ToJsonValue());
+  ASSERT_EQ(again.Size(), 3u);
+  EXPECT_EQ(again.ToJsonValue(), patch.ToJsonValue());
+  EXPECT_EQ(again.Operations()[0].path_tokens,
+            std::vector<std::string>{"a/b"});
+  EXPECT_EQ(JsonPatch::EscapeToken("a/~b"), "a~1~0b");
+  EXPECT_EQ(JsonPatch::ParsePointer("/a~1~0b//"),
+            (std::vector<std::string>{"a/~b", "", ""}));
+}
+
+TEST(JsonPatchTest, AppliesRfc7396MergePatches) {
+  struct Case {
+    const char* target;
+    const char* patch;
+    const char* result;
+  };
+  const Case cases[] = {
+      {R"({"a":"b"})", R"({"a":"c"})", R"({"a":"c"})"},
+      {R"({"a":"b"})", R"({"b":"c"})", R"({"a":"b","b":"c"})"},
+      {R"({"a":"b"})", R"({"a":null})", R"({})"},
+      {R"({"a":"b","b":"c"})", R"({"a":null})", R"({"b":"c"})"},
+      {R"({"a":["b"]})", R"({"a":"c"})", R"({"a":"c"})"},
+      {R"({"a":"c"})", R"({"a":["b"]})", R"({"a":["b"]})"},
+      {R"({"a":{"b":"c"}})", R"({"a":{"b":"d","c":null}})",
+       R"({"a":{"b":"d"}})"},
+      {R"({"a":[{"b":"c"}]})", R"({"a":[1]})", R"({"a":[1]})"},
+      {R"(["a","b"])", R"(["c","d"])", R"(["c","d"])"},
+      {R"({"a":"b"})", R"(["c"])", R"(["c"])"},
+      {R"({"e":null})", R"({"a":1})", R"({"e":null,"a":1})"},
+      {R"([1,2])", R"({"a":"b","c":null})", R"({"a":"b"})"},
+      {R"({})", R"({"a":{"bb":{"ccc":null}}})", R"({"a":{"bb":{}}})"},
+  };
+  for (const Case& c : cases) {
+    JsonValue target = Json(c.target);
+    const JsonValue patch = Json(c.patch);
+    JsonPatch::ApplyMergePatch(target, patch);
+    EXPECT_EQ(target, Json(c.result)) << c.patch;
+    EXPECT_EQ(patch, Json(c.patch));
+
+    JsonValue moved_into = Json(c.target);
+    JsonPatch::ApplyMergePatch(moved_into, Json(c.patch));
+    EXPECT_EQ(moved_into, Json(c.result)) << c.patch;
+  }
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+using namespace json_parser;
+
+class JsonPathTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    json_ = R"({
+      "store": {
+        "name": "corner \"shop\"",
+        "books": [
+          {"title": "A", "price": 10, "tags": ["x", "]"]},
+          {"title": "B", "price": 20},
+          {"title": "C", "price": 30},
+          {"title": "D", "price": 40}
+        ]
+      },
+      "a/b": {"m~n": true},
+      "skipped": {"deep": [[[{"x": "}"}]]]}
+    })";
+  }
+  void TearDown() override {}
+
+  std::string json_;
+};
+
+TEST_F(JsonPathTest, CompileSyntaxes) {
+  JsonPath dotted = JsonPath::Compile("store.books[0].title");
+  ASSERT_EQ(dotted.Segments().size(), 4);
+  EXPECT_EQ(dotted.Segments()[2].type, JsonPathSegment::Type::kIndex);
+
+  JsonPath jsonpath = JsonPath::Compile("$['store'].books[1:3].*");
+  ASSERT_EQ(jsonpath.Segments().size(), 4);
+  EXPECT_EQ(jsonpath.Segments()[0].key, "store");
+  EXPECT_EQ(jsonpath.Segments()[2].type, JsonPathSegment::Type::kSlice);
+  EXPECT_EQ(jsonpath.Segments()[3].type, JsonPathSegment::Type::kWildcard);
+
+  JsonPath pointer = JsonPath::Compile("/a~1b/m~0n");
+  ASSERT_EQ(pointer.Segments().size(), 2);
+  EXPECT_EQ(pointer.Segments()[0].key, "a/b");
+  EXPECT_EQ(pointer.Segments()[1].key, "m~n");
+
+  EXPECT_TRUE(JsonPath::Compile("$").IsRoot());
+}
+
+TEST_F(JsonPathTest, CompileRejectsMalformed) {
+  EXPECT_THROW(JsonPath::Compile("$.a[1"), JsonPathException);
+  EXPECT_THROW(JsonPath::Compile("$.a[x]"), JsonPathException);
+  EXPECT_THROW(JsonPath::Compile("$..a"), JsonPathException);
+  EXPECT_THROW(JsonPath::Compile("$.a[::0]"), JsonPathException);
+  EXPECT_THROW(JsonPath::Compile("/a~2"), JsonPathException);
+}
+
+TEST_F(JsonPathTest, SelectKeyAndIndex) {
+  std::vector<JsonValue> result =
+      JsonPath::Compile("$.store.books[2].title").Select(json_);
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_EQ(result[0].AsString(), "C");
+
+  result = JsonPath::Compile("store.name").Select(json_);
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_EQ(result[0].AsString(), "corner \"shop\"");
+
+  result = JsonPath::Compile("/a~1b/m~0n").Select(json_);
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_TRUE(result[0].AsBoolean());
+}
+
+TEST_F(JsonPathTest, SelectWildcardAndSlice) {
+  std::vector<JsonValue> prices =
+      JsonPath::Compile("$.store.books[*].price").Select(json_);
+  ASSERT_EQ(prices.size(), 4);
+  EXPECT_EQ(prices[3].AsNumber(), 40);
+
+  std::vector<JsonValue> titles =
+      JsonPath::Compile("$.store.books[1:4:2].title").Select(json_);
+  ASSERT_EQ(titles.size(), 2);
+  EXPECT_EQ(titles[0].AsString(), "B");
+  EXPECT_EQ(titles[1].AsString(), "D");
+
+  std::vector<JsonValue> last =
+      JsonPath::Compile("$.store.books[-1].title").Select(json_);
+  ASSERT_EQ(last.size(), 1);
+  EXPECT_EQ(last[0].AsString(), "D");
+
+  std::vector<JsonValue> tail =
+      JsonPath::Compile("$.store.books[-2:].price").Select(json_);
+  ASSERT_EQ(tail.size(), 2);
+  EXPECT_EQ(tail[0].AsNumber(), 30);
+}
+
+TEST_F(JsonPathTest, SelectMaterializesSubtree) {
+  std::vector<JsonValue> result =
+      JsonPath::Compile("$.store.books[0]").Select(json_);
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_EQ(result[0].AsObject()["tags"].AsArray()[1].AsString(), "]");
+}
+
+TEST_F(JsonPathTest, SelectNoMatch) {
+  EXPECT_TRUE(JsonPath::Compile("$.missing.key").Select(json_).empty());
+  EXPECT_TRUE(JsonPath::Compile("$.store.books[9]").Select(json_).empty());
+  EXPECT_TRUE(JsonPath::Compile("$.store.name[0]").Select(json_).empty());
+}
+
+TEST_F(JsonPathTest, SelectMalformedTextThrows) {
+  EXPECT_THROW(JsonPath::Compile("$.b").Select(R"({"a": [1, 2, "x)"),
+               JsonParseException);
+}
+
+TEST_F(JsonPathTest, FindInDocument) {
+  JsonValue root = JsonParser::Parse(json_);
+  JsonPath path = JsonPath::Compile("store.books[1].price");
+  EXPECT_TRUE(path.IsSingular());
+  const JsonValue* price = path.Find(root);
+  ASSERT_NE(price, nullptr);
+  EXPECT_EQ(price->AsNumber(), 20);
+
+  EXPECT_EQ(JsonPath::Compile("store.books[-1].title").Find(root)->AsString(),
+            "D");
+  EXPECT_EQ(JsonPath::Compile("/store/books/2/title").Find(root)->AsString(),
+            "C");
+  EXPECT_EQ(JsonPath::Compile("store.missing").Find(root), nullptr);
+  EXPECT_EQ(JsonPath::Compile("store.books[10]").Find(root), nullptr);
+  EXPECT_EQ(JsonPath::Compile("store.name.x").Find(root), nullptr);
+  EXPECT_EQ(JsonPath::Compile("$").Find(root), &root);
+}
+
+TEST_F(JsonPathTest, FindMutable) {
+  JsonValue root = JsonParser::Parse(json_);
+  JsonPath path = JsonPath::Compile("$.store.books[0].price");
+  path.Find(root)->AsNumber() = 15;
+  EXPECT_EQ(path.Find(root)->AsNumber(), 15);
+}
+
+TEST_F(JsonPathTest, CompileDottedKeepsKeysLiteral) {
+  JsonValue root = JsonParser::Parse(json_);
+  JsonPath path = JsonPath::CompileDotted("store.books[1].price");
+  EXPECT_TRUE(path.IsSingular());
+  ASSERT_NE(path.Find(root), nullptr);
+  EXPECT_EQ(path.Find(root)->AsNumber(), 20);
+
+  JsonPath star = JsonPath::CompileDotted("store.*");
+  ASSERT_EQ(star.Segments().size(), 2);
+  EXPECT_EQ(star.Segments()[1].type, JsonPathSegment::Type::kKey);
+  EXPECT_EQ(star.Segments()[1].key, "*");
+  EXPECT_EQ(star.Find(root), nullptr);
+  EXPECT_EQ(JsonPath::CompileDotted("a/b.m~n").Find(root)->AsBoolean(), true);
+  EXPECT_EQ(JsonPath::CompileDotted("").Find(root), &root);
+
+  EXPECT_THROW(JsonPath::CompileDotted("store.books[-1]"), JsonPathException);
+  EXPECT_THROW(JsonPath::CompileDotted("store.books[1:2]"),
+               JsonPathException);
+  EXPECT_THROW(JsonPath::CompileDotted("store.books[0]x"), JsonPathException);
+}
+
+TEST_F(JsonPathTest, FindAllWildcardAndSlice) {
+  JsonValue root = JsonParser::Parse(json_);
+  JsonPath prices = JsonPath::Compile("$.store.books[*].price");
+  EXPECT_FALSE(prices.IsSingular());
+  std::vector<const JsonValue*> all = prices.FindAll(root);
+  ASSERT_EQ(all.size(), 4);
+  EXPECT_EQ(all[0]->AsNumber(), 10);
+  EXPECT_EQ(all[3]->AsNumber(), 40);
+
+  std::vector<const JsonValue*> sliced =
+      JsonPath::Compile("$.store.books[::2].title").FindAll(root);
+  ASSERT_EQ(sliced.size(), 2);
+  EXPECT_EQ(sliced[1]->AsString(), "C");
+
+  const JsonValue* first = prices.Find(root);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(first->AsNumber(), 10);
+}
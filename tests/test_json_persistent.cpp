@@ -0,0 +1,272 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace json_parser;
+
+namespace {
+
+JsonPersistentValue Sample() {
+  return JsonPersistentValue::FromJsonValue(JsonParser::Parse(R"({
+    "name": "config",
+    "limits": {"cpu": 2, "memory": 512},
+    "hosts": ["a", "b", "c"],
+    "enabled": true,
+    "owner": null
+  })"));
+}
+
+}  // namespace
+
+TEST(JsonPersistentTest, ConvertsToAndFromJsonValue) {
+  JsonValue source = JsonParser::Parse(
+      R"({"a": [1, 2.5, "x", {"b": null}], "c": {}, "d": [], "e": false})");
+  JsonPersistentValue value = JsonPersistentValue::FromJsonValue(source);
+
+  EXPECT_TRUE(value.IsObject());
+  EXPECT_EQ(value.Size(), 4u);
+  EXPECT_EQ(value["a"][1].AsNumber(), 2.5);
+  EXPECT_EQ(value["a"][2].AsString(), "x");
+  EXPECT_TRUE(value["a"][3]["b"].IsNull());
+  EXPECT_FALSE(value["e"].AsBoolean());
+  EXPECT_EQ(value.ToJsonValue(), source);
+}
+
+TEST(JsonPersistentTest, UpdatesLeaveOldVersionsIntact) {
+  JsonPersistentValue v1 = Sample();
+  JsonPersistentValue v2 = v1.Set("name", JsonPersistentValue("changed"));
+  JsonPersistentValue v3 =
+      v2.Erase("owner").Set("new", JsonPersistentValue(1));
+
+  EXPECT_EQ(v1["name"].AsString(), "config");
+  EXPECT_TRUE(v1.Contains("owner"));
+  EXPECT_FALSE(v1.Contains("new"));
+  EXPECT_EQ(v2["name"].AsString(), "changed");
+  EXPECT_EQ(v3.Size(), 5u);
+  EXPECT_FALSE(v3.Contains("owner"));
+  EXPECT_EQ(v3["new"].AsNumber(), 1);
+
+  // Untouched members are shared, not copied
+  EXPECT_TRUE(v3["limits"].SharesStorageWith(v1["limits"]));
+  EXPECT_TRUE(v3["hosts"].SharesStorageWith(v1["hosts"]));
+  EXPECT_EQ(v1.Erase("missing").Size(), v1.Size());
+  EXPECT_NE(v1, v2);
+  EXPECT_EQ(v2.Set("name", JsonPersistentValue("config")), v1);
+}
+
+TEST(JsonPersistentTest, ObjectMatchesReferenceMap) {
+  std::mt19937 rng(7);
+  std::map<std::string, int> expected;
+  JsonPersistentValue obj = JsonPersistentValue::Object();
+  std::vector<JsonPersistentValue> versions;
+
+  for (int step = 0; step < 20000; ++step) {
+    std::string key = "k" + std::to_string(rng() % 3000);
+    if (rng() % 3 == 0) {
+      expected.erase(key);
+      obj = obj.Erase(key);
+    } else {
+      expected[key] = step;
+      obj = obj.Set(key, JsonPersistentValue(step));
+    }
+    if (step % 5000 == 0) {
+      versions.push_back(obj);
+    }
+  }
+
+  ASSERT_EQ(obj.Size(), expected.size());
+  for (const auto& entry : expected) {
+    const JsonPersistentValue* value = obj.Find(entry.first);
+    ASSERT_NE(value, nullptr) << entry.first;
+    EXPECT_EQ(value->AsNumber(), entry.second);
+  }
+  size_t visited = 0;
+  obj.ForEachMember([&](const std::string& key, const JsonPersistentValue&) {
+    EXPECT_EQ(expected.count(key), 1u);
+    ++visited;
+  });
+  EXPECT_EQ(visited, expected.size());
+
+  // The same keys give the same trie however they were inserted, and
+  // erasing everything leaves an empty object
+  JsonPersistentValue rebuilt = JsonPersistentValue::Object();
+  for (auto it = expected.rbegin(); it != expected.rend(); ++it) {
+    rebuilt = rebuilt.Set(it->first, JsonPersistentValue(it->second));
+  }
+  EXPECT_EQ(rebuilt, obj);
+  for (const auto& entry : expected) {
+    obj = obj.Erase(entry.first);
+  }
+  EXPECT_TRUE(obj.Empty());
+  EXPECT_EQ(obj, JsonPersistentValue::Object());
+  EXPECT_EQ(versions.front().Size(), 1u);
+}
+
+TEST(JsonPersistentTest, ArrayPushSetAndPop) {
+  JsonPersistentValue arr = JsonPersistentValue::Array();
+  std::vector<JsonPersistentValue> versions;
+  const int kCount = 40000;
+  for (int i = 0; i < kCount; ++i) {
+    if (i == 1056 || i == 33825) {
+      versions.push_back(arr);
+    }
+    arr = arr.PushBack(JsonPersistentValue(i));
+  }
+  ASSERT_EQ(arr.Size(), static_cast<size_t>(kCount));
+  for (int i = 0; i < kCount; i += 7) {
+    EXPECT_EQ(arr[i].AsNumber(), i);
+  }
+
+  // Pushes build the same layout as bulk conversion
+  JsonValue dom{JsonArray()};
+  for (int i = 0; i < kCount; ++i) {
+    dom.AsArray().PushBack(JsonValue(i));
+  }
+  EXPECT_EQ(JsonPersistentValue::FromJsonValue(dom), arr);
+
+  JsonPersistentValue changed = arr.Set(1000, JsonPersistentValue("x"))
+                                    .Set(kCount - 1, JsonPersistentValue("y"));
+  EXPECT_EQ(changed[1000].AsString(), "x");
+  EXPECT_EQ(changed[kCount - 1].AsString(), "y");
+  EXPECT_EQ(arr[1000].AsNumber(), 1000);
+  EXPECT_NE(changed, arr);
+
+  for (int i = kCount; i > 0; --i) {
+    if (i == 1056 || i == 33825) {
+      EXPECT_EQ(arr, versions[i == 1056 ? 0 : 1]);
+    }
+    ASSERT_EQ(arr[i - 1].AsNumber(), i - 1);
+    arr = arr.PopBack();
+  }
+  EXPECT_TRUE(arr.Empty());
+  EXPECT_EQ(versions[1].Size(), 33825u);
+  EXPECT_EQ(versions[1][33824].AsNumber(), 33824);
+  EXPECT_THROW(arr.PopBack(), JsonException);
+}
+
+TEST(JsonPersistentTest, ArrayInsertAndEraseMatchReferenceVector) {
+  std::mt19937 rng(11);
+  std::vector<int> expected;
+  JsonPersistentValue arr = JsonPersistentValue::Array();
+  std::vector<std::pair<std::vector<int>, JsonPersistentValue>> versions;
+
+  for (int step = 0; step < 20000; ++step) {
+    const size_t size = expected.size();
+    const unsigned op = rng() % 8;
+    if (op < 4 || size < 100) {
+      size_t index = rng() % (size + 1);
+      expected.insert(expected.begin() + index, step);
+      arr = arr.Insert(index, JsonPersistentValue(step));
+    } else if (op < 6) {
+      size_t index = rng() % size;
+      expected.erase(expected.begin() + index);
+      arr = arr.Erase(index);
+    } else if (op == 6) {
+      expected.push_back(step);
+      arr = arr.PushBack(JsonPersistentValue(step));
+    } else {
+      size_t index = rng() % size;
+      expected[index] = -step;
+      arr = arr.Set(index, JsonPersistentValue(-step));
+    }
+    if (step % 2500 == 0) {
+      versions.emplace_back(expected, arr);
+    }
+  }
+
+  // Every version still reads back as it was, and compares equal to the
+  // regular layout of the same elements
+  versions.emplace_back(expected, arr);
+  for (const auto& version : versions) {
+    const std::vector<int>& values = version.first;
+    ASSERT_EQ(version.second.Size(), values.size());
+    JsonValue dom{JsonArray()};
+    for (size_t i = 0; i < values.size(); ++i) {
+      ASSERT_EQ(version.second[i].AsNumber(), values[i]) << i;
+      dom.AsArray().PushBack(JsonValue(values[i]));
+    }
+    EXPECT_EQ(version.second, JsonPersistentValue::FromJsonValue(dom));
+    EXPECT_EQ(version.second.ToJsonValue(), dom);
+  }
+
+  // Draining from the front empties the array
+  while (!arr.Empty()) {
+    ASSERT_EQ(arr[0].AsNumber(), expected.front());
+    expected.erase(expected.begin());
+    arr = arr.Erase(0);
+  }
+  EXPECT_EQ(arr, JsonPersistentValue::Array());
+  EXPECT_THROW(arr.Erase(0), JsonException);
+  EXPECT_THROW(arr.Insert(1, JsonPersistentValue()), JsonException);
+}
+
+TEST(JsonPersistentTest, PathUpdatesCopyOnlyThePath) {
+  JsonPersistentValue v1 = Sample();
+  JsonPersistentValue v2 =
+      v1.SetIn(JsonPath::Compile("/limits/cpu"), JsonPersistentValue(4));
+  JsonPersistentValue v3 =
+      v2.SetIn(JsonPath::Compile("$.hosts[1]"), JsonPersistentValue("B"))
+          .SetIn(JsonPath::Compile("/hosts/-"), JsonPersistentValue("d"))
+          .EraseIn(JsonPath::Compile("/hosts/0"));
+
+  EXPECT_EQ(v1["limits"]["cpu"].AsNumber(), 2);
+  EXPECT_EQ(v2["limits"]["cpu"].AsNumber(), 4);
+  EXPECT_TRUE(v2["hosts"].SharesStorageWith(v1["hosts"]));
+  EXPECT_EQ(v3["hosts"].ToJsonValue(),
+            JsonParser::Parse(R"(["B", "c", "d"])"));
+  EXPECT_TRUE(v3["limits"].SharesStorageWith(v2["limits"]));
+
+  const JsonPersistentValue* cpu = v3.FindIn(JsonPath::Compile("limits.cpu"));
+  ASSERT_NE(cpu, nullptr);
+  EXPECT_EQ(cpu->AsNumber(), 4);
+  EXPECT_EQ(v3.FindIn(JsonPath::Compile("/hosts/9")), nullptr);
+}
+
+TEST(JsonPersistentTest, InvalidOperationsThrow) {
+  JsonPersistentValue v = Sample();
+  EXPECT_THROW(v["missing"], JsonKeyException);
+  EXPECT_THROW(v["hosts"][3], JsonException);
+  EXPECT_THROW(v["name"].AsNumber(), JsonTypeException);
+  EXPECT_THROW(v["name"].Set("x", JsonPersistentValue(1)), JsonTypeException);
+  EXPECT_THROW(v.SetIn(JsonPath::Compile("/missing/x"), JsonPersistentValue()),
+               JsonPathException);
+  EXPECT_THROW(v.SetIn(JsonPath::Compile("$.hosts[*]"), JsonPersistentValue()),
+               JsonPathException);
+  EXPECT_THROW(v.SetIn(JsonPath::Compile("/name/x"), JsonPersistentValue()),
+               JsonPathException);
+  EXPECT_THROW(v.EraseIn(JsonPath::Compile("/hosts/5")), JsonPathException);
+}
+
+TEST(JsonPersistentTest, ReadersSeeTheirVersionWhileWritersUpdate) {
+  JsonPersistentValue base = JsonPersistentValue::Array();
+  for (int i = 0; i < 5000; ++i) {
+    base = base.PushBack(
+        JsonPersistentValue::Object().Set("id", JsonPersistentValue(i)));
+  }
+
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([base]() {
+      for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 5000; i += 3) {
+          ASSERT_EQ(base[i]["id"].AsNumber(), i);
+        }
+      }
+    });
+  }
+  JsonPersistentValue current = base;
+  for (int i = 0; i < 5000; ++i) {
+    current = current.Set(i, current[i].Set("id", JsonPersistentValue(-i)));
+  }
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(current[4999]["id"].AsNumber(), -4999);
+  EXPECT_EQ(base[4999]["id"].AsNumber(), 4999);
+}
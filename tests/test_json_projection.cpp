@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+using namespace json_parser;
+
+class JsonProjectionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    json_ = R"({
+      "id": 7,
+      "user": {"name": "Alice", "email": "a@example.com", "age": 30},
+      "items": [
+        {"sku": "A1", "qty": 2, "meta": {"color": "red"}},
+        {"sku": "B2", "qty": 1, "meta": {"color": "blue"}}
+      ],
+      "payload": {"big": [1, 2, 3, {"nested": "A \"x\""}]}
+    })";
+  }
+  void TearDown() override {}
+
+  std::string json_;
+};
+
+TEST_F(JsonProjectionTest, KeepsSelectedMembers) {
+  JsonProjection projection =
+      JsonProjection::FromPaths({"id", "user.name", "items[*].sku"});
+  JsonValue value = JsonParser::Parse(json_, projection);
+
+  const JsonObject& root = value.AsObject();
+  EXPECT_EQ(root.Size(), 3);
+  EXPECT_EQ(root["id"].AsNumber(), 7);
+  EXPECT_FALSE(root.Contains("payload"));
+
+  const JsonObject& user = root["user"].AsObject();
+  EXPECT_EQ(user.Size(), 1);
+  EXPECT_EQ(user["name"].AsString(), "Alice");
+
+  const JsonArray& items = root["items"].AsArray();
+  ASSERT_EQ(items.Size(), 2);
+  EXPECT_EQ(items[1].AsObject().Size(), 1);
+  EXPECT_EQ(items[1].AsObject()["sku"].AsString(), "B2");
+}
+
+TEST_F(JsonProjectionTest, ArraysAreTransparent) {
+  JsonProjection projection;
+  projection.Include("items.meta.color");
+  JsonValue value = JsonParser::Parse(json_, projection);
+  const JsonArray& items = value.AsObject()["items"].AsArray();
+  ASSERT_EQ(items.Size(), 2);
+  EXPECT_EQ(items[0].AsObject()["meta"].AsObject()["color"].AsString(), "red");
+  EXPECT_FALSE(items[0].AsObject().Contains("sku"));
+}
+
+TEST_F(JsonProjectionTest, WildcardMergesWithNamedKeys) {
+  JsonProjection projection;
+  projection.Include("user.name").Include("*.age");
+  JsonValue value = JsonParser::Parse(json_, projection);
+  const JsonObject& user = value.AsObject()["user"].AsObject();
+  EXPECT_EQ(user.Size(), 2);
+  EXPECT_EQ(user["age"].AsNumber(), 30);
+  EXPECT_FALSE(value.AsObject().Contains("id"));
+}
+
+TEST_F(JsonProjectionTest, WholeSubtree) {
+  JsonProjection projection;
+  projection.Include("payload");
+  JsonValue value = JsonParser::Parse(json_, projection);
+  EXPECT_EQ(value.AsObject()["payload"].AsObject()["big"].AsArray().Size(), 4);
+
+  JsonProjection everything;
+  everything.Include("$");
+  EXPECT_EQ(JsonParser::Parse(json_, everything), JsonParser::Parse(json_));
+}
+
+TEST_F(JsonProjectionTest, SkippedMembersAreValidated) {
+  JsonProjection projection;
+  projection.Include("id");
+  EXPECT_THROW(JsonParser::Parse(R"({"id": 1, "junk": [1, }] })", projection),
+               JsonParseException);
+  EXPECT_THROW(JsonParser::Parse(R"({"id": 1, "junk": "\u00zz"})", projection),
+               JsonParseException);
+  EXPECT_THROW(JsonParser::Parse(R"({"id": 1, "junk": tru})", projection),
+               JsonParseException);
+}
+
+TEST_F(JsonProjectionTest, RejectsIndexPaths) {
+  JsonProjection projection;
+  EXPECT_THROW(projection.Include("items[0].sku"), JsonPathException);
+}
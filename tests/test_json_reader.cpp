@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+using namespace json_parser;
+
+TEST(JsonReaderTest, ReadsObjectMembers) {
+  PaddedJsonBuffer json(R"({"name": "aé😀", "n": -12, "ok": true, "x": null})");
+  JsonReader reader(json);
+  std::string key;
+
+  reader.BeginObject();
+  ASSERT_TRUE(reader.NextKey(key));
+  EXPECT_EQ(key, "name");
+  EXPECT_EQ(reader.ReadString(), "a\xC3\xA9\xF0\x9F\x98\x80");
+  ASSERT_TRUE(reader.NextKey(key));
+  EXPECT_EQ(reader.ReadInt64(), -12);
+  ASSERT_TRUE(reader.NextKey(key));
+  EXPECT_TRUE(reader.ReadBool());
+  ASSERT_TRUE(reader.NextKey(key));
+  EXPECT_EQ(reader.PeekType(), JsonValueType::kNull);
+  reader.ReadNull();
+  EXPECT_FALSE(reader.NextKey(key));
+  reader.ExpectEnd();
+}
+
+TEST(JsonReaderTest, DecodesUnicodeEscapes) {
+  PaddedJsonBuffer json(R"(["a\u00e9\ud83d\ude00", "\u0041\n"])");
+  JsonReader reader(json);
+
+  reader.BeginArray();
+  ASSERT_TRUE(reader.NextElement());
+  EXPECT_EQ(reader.ReadString(), "a\xC3\xA9\xF0\x9F\x98\x80");
+  ASSERT_TRUE(reader.NextElement());
+  EXPECT_EQ(reader.ReadString(), "A\n");
+  EXPECT_FALSE(reader.NextElement());
+  reader.ExpectEnd();
+}
+
+TEST(JsonReaderTest, ReadsArrayElements) {
+  PaddedJsonBuffer json("[1.5, 2e2, [], {}]");
+  JsonReader reader(json);
+
+  reader.BeginArray();
+  ASSERT_TRUE(reader.NextElement());
+  EXPECT_DOUBLE_EQ(reader.ReadDouble(), 1.5);
+  ASSERT_TRUE(reader.NextElement());
+  EXPECT_EQ(reader.ReadInt64(), 200);
+  ASSERT_TRUE(reader.NextElement());
+  reader.SkipValue();
+  ASSERT_TRUE(reader.NextElement());
+  JsonValue empty = reader.ReadValue();
+  EXPECT_TRUE(empty.IsObject());
+  EXPECT_FALSE(reader.NextElement());
+  reader.ExpectEnd();
+}
+
+TEST(JsonReaderTest, IntegerRanges) {
+  PaddedJsonBuffer json("[9223372036854775807, -9223372036854775808, "
+                        "9223372036854775808, 18446744073709551615, 1.5]");
+  JsonReader reader(json);
+  reader.BeginArray();
+  reader.NextElement();
+  EXPECT_EQ(reader.ReadInt64(), INT64_MAX);
+  reader.NextElement();
+  EXPECT_EQ(reader.ReadInt64(), INT64_MIN);
+  reader.NextElement();
+  EXPECT_THROW(reader.ReadInt64(), JsonTypeException);
+
+  JsonReader unsigned_reader(json);
+  unsigned_reader.BeginArray();
+  unsigned_reader.NextElement();
+  unsigned_reader.SkipValue();
+  unsigned_reader.NextElement();
+  EXPECT_THROW(unsigned_reader.ReadUInt64(), JsonTypeException);
+  unsigned_reader.SkipValue();
+  unsigned_reader.NextElement();
+  unsigned_reader.SkipValue();
+  unsigned_reader.NextElement();
+  EXPECT_EQ(unsigned_reader.ReadUInt64(), UINT64_MAX);
+  unsigned_reader.NextElement();
+  EXPECT_THROW(unsigned_reader.ReadUInt64(), JsonTypeException);
+}
+
+TEST(JsonReaderTest, TypeMismatchThrowsTypeException) {
+  PaddedJsonBuffer json(R"({"a": "text"})");
+  JsonReader reader(json);
+  EXPECT_THROW(reader.BeginArray(), JsonTypeException);
+  reader.BeginObject();
+  std::string key;
+  reader.NextKey(key);
+  EXPECT_THROW(reader.ReadInt64(), JsonTypeException);
+}
+
+TEST(JsonReaderTest, MalformedInputThrowsParseException) {
+  auto skip = [](const std::string& text) {
+    PaddedJsonBuffer json(text);
+    JsonReader reader(json);
+    reader.SkipValue();
+    reader.ExpectEnd();
+  };
+  EXPECT_THROW(skip(R"({"a" 1})"), JsonParseException);
+  EXPECT_THROW(skip(R"({"a": 1,})"), JsonParseException);
+  EXPECT_THROW(skip("[1 2]"), JsonParseException);
+  EXPECT_THROW(skip("[01]"), JsonParseException);
+  EXPECT_THROW(skip("[1.]"), JsonParseException);
+  EXPECT_THROW(skip(R"(["abc)"), JsonParseException);
+  EXPECT_THROW(skip(R"(["\x"])"), JsonParseException);
+  EXPECT_THROW(skip("[tru]"), JsonParseException);
+  EXPECT_THROW(skip("[1] 2"), JsonParseException);
+  EXPECT_THROW(skip(""), JsonParseException);
+  EXPECT_NO_THROW(skip(R"({"a": [1, {"b": "\"}"}], "c": -0.5e-3})"));
+}
+
+TEST(JsonReaderTest, EnforcesMaxDepth) {
+  JsonParserConfig config;
+  config.max_depth = 3;
+  PaddedJsonBuffer json("[[[[1]]]]");
+  JsonReader reader(json, config);
+  EXPECT_THROW(reader.SkipValue(), JsonParseException);
+}
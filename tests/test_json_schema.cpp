@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+using namespace json_parser;
+
+class JsonSchemaTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    schema_ = JsonSchema::Compile(R"({
+      "type": "object",
+      "required": ["id", "user"],
+      "properties": {
+        "id": {"type": "integer", "minimum": 1},
+        "user": {"$ref": "#/$defs/user"},
+        "tags": {
+          "type": "array",
+          "items": {"type": "string", "minLength": 1},
+          "uniqueItems": true,
+          "maxItems": 3
+        },
+        "kind": {"enum": ["a", "b"]}
+      },
+      "additionalProperties": false,
+      "$defs": {
+        "user": {
+          "type": "object",
+          "properties": {
+            "name": {"type": "string", "pattern": "^[A-Z]"},
+            "age": {"type": "number", "exclusiveMinimum": 0, "multipleOf": 0.5}
+          },
+          "required": ["name"]
+        }
+      }
+    })");
+  }
+  void TearDown() override {}
+
+  std::string Error(const std::string& json) {
+    std::string error;
+    EXPECT_FALSE(schema_.Validate(JsonParser::Parse(json), &error)) << json;
+    return error;
+  }
+
+  JsonSchema schema_ = JsonSchema::Compile(JsonValue(true));
+};
+
+TEST_F(JsonSchemaTest, ValidDocument) {
+  const char* json =
+      R"({"id": 3, "user": {"name": "Ann", "age": 4.5}, "tags": ["x", "y"]})";
+  EXPECT_TRUE(schema_.Validate(JsonParser::Parse(json)));
+  JsonValue value = schema_.ParseValidated(json);
+  EXPECT_EQ(value.AsObject()["user"].AsObject()["name"].AsString(), "Ann");
+  EXPECT_EQ(value.AsObject()["tags"].AsArray().Size(), 2);
+}
+
+TEST_F(JsonSchemaTest, ReportsLocationAndKeyword) {
+  EXPECT_EQ(Error(R"({"id": 0, "user": {"name": "A"}})"),
+            "value at '/id' fails 'minimum'");
+  EXPECT_EQ(Error(R"({"id": 1.5, "user": {"name": "A"}})"),
+            "value at '/id' fails 'type'");
+  EXPECT_EQ(Error(R"({"id": 1, "user": {"name": "ann"}})"),
+            "value at '/user/name' fails 'pattern'");
+  EXPECT_EQ(Error(R"({"id": 1, "user": {"name": "A", "age": 1.2}})"),
+            "value at '/user/age' fails 'multipleOf'");
+  EXPECT_EQ(Error(R"({"id": 1, "user": {}})"),
+            "value at '/user' fails 'required'");
+  EXPECT_EQ(Error(R"({"id": 1, "user": {"name": "A"}, "tags": ["", "b"]})"),
+            "value at '/tags/0' fails 'minLength'");
+  EXPECT_EQ(Error(R"({"id": 1, "user": {"name": "A"}, "tags": ["b", "b"]})"),
+            "value at '/tags' fails 'uniqueItems'");
+  EXPECT_EQ(Error(R"({"id": 1, "user": {"name": "A"}, "kind": "c"})"),
+            "value at '/kind' fails 'enum'");
+  EXPECT_EQ(Error(R"({"id": 1, "user": {"name": "A"}, "x~y": 1})"),
+            "value at '/x~0y' fails 'false'");
+  EXPECT_EQ(Error("[]"), "value at '' fails 'type'");
+}
+
+TEST_F(JsonSchemaTest, ParseValidatedRejectsEarly) {
+  try {
+    schema_.ParseValidated(R"({"id": 1, "user": {"name": "A", "age": -1},)"
+                           R"( "rest": )");
+    FAIL() << "expected JsonSchemaException";
+  } catch (const JsonSchemaException& e) {
+    // The truncated tail is never reached
+    EXPECT_NE(std::string(e.what()).find("'/user/age' fails "
+                                         "'exclusiveMinimum'"),
+              std::string::npos);
+  }
+  EXPECT_THROW(schema_.ParseValidated(R"({"user": {"name": "A"}})"),
+               JsonSchemaException);
+  EXPECT_THROW(schema_.ParseValidated(R"({"id": "1"})"), JsonSchemaException);
+  EXPECT_THROW(schema_.ParseValidated(R"({"id": 1)"), JsonParseException);
+}
+
+TEST(JsonSchemaCompositionTest, CombinatorsAndConditionals) {
+  JsonSchema schema = JsonSchema::Compile(R"({
+    "anyOf": [{"type": "string"}, {"type": "number", "maximum": 10}],
+    "not": {"const": "forbidden"},
+    "if": {"type": "number"},
+    "then": {"oneOf": [{"multipleOf": 2}, {"multipleOf": 3}]}
+  })");
+  EXPECT_TRUE(schema.Validate(JsonValue("ok")));
+  EXPECT_FALSE(schema.Validate(JsonValue("forbidden")));
+  EXPECT_TRUE(schema.Validate(JsonValue(4)));
+  EXPECT_FALSE(schema.Validate(JsonValue(6)));  // Both oneOf branches
+  EXPECT_FALSE(schema.Validate(JsonValue(7)));  // Neither
+  EXPECT_FALSE(schema.Validate(JsonValue(12)));  // Above maximum
+  EXPECT_FALSE(schema.Validate(JsonValue(true)));
+  EXPECT_THROW(schema.ParseValidated("6"), JsonSchemaException);
+  EXPECT_EQ(schema.ParseValidated("3").AsNumber(), 3);
+}
+
+TEST(JsonSchemaCompositionTest, ArraysAndObjects) {
+  JsonSchema schema = JsonSchema::Compile(R"({
+    "type": "object",
+    "properties": {
+      "pair": {"prefixItems": [{"type": "string"}, {"type": "integer"}],
+               "items": false},
+      "list": {"contains": {"const": 1}, "minContains": 2}
+    },
+    "patternProperties": {"^n_": {"type": "number"}},
+    "propertyNames": {"maxLength": 6},
+    "dependentRequired": {"a": ["b"]},
+    "minProperties": 1
+  })");
+  auto valid = [&](const std::string& json) {
+    bool dom = schema.Validate(JsonParser::Parse(json));
+    bool streamed = true;
+    try {
+      schema.ParseValidated(json);
+    } catch (const JsonSchemaException&) {
+      streamed = false;
+    }
+    EXPECT_EQ(dom, streamed) << json;
+    return dom;
+  };
+  EXPECT_TRUE(valid(R"({"pair": ["x", 1]})"));
+  EXPECT_FALSE(valid(R"({"pair": ["x", 1, 2]})"));
+  EXPECT_FALSE(valid(R"({"pair": [1]})"));
+  EXPECT_TRUE(valid(R"({"list": [1, 0, 1]})"));
+  EXPECT_FALSE(valid(R"({"list": [1, 0]})"));
+  EXPECT_TRUE(valid(R"({"n_x": 1})"));
+  EXPECT_FALSE(valid(R"({"n_x": "1"})"));
+  EXPECT_FALSE(valid(R"({"toolong": 1})"));
+  EXPECT_FALSE(valid(R"({"a": 1})"));
+  EXPECT_TRUE(valid(R"({"a": 1, "b": 2})"));
+  EXPECT_FALSE(valid("{}"));
+}
+
+TEST(JsonSchemaCompositionTest, RecursiveRef) {
+  JsonSchema tree = JsonSchema::Compile(R"({
+    "type": "object",
+    "properties": {
+      "value": {"type": "integer"},
+      "children": {"type": "array", "items": {"$ref": "#"}}
+    }
+  })");
+  const char* good = R"({"value": 1, "children": [{"value": 2, "children": []}]})";
+  const char* bad = R"({"value": 1, "children": [{"value": "2"}]})";
+  EXPECT_TRUE(tree.Validate(JsonParser::Parse(good)));
+  EXPECT_NO_THROW(tree.ParseValidated(good));
+  std::string error;
+  EXPECT_FALSE(tree.Validate(JsonParser::Parse(bad), &error));
+  EXPECT_EQ(error, "value at '/children/0/value' fails 'type'");
+}
+
+TEST(JsonSchemaCompositionTest, RejectsBadSchemas) {
+  EXPECT_THROW(JsonSchema::Compile(R"({"type": "decimal"})"),
+               JsonSchemaException);
+  EXPECT_THROW(JsonSchema::Compile(R"({"$ref": "other.json"})"),
+               JsonSchemaException);
+  EXPECT_THROW(JsonSchema::Compile(R"({"$ref": "#/$defs/missing"})"),
+               JsonSchemaException);
+  EXPECT_THROW(JsonSchema::Compile(R"({"pattern": "("})"),
+               JsonSchemaException);
+  EXPECT_THROW(JsonSchema::Compile(R"({"unevaluatedProperties": false})"),
+               JsonSchemaException);
+  EXPECT_THROW(JsonSchema::Compile(R"({"minLength": -1})"),
+               JsonSchemaException);
+  EXPECT_THROW(JsonSchema::Compile("3"), JsonSchemaException);
+  EXPECT_FALSE(JsonSchema::Compile("false").Validate(JsonValue(1)));
+}
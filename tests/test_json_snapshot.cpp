@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace json_parser;
+
+namespace {
+
+JsonValue Sample() {
+  return JsonParser::Parse(R"({
+    "name": "snapshot",
+    "count": 3,
+    "ratio": -0.25,
+    "ok": true,
+    "missing": null,
+    "items": [{"id": 1, "tag": "a"}, {"id": 2, "tag": "b"}, {"id": 3}],
+    "": "empty key"
+  })");
+}
+
+}  // namespace
+
+TEST(JsonSnapshotTest, QueriesScalarsAndContainers) {
+  std::string data = JsonSnapshot::Encode(Sample());
+  JsonSnapshot snapshot = JsonSnapshot::FromBuffer(data.data(), data.size());
+  JsonSnapshotView root = snapshot.Root();
+
+  ASSERT_TRUE(root.IsObject());
+  EXPECT_EQ(root.Size(), 7);
+  EXPECT_EQ(root["name"].AsString(), "snapshot");
+  EXPECT_EQ(root["count"].AsNumber(), 3);
+  EXPECT_EQ(root["ratio"].AsNumber(), -0.25);
+  EXPECT_TRUE(root["ok"].AsBoolean());
+  EXPECT_TRUE(root["missing"].IsNull());
+  EXPECT_EQ(root[""].AsString(), "empty key");
+
+  JsonSnapshotView items = root["items"];
+  ASSERT_TRUE(items.IsArray());
+  ASSERT_EQ(items.Size(), 3);
+  EXPECT_EQ(items[1]["tag"].AsString(), "b");
+  EXPECT_FALSE(items[2].Contains("tag"));
+  EXPECT_EQ(data.size() % 8, 0);
+}
+
+TEST(JsonSnapshotTest, KeysAreSortedAndSearchable) {
+  std::string data = JsonSnapshot::Encode(
+      JsonParser::Parse(R"({"b": 2, "a": 1, "c": 3, "ab": 4})"));
+  JsonSnapshotView root =
+      JsonSnapshot::FromBuffer(data.data(), data.size()).Root();
+
+  ASSERT_EQ(root.Size(), 4);
+  EXPECT_EQ(root.KeyAt(0), "a");
+  EXPECT_EQ(root.KeyAt(1), "ab");
+  EXPECT_EQ(root.KeyAt(2), "b");
+  EXPECT_EQ(root.KeyAt(3), "c");
+  EXPECT_EQ(root.ValueAt(1).AsNumber(), 4);
+  EXPECT_FALSE(root.Find("d").has_value());
+  EXPECT_FALSE(root.Find("aa").has_value());
+  EXPECT_THROW(root["d"], JsonKeyException);
+}
+
+TEST(JsonSnapshotTest, DeduplicatesRepeatedKeys) {
+  JsonValue rows{JsonArray()};
+  for (int i = 0; i < 100; ++i) {
+    rows.AsArray().PushBack(
+        JsonParser::Parse(R"({"a_rather_long_key_name": 1})"));
+  }
+  std::string data = JsonSnapshot::Encode(rows);
+  EXPECT_EQ(data.find("a_rather_long_key_name"),
+            data.rfind("a_rather_long_key_name"));
+}
+
+TEST(JsonSnapshotTest, RoundTripsThroughJsonValue) {
+  JsonValue original = Sample();
+  std::string data = JsonSnapshot::Encode(original);
+  JsonSnapshot snapshot = JsonSnapshot::FromBuffer(data.data(), data.size());
+  EXPECT_EQ(snapshot.Root().ToJsonValue(), original);
+
+  std::string scalar = JsonSnapshot::Encode(JsonValue("text"));
+  EXPECT_EQ(JsonSnapshot::FromBuffer(scalar.data(), scalar.size())
+                .Root()
+                .AsString(),
+            "text");
+}
+
+TEST(JsonSnapshotTest, OpensMappedFile) {
+  const std::string filename = "test_json_snapshot.bin";
+  JsonSnapshot::WriteFile(Sample(), filename);
+  {
+    JsonSnapshot snapshot = JsonSnapshot::Open(filename);
+    JsonSnapshot moved = std::move(snapshot);
+    EXPECT_EQ(moved.Root()["items"][0]["id"].AsNumber(), 1);
+    EXPECT_EQ(moved.Root().ToJsonValue(), Sample());
+  }
+  std::remove(filename.c_str());
+
+  EXPECT_THROW(JsonSnapshot::Open("does_not_exist.bin"), JsonFileException);
+}
+
+TEST(JsonSnapshotTest, WrongTypeAccessThrows) {
+  std::string data = JsonSnapshot::Encode(Sample());
+  JsonSnapshotView root =
+      JsonSnapshot::FromBuffer(data.data(), data.size()).Root();
+  EXPECT_THROW(root.AsString(), JsonTypeException);
+  EXPECT_THROW(root["name"].AsNumber(), JsonTypeException);
+  EXPECT_THROW(root["count"].Size(), JsonTypeException);
+  EXPECT_THROW(root["items"][3], JsonException);
+}
+
+TEST(JsonSnapshotTest, RejectsCorruptInput) {
+  std::string data = JsonSnapshot::Encode(Sample());
+
+  // The header is little-endian whatever the host order: version 1
+  EXPECT_EQ(data.substr(0, 8), std::string("JSNP\x01\0\0\0", 8));
+  std::string bad_version = data;
+  bad_version[7] = 1;
+  EXPECT_THROW(
+      JsonSnapshot::FromBuffer(bad_version.data(), bad_version.size()),
+      JsonParseException);
+
+  std::string bad_magic = data;
+  bad_magic[0] = 'X';
+  EXPECT_THROW(JsonSnapshot::FromBuffer(bad_magic.data(), bad_magic.size()),
+               JsonParseException);
+
+  std::string truncated = data.substr(0, data.size() - 8);
+  EXPECT_THROW(JsonSnapshot::FromBuffer(truncated.data(), truncated.size()),
+               JsonParseException);
+
+  EXPECT_THROW(JsonSnapshot::FromBuffer(data.data(), 16), JsonParseException);
+
+  // Point the root at the end of the buffer
+  std::string bad_root = data;
+  uint64_t ref = uint64_t{data.size()} << 3 | 6;
+  std::memcpy(&bad_root[16], &ref, sizeof(ref));
+  JsonSnapshotView root =
+      JsonSnapshot::FromBuffer(bad_root.data(), bad_root.size()).Root();
+  EXPECT_THROW(root.Size(), JsonParseException);
+
+  // A container that claims more entries than fit
+  std::string bad_count = JsonSnapshot::Encode(JsonParser::Parse("[1, 2]"));
+  uint64_t root_ref;
+  std::memcpy(&root_ref, &bad_count[16], sizeof(root_ref));
+  uint64_t huge = uint64_t{1} << 60;
+  std::memcpy(&bad_count[root_ref >> 3], &huge, sizeof(huge));
+  EXPECT_THROW(
+      JsonSnapshot::FromBuffer(bad_count.data(), bad_count.size()).Root().Size(),
+      JsonParseException);
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace json_parser;
+
+TEST(JsonStreamWriterTest, WritesCompactTokens) {
+  JsonOutputBuffer out;
+  JsonStreamWriter writer(out);
+  writer.BeginObject()
+      .Key("id").Int64(-42)
+      .Key("big").UInt64(18446744073709551615ull)
+      .Key("ratio").Double(0.5)
+      .Key("name").String("a\"b\n")
+      .Key("ok").Bool(true)
+      .Key("none").Null()
+      .Key("list").BeginArray().Int64(1).BeginObject().EndObject()
+      .BeginArray().EndArray().EndArray()
+      .EndObject();
+  EXPECT_TRUE(writer.IsComplete());
+  EXPECT_EQ(out.TakeString(),
+            R"({"id":-42,"big":18446744073709551615,"ratio":0.5,)"
+            R"("name":"a\"b\n","ok":true,"none":null,"list":[1,{},[]]})");
+}
+
+TEST(JsonStreamWriterTest, PrettyOutputMatchesJsonWriter) {
+  JsonValue doc = JsonParser::Parse(
+      R"({"rows": [{"id": 1}, {"id": 2, "tags": []}, [true, {}]]})");
+  JsonWriterConfig config = JsonWriterConfig::Pretty();
+  config.sort_keys = true;
+
+  JsonOutputBuffer out;
+  JsonStreamWriter writer(out, config);
+  writer.Value(doc);
+  EXPECT_EQ(out.TakeString(), JsonWriter(config).Write(doc));
+}
+
+TEST(JsonStreamWriterTest, CanonicalOutputMatchesJsonWriter) {
+  JsonValue doc = JsonParser::Parse(
+      R"({"z": 1e21, "a": [1.5e-7, -0.0, {"b": 2, "A": "\u00e9"}],)"
+      R"( "\ud83d\ude00": 100, "\u20ac": true})");
+  JsonWriterConfig config = JsonWriterConfig::Canonical();
+
+  JsonOutputBuffer out;
+  JsonStreamWriter writer(out, config);
+  writer.BeginArray().Value(doc).Double(1e21).Double(-0.0).EndArray();
+  EXPECT_EQ(out.TakeString(),
+            "[" + JsonWriter(config).Write(doc) + ",1e+21,0]");
+
+  JsonStreamWriter rejects(out, config);
+  EXPECT_THROW(rejects.Double(std::numeric_limits<double>::infinity()),
+               JsonException);
+}
+
+TEST(JsonStreamWriterTest, RejectsInvalidNesting) {
+  JsonOutputBuffer out;
+  EXPECT_THROW(JsonStreamWriter(out).Key("k"), JsonException);
+  EXPECT_THROW(JsonStreamWriter(out).BeginArray().Key("k"), JsonException);
+  EXPECT_THROW(JsonStreamWriter(out).BeginObject().Int64(1), JsonException);
+  EXPECT_THROW(JsonStreamWriter(out).BeginObject().Key("a").Key("b"),
+               JsonException);
+  EXPECT_THROW(JsonStreamWriter(out).BeginObject().Key("a").EndObject(),
+               JsonException);
+  EXPECT_THROW(JsonStreamWriter(out).BeginObject().EndArray(), JsonException);
+  EXPECT_THROW(JsonStreamWriter(out).EndArray(), JsonException);
+  EXPECT_THROW(JsonStreamWriter(out).Int64(1).Int64(2), JsonException);
+
+  JsonWriterConfig config = JsonWriterConfig::Compact();
+  config.max_depth = 3;
+  JsonStreamWriter shallow(out, config);
+  shallow.BeginArray().BeginArray().BeginArray();
+  EXPECT_THROW(shallow.BeginArray(), JsonException);
+}
+
+TEST(JsonStreamWriterTest, TracksDeepNesting) {
+  JsonOutputBuffer out;
+  JsonStreamWriter writer(out);
+  // Cross several words of the bit stack, alternating container types
+  for (int i = 0; i < 150; ++i) {
+    if (i % 3 == 0) {
+      writer.BeginObject().Key("k");
+    } else {
+      writer.BeginArray();
+    }
+  }
+  EXPECT_EQ(writer.Depth(), 150);
+  for (int i = 149; i >= 0; --i) {
+    if (i % 3 == 0) {
+      writer.EndObject();
+    } else {
+      EXPECT_THROW(writer.EndObject(), JsonException);
+      writer.EndArray();
+    }
+  }
+  EXPECT_TRUE(writer.IsComplete());
+  EXPECT_NO_THROW(JsonParser::Parse(out.TakeString()));
+}
+
+TEST(JsonStreamWriterTest, FlushesToStreamAtThreshold) {
+  std::ostringstream stream;
+  {
+    JsonStreamWriter writer(stream, JsonWriterConfig::Compact(), 256);
+    writer.BeginArray();
+    for (int i = 0; i < 1000; ++i) {
+      writer.Int64(i);
+    }
+    // Everything but the last partial chunk has reached the stream
+    EXPECT_GT(stream.str().size(), 3000);
+    writer.EndArray();
+  }
+  JsonValue value = JsonParser::Parse(stream.str());
+  ASSERT_EQ(value.AsArray().Size(), 1000);
+  EXPECT_EQ(value.AsArray()[999].AsNumber(), 999);
+}
+
+TEST(JsonStreamWriterTest, WritesToFileDescriptor) {
+  const std::string filename = "json_stream_writer_test.json";
+  int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  ASSERT_GE(fd, 0);
+  {
+    JsonStreamWriter writer(fd, JsonWriterConfig::Compact(), 64);
+    writer.BeginArray();
+    for (int i = 0; i < 100; ++i) {
+      writer.BeginObject().Key("n").Int64(i).EndObject();
+    }
+    writer.EndArray();
+  }
+  ::close(fd);
+
+  std::ifstream file(filename);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  JsonValue value = JsonParser::Parse(contents.str());
+  ASSERT_EQ(value.AsArray().Size(), 100);
+  EXPECT_EQ(value.AsArray()[42].AsObject()["n"].AsNumber(), 42);
+  std::remove(filename.c_str());
+}
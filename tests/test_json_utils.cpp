@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "json_parser.h"
 
+#include <utility>
+
 using namespace json_parser;
 
 class JsonUtilsTest : public ::testing::Test {
@@ -62,3 +64,92 @@ TEST_F(JsonUtilsTest, CompactPrint) {
   EXPECT_EQ(compact.find('\n'), std::string::npos);
 }
 
+
+TEST_F(JsonUtilsTest, GetByPathNestedIndex) {
+  std::string json = R"({"grid": [[1, 2], [3, 4]], "user": {"tags": ["a"]}})";
+  JsonValue value = JsonParser::Parse(json);
+  const JsonValue* cell = JsonUtils::GetByPath(value, "grid[1][0]");
+  ASSERT_NE(cell, nullptr);
+  EXPECT_EQ(cell->AsNumber(), 3);
+  EXPECT_EQ(JsonUtils::GetByPath(value, "missing[0]"), nullptr);
+  EXPECT_TRUE(JsonUtils::HasPath(value, "user.tags[0]"));
+}
+
+TEST_F(JsonUtilsTest, GetByPathTakesKeysLiterally) {
+  std::string json =
+      R"({"a": {"*": 1, "x": 2, "": {"c": 3}}, "$": {"b": 4}, "/p": 5})";
+  JsonValue value = JsonParser::Parse(json);
+
+  const JsonValue* star = JsonUtils::GetByPath(value, "a.*");
+  ASSERT_NE(star, nullptr);
+  EXPECT_EQ(star->AsNumber(), 1);
+  const JsonValue* dollar = JsonUtils::GetByPath(value, "$.b");
+  ASSERT_NE(dollar, nullptr);
+  EXPECT_EQ(dollar->AsNumber(), 4);
+  const JsonValue* slash = JsonUtils::GetByPath(value, "/p");
+  ASSERT_NE(slash, nullptr);
+  EXPECT_EQ(slash->AsNumber(), 5);
+  const JsonValue* empty_key = JsonUtils::GetByPath(value, "a..c");
+  ASSERT_NE(empty_key, nullptr);
+  EXPECT_EQ(empty_key->AsNumber(), 3);
+
+  EXPECT_EQ(JsonUtils::GetByPath(value, "a.b..c"), nullptr);
+  EXPECT_FALSE(JsonUtils::HasPath(value, "a.b..c"));
+  EXPECT_EQ(JsonUtils::GetByPath(value, "a[x]"), nullptr);
+  EXPECT_EQ(JsonUtils::GetByPath(value, "a[0"), nullptr);
+  EXPECT_FALSE(JsonUtils::HasPath(value, "a[-1]"));
+}
+
+TEST_F(JsonUtilsTest, EditingAnInternedOccurrenceLeavesOthersUnchanged) {
+  JsonValue doc = JsonParser::Parse(
+      R"({"a": {"c": "USD", "n": [1]}, "b": {"c": "USD", "n": [1]}})");
+  JsonUtils::Intern(doc);
+  const JsonValue& shared = doc;
+  ASSERT_EQ(&shared.AsObject().At("a").AsObject(),
+            &shared.AsObject().At("b").AsObject());
+  const uint64_t b_hash = shared.AsObject().At("b").Hash();
+
+  // The root is interned too but held once, so it is edited in place
+  const JsonObject* root = &shared.AsObject();
+  doc.AsObject()["a"].AsObject()["c"] = JsonValue("EUR");
+  EXPECT_EQ(&shared.AsObject(), root);
+  doc.AsObject()["b"].AsObject()["n"].AsArray().PushBack(JsonValue(2));
+  EXPECT_EQ(doc, JsonParser::Parse(R"({"a": {"c": "EUR", "n": [1]},)"
+                                   R"( "b": {"c": "USD", "n": [1, 2]}})"));
+  EXPECT_NE(doc.AsObject().At("b").Hash(), b_hash);
+
+  JsonParserConfig config;
+  config.intern_subtrees = true;
+  JsonValue parsed = JsonParser::Parse("[[1, 2], [1, 2]]", config);
+  ASSERT_EQ(&std::as_const(parsed).AsArray()[0].AsArray(),
+            &std::as_const(parsed).AsArray()[1].AsArray());
+  parsed.AsArray()[1].AsArray()[0] = JsonValue(3);
+  EXPECT_EQ(parsed, JsonParser::Parse("[[1, 2], [3, 2]]"));
+}
+
+TEST_F(JsonUtilsTest, InternSharesEqualSubtrees) {
+  JsonValue value{JsonArray()};
+  for (int i = 0; i < 100; ++i) {
+    JsonValue unit = JsonParser::Parse(R"({"currency": "USD", "unit": [1]})");
+    JsonValue item{JsonObject()};
+    item.AsObject().Insert("id", JsonValue(i % 2));
+    item.AsObject().Insert("unit", std::move(unit));
+    value.AsArray().PushBack(std::move(item));
+  }
+  const JsonValue expected = JsonUtils::DeepCopy(value);
+
+  // 99 of the 100 [1] arrays, then 99 of the units holding them, then 98
+  // of the items, which have only two distinct shapes
+  EXPECT_EQ(JsonUtils::Intern(value), 99u + 99u + 98u);
+  EXPECT_EQ(value, expected);
+  const JsonArray& items = value.AsArray();
+  EXPECT_EQ(&items[0].AsObject(), &items[2].AsObject());
+  EXPECT_NE(&items[0].AsObject(), &items[1].AsObject());
+  EXPECT_EQ(&items[0].AsObject()["unit"].AsObject(),
+            &items[1].AsObject()["unit"].AsObject());
+
+  // Interning again finds nothing new and walks shared subtrees once
+  EXPECT_EQ(JsonUtils::Intern(value), 0u);
+  JsonValue scalar(1);
+  EXPECT_EQ(JsonUtils::Intern(scalar), 0u);
+}
@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 #include "json_parser.h"
 
+#include <string>
+#include <unordered_set>
+#include <vector>
+
 using namespace json_parser;
 
 class JsonValueTest : public ::testing::Test {
@@ -111,3 +115,132 @@ TEST_F(JsonValueTest, TypeException) {
   EXPECT_THROW(value.AsArray(), JsonTypeException);
 }
 
+TEST_F(JsonValueTest, ToStringLayout) {
+  JsonValue value{JsonObject()};
+  JsonValue list{JsonArray()};
+  list.AsArray().PushBack(JsonValue(1));
+  list.AsArray().PushBack(JsonValue{JsonObject()});
+  value.AsObject().Insert("list", std::move(list));
+
+  EXPECT_EQ(value.ToString(), "{\n  \"list\": [\n    1,\n    {}\n  ]\n}");
+  EXPECT_EQ(value.ToString(4),
+            "{\n      \"list\": [\n        1,\n        {}\n      ]\n    }");
+  EXPECT_EQ(value.ToCompactString(), "{\"list\":[1,{}]}");
+  // Same layout as the default JsonWriter
+  EXPECT_EQ(value.ToString(), JsonWriter().Write(value));
+}
+
+TEST_F(JsonValueTest, ToStringEscapesControlCharacters) {
+  JsonValue value(std::string("a\"b\\c\x01\n"));
+  EXPECT_EQ(value.ToString(), "\"a\\\"b\\\\c\\u0001\\n\"");
+  EXPECT_EQ(value.ToCompactString(), value.ToString());
+}
+
+TEST_F(JsonValueTest, HashIsConsistentWithEquality) {
+  JsonValue a = JsonParser::Parse(R"({"x": [1, {"y": null}], "z": "s"})");
+  JsonValue b = JsonParser::Parse(R"({"z": "s", "x": [1, {"y": null}]})");
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a.Hash(), b.Hash());
+  EXPECT_NE(a.Hash(), JsonParser::Parse(R"({"x": [1, {"y": 0}], "z": "s"})")
+                          .Hash());
+  EXPECT_EQ(JsonValue(0.0), JsonValue(-0.0));
+  EXPECT_EQ(JsonValue(0.0).Hash(), JsonValue(-0.0).Hash());
+  // Numbers compare exactly, so equality is transitive
+  EXPECT_NE(JsonValue(0.1 + 0.2), JsonValue(0.3));
+
+  std::unordered_set<JsonValue> seen;
+  seen.insert(a);
+  seen.insert(b);
+  seen.insert(JsonValue("s"));
+  EXPECT_EQ(seen.size(), 2u);
+  EXPECT_EQ(seen.count(JsonParser::Parse(R"({"x": [1, {"y": null}],
+                                            "z": "s"})")),
+            1u);
+}
+
+TEST_F(JsonValueTest, HashFollowsNestedAndSharedMutations) {
+  JsonValue child = JsonParser::Parse(R"({"items": [1, 2]})");
+  JsonValue first{JsonObject()};
+  JsonValue second{JsonObject()};
+  first.AsObject().Insert("child", child);
+  second.AsObject().Insert("child", child);
+  const JsonValue before = JsonUtils::DeepCopy(second);
+  EXPECT_EQ(second.Hash(), before.Hash());
+
+  // Modified through first, which was never hashed; second shares the
+  // child and must notice
+  first.AsObject()["child"].AsObject()["items"].AsArray().PushBack(
+      JsonValue(3));
+  const JsonValue after =
+      JsonParser::Parse(R"({"child": {"items": [1, 2, 3]}})");
+  EXPECT_EQ(second.Hash(), after.Hash());
+  EXPECT_NE(second.Hash(), before.Hash());
+  EXPECT_NE(second, before);
+  EXPECT_EQ(second, after);
+
+  second.AsObject()["child"].AsObject()["items"].AsArray()[2] =
+      JsonValue(4);
+  EXPECT_NE(first, after);
+  EXPECT_NE(first.Hash(), after.Hash());
+}
+
+TEST_F(JsonValueTest, HashInvalidationStaysWithinAncestors) {
+  JsonValue doc = JsonParser::Parse(
+      R"({"a": {"c": "USD"}, "b": {"c": "USD"}, "n": [1, 2]})");
+  JsonValue other = JsonParser::Parse(R"({"x": [1, 2, 3]})");
+  // Written after hashing, a cached hash cannot see these; they show
+  // whether a hash was kept or recomputed
+  JsonValue& b_currency = doc.AsObject()["b"].AsObject()["c"];
+  JsonValue& other_first = other.AsObject()["x"].AsArray()[0];
+  const uint64_t b_hash = doc.AsObject().At("b").Hash();
+  const uint64_t other_hash = other.Hash();
+  doc.Hash();
+
+  // Modifying a sibling and reading through the const accessors leave
+  // other hashes alone
+  doc.AsObject()["a"].AsObject()["c"] = JsonValue("EUR");
+  const JsonValue& const_doc = doc;
+  EXPECT_EQ(const_doc.AsObject().At("b").AsObject().At("c").AsString(),
+            "USD");
+  b_currency = JsonValue("GBP");
+  other_first = JsonValue(7);
+  EXPECT_EQ(doc.AsObject().At("b").Hash(), b_hash);
+  EXPECT_EQ(other.Hash(), other_hash);
+
+  // The modified subtree's ancestors were recomputed
+  EXPECT_EQ(doc.AsObject().At("a"), JsonParser::Parse(R"({"c": "EUR"})"));
+  EXPECT_EQ(doc.AsObject().At("a").Hash(),
+            JsonParser::Parse(R"({"c": "EUR"})").Hash());
+}
+
+TEST_F(JsonValueTest, HashFollowsMutationsOfWidelySharedChildren) {
+  JsonValue shared = JsonParser::Parse(R"({"k": [1]})");
+  std::vector<JsonValue> parents;
+  for (int i = 0; i < 50; ++i) {
+    JsonValue parent{JsonArray()};
+    parent.AsArray().PushBack(shared);
+    parent.AsArray().PushBack(JsonValue(i));
+    parent.Hash();
+    parent.Hash();
+    parents.push_back(parent);
+  }
+  shared.AsObject()["k"].AsArray().PushBack(JsonValue(2));
+  for (int i = 0; i < 50; ++i) {
+    JsonValue expected = JsonParser::Parse(
+        "[{\"k\": [1, 2]}, " + std::to_string(i) + "]");
+    EXPECT_EQ(parents[i].Hash(), expected.Hash());
+  }
+}
+
+TEST_F(JsonValueTest, HashSeesWritesThroughFoundValues) {
+  JsonValue doc = JsonParser::Parse(R"({"a": {"b": [1, {"c": 2}]}})");
+  const uint64_t before = doc.Hash();
+  JsonUtils::GetByPath(doc, "a.b[1].c")->AsNumber() = 3;
+  EXPECT_NE(doc.Hash(), before);
+  EXPECT_EQ(doc.Hash(),
+            JsonParser::Parse(R"({"a": {"b": [1, {"c": 3}]}})").Hash());
+
+  *JsonPath::Compile("$.a.b[*]").Find(doc) = JsonValue(5);
+  EXPECT_EQ(doc.Hash(),
+            JsonParser::Parse(R"({"a": {"b": [5, {"c": 3}]}})").Hash());
+}
@@ -1,6 +1,13 @@
 #include <gtest/gtest.h>
 #include "json_parser.h"
 
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
 using namespace json_parser;
 
 class JsonWriterTest : public ::testing::Test {
@@ -54,3 +61,267 @@ TEST_F(JsonWriterTest, WriteNested) {
   EXPECT_NE(result.find("nested"), std::string::npos);
 }
 
+
+TEST_F(JsonWriterTest, WritePrettyLayout) {
+  JsonValue value = JsonParser::Parse(R"({"b": [1, true, null], "a": {}})");
+  JsonWriterConfig config = JsonWriterConfig::Pretty();
+  config.sort_keys = true;
+  EXPECT_EQ(JsonWriter(config).Write(value),
+            "{\n  \"a\": {},\n  \"b\": [\n    1,\n    true,\n    null\n  ]\n}");
+
+  config.pretty_print = false;
+  EXPECT_EQ(JsonWriter(config).Write(value), R"({"a":{},"b":[1,true,null]})");
+}
+
+TEST_F(JsonWriterTest, IndentsPastPrecomputedDepth) {
+  std::string json = std::string(40, '[') + "1" + std::string(40, ']');
+  JsonWriterConfig config = JsonWriterConfig::Pretty();
+  config.indent_size = 4;
+  std::string result = JsonWriter(config).Write(JsonParser::Parse(json));
+  EXPECT_NE(result.find("\n" + std::string(160, ' ') + "1\n"),
+            std::string::npos);
+  EXPECT_EQ(JsonParser::Parse(result), JsonParser::Parse(json));
+}
+
+TEST_F(JsonWriterTest, WriteToBufferAndStreamMatch) {
+  JsonValue value = JsonParser::Parse(R"({"s": "a\"b\\c\n", "n": [1.5, -2]})");
+  JsonWriter writer(JsonWriterConfig::Compact());
+
+  JsonOutputBuffer buffer;
+  writer.WriteToBuffer(buffer, value);
+  std::string from_buffer = buffer.TakeString();
+
+  std::ostringstream stream;
+  writer.WriteToStream(stream, value);
+  EXPECT_EQ(stream.str(), from_buffer);
+  EXPECT_EQ(writer.Write(value), from_buffer);
+  EXPECT_EQ(JsonParser::Parse(from_buffer), value);
+}
+
+TEST_F(JsonWriterTest, WritesShortestRoundTripNumbers) {
+  JsonWriter writer(JsonWriterConfig::Compact());
+  EXPECT_EQ(writer.Write(JsonValue(0.1)), "0.1");
+  EXPECT_EQ(writer.Write(JsonValue(1e-9)), "1e-09");
+  EXPECT_EQ(writer.Write(JsonValue(-2.5)), "-2.5");
+  EXPECT_EQ(writer.Write(JsonValue(42)), "42");
+  EXPECT_EQ(writer.Write(JsonValue(-1234567890123.0)), "-1234567890123");
+  EXPECT_EQ(writer.Write(JsonValue(-0.0)), "-0");
+  EXPECT_EQ(writer.Write(JsonValue(std::nan(""))), "null");
+
+  for (double number : {0.1 + 0.2, 1.0 / 3, 5e-324, 1.7976931348623157e308,
+                        123456.789e-30, -9.2233720368547758e18, 1e21}) {
+    std::string text = writer.Write(JsonValue(number));
+    EXPECT_EQ(JsonParser::Parse(text).AsNumber(), number) << text;
+    EXPECT_EQ(JsonValue(number).ToString(), text);
+  }
+}
+
+TEST_F(JsonWriterTest, EscapesAllControlCharacters) {
+  JsonWriter writer(JsonWriterConfig::Compact());
+  std::string text("a\x01" "b\x1f\b\f\n\r\t\"\\/\x7f", 13);
+  EXPECT_EQ(writer.Write(JsonValue(text)),
+            R"("a\u0001b\u001f\b\f\n\r\t\"\\/)" "\x7f\"");
+
+  // Long enough to exercise the vector scan and its scalar tail
+  std::string long_text(100, 'x');
+  long_text[17] = '\n';
+  long_text[98] = '"';
+  std::string written = writer.Write(JsonValue(long_text));
+  EXPECT_EQ(written.size(), long_text.size() + 4);
+  EXPECT_EQ(JsonParser::Parse(written).AsString(), long_text);
+}
+
+TEST_F(JsonWriterTest, EscapeUnicodeUsesCodePoints) {
+  JsonWriterConfig config = JsonWriterConfig::Compact();
+  config.escape_unicode = true;
+  JsonWriter writer(config);
+  // U+00E9, U+20AC and U+1F600 (a surrogate pair)
+  std::string text = "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80";
+  EXPECT_EQ(writer.Write(JsonValue(text)),
+            R"("caf\u00e9 \u20ac \ud83d\ude00")");
+  EXPECT_EQ(JsonParser::Parse(writer.Write(JsonValue(text))).AsString(), text);
+
+  // Malformed UTF-8: a lone continuation byte and a truncated sequence
+  EXPECT_EQ(writer.Write(JsonValue(std::string("\x80x\xe2\x82"))),
+            R"("\ufffdx\ufffd\ufffd")");
+
+  // Without the option non-ASCII bytes pass through untouched
+  EXPECT_EQ(JsonWriter(JsonWriterConfig::Compact()).Write(JsonValue(text)),
+            "\"" + text + "\"");
+}
+
+TEST_F(JsonWriterTest, ParallelOutputMatchesSequential) {
+  JsonValue doc{JsonObject()};
+  JsonValue rows{JsonArray()};
+  JsonValue index{JsonObject()};
+  for (int i = 0; i < 20000; ++i) {
+    JsonValue row{JsonObject()};
+    row.AsObject().Insert("id", JsonValue(i));
+    row.AsObject().Insert("score", JsonValue(i / 7.0));
+    JsonValue tags{JsonArray()};
+    tags.AsArray().PushBack(JsonValue("t" + std::to_string(i % 13)));
+    row.AsObject().Insert("tags", std::move(tags));
+    rows.AsArray().PushBack(std::move(row));
+    index.AsObject().Insert("k" + std::to_string(i), JsonValue(i % 2 == 0));
+  }
+  doc.AsObject().Insert("rows", std::move(rows));
+  doc.AsObject().Insert("index", std::move(index));
+
+  for (bool pretty : {false, true}) {
+    JsonWriterConfig config =
+        pretty ? JsonWriterConfig::Pretty() : JsonWriterConfig::Compact();
+    config.sort_keys = true;
+    std::string sequential = JsonWriter(config).Write(doc);
+
+    config.threads = 4;
+    config.parallel_min_elements = 1000;
+    EXPECT_EQ(JsonWriter(config).Write(doc), sequential);
+
+    std::ostringstream stream;
+    JsonWriter(config).WriteToStream(stream, doc);
+    EXPECT_EQ(stream.str(), sequential);
+
+    config.threads = 0;
+    EXPECT_EQ(JsonWriter(config).Write(doc), sequential);
+  }
+}
+
+TEST_F(JsonWriterTest, ParallelWriteReportsErrors) {
+  JsonValue deep = JsonParser::Parse("[[[[1]]]]");
+  JsonValue rows{JsonArray()};
+  for (int i = 0; i < 10000; ++i) {
+    rows.AsArray().PushBack(i == 9000 ? deep : JsonValue(i));
+  }
+  JsonWriterConfig config = JsonWriterConfig::Compact();
+  config.max_depth = 3;
+  config.threads = 3;
+  config.parallel_min_elements = 1000;
+  EXPECT_THROW(JsonWriter(config).Write(rows), JsonException);
+}
+
+TEST_F(JsonWriterTest, WriteToFileGathersLongStrings) {
+  JsonValue doc{JsonArray()};
+  for (int i = 0; i < 40; ++i) {
+    std::string blob(5000 + i * 997, static_cast<char>('a' + i % 26));
+    blob[blob.size() / 2] = '"';  // Splits the blob into two long runs
+    doc.AsArray().PushBack(JsonValue(blob));
+    doc.AsArray().PushBack(JsonValue(i));
+  }
+  const std::string filename = "json_writer_gather_test.json";
+  JsonWriter writer(JsonWriterConfig::Compact());
+  writer.WriteToFile(filename, doc);
+
+  std::ifstream file(filename, std::ios::binary);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  EXPECT_EQ(contents.str(), writer.Write(doc));
+  std::remove(filename.c_str());
+
+  EXPECT_THROW(writer.WriteToFile("no_such_dir/out.json", doc),
+               JsonFileException);
+}
+
+TEST_F(JsonWriterTest, GatheringBufferKeepsOrder) {
+  std::string blob(JsonOutputBuffer::kMinReferenceLength, 'x');
+  JsonOutputBuffer out(-1, 1 << 20, /*gather=*/true);
+  out.Append("[", 1);
+  out.AppendReference(blob.data(), blob.size());
+  out.Append(",", 1);
+  out.AppendReference("short", 5);
+  out.AppendReference(blob.data(), blob.size());
+  out.Append("]", 1);
+  EXPECT_EQ(out.Size(), 2 * blob.size() + 8);
+  EXPECT_EQ(out.TakeString(), "[" + blob + ",short" + blob + "]");
+  EXPECT_EQ(out.Size(), 0);
+}
+
+TEST_F(JsonWriterTest, CanonicalMatchesRfc8785Example) {
+  JsonValue value = JsonParser::Parse(R"({
+      "numbers": [333333333.33333329, 1E30, 4.50, 2e-3,
+                  0.000000000000000000000000001],
+      "string": "\u20ac$\u000F\u000aA'\u0042\u0022\u005c\\\"\/",
+      "literals": [null, true, false]})");
+  JsonWriter writer(JsonWriterConfig::Canonical());
+  EXPECT_EQ(writer.Write(value),
+            "{\"literals\":[null,true,false],"
+            "\"numbers\":[333333333.3333333,1e+30,4.5,0.002,1e-27],"
+            "\"string\":\"\xe2\x82\xac$\\u000f\\nA'B\\\"\\\\\\\\\\\"/\"}");
+
+  // Canonical overrides the formatting options
+  JsonWriterConfig config = JsonWriterConfig::Pretty();
+  config.canonical = true;
+  config.escape_unicode = true;
+  EXPECT_EQ(JsonWriter(config).Write(value), writer.Write(value));
+}
+
+TEST_F(JsonWriterTest, CanonicalSortsKeysByUtf16CodeUnits) {
+  // The RFC 8785 sorting example: U+1F600 is a surrogate pair, so it sorts
+  // before U+FB33 even though its UTF-8 bytes are larger
+  JsonValue value = JsonParser::Parse(R"({
+      "\u20ac": "Euro Sign", "\r": "Carriage Return",
+      "\ufb33": "Hebrew Letter Dalet With Dagesh", "1": "One",
+      "\ud83d\ude00": "Emoji: Grinning Face", "\u0080": "Control",
+      "\u00f6": "Latin Small Letter O With Diaeresis"})");
+  std::string canonical =
+      JsonWriter(JsonWriterConfig::Canonical()).Write(value);
+  std::vector<std::string> order = {"\\r", "1", "\xc2\x80", "\xc3\xb6",
+                                    "\xe2\x82\xac", "\xf0\x9f\x98\x80",
+                                    "\xef\xac\xb3"};
+  size_t previous = 0;
+  for (const std::string& key : order) {
+    size_t position = canonical.find("\"" + key + "\"");
+    ASSERT_NE(position, std::string::npos) << key;
+    EXPECT_GE(position, previous) << key;
+    previous = position;
+  }
+
+  // Nested objects are sorted independently of their parents
+  JsonValue nested = JsonParser::Parse(
+      R"({"b": {"z": 1, "y": {"d": 0, "c": 0}}, "a": [{"f": 0, "e": 0}]})");
+  EXPECT_EQ(JsonWriter(JsonWriterConfig::Canonical()).Write(nested),
+            R"({"a":[{"e":0,"f":0}],"b":{"y":{"c":0,"d":0},"z":1}})");
+}
+
+TEST_F(JsonWriterTest, CanonicalNumbersMatchEcmaScript) {
+  // Test vectors from RFC 8785 Appendix B
+  struct Case {
+    uint64_t bits;
+    const char* text;
+  };
+  const Case cases[] = {
+      {0x0000000000000000, "0"},
+      {0x8000000000000000, "0"},
+      {0x0000000000000001, "5e-324"},
+      {0x8000000000000001, "-5e-324"},
+      {0x7fefffffffffffff, "1.7976931348623157e+308"},
+      {0xffefffffffffffff, "-1.7976931348623157e+308"},
+      {0x4340000000000000, "9007199254740992"},
+      {0xc340000000000000, "-9007199254740992"},
+      {0x4430000000000000, "295147905179352830000"},
+      {0x44b52d02c7e14af5, "9.999999999999997e+22"},
+      {0x44b52d02c7e14af6, "1e+23"},
+      {0x44b52d02c7e14af7, "1.0000000000000001e+23"},
+      {0x444b1ae4d6e2ef4e, "999999999999999700000"},
+      {0x444b1ae4d6e2ef4f, "999999999999999900000"},
+      {0x444b1ae4d6e2ef50, "1e+21"},
+      {0x3eb0c6f7a0b5ed8c, "9.999999999999997e-7"},
+      {0x3eb0c6f7a0b5ed8d, "0.000001"},
+      {0x41b3de4355555553, "333333333.3333332"},
+      {0x41b3de4355555554, "333333333.33333325"},
+      {0x41b3de4355555555, "333333333.3333333"},
+      {0x41b3de4355555556, "333333333.3333334"},
+      {0x41b3de4355555557, "333333333.33333343"},
+      {0xbecbf647612f3696, "-0.0000033333333333333333"},
+      {0x43143ff3c1cb0959, "1424953923781206.2"},
+  };
+  JsonWriter writer(JsonWriterConfig::Canonical());
+  for (const Case& c : cases) {
+    double number;
+    std::memcpy(&number, &c.bits, sizeof(number));
+    EXPECT_EQ(writer.Write(JsonValue(number)), c.text) << std::hex << c.bits;
+  }
+  EXPECT_EQ(writer.Write(JsonValue(-42)), "-42");
+  EXPECT_EQ(writer.Write(JsonValue(0.5)), "0.5");
+  EXPECT_THROW(writer.Write(JsonValue(std::nan(""))), JsonException);
+  EXPECT_THROW(writer.Write(JsonValue(INFINITY)), JsonException);
+}